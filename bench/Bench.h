@@ -0,0 +1,101 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <math.h>
+#include <stdio.h>
+#include <time.h>
+#include "../path/Path.h"
+
+/********************************************************************************************************************************
+**  BenchNow
+**
+**      Input:
+**
+**      Output: Monotonic time in nanoseconds.
+**
+********************************************************************************************************************************/
+static inline double BenchNow (void) {
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/********************************************************************************************************************************
+**  BenchReport
+**
+**      Prints one result as a single line of space separated key=value pairs, e.g.
+**          bench=FleetStep followers=100 threads=4 ns_per_op=812.4
+**
+**      Input:
+**          const char *name        Name of the benchmark
+**          const char *params      Preformatted key=value parameters of this run (may be empty)
+**          double nsPerOp          Measured time per operation
+**
+**      Output:
+**
+********************************************************************************************************************************/
+static inline void BenchReport (const char *name, const char *params, double nsPerOp) {
+    printf( "bench=%s %s%sns_per_op=%.1f\n", name, params, params[0] ? " " : "", nsPerOp );
+    fflush( stdout );
+}
+
+/********************************************************************************************************************************
+**  BenchReportScaling
+**
+**      Fits ns/op = c * size^k by least squares on a log-log scale and prints the exponent k, e.g.
+**          bench=GetTargetPoint scaling=waypoints exponent=1.02
+**      0 means the cost does not depend on the size, 1 that it grows linearly with it.
+**
+**      Input:
+**          const char *name        Name of the benchmark
+**          const char *sizeName    What the sizes count
+**          const double *sizes     Size of each run
+**          const double *nsPerOp   Measured time per operation of each run
+**          int count               Number of runs
+**
+**      Output:
+**
+********************************************************************************************************************************/
+static inline void BenchReportScaling (const char *name, const char *sizeName, const double *sizes, const double *nsPerOp, int count) {
+    double sumX = 0.0, sumY = 0.0, sumXX = 0.0, sumXY = 0.0, x, y, exponent = 0.0;
+    int i;
+
+    for ( i = 0; i < count; i++ ) {
+        x = log( sizes[i] );
+        y = log( nsPerOp[i] );
+        sumX += x;
+        sumY += y;
+        sumXX += x * x;
+        sumXY += x * y;
+    }
+    if ( count > 1 && count * sumXX - sumX * sumX > 0.0 ) {
+        exponent = ( count * sumXY - sumX * sumY ) / ( count * sumXX - sumX * sumX );
+    }
+    printf( "bench=%s scaling=%s exponent=%.2f\n", name, sizeName, exponent );
+    fflush( stdout );
+}
+
+/********************************************************************************************************************************
+**  BenchFollowerParams
+**
+**      Input:
+**
+**      Output: Path following parameters used by the benchmarks (60 in/s cruise, 120 in/s^2, feed forward only).
+**
+********************************************************************************************************************************/
+static inline pathFollowerParams_t BenchFollowerParams (void) {
+    pathFollowerParams_t params = {
+        .lookahead = { .minDistance_in = 12.0, .maxDistance_in = 36.0, .minSpeed_ips = 4.0, .maxSpeed_ips = 120.0 },
+        .profile_kffv = 1.0,
+        .profile_max_abs_vel = 60.0,
+        .profile_max_abs_acc = 120.0,
+        .goal_pos_tolerance = 0.75,
+        .goal_vel_tolerance = 12.0,
+        .stop_steering_distance = 9.0,
+    };
+
+    return params;
+}
+
+#endif
@@ -0,0 +1,88 @@
+#include <stdio.h>
+#include "Bench.h"
+#include "../fleet/Fleet.h"
+
+#define BENCH_FLEET_TICKS 200
+#define BENCH_FLEET_DT 0.005
+
+
+/********************************************************************************************************************************
+**  BenchFleetIntegrate
+**
+**      Drives one simulated robot by its last command for one tick.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void BenchFleetIntegrate (void *context, int index) {
+    fleetSlot_t *slot = &( (fleetEngine_t *) context )->slots[index];
+    twist2d_t delta;
+    transform2d_t motion;
+
+    delta.dx_in = slot->command.dx_in * BENCH_FLEET_DT;
+    delta.dy_in = slot->command.dy_in * BENCH_FLEET_DT;
+    delta.dtheta_rad = slot->command.dtheta_rad * BENCH_FLEET_DT;
+    motion = Exp( &delta );
+    slot->pose = TranformAByB( &slot->pose, &motion );
+    slot->displacement += delta.dx_in;
+    slot->velocity = slot->command.dx_in;
+}
+
+
+/********************************************************************************************************************************
+**  BenchFleetEngine
+**
+**      Steps 1 to 1000 followers on 1 to N threads and reports the time per follower tick.  Every follower drives its own copy
+**      of a zig-zag route, offset so that no two are identical.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void BenchFleetEngine (void) {
+    int followerCounts[] = {1, 10, 100, 1000};
+    fleetEngine_t *engine;
+    pathFollowerParams_t params;
+    pathSegmentsList_t path;
+    waypoint_t waypoints[6];
+    waypoint_t *wps[6];
+    transform2d_t startPose;
+    char text[128];
+    double start, elapsed;
+    int c, threads, maxThreads, i, k, tick;
+
+    params = BenchFollowerParams();
+    maxThreads = GetNumCores();
+    for ( c = 0; c < 4; c++ ) {
+        for ( threads = 1; threads <= maxThreads; threads = ( threads * 2 > maxThreads && threads < maxThreads ) ? maxThreads : threads * 2 ) {
+            engine = CreateFleetEngine( followerCounts[c], threads );
+            for ( i = 0; i < followerCounts[c]; i++ ) {
+                for ( k = 0; k < 6; k++ ) {
+                    waypoints[k].position.x_in = 120.0 * k;
+                    waypoints[k].position.y_in = ( k % 2 ) * 96.0 + i * 0.5;
+                    waypoints[k].radius = ( k == 0 || k == 5 ) ? 0.0 : 24.0;
+                    waypoints[k].speed_ips = 60.0;
+                    wps[k] = &waypoints[k];
+                }
+                path = BuildPathFromWaypoints( wps, 6 );
+                startPose.translation = waypoints[0].position;
+                startPose.rotation = TranslationDirection( &path.head->segment.deltaStart );
+                AddFleetFollower( engine, &path, 0, &params, &startPose );
+            }
+
+            elapsed = 0.0;
+            for ( tick = 0; tick < BENCH_FLEET_TICKS; tick++ ) {
+                start = BenchNow();
+                StepFleet( engine, tick * BENCH_FLEET_DT );
+                elapsed += BenchNow() - start;
+                RunThreadPool( engine->pool, BenchFleetIntegrate, engine, engine->numSlots );
+            }
+            snprintf( text, sizeof( text ), "followers=%d threads=%d", followerCounts[c], threads );
+            BenchReport( "FleetStep", text, elapsed / ( (double) BENCH_FLEET_TICKS * followerCounts[c] ) );
+            DestroyFleetEngine( engine );
+        }
+    }
+}
@@ -0,0 +1,49 @@
+#include <stdlib.h>
+#include "Bench.h"
+#include "../recorder/Recorder.h"
+
+#define BENCH_FLIGHT_RECORDER_CAPACITY 4096
+#define BENCH_FLIGHT_RECORDER_OPS 2000000
+
+
+/********************************************************************************************************************************
+**  BenchFlightRecorder
+**
+**      Cost of recording one tick of a follower that is part way along its path.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void BenchFlightRecorder (void) {
+    pathFollowerParams_t params = BenchFollowerParams();
+    waypoint_t waypoints[3] = {{{0.0, 0.0}, 0.0, 60.0}, {{100.0, 0.0}, 20.0, 60.0}, {{100.0, 100.0}, 0.0, 60.0}};
+    waypoint_t *wps[3] = {&waypoints[0], &waypoints[1], &waypoints[2]};
+    flightRecord_t *records;
+    flightRecorder_t recorder;
+    pathSegmentsList_t path;
+    pathFollower_t follower;
+    transform2d_t pose = {{10.0, 1.0}, {0.0, 1.0}};
+    twist2d_t command;
+    char text[64];
+    double start;
+    long i;
+
+    records = aligned_alloc( 64, BENCH_FLIGHT_RECORDER_CAPACITY * sizeof( flightRecord_t ) );
+    InitFlightRecorder( &recorder, records, BENCH_FLIGHT_RECORDER_CAPACITY );
+    path = BuildPathFromWaypoints( wps, 3 );
+    InitPathFollower( &follower, &path, 0, &params );
+    command = GetPathFollowerUpdate( &follower, 0.0, 0.0, 0.0, &pose );
+
+    start = BenchNow();
+    for ( i = 0; i < BENCH_FLIGHT_RECORDER_OPS; i++ ) {
+        RecordFlightTick( &recorder, &follower, i * 0.005, &pose, &command );
+    }
+    snprintf( text, sizeof( text ), "capacity=%d record_bytes=%zu", BENCH_FLIGHT_RECORDER_CAPACITY, sizeof( flightRecord_t ) );
+    BenchReport( "FlightRecorderTick", text, ( BenchNow() - start ) / BENCH_FLIGHT_RECORDER_OPS );
+
+    ClearPath( &path );
+    ClearPathFollower( &follower );
+    free( records );
+}
@@ -0,0 +1,424 @@
+#ifndef BENCH_HOT_PATH_H
+#define BENCH_HOT_PATH_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "Bench.h"
+#include "../path/Path.h"
+#include "../utils/AllocTrack.h"
+
+#define BENCH_HOT_PATH_NUM_SIZES 6
+#define BENCH_HOT_PATH_MIN_NS 2e7
+#define BENCH_HOT_PATH_BATCH 64
+#define BENCH_HOT_PATH_DT 0.005
+
+static const int kBenchHotPathSizes[BENCH_HOT_PATH_NUM_SIZES] = {2, 10, 100, 1000, 10000, 100000};
+
+typedef struct benchHotPath {
+    int numWaypoints;
+    waypoint_t *waypoints;
+    waypoint_t **wps;
+    pathSegmentsList_t path;
+    pathSegmentsList_t built;
+    double length;
+    pathFollower_t follower;
+    transform2d_t pose;
+    motionProfileConstraints_t constraints;
+    motionProfileGoal_t goal;
+    motionProfileList_t profiles[BENCH_HOT_PATH_BATCH];
+    int numProfiles;
+    setpointGenerator_t generator;
+    profileFollower_t profileFollower;
+    trajectory_t trajectory;
+    motionState_t state;
+    double t;
+} benchHotPath_t;
+
+typedef struct benchHotPathOp {
+    const char *name;
+    int batch;                                      // Operations per timed call
+    void (*prepare)(benchHotPath_t *bench);         // Untimed, before every timed call (may be NULL)
+    void (*run)(benchHotPath_t *bench, int count);
+} benchHotPathOp_t;
+
+
+/********************************************************************************************************************************
+**  BenchHotPathSetup
+**
+**      Builds a zig-zag route of the given number of waypoints, 120 in apart with 24 in radius corners, and a follower on it
+**      with the robot 20 in along the first segment and 2 in off to the side.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void BenchHotPathSetup (benchHotPath_t *bench, int numWaypoints) {
+    pathFollowerParams_t params = BenchFollowerParams();
+    pathSegmentNode_t *node;
+    translation2d_t along, side;
+    int k;
+
+    bench->numWaypoints = numWaypoints;
+    bench->waypoints = malloc( numWaypoints * sizeof( waypoint_t ) );
+    bench->wps = malloc( numWaypoints * sizeof( waypoint_t * ) );
+    for ( k = 0; k < numWaypoints; k++ ) {
+        bench->waypoints[k].position.x_in = 120.0 * k;
+        bench->waypoints[k].position.y_in = ( k % 2 ) * 96.0;
+        bench->waypoints[k].radius = ( k == 0 || k == numWaypoints - 1 ) ? 0.0 : 24.0;
+        bench->waypoints[k].speed_ips = 60.0;
+        bench->wps[k] = &bench->waypoints[k];
+    }
+    bench->path = BuildPathFromWaypoints( bench->wps, numWaypoints );
+    bench->length = 0.0;
+    for ( node = bench->path.head; node; node = node->next ) {
+        bench->length += GetLength( &node->segment );
+    }
+    InitPathFollower( &bench->follower, &bench->path, 0, &params );
+    bench->built = (pathSegmentsList_t) {0};
+    bench->trajectory.points = NULL;
+    bench->trajectory.numPoints = 0;
+
+    bench->pose.rotation = TranslationDirection( &bench->path.head->segment.deltaStart );
+    along = TranslationScale( &bench->path.head->segment.deltaStart, 20.0 / TranslationNormal( &bench->path.head->segment.deltaStart ) );
+    side.x_in = -bench->pose.rotation.sinTheta_rad * 2.0;
+    side.y_in = bench->pose.rotation.cosTheta_rad * 2.0;
+    bench->pose.translation = TranslateAbyB( &bench->waypoints[0].position, &along );
+    bench->pose.translation = TranslateAbyB( &bench->pose.translation, &side );
+
+    // The speed benchmarks drive the whole route as one profile.
+    bench->constraints.maxAbsVel = params.profile_max_abs_vel;
+    bench->constraints.maxAbsAcc = params.profile_max_abs_acc;
+    bench->goal.pos = bench->length;
+    bench->goal.maxAbsVel = 0.0;
+    bench->goal.completionBehavior = VIOLATE_MAX_ACCEL;
+    bench->goal.posTolerance = params.goal_pos_tolerance;
+    bench->goal.velTolerance = params.goal_vel_tolerance;
+    bench->numProfiles = 0;
+    bench->generator = kInvalidSetpointGenerator;
+    InitProfileFollower( &bench->profileFollower );
+    bench->state.t = -1.0;
+    bench->t = 0.0;
+}
+
+
+/********************************************************************************************************************************
+**  BenchHotPathTeardown
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void BenchHotPathTeardown (benchHotPath_t *bench) {
+    int i;
+
+    for ( i = 0; i < bench->numProfiles; i++ ) {
+        ClearProfile( &bench->profiles[i] );
+    }
+    ClearSetpointGenerator( &bench->generator );
+    ClearProfileFollower( &bench->profileFollower );
+    free( bench->profileFollower.setpointGenerator );
+    ClearPath( &bench->built );
+    ClearTrajectory( &bench->trajectory );
+    ClearPath( &bench->path );
+    ClearPathFollower( &bench->follower );
+    free( bench->wps );
+    free( bench->waypoints );
+}
+
+
+/********************************************************************************************************************************
+**  BenchHotPathRestartSpeed
+**
+**      Starts the speed profile over from standstill when the next batch would run past its end, so that only sampling along
+**      the profile is timed.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void BenchHotPathRestartSpeed (benchHotPath_t *bench) {
+    if ( bench->state.t >= 0.0 && bench->state.t + ( BENCH_HOT_PATH_BATCH + 1 ) * BENCH_HOT_PATH_DT < bench->length / bench->constraints.maxAbsVel ) {
+        return;
+    }
+    bench->state.t = 0.0;
+    bench->state.pos = 0.0;
+    bench->state.vel = 0.0;
+    bench->state.acc = 0.0;
+    ClearSetpointGenerator( &bench->generator );
+    SetSetpointGenerator( &bench->generator, &bench->constraints, &bench->goal, &bench->state );
+
+    ClearProfileFollower( &bench->profileFollower );
+    free( bench->profileFollower.setpointGenerator );
+    InitProfileFollower( &bench->profileFollower );
+    SetProfileFollowerGains( &bench->profileFollower, 0.0, 0.0, 0.0, 1.0, 0.0 );
+    SetProfileFollowerGoalAndConstraints( &bench->profileFollower, &bench->goal, &bench->constraints );
+    ProfileFollowerUpdate( &bench->profileFollower, &bench->state, 0.0 );
+}
+
+
+/********************************************************************************************************************************
+**  BenchHotPathClearResults
+**
+**      Frees what the previous batch of GenerateProfile or BuildPathFromWaypoints produced, outside the timing.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void BenchHotPathClearResults (benchHotPath_t *bench) {
+    int i;
+
+    for ( i = 0; i < bench->numProfiles; i++ ) {
+        ClearProfile( &bench->profiles[i] );
+    }
+    bench->numProfiles = 0;
+    ClearPath( &bench->built );
+}
+
+
+/********************************************************************************************************************************
+**  BenchHotPathGenerateProfile
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void BenchHotPathGenerateProfile (benchHotPath_t *bench, int count) {
+    motionState_t start = {0.0, 0.0, 0.0, 0.0};
+
+    for ( ; bench->numProfiles < count; bench->numProfiles++ ) {
+        bench->profiles[bench->numProfiles] = GenerateProfile( &bench->constraints, &bench->goal, &start );
+    }
+}
+
+
+/********************************************************************************************************************************
+**  BenchHotPathGetSetpoint
+**
+**      Advances along the speed profile one control period per operation.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void BenchHotPathGetSetpoint (benchHotPath_t *bench, int count) {
+    setpoint_t setpoint;
+    int i;
+
+    for ( i = 0; i < count; i++ ) {
+        setpoint = GetSetpoint( &bench->generator, &bench->constraints, &bench->goal, &bench->state, bench->state.t + BENCH_HOT_PATH_DT );
+        bench->state = setpoint.motionState;
+    }
+}
+
+
+/********************************************************************************************************************************
+**  BenchHotPathProfileFollowerUpdate
+**
+**      Advances along the speed profile one control period per operation, with the robot tracking the setpoint exactly.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void BenchHotPathProfileFollowerUpdate (benchHotPath_t *bench, int count) {
+    motionState_t actual;
+    int i;
+
+    for ( i = 0; i < count; i++ ) {
+        actual = GetProfileSetpoint( &bench->profileFollower );
+        ProfileFollowerUpdate( &bench->profileFollower, &actual, actual.t + BENCH_HOT_PATH_DT );
+    }
+    bench->state = GetProfileSetpoint( &bench->profileFollower );
+}
+
+
+/********************************************************************************************************************************
+**  BenchHotPathGetTargetPoint
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void BenchHotPathGetTargetPoint (benchHotPath_t *bench, int count) {
+    volatile double sink;
+    targetPoint_t targetPoint;
+    int i;
+
+    for ( i = 0; i < count; i++ ) {
+        targetPoint = GetTargetPoint( &bench->path, &bench->follower.steeringController.lookahead, &bench->pose.translation );
+        sink = targetPoint.lookaheadPoint.x_in;
+    }
+    (void) sink;
+}
+
+
+/********************************************************************************************************************************
+**  BenchHotPathUsePathProfile
+**
+**      Switches the route over to one path-wide speed profile (see BuildPathProfile), once.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void BenchHotPathUsePathProfile (benchHotPath_t *bench) {
+    if ( !bench->path.profile ) {
+        BuildPathProfile( &bench->path );
+    }
+}
+
+
+/********************************************************************************************************************************
+**  BenchHotPathGetSteeringUpdate
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void BenchHotPathGetSteeringUpdate (benchHotPath_t *bench, int count) {
+    volatile double sink;
+    steeringComamnd_t command;
+    int i;
+
+    for ( i = 0; i < count; i++ ) {
+        command = GetSteeringUpdate( &bench->follower.steeringController, &bench->pose );
+        sink = command.delta.dtheta_rad;
+    }
+    (void) sink;
+}
+
+
+/********************************************************************************************************************************
+**  BenchHotPathGetPathFollowerUpdate
+**
+**      One whole control tick per operation, with the robot standing still at its pose.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void BenchHotPathGetPathFollowerUpdate (benchHotPath_t *bench, int count) {
+    volatile double sink;
+    twist2d_t command;
+    int i;
+
+    for ( i = 0; i < count; i++ ) {
+        bench->t += BENCH_HOT_PATH_DT;
+        command = GetPathFollowerUpdate( &bench->follower, bench->t, 0.0, 0.0, &bench->pose );
+        sink = command.dx_in;
+    }
+    (void) sink;
+}
+
+
+/********************************************************************************************************************************
+**  BenchHotPathBuildPath
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void BenchHotPathBuildPath (benchHotPath_t *bench, int count) {
+    bench->built = BuildPathFromWaypoints( bench->wps, bench->numWaypoints );
+}
+
+static const benchHotPathOp_t kBenchHotPathOps[] = {
+    {"GenerateProfile", BENCH_HOT_PATH_BATCH, BenchHotPathClearResults, BenchHotPathGenerateProfile},
+    {"GetSetpoint", BENCH_HOT_PATH_BATCH, BenchHotPathRestartSpeed, BenchHotPathGetSetpoint},
+    {"ProfileFollowerUpdate", BENCH_HOT_PATH_BATCH, BenchHotPathRestartSpeed, BenchHotPathProfileFollowerUpdate},
+    {"GetTargetPoint", BENCH_HOT_PATH_BATCH, NULL, BenchHotPathGetTargetPoint},
+    {"GetTargetPointPathProfile", BENCH_HOT_PATH_BATCH, BenchHotPathUsePathProfile, BenchHotPathGetTargetPoint},
+    {"GetSteeringUpdate", BENCH_HOT_PATH_BATCH, NULL, BenchHotPathGetSteeringUpdate},
+    {"GetPathFollowerUpdate", BENCH_HOT_PATH_BATCH, NULL, BenchHotPathGetPathFollowerUpdate},
+    {"BuildPathFromWaypoints", 1, BenchHotPathClearResults, BenchHotPathBuildPath},
+};
+
+/********************************************************************************************************************************
+**  BenchHotPathOps
+**
+**      Times each operation over routes of the first numSizes route sizes, reporting one line per size with the time and heap
+**      allocations per call, then the exponent of how the time grows with the number of waypoints.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void BenchHotPathOps (const benchHotPathOp_t *ops, int numOps, int numSizes) {
+    benchHotPath_t *bench;
+    allocStats_t stats;
+    double sizes[BENCH_HOT_PATH_NUM_SIZES], nsPerOp[BENCH_HOT_PATH_NUM_SIZES];
+    char text[96];
+    double start, elapsed;
+    long count, allocations;
+    int o, s;
+
+    bench = malloc( sizeof( benchHotPath_t ) );
+    StartAllocTracking();
+    for ( o = 0; o < numOps; o++ ) {
+        for ( s = 0; s < numSizes; s++ ) {
+            BenchHotPathSetup( bench, kBenchHotPathSizes[s] );
+            elapsed = 0.0;
+            count = 0;
+            allocations = 0;
+            // One untimed call first fills the profile node pool.
+            if ( ops[o].prepare ) {
+                ops[o].prepare( bench );
+            }
+            ops[o].run( bench, 1 );
+            while ( elapsed < BENCH_HOT_PATH_MIN_NS ) {
+                if ( ops[o].prepare ) {
+                    ops[o].prepare( bench );
+                }
+                GetAllocStats( &stats );
+                allocations -= stats.allocations;
+                start = BenchNow();
+                ops[o].run( bench, ops[o].batch );
+                elapsed += BenchNow() - start;
+                GetAllocStats( &stats );
+                allocations += stats.allocations;
+                count += ops[o].batch;
+            }
+            sizes[s] = kBenchHotPathSizes[s];
+            nsPerOp[s] = elapsed / count;
+            snprintf( text, sizeof( text ), "waypoints=%d allocs_per_op=%.2f", kBenchHotPathSizes[s], (double) allocations / count );
+            BenchReport( ops[o].name, text, nsPerOp[s] );
+            BenchHotPathTeardown( bench );
+        }
+        BenchReportScaling( ops[o].name, "waypoints", sizes, nsPerOp, numSizes );
+    }
+    StopAllocTracking();
+    free( bench );
+}
+
+
+/********************************************************************************************************************************
+**  BenchHotPath
+**
+**      Times every function on the control path over zig-zag routes of 2 to 100,000 waypoints.  The speed profile functions
+**      are given the whole route as their goal.  GetPathFollowerUpdate should stay at 0 allocations per call (see
+**      test_AllocTrack.h).
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void BenchHotPath (void) {
+    BenchHotPathOps( kBenchHotPathOps, sizeof( kBenchHotPathOps ) / sizeof( kBenchHotPathOps[0] ), BENCH_HOT_PATH_NUM_SIZES );
+}
+
+#endif
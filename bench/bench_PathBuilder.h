@@ -0,0 +1,190 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench_HotPath.h"
+#include "../utils/AllocTrack.h"
+#include "../utils/ThreadPool.h"
+
+#define BENCH_PARALLEL_FIRST_SIZE 3
+
+
+/********************************************************************************************************************************
+**  BenchPathHeap
+**
+**      Heap used by building a path from 2 to 100,000 waypoints: the allocations made, the peak heap held while building and
+**      that peak per waypoint.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void BenchPathHeap (void) {
+    benchHotPath_t *bench;
+    allocStats_t stats;
+    char text[128];
+    double start, elapsed;
+    int s;
+
+    bench = malloc( sizeof( benchHotPath_t ) );
+    for ( s = 0; s < BENCH_HOT_PATH_NUM_SIZES; s++ ) {
+        BenchHotPathSetup( bench, kBenchHotPathSizes[s] );
+        StartAllocTracking();
+        start = BenchNow();
+        BenchHotPathBuildPath( bench, 1 );
+        elapsed = BenchNow() - start;
+        StopAllocTracking();
+        GetAllocStats( &stats );
+        snprintf( text, sizeof( text ), "waypoints=%d allocations=%ld peak_bytes=%ld bytes_per_waypoint=%.1f", kBenchHotPathSizes[s],
+                  stats.allocations, stats.peakBytes, (double) stats.peakBytes / kBenchHotPathSizes[s] );
+        BenchReport( "PathHeap", text, elapsed );
+        BenchHotPathTeardown( bench );
+    }
+    free( bench );
+}
+
+
+/********************************************************************************************************************************
+**  BenchPathStream
+**
+**      Streaming a route in with AppendPathWaypoint against building it in one go, over routes of 2 to 100,000 waypoints:
+**      how long until the robot has a first segment to drive, and the cost of each further waypoint (ns_per_op), which
+**      should not grow with the route.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void BenchPathStream (void) {
+    benchHotPath_t *bench;
+    pathSegmentsList_t built;
+    pathBuilder_t builder;
+    char text[128];
+    double start, buildNs, firstNs, streamNs;
+    int s, k;
+
+    bench = malloc( sizeof( benchHotPath_t ) );
+    for ( s = 0; s < BENCH_HOT_PATH_NUM_SIZES; s++ ) {
+        BenchHotPathSetup( bench, kBenchHotPathSizes[s] );
+        start = BenchNow();
+        built = BuildPathFromWaypoints( bench->wps, bench->numWaypoints );
+        buildNs = BenchNow() - start;
+        ClearPath( &built );
+
+        start = BenchNow();
+        InitPathBuilder( &builder, &bench->built );
+        AppendPathWaypoint( &builder, bench->wps[0] );
+        AppendPathWaypoint( &builder, bench->wps[1] );
+        firstNs = BenchNow() - start;
+        start = BenchNow();
+        for ( k = 2; k < bench->numWaypoints; k++ ) {
+            AppendPathWaypoint( &builder, bench->wps[k] );
+        }
+        streamNs = BenchNow() - start;
+
+        snprintf( text, sizeof( text ), "waypoints=%d build_ns=%.0f first_segment_ns=%.0f", bench->numWaypoints, buildNs, firstNs );
+        BenchReport( "PathStream", text, bench->numWaypoints > 2 ? streamNs / ( bench->numWaypoints - 2 ) : 0.0 );
+        BenchHotPathTeardown( bench );
+    }
+    free( bench );
+}
+
+
+/********************************************************************************************************************************
+**  BenchParallelBuild
+**
+**      BuildPathFromWaypointsParallel against BuildPathFromWaypoints over routes of 1,000 to 100,000 waypoints, on 1, 2 and 4
+**      threads and one per core, reporting the speedup over the serial build.  Each build is timed best of three.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void BenchParallelBuild (void) {
+    const int threads[] = {1, 2, 4, 0};
+    benchHotPath_t *bench;
+    threadPool_t *pool;
+    pathSegmentsList_t built;
+    char text[128];
+    double start, elapsed, serialNs, parallelNs;
+    int s, t, run, numThreads;
+
+    bench = malloc( sizeof( benchHotPath_t ) );
+    for ( s = BENCH_PARALLEL_FIRST_SIZE; s < BENCH_HOT_PATH_NUM_SIZES; s++ ) {
+        BenchHotPathSetup( bench, kBenchHotPathSizes[s] );
+        serialNs = 1e18;
+        for ( run = 0; run < 3; run++ ) {
+            start = BenchNow();
+            built = BuildPathFromWaypoints( bench->wps, bench->numWaypoints );
+            elapsed = BenchNow() - start;
+            ClearPath( &built );
+            serialNs = fmin( serialNs, elapsed );
+        }
+        for ( t = 0; t < sizeof( threads ) / sizeof( threads[0] ); t++ ) {
+            numThreads = threads[t] ? threads[t] : GetNumCores();
+            pool = CreateThreadPool( numThreads );
+            parallelNs = 1e18;
+            for ( run = 0; run < 3; run++ ) {
+                start = BenchNow();
+                built = BuildPathFromWaypointsParallel( bench->wps, bench->numWaypoints, pool );
+                elapsed = BenchNow() - start;
+                ClearPath( &built );
+                parallelNs = fmin( parallelNs, elapsed );
+            }
+            DestroyThreadPool( pool );
+            snprintf( text, sizeof( text ), "waypoints=%d threads=%d cores=%d serial_ns=%.0f speedup=%.2f", bench->numWaypoints, numThreads,
+                      GetNumCores(), serialNs, serialNs / parallelNs );
+            BenchReport( "ParallelBuild", text, parallelNs );
+        }
+        BenchHotPathTeardown( bench );
+    }
+    free( bench );
+}
+
+
+/********************************************************************************************************************************
+**  BenchLazyBuild
+**
+**      BuildLazyPathFromWaypoints with a two segment window against BuildPathFromWaypoints over routes of 2 to 100,000
+**      waypoints: the time to build each and the peak heap each holds, with the lazy build's share of the full build.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void BenchLazyBuild (void) {
+    benchHotPath_t *bench;
+    pathSegmentsList_t built;
+    allocStats_t eager, lazy;
+    char text[160];
+    double start, eagerNs, lazyNs;
+    int s;
+
+    bench = malloc( sizeof( benchHotPath_t ) );
+    for ( s = 0; s < BENCH_HOT_PATH_NUM_SIZES; s++ ) {
+        BenchHotPathSetup( bench, kBenchHotPathSizes[s] );
+        StartAllocTracking();
+        start = BenchNow();
+        built = BuildPathFromWaypoints( bench->wps, bench->numWaypoints );
+        eagerNs = BenchNow() - start;
+        StopAllocTracking();
+        GetAllocStats( &eager );
+        ClearPath( &built );
+
+        StartAllocTracking();
+        start = BenchNow();
+        built = BuildLazyPathFromWaypoints( bench->wps, bench->numWaypoints, 2 );
+        lazyNs = BenchNow() - start;
+        StopAllocTracking();
+        GetAllocStats( &lazy );
+        ClearPath( &built );
+
+        snprintf( text, sizeof( text ), "waypoints=%d eager_ns=%.0f eager_peak_bytes=%ld lazy_peak_bytes=%ld time_ratio=%.2f heap_ratio=%.2f",
+                  bench->numWaypoints, eagerNs, eager.peakBytes, lazy.peakBytes, lazyNs / eagerNs, (double) lazy.peakBytes / eager.peakBytes );
+        BenchReport( "LazyBuild", text, lazyNs );
+        BenchHotPathTeardown( bench );
+    }
+    free( bench );
+}
@@ -0,0 +1,130 @@
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "Bench.h"
+#include "../path/Path.h"
+
+#define BENCH_PATH_CACHE_NUM_SIZES 4
+#define BENCH_PATH_CACHE_STARTS 20
+
+static const int kBenchPathCacheSizes[BENCH_PATH_CACHE_NUM_SIZES] = {10, 100, 1000, 10000};
+
+
+/********************************************************************************************************************************
+**  BenchPathCacheRemoveFiles
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void BenchPathCacheRemoveFiles (const char *directory) {
+    struct dirent *entry;
+    char fileName[512];
+    DIR *dir;
+
+    dir = opendir( directory );
+    if ( !dir ) {
+        return;
+    }
+    while ( ( entry = readdir( dir ) ) ) {
+        if ( entry->d_name[0] != '.' ) {
+            snprintf( fileName, sizeof( fileName ), "%s/%s", directory, entry->d_name );
+            unlink( fileName );
+        }
+    }
+    closedir( dir );
+}
+
+
+/********************************************************************************************************************************
+**  BenchPathCache
+**
+**      Startup cost of a route that is run again and again, over zig-zag routes of 10 to 10,000 waypoints: building it every
+**      time, taking it from the cache in memory, and loading it from the disk tier into an empty cache (as at the start of
+**      the next run of the program).  Each line reports the cache's hits and misses over its starts.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void BenchPathCache (void) {
+    waypoint_t *waypoints, **wps;
+    pathSegmentsList_t path;
+    pathCacheEntry_t *entry;
+    pathCacheStats_t stats;
+    pathCache_t cache;
+    char directory[] = "/tmp/benchpathcacheXXXXXX", text[128];
+    double start, elapsed;
+    long hits, misses, diskHits;
+    int s, k, size, run;
+
+    if ( !mkdtemp( directory ) ) {
+        return;
+    }
+    for ( s = 0; s < BENCH_PATH_CACHE_NUM_SIZES; s++ ) {
+        size = kBenchPathCacheSizes[s];
+        waypoints = malloc( size * sizeof( waypoint_t ) );
+        wps = malloc( size * sizeof( waypoint_t * ) );
+        for ( k = 0; k < size; k++ ) {
+            waypoints[k].position.x_in = 120.0 * k;
+            waypoints[k].position.y_in = ( k % 2 ) * 96.0;
+            waypoints[k].radius = ( k == 0 || k == size - 1 ) ? 0.0 : 24.0;
+            waypoints[k].speed_ips = 60.0;
+            wps[k] = &waypoints[k];
+        }
+
+        elapsed = 0.0;
+        for ( run = 0; run < BENCH_PATH_CACHE_STARTS; run++ ) {
+            start = BenchNow();
+            path = BuildPathFromWaypoints( wps, size );
+            elapsed += BenchNow() - start;
+            ClearPath( &path );
+        }
+        snprintf( text, sizeof( text ), "waypoints=%d mode=build", size );
+        BenchReport( "PathCacheStart", text, elapsed / BENCH_PATH_CACHE_STARTS );
+
+        // The first start builds the path, the rest are hits.
+        InitPathCache( &cache, (size_t) 1 << 30, NULL );
+        ReleaseCachedPath( &cache, AcquireCachedPath( &cache, wps, size, &path ) );
+        elapsed = 0.0;
+        for ( run = 0; run < BENCH_PATH_CACHE_STARTS; run++ ) {
+            start = BenchNow();
+            entry = AcquireCachedPath( &cache, wps, size, &path );
+            elapsed += BenchNow() - start;
+            ReleaseCachedPath( &cache, entry );
+        }
+        GetPathCacheStats( &cache, &stats );
+        DestroyPathCache( &cache );
+        snprintf( text, sizeof( text ), "waypoints=%d mode=memory hits=%ld misses=%ld", size, stats.hits, stats.misses );
+        BenchReport( "PathCacheStart", text, elapsed / BENCH_PATH_CACHE_STARTS );
+
+        // Store the path once, then time each start with a new cache so every start comes from disk.
+        InitPathCache( &cache, (size_t) 1 << 30, directory );
+        ReleaseCachedPath( &cache, AcquireCachedPath( &cache, wps, size, &path ) );
+        DestroyPathCache( &cache );
+        elapsed = 0.0;
+        hits = misses = diskHits = 0;
+        for ( run = 0; run < BENCH_PATH_CACHE_STARTS; run++ ) {
+            InitPathCache( &cache, (size_t) 1 << 30, directory );
+            start = BenchNow();
+            entry = AcquireCachedPath( &cache, wps, size, &path );
+            elapsed += BenchNow() - start;
+            ReleaseCachedPath( &cache, entry );
+            GetPathCacheStats( &cache, &stats );
+            hits += stats.hits;
+            misses += stats.misses;
+            diskHits += stats.diskHits;
+            DestroyPathCache( &cache );
+        }
+        snprintf( text, sizeof( text ), "waypoints=%d mode=disk hits=%ld misses=%ld disk_hits=%ld", size, hits, misses, diskHits );
+        BenchReport( "PathCacheStart", text, elapsed / BENCH_PATH_CACHE_STARTS );
+
+        BenchPathCacheRemoveFiles( directory );
+        free( wps );
+        free( waypoints );
+    }
+    rmdir( directory );
+}
@@ -0,0 +1,57 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench_HotPath.h"
+#include "../utils/ThreadPool.h"
+
+
+/********************************************************************************************************************************
+**  BenchPathPrefetch
+**
+**      What a transition to the next route costs the control thread, over routes of 2 to 100,000 waypoints: building it
+**      there and then, against asking for it with PrefetchPath while the current route is driven and taking it when done.
+**      The prefetch time covers both calls; the build itself runs on the worker, so with a single core the request may
+**      include it when the worker is scheduled at once.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void BenchPathPrefetch (void) {
+    benchHotPath_t *bench;
+    pathSegmentsList_t built, taken;
+    pathPrefetch_t prefetch;
+    motionState_t seed;
+    char text[128];
+    double start, buildNs, requestNs, takeNs;
+    int s;
+
+    if ( InitPathPrefetch( &prefetch ) ) {
+        return;
+    }
+    bench = malloc( sizeof( benchHotPath_t ) );
+    for ( s = 0; s < BENCH_HOT_PATH_NUM_SIZES; s++ ) {
+        BenchHotPathSetup( bench, kBenchHotPathSizes[s] );
+        seed = GetLastMotionState( &bench->path );
+        start = BenchNow();
+        built = BuildPathFromState( bench->wps, bench->numWaypoints, &seed );
+        buildNs = BenchNow() - start;
+        ClearPath( &built );
+
+        start = BenchNow();
+        PrefetchPath( &prefetch, bench->wps, bench->numWaypoints, &bench->path );
+        requestNs = BenchNow() - start;
+        do {
+            start = BenchNow();
+        } while ( !TakePrefetchedPath( &prefetch, &taken ) );
+        takeNs = BenchNow() - start;
+        ClearPath( &taken );
+
+        snprintf( text, sizeof( text ), "waypoints=%d cores=%d build_ns=%.0f request_ns=%.0f take_ns=%.0f", bench->numWaypoints, GetNumCores(),
+                  buildNs, requestNs, takeNs );
+        BenchReport( "PathPrefetch", text, requestNs + takeNs );
+        BenchHotPathTeardown( bench );
+    }
+    free( bench );
+    DestroyPathPrefetch( &prefetch );
+}
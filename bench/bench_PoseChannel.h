@@ -0,0 +1,95 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "Bench.h"
+#include "../robot/PoseChannel.h"
+#include "../utils/Histogram.h"
+
+#define BENCH_POSE_CHANNEL_OPS 10000000
+#define BENCH_POSE_CHANNEL_LATENCY_SAMPLES 200000
+#define BENCH_POSE_CHANNEL_LATENCY_NS 2e9
+
+typedef struct benchPoseChannelLatency {
+    poseChannel_t channel;
+    _Atomic int stop;
+} benchPoseChannelLatency_t;
+
+
+/********************************************************************************************************************************
+**  BenchPoseChannelWriter
+**
+**      Publishes poses stamped with the time they were published at until told to stop.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void * BenchPoseChannelWriter (void *arg) {
+    benchPoseChannelLatency_t *latency = arg;
+    transform2d_t pose = {{0.0, 0.0}, {0.0, 1.0}};
+
+    while ( !atomic_load( &latency->stop ) ) {
+        pose.translation.x_in += 1.0;
+        PublishPose( &latency->channel, &pose, BenchNow() );
+    }
+    return NULL;
+}
+
+
+/********************************************************************************************************************************
+**  BenchPoseChannel
+**
+**      Cost of a publish and of a read on one thread, then the publish-to-read latency between two threads.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void BenchPoseChannel (void) {
+    benchPoseChannelLatency_t latency;
+    timestampedPose_t sample;
+    transform2d_t pose = {{0.0, 0.0}, {0.0, 1.0}};
+    histogram_t histogram;
+    pthread_t writer;
+    char text[128];
+    double start, now, deadline;
+    volatile long fresh;
+    long i;
+
+    InitPoseChannel( &latency.channel );
+    start = BenchNow();
+    for ( i = 0; i < BENCH_POSE_CHANNEL_OPS; i++ ) {
+        pose.translation.x_in = i;
+        PublishPose( &latency.channel, &pose, i );
+    }
+    BenchReport( "PoseChannelPublish", "", ( BenchNow() - start ) / BENCH_POSE_CHANNEL_OPS );
+
+    fresh = 0;
+    start = BenchNow();
+    for ( i = 0; i < BENCH_POSE_CHANNEL_OPS; i++ ) {
+        fresh += ReadLatestPose( &latency.channel, &sample );
+    }
+    BenchReport( "PoseChannelRead", "", ( BenchNow() - start ) / BENCH_POSE_CHANNEL_OPS );
+
+    InitPoseChannel( &latency.channel );
+    atomic_init( &latency.stop, 0 );
+    ClearHistogram( &histogram );
+    pthread_create( &writer, NULL, BenchPoseChannelWriter, &latency );
+    // With fewer cores than threads the reader only sees a new pose once per time slice, so the run is also time-bounded.
+    deadline = BenchNow() + BENCH_POSE_CHANNEL_LATENCY_NS;
+    now = 0.0;
+    while ( histogram.count < BENCH_POSE_CHANNEL_LATENCY_SAMPLES && now < deadline ) {
+        now = BenchNow();
+        if ( ReadLatestPose( &latency.channel, &sample ) ) {
+            HistogramAdd( &histogram, (uint64_t) ( now > sample.t ? now - sample.t : 0.0 ) );
+        }
+    }
+    atomic_store( &latency.stop, 1 );
+    pthread_join( writer, NULL );
+    snprintf( text, sizeof( text ), "samples=%u p50_ns=%llu p99_ns=%llu max_ns=%llu", histogram.count,
+              (unsigned long long) HistogramPercentile( &histogram, 50.0 ),
+              (unsigned long long) HistogramPercentile( &histogram, 99.0 ), (unsigned long long) histogram.max );
+    BenchReport( "PoseChannelLatency", text, HistogramMean( &histogram ) );
+}
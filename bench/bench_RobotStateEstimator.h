@@ -0,0 +1,90 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "Bench.h"
+#include "../robot/RobotStateEstimator.h"
+
+#define BENCH_POSE_HISTORY_OPS 1000000
+#define BENCH_POSE_FILTER_OPS 10000000
+
+
+/********************************************************************************************************************************
+**  BenchPoseHistory
+**
+**      Cost of recording a pose, and of looking one up at a time spread over a full history (see GetPoseAtTime).
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void BenchPoseHistory (void) {
+    poseHistory_t *history;
+    transform2d_t pose = {{0.0, 0.0}, {0.0, 1.0}};
+    char text[64];
+    double start;
+    volatile double sink;
+    long i;
+
+    history = malloc( sizeof( poseHistory_t ) );
+    InitPoseHistory( history );
+    start = BenchNow();
+    for ( i = 0; i < BENCH_POSE_HISTORY_OPS; i++ ) {
+        pose.translation.x_in = i;
+        RecordPose( history, &pose, i * 0.01 );
+    }
+    BenchReport( "PoseHistoryRecord", "", ( BenchNow() - start ) / BENCH_POSE_HISTORY_OPS );
+
+    start = BenchNow();
+    for ( i = 0; i < BENCH_POSE_HISTORY_OPS; i++ ) {
+        GetPoseAtTime( history, ( BENCH_POSE_HISTORY_OPS - 1 - ( i * 7919 ) % ( POSE_HISTORY_SIZE - 1 ) ) * 0.01 - 0.005, &pose );
+        sink = pose.translation.x_in;
+    }
+    (void) sink;
+    snprintf( text, sizeof( text ), "history=%d", POSE_HISTORY_SIZE );
+    BenchReport( "PoseHistoryLookup", text, ( BenchNow() - start ) / BENCH_POSE_HISTORY_OPS );
+    free( history );
+}
+
+
+/********************************************************************************************************************************
+**  BenchPoseFilter
+**
+**      Cost of a pose filter step (see UpdatePoseFilter), of its predict on its own and of a heading correction, the robot
+**      driving a gentle curve.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void BenchPoseFilter (void) {
+    poseFilter_t filter;
+    transform2d_t pose;
+    double start;
+    volatile double sink;
+    long i;
+
+    InitPoseFilter( &filter, 24.0, 1E-4, 1E-4 );
+    start = BenchNow();
+    for ( i = 1; i <= BENCH_POSE_FILTER_OPS; i++ ) {
+        pose = UpdatePoseFilter( &filter, i * 0.01, i * 0.47, i * 0.49, 0.0008 / 0.01 );
+    }
+    sink = pose.translation.x_in;
+    BenchReport( "PoseFilterUpdate", "", ( BenchNow() - start ) / BENCH_POSE_FILTER_OPS );
+
+    InitPoseFilter( &filter, 24.0, 1E-4, 1E-4 );
+    start = BenchNow();
+    for ( i = 1; i <= BENCH_POSE_FILTER_OPS; i++ ) {
+        PredictPoseFilter( &filter, i * 0.01, i * 0.47, i * 0.49 );
+    }
+    sink = filter.x_in;
+    BenchReport( "PoseFilterPredict", "", ( BenchNow() - start ) / BENCH_POSE_FILTER_OPS );
+
+    start = BenchNow();
+    for ( i = 1; i <= BENCH_POSE_FILTER_OPS; i++ ) {
+        CorrectPoseFilterHeading( &filter, i * 1E-9, 1E-4 );
+    }
+    sink = filter.theta_rad;
+    (void) sink;
+    BenchReport( "PoseFilterCorrect", "", ( BenchNow() - start ) / BENCH_POSE_FILTER_OPS );
+}
@@ -0,0 +1,57 @@
+#include <string.h>
+#include "bench_FleetEngine.h"
+#include "bench_PoseChannel.h"
+#include "bench_RobotStateEstimator.h"
+#include "bench_FlightRecorder.h"
+#include "bench_HotPath.h"
+#include "bench_Trajectory.h"
+#include "bench_PathBuilder.h"
+#include "bench_PathPrefetch.h"
+#include "bench_PathCache.h"
+
+typedef struct benchmark {
+    const char *name;
+    void (*run)(void);
+} benchmark_t;
+
+static const benchmark_t kBenchmarks[] = {
+    {"FleetEngine", BenchFleetEngine},
+    {"PoseChannel", BenchPoseChannel},
+    {"PoseHistory", BenchPoseHistory},
+    {"PoseFilter", BenchPoseFilter},
+    {"FlightRecorder", BenchFlightRecorder},
+    {"HotPath", BenchHotPath},
+    {"PathHeap", BenchPathHeap},
+    {"Trajectory", BenchTrajectory},
+    {"PathStream", BenchPathStream},
+    {"ParallelBuild", BenchParallelBuild},
+    {"LazyBuild", BenchLazyBuild},
+    {"PathPrefetch", BenchPathPrefetch},
+    {"PathCache", BenchPathCache},
+};
+
+
+/********************************************************************************************************************************
+**  main
+**
+**      Runs every benchmark, or only those named on the command line.
+**
+********************************************************************************************************************************/
+int main(int argc, char *argv[]) {
+    int i, j, count;
+
+    count = sizeof( kBenchmarks ) / sizeof( kBenchmarks[0] );
+    for ( i = 0; i < count; i++ ) {
+        if ( argc < 2 ) {
+            kBenchmarks[i].run();
+            continue;
+        }
+        for ( j = 1; j < argc; j++ ) {
+            if ( !strcmp( argv[j], kBenchmarks[i].name ) ) {
+                kBenchmarks[i].run();
+            }
+        }
+    }
+
+    return 0;
+}
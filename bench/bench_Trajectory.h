@@ -0,0 +1,70 @@
+#include "bench_HotPath.h"
+
+#define BENCH_TRAJECTORY_NUM_SIZES 4
+
+
+/********************************************************************************************************************************
+**  BenchHotPathClearTrajectory
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void BenchHotPathClearTrajectory (benchHotPath_t *bench) {
+    ClearTrajectory( &bench->trajectory );
+}
+
+
+/********************************************************************************************************************************
+**  BenchHotPathCompileTrajectory
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void BenchHotPathCompileTrajectory (benchHotPath_t *bench, int count) {
+    CompileTrajectory( &bench->path, BENCH_HOT_PATH_DT, &bench->trajectory );
+}
+
+
+/********************************************************************************************************************************
+**  BenchHotPathFollowTrajectory
+**
+**      Switches the follower to the compiled trajectory of its route, once per setup.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void BenchHotPathFollowTrajectory (benchHotPath_t *bench) {
+    if ( !bench->trajectory.points ) {
+        CompileTrajectory( &bench->path, BENCH_HOT_PATH_DT, &bench->trajectory );
+        SetPathFollowerTrajectory( &bench->follower, &bench->trajectory, 0.0 );
+    }
+}
+
+
+// Trajectory tables grow with the driving time of the route, so these stop at 1,000 waypoints.
+static const benchHotPathOp_t kBenchTrajectoryOps[] = {
+    {"CompileTrajectory", 1, BenchHotPathClearTrajectory, BenchHotPathCompileTrajectory},
+    {"GetTrajectoryFollowerUpdate", BENCH_HOT_PATH_BATCH, BenchHotPathFollowTrajectory, BenchHotPathGetPathFollowerUpdate},
+};
+
+
+/********************************************************************************************************************************
+**  BenchTrajectory
+**
+**      Compiling a route into a trajectory table, and a control tick following the table, over routes of 2 to 1,000
+**      waypoints.  The tick should not grow with the route, unlike GetPathFollowerUpdate in BenchHotPath.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void BenchTrajectory (void) {
+    BenchHotPathOps( kBenchTrajectoryOps, sizeof( kBenchTrajectoryOps ) / sizeof( kBenchTrajectoryOps[0] ), BENCH_TRAJECTORY_NUM_SIZES );
+}
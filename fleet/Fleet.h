@@ -0,0 +1,40 @@
+#ifndef FLEET_H
+#define FLEET_H
+
+#include "Geometry.h"
+#include "Path.h"
+#include "ThreadPool.h"
+
+#define FLEET_CACHE_LINE 64
+
+// Everything one follower touches during a tick lives in its own slot.  Slots are cache-line aligned (and so padded to a
+// multiple of the line size) so that followers stepped on different cores never share a line.
+typedef struct fleetSlot {
+    _Alignas(FLEET_CACHE_LINE) pathFollower_t follower;
+    pathSegmentsList_t path;
+    transform2d_t pose;
+    double displacement;
+    double velocity;
+    twist2d_t command;
+    int active;
+    int finished;
+} fleetSlot_t;
+
+typedef struct fleetEngine {
+    fleetSlot_t *slots;
+    int capacity;
+    int numSlots;
+    double t;
+    threadPool_t *pool;
+} fleetEngine_t;
+
+
+// FleetEngine.c
+fleetEngine_t * CreateFleetEngine (int capacity, int numThreads);
+void DestroyFleetEngine (fleetEngine_t *engine);
+int AddFleetFollower (fleetEngine_t *engine, pathSegmentsList_t *path, int reversed, pathFollowerParams_t *params, transform2d_t *startPose);
+void SetFleetFollowerState (fleetEngine_t *engine, int slot, transform2d_t *pose, double displacement, double velocity);
+void StepFleet (fleetEngine_t *engine, double t);
+int FleetIsFinished (fleetEngine_t *engine);
+
+#endif
@@ -0,0 +1,182 @@
+#include <stdlib.h>
+#include <string.h>
+#include "Fleet.h"
+
+
+/********************************************************************************************************************************
+**  CreateFleetEngine
+**
+**      Input:
+**          int capacity            Maximum number of followers the engine can hold
+**          int numThreads          Number of threads stepping the followers (1 steps them on the calling thread)
+**
+**      Output: The new engine, or NULL if it could not be created.
+**
+********************************************************************************************************************************/
+fleetEngine_t * CreateFleetEngine (int capacity, int numThreads) {
+    fleetEngine_t *engine;
+
+    engine = malloc( sizeof( fleetEngine_t ) );
+    if ( !engine ) {
+        return NULL;
+    }
+    engine->slots = aligned_alloc( FLEET_CACHE_LINE, capacity * sizeof( fleetSlot_t ) );
+    engine->pool = CreateThreadPool( numThreads );
+    if ( !engine->slots || !engine->pool ) {
+        free( engine->slots );
+        if ( engine->pool ) {
+            DestroyThreadPool( engine->pool );
+        }
+        free( engine );
+        return NULL;
+    }
+    memset( engine->slots, 0, capacity * sizeof( fleetSlot_t ) );
+    engine->capacity = capacity;
+    engine->numSlots = 0;
+    engine->t = 0.0;
+
+    return engine;
+}
+
+
+/********************************************************************************************************************************
+**  DestroyFleetEngine
+**
+**      Frees the engine along with the paths it took over.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void DestroyFleetEngine (fleetEngine_t *engine) {
+    int i;
+
+    for ( i = 0; i < engine->numSlots; i++ ) {
+        ClearPath( &engine->slots[i].path );
+        ClearPathFollower( &engine->slots[i].follower );
+    }
+    DestroyThreadPool( engine->pool );
+    free( engine->slots );
+    free( engine );
+}
+
+
+/********************************************************************************************************************************
+**  AddFleetFollower
+**
+**      Adds a follower for the given path.  The engine takes over the path's segments; the caller's list is emptied.
+**
+**      Input:
+**
+**      Output: The slot index of the new follower, or -1 if the engine is full.
+**
+********************************************************************************************************************************/
+int AddFleetFollower (fleetEngine_t *engine, pathSegmentsList_t *path, int reversed, pathFollowerParams_t *params, transform2d_t *startPose) {
+    fleetSlot_t *slot;
+
+    if ( engine->numSlots >= engine->capacity ) {
+        return -1;
+    }
+    slot = &engine->slots[engine->numSlots];
+    slot->path = *path;
+    path->head = NULL;
+    path->tail = NULL;
+    path->length = 0;
+    path->nodes = NULL;
+    path->capacity = 0;
+    path->profileWindow = 0;
+    path->profile = NULL;
+    path->profileLength = 0;
+    path->route = NULL;
+    InitPathFollower( &slot->follower, &slot->path, reversed, params );
+    slot->pose = *startPose;
+    slot->displacement = 0.0;
+    slot->velocity = 0.0;
+    slot->command.dx_in = 0.0;
+    slot->command.dy_in = 0.0;
+    slot->command.dtheta_rad = 0.0;
+    slot->active = slot->path.length > 0;
+    slot->finished = !slot->active;
+
+    engine->numSlots += 1;
+    return engine->numSlots - 1;
+}
+
+
+/********************************************************************************************************************************
+**  SetFleetFollowerState
+**
+**      Feeds the latest measurements for one follower, used by the next StepFleet.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void SetFleetFollowerState (fleetEngine_t *engine, int slot, transform2d_t *pose, double displacement, double velocity) {
+    engine->slots[slot].pose = *pose;
+    engine->slots[slot].displacement = displacement;
+    engine->slots[slot].velocity = velocity;
+}
+
+
+/********************************************************************************************************************************
+**  StepFleetSlot
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+static void StepFleetSlot (void *context, int index) {
+    fleetEngine_t *engine = context;
+    fleetSlot_t *slot = &engine->slots[index];
+
+    if ( !slot->active || slot->finished ) {
+        slot->command.dx_in = 0.0;
+        slot->command.dy_in = 0.0;
+        slot->command.dtheta_rad = 0.0;
+        return;
+    }
+    slot->command = GetPathFollowerUpdate( &slot->follower, engine->t, slot->displacement, slot->velocity, &slot->pose );
+    slot->finished = PathFollowerIsFinished( &slot->follower );
+}
+
+
+/********************************************************************************************************************************
+**  StepFleet
+**
+**      Runs one control tick of every follower, spread over the engine's threads.  Each follower only reads and writes its own
+**      slot, so the result does not depend on the number of threads.  The commands are in each slot once this returns.
+**
+**      Input:
+**          double t                The time of this tick
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void StepFleet (fleetEngine_t *engine, double t) {
+    engine->t = t;
+    RunThreadPool( engine->pool, StepFleetSlot, engine, engine->numSlots );
+}
+
+
+/********************************************************************************************************************************
+**  FleetIsFinished
+**
+**      Input:
+**
+**      Output: Returns 1 once every follower has finished its path.
+**
+********************************************************************************************************************************/
+int FleetIsFinished (fleetEngine_t *engine) {
+    int i;
+
+    for ( i = 0; i < engine->numSlots; i++ ) {
+        if ( !engine->slots[i].finished ) {
+            return 0;
+        }
+    }
+    return 1;
+}
@@ -0,0 +1,218 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include "ControlLoop.h"
+
+#define CONTROLLOOP_STACK_PREFAULT (256 * 1024)
+#define NSEC_PER_SEC 1000000000LL
+
+
+/********************************************************************************************************************************
+**  TimespecToNs
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+static int64_t TimespecToNs (struct timespec *ts) {
+    return (int64_t) ts->tv_sec * NSEC_PER_SEC + ts->tv_nsec;
+}
+
+
+/********************************************************************************************************************************
+**  NsToTimespec
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+static struct timespec NsToTimespec (int64_t ns) {
+    struct timespec ts;
+
+    ts.tv_sec = ns / NSEC_PER_SEC;
+    ts.tv_nsec = ns % NSEC_PER_SEC;
+    return ts;
+}
+
+
+/********************************************************************************************************************************
+**  MonotonicNs
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+static int64_t MonotonicNs (void) {
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return TimespecToNs( &ts );
+}
+
+
+/********************************************************************************************************************************
+**  PrefaultStack
+**
+**      Touches a block of stack so the pages are resident (and locked) before the loop starts.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+static void PrefaultStack (void) {
+    volatile unsigned char stack[CONTROLLOOP_STACK_PREFAULT];
+
+    memset( (void *) stack, 0, sizeof( stack ) );
+}
+
+
+/********************************************************************************************************************************
+**  SetupRealtime
+**
+**      Applies the requested memory locking, CPU affinity and scheduling to the calling thread.  Anything that cannot be
+**      applied (usually for lack of privileges) is reported and skipped; the stats record what actually took effect.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+static void SetupRealtime (controlLoopConfig_t *config, controlLoopStats_t *stats) {
+    struct sched_param param;
+    cpu_set_t cpus;
+    int err;
+
+    stats->memoryLocked = 0;
+    stats->appliedCpu = -1;
+    stats->appliedPriority = 0;
+
+    if ( config->lockMemory ) {
+        if ( mlockall( MCL_CURRENT | MCL_FUTURE ) == 0 ) {
+            stats->memoryLocked = 1;
+        } else {
+            fprintf( stderr, "ControlLoop: mlockall failed: %s\n", strerror( errno ) );
+        }
+        PrefaultStack();
+    }
+
+    if ( config->cpu >= 0 ) {
+        CPU_ZERO( &cpus );
+        CPU_SET( config->cpu, &cpus );
+        err = pthread_setaffinity_np( pthread_self(), sizeof( cpus ), &cpus );
+        if ( err == 0 ) {
+            stats->appliedCpu = config->cpu;
+        } else {
+            fprintf( stderr, "ControlLoop: pinning to cpu %d failed: %s\n", config->cpu, strerror( err ) );
+        }
+    }
+
+    if ( config->realtimePriority > 0 ) {
+        param.sched_priority = config->realtimePriority;
+        err = pthread_setschedparam( pthread_self(), SCHED_FIFO, &param );
+        if ( err == 0 ) {
+            stats->appliedPriority = config->realtimePriority;
+        } else {
+            fprintf( stderr, "ControlLoop: SCHED_FIFO priority %d failed: %s\n", config->realtimePriority, strerror( err ) );
+        }
+    }
+}
+
+
+/********************************************************************************************************************************
+**  RunControlLoop
+**
+**      Calls tick once per period until it returns non-zero or config->iterations ticks have run (0 runs until stopped).
+**      The loop sleeps with clock_nanosleep on absolute CLOCK_MONOTONIC deadlines.  When a tick runs past one or more later
+**      deadlines those periods are skipped, keeping the original phase, and counted as deadline misses.
+**
+**      Input:
+**          controlLoopConfig_t config      Rate and real-time settings
+**          controlLoopTick_t tick          Control function run every period
+**          void *context                   Passed through to tick
+**
+**      Output:
+**          controlLoopStats_t stats        Timing statistics of the run
+**          int                             Return 0, or the clock_nanosleep error that ended the loop
+**
+********************************************************************************************************************************/
+int RunControlLoop (controlLoopConfig_t *config, controlLoopTick_t tick, void *context, controlLoopStats_t *stats) {
+    struct timespec deadlineTs;
+    int64_t start, deadline, wake, lastWake, done, interval;
+    int err, stop;
+
+    ClearHistogram( &stats->wakeLatency );
+    ClearHistogram( &stats->execution );
+    ClearHistogram( &stats->jitter );
+    ClearHistogram( &stats->overrun );
+    stats->ticks = 0;
+    stats->deadlineMisses = 0;
+    stats->skippedPeriods = 0;
+    SetupRealtime( config, stats );
+
+    start = MonotonicNs() + config->period_ns;
+    deadline = start;
+    lastWake = 0;
+    stop = 0;
+    while ( !stop && ( config->iterations <= 0 || stats->ticks < config->iterations ) ) {
+        deadlineTs = NsToTimespec( deadline );
+        do {
+            err = clock_nanosleep( CLOCK_MONOTONIC, TIMER_ABSTIME, &deadlineTs, NULL );
+        } while ( err == EINTR );
+        if ( err ) {
+            return err;
+        }
+
+        wake = MonotonicNs();
+        HistogramAdd( &stats->wakeLatency, (uint64_t) ( wake > deadline ? wake - deadline : 0 ) );
+        if ( lastWake ) {
+            interval = wake - lastWake;
+            HistogramAdd( &stats->jitter, (uint64_t) ( interval > config->period_ns ? interval - config->period_ns : config->period_ns - interval ) );
+        }
+        lastWake = wake;
+
+        stop = tick( context, ( deadline - start ) / 1e9 );
+        done = MonotonicNs();
+        HistogramAdd( &stats->execution, (uint64_t) ( done - wake ) );
+        stats->ticks += 1;
+
+        deadline += config->period_ns;
+        if ( done > deadline ) {
+            stats->deadlineMisses += 1;
+            HistogramAdd( &stats->overrun, (uint64_t) ( done - deadline ) );
+            while ( deadline < done ) {
+                deadline += config->period_ns;
+                stats->skippedPeriods += 1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+
+/********************************************************************************************************************************
+**  PrintControlLoopStats
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void PrintControlLoopStats (controlLoopConfig_t *config, controlLoopStats_t *stats) {
+    printf( "period=%lld ns ticks=%ld deadline_misses=%ld skipped_periods=%ld priority=%d cpu=%d memory_locked=%d\n",
+            (long long) config->period_ns, stats->ticks, stats->deadlineMisses, stats->skippedPeriods, stats->appliedPriority,
+            stats->appliedCpu, stats->memoryLocked );
+    PrintHistogram( &stats->wakeLatency, "wake_latency", "ns" );
+    PrintHistogram( &stats->execution, "execution", "ns" );
+    PrintHistogram( &stats->jitter, "jitter", "ns" );
+    PrintHistogram( &stats->overrun, "overrun", "ns" );
+}
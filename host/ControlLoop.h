@@ -0,0 +1,50 @@
+#ifndef CONTROLLOOP_H
+#define CONTROLLOOP_H
+
+#include <stdint.h>
+#include "Histogram.h"
+
+// period_ns
+// Control period; ticks are released on absolute deadlines start + k * period_ns, so a late tick never shifts later ones.
+//
+// realtimePriority
+// SCHED_FIFO priority (1-99) for the loop thread, 0 keeps the default scheduler.
+//
+// cpu
+// CPU the loop thread is pinned to, -1 leaves the affinity alone.
+//
+// lockMemory
+// Lock all current and future pages (mlockall) and prefault the stack, so the loop never takes a page fault.
+typedef struct controlLoopConfig {
+    int64_t period_ns;
+    long iterations;
+    int realtimePriority;
+    int cpu;
+    int lockMemory;
+} controlLoopConfig_t;
+
+// wakeLatency     Time from the deadline to the loop actually waking up.
+// execution       Time spent in the tick function.
+// jitter          Deviation of the interval between two wake ups from the period.
+// overrun         For ticks that finish after the next deadline, how far past it they finish.
+typedef struct controlLoopStats {
+    histogram_t wakeLatency;
+    histogram_t execution;
+    histogram_t jitter;
+    histogram_t overrun;
+    long ticks;
+    long deadlineMisses;
+    long skippedPeriods;
+    int appliedPriority;
+    int appliedCpu;
+    int memoryLocked;
+} controlLoopStats_t;
+
+// Called once per period with the time since the loop started, returns non-zero to stop the loop.
+typedef int (*controlLoopTick_t)(void *context, double t);
+
+// ControlLoop.c
+int RunControlLoop (controlLoopConfig_t *config, controlLoopTick_t tick, void *context, controlLoopStats_t *stats);
+void PrintControlLoopStats (controlLoopConfig_t *config, controlLoopStats_t *stats);
+
+#endif
@@ -0,0 +1,172 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "ControlLoop.h"
+#include "Instrument.h"
+#include "Recorder.h"
+#include "Path.h"
+#include "RobotStateEstimator.h"
+
+#define RUNNER_FLIGHT_RECORDS 8192
+#define RUNNER_TRACK_WIDTH_IN 24.0
+
+// The follower only ever sees the pose the estimator last published to channel, as it would with the estimator on its own
+// thread; the simulated drive feeds the estimator wheel distances.
+typedef struct runnerState {
+    pathFollowerParams_t params;
+    pathSegmentsList_t path;
+    pathFollower_t follower;
+    robotStateEstimator_t estimator;
+    poseChannel_t channel;
+    double leftDistance_in;
+    double rightDistance_in;
+    double displacement;
+    double velocity;
+    double lastT;
+    double pathStartT;
+    int pathsCompleted;
+    flightRecorder_t *recorder;
+} runnerState_t;
+
+
+/********************************************************************************************************************************
+**  StartRoute
+**
+**      Builds the demo route and puts the simulated robot back at its start, publishing the start pose.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void StartRoute (runnerState_t *state, double t) {
+    waypoint_t waypoints[6] = {{{0.0, 0.0}, 0.0, 60.0}, {{120.0, 0.0}, 24.0, 60.0}, {{120.0, 120.0}, 24.0, 48.0},
+                               {{240.0, 120.0}, 24.0, 60.0}, {{240.0, 0.0}, 24.0, 60.0}, {{360.0, 0.0}, 0.0, 60.0}};
+    waypoint_t *wps[6];
+    transform2d_t start;
+    int i;
+
+    for ( i = 0; i < 6; i++ ) {
+        wps[i] = &waypoints[i];
+    }
+    ClearPath( &state->path );
+    state->path = BuildPathFromWaypoints( wps, 6 );
+    InitPathFollower( &state->follower, &state->path, 0, &state->params );
+    start.translation = waypoints[0].position;
+    start.rotation.sinTheta_rad = 0.0;
+    start.rotation.cosTheta_rad = 1.0;
+    ResetRobotStateEstimator( &state->estimator, &start, t, state->leftDistance_in, state->rightDistance_in );
+    state->displacement = 0.0;
+    state->velocity = 0.0;
+    state->pathStartT = t;
+}
+
+
+/********************************************************************************************************************************
+**  RunnerTick
+**
+**      One control period: run the path follower on the latest pose from the channel, then drive the simulated wheels by
+**      the command and update the estimator from them, which publishes the pose the next period reads.
+**
+**      Input:
+**
+**      Output: Always 0, the loop runs for the configured number of ticks.
+**
+********************************************************************************************************************************/
+int RunnerTick (void *context, double t) {
+    runnerState_t *state = context;
+    timestampedPose_t sample;
+    twist2d_t command;
+    double dt, distance_in, turn_in;
+
+    if ( PathFollowerIsFinished( &state->follower ) ) {
+        state->pathsCompleted += 1;
+        ClearPathFollower( &state->follower );
+        StartRoute( state, t );
+    }
+    ReadLatestPose( &state->channel, &sample );
+    command = GetPathFollowerUpdate( &state->follower, t - state->pathStartT, state->displacement, state->velocity, &sample.pose );
+    if ( state->recorder ) {
+        RecordFlightTick( state->recorder, &state->follower, t - state->pathStartT, &sample.pose, &command );
+    }
+
+    dt = t - state->lastT;
+    distance_in = command.dx_in * dt;
+    turn_in = 0.5 * RUNNER_TRACK_WIDTH_IN * command.dtheta_rad * dt;
+    state->leftDistance_in += distance_in - turn_in;
+    state->rightDistance_in += distance_in + turn_in;
+    UpdateRobotStateEstimator( &state->estimator, t, state->leftDistance_in, state->rightDistance_in );
+    state->displacement += distance_in;
+    state->velocity = command.dx_in;
+    state->lastT = t;
+
+    return 0;
+}
+
+
+/********************************************************************************************************************************
+**  main
+**
+**      Runs the path follower against a simulated robot at a fixed rate and prints the loop timing statistics.
+**
+**      Usage: controlloop.out [-r rate_hz] [-n ticks] [-p fifo_priority] [-c cpu] [-m] [-f flight_dump]
+**
+**      With -f the last RUNNER_FLIGHT_RECORDS ticks are written to flight_dump at the end of the run, or when it crashes.
+**      Decode the dump with flightdecoder.out.
+**
+********************************************************************************************************************************/
+int main(int argc, char *argv[]) {
+    controlLoopConfig_t config = {5000000, 2000, 0, -1, 0};
+    controlLoopStats_t stats;
+    runnerState_t state = {0};
+    flightRecorder_t recorder;
+    flightRecord_t *records;
+    const char *dumpName = NULL;
+    int opt, err;
+
+    while ( ( opt = getopt( argc, argv, "r:n:p:c:mf:" ) ) != -1 ) {
+        switch ( opt ) {
+            case 'r': config.period_ns = (int64_t) ( 1e9 / atof( optarg ) ); break;
+            case 'n': config.iterations = atol( optarg ); break;
+            case 'p': config.realtimePriority = atoi( optarg ); break;
+            case 'c': config.cpu = atoi( optarg ); break;
+            case 'm': config.lockMemory = 1; break;
+            case 'f': dumpName = optarg; break;
+            default:
+                fprintf( stderr, "usage: %s [-r rate_hz] [-n ticks] [-p fifo_priority] [-c cpu] [-m] [-f flight_dump]\n", argv[0] );
+                return 2;
+        }
+    }
+
+    if ( dumpName ) {
+        records = calloc( RUNNER_FLIGHT_RECORDS, sizeof( flightRecord_t ) );
+        if ( !records ) {
+            fprintf( stderr, "ControlLoop: no memory for the flight recorder\n" );
+            return 1;
+        }
+        InitFlightRecorder( &recorder, records, RUNNER_FLIGHT_RECORDS );
+        InstallFlightRecorderFaultDump( &recorder, dumpName );
+        state.recorder = &recorder;
+    }
+
+    state.params = GetDefaultPathFollowerParams();
+    InitPoseChannel( &state.channel );
+    InitRobotStateEstimator( &state.estimator, RUNNER_TRACK_WIDTH_IN, &state.channel );
+    StartRoute( &state, 0.0 );
+    InitInstrument();
+    err = RunControlLoop( &config, RunnerTick, &state, &stats );
+    if ( err ) {
+        fprintf( stderr, "ControlLoop: clock_nanosleep failed: %d\n", err );
+        return 1;
+    }
+    printf( "paths_completed=%d\n", state.pathsCompleted );
+    if ( dumpName && DumpFlightRecorder( &recorder, dumpName ) ) {
+        fprintf( stderr, "ControlLoop: could not write %s\n", dumpName );
+    }
+    PrintControlLoopStats( &config, &stats );
+#ifdef INSTRUMENT
+    PrintInstrumentStats();
+#endif
+
+    return stats.deadlineMisses ? 3 : 0;
+}
@@ -0,0 +1,70 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "Recorder.h"
+
+
+/********************************************************************************************************************************
+**  PrintFlightRecordCsv
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void PrintFlightRecordCsv (FILE *out, flightRecord_t *r) {
+    fprintf( out, "%u,%.6f,%.4f,%.4f,%.6f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.6f,%.4f,%.4f,%.4f,%.4f,"
+                  "%.6f,%.4f,%.4f,%.4f,%.4f,%.4f,%.6f,%d,%d,%d\n",
+             r->sequence, r->t, r->poseX, r->poseY, atan2( r->poseSin, r->poseCos ), r->closestX, r->closestY, r->closestDistance,
+             r->closestSpeed, r->remainingSegmentDistance, r->remainingPathDistance, r->maxSpeed, r->lookaheadX, r->lookaheadY,
+             r->lookaheadSpeed, r->steerDx, r->steerDy, r->steerDtheta, r->crossTrackError, r->steerMaxSpeed, r->steerEndSpeed,
+             r->remainingPathLength, r->setpointT, r->setpointPos, r->setpointVel, r->setpointAcc, r->outputDx, r->outputDy,
+             r->outputDtheta, !!( r->flags & FLIGHT_AT_END_OF_PATH ), !!( r->flags & FLIGHT_DONE_STEERING ),
+             !!( r->flags & FLIGHT_FINISHED ) );
+}
+
+
+/********************************************************************************************************************************
+**  main
+**
+**      Decodes a flight recorder dump into CSV, one row per tick, oldest first.
+**
+**      Usage: flightdecoder.out dump.bin [out.csv]
+**
+********************************************************************************************************************************/
+int main(int argc, char *argv[]) {
+    flightDumpHeader_t header;
+    flightRecord_t *records;
+    FILE *out = stdout;
+    uint32_t i;
+
+    if ( argc < 2 || argc > 3 ) {
+        fprintf( stderr, "usage: %s dump.bin [out.csv]\n", argv[0] );
+        return 2;
+    }
+    records = LoadFlightDump( argv[1], &header );
+    if ( !records ) {
+        fprintf( stderr, "FlightDecoder: %s is not a flight recorder dump (or is empty)\n", argv[1] );
+        return 1;
+    }
+    if ( argc == 3 && !( out = fopen( argv[2], "w" ) ) ) {
+        fprintf( stderr, "FlightDecoder: cannot write %s\n", argv[2] );
+        free( records );
+        return 1;
+    }
+
+    fprintf( out, "sequence,t,pose_x,pose_y,pose_theta,closest_x,closest_y,closest_distance,closest_speed,remaining_segment_distance,"
+                  "remaining_path_distance,max_speed,lookahead_x,lookahead_y,lookahead_speed,steer_dx,steer_dy,steer_dtheta,"
+                  "cross_track_error,steer_max_speed,steer_end_speed,remaining_path_length,setpoint_t,setpoint_pos,setpoint_vel,"
+                  "setpoint_acc,output_dx,output_dy,output_dtheta,at_end_of_path,done_steering,finished\n" );
+    for ( i = 0; i < header.numRecords; i++ ) {
+        PrintFlightRecordCsv( out, &records[i] );
+    }
+    fprintf( stderr, "FlightDecoder: %u of %llu recorded ticks\n", header.numRecords, (unsigned long long) header.totalRecorded );
+
+    if ( out != stdout ) {
+        fclose( out );
+    }
+    free( records );
+    return 0;
+}
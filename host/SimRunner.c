@@ -0,0 +1,70 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "Sim.h"
+
+#define SIM_RUNNER_FLIGHT_RECORDS 16384
+
+
+/********************************************************************************************************************************
+**  main
+**
+**      Runs the path follower against the simulated robot over the route corpus (or one route) and prints the metrics of
+**      every run.  Exits non-zero if any run did not finish.  -d delays the commands reaching the wheels, -c sets the
+**      actuation latency the follower compensates for.
+**
+**      Usage: sim.out [-r route] [-l lag_s] [-d delay_s] [-c latency_s] [-n noise_ips] [-s slip] [-S seed] [-t dt_s]
+**                     [-f flight_dump]
+**
+********************************************************************************************************************************/
+int main(int argc, char *argv[]) {
+    pathFollowerParams_t params = GetDefaultPathFollowerParams();
+    simConfig_t config;
+    simMetrics_t metrics;
+    simRoute_t *route;
+    flightRecorder_t recorder;
+    flightRecord_t *records = NULL;
+    const char *routeName = NULL, *dumpName = NULL;
+    int opt, i, failures = 0;
+
+    InitSimConfig( &config );
+    while ( ( opt = getopt( argc, argv, "r:l:d:c:n:s:S:t:f:" ) ) != -1 ) {
+        switch ( opt ) {
+            case 'r': routeName = optarg; break;
+            case 'l': config.actuatorTimeConstant = atof( optarg ); break;
+            case 'd': config.actuationDelay_s = atof( optarg ); break;
+            case 'c': params.actuation_latency = atof( optarg ); break;
+            case 'n': config.wheelSpeedNoise_ips = atof( optarg ); break;
+            case 's': config.wheelSlip = atof( optarg ); break;
+            case 'S': config.seed = strtoull( optarg, NULL, 0 ); break;
+            case 't': config.dt = atof( optarg ); break;
+            case 'f': dumpName = optarg; break;
+            default:
+                fprintf( stderr, "usage: %s [-r route] [-l lag_s] [-d delay_s] [-c latency_s] [-n noise_ips] [-s slip] [-S seed] [-t dt_s] [-f flight_dump]\n", argv[0] );
+                return 2;
+        }
+    }
+    if ( dumpName ) {
+        records = calloc( SIM_RUNNER_FLIGHT_RECORDS, sizeof( flightRecord_t ) );
+        InitFlightRecorder( &recorder, records, SIM_RUNNER_FLIGHT_RECORDS );
+    }
+
+    for ( i = 0; i < GetNumSimRoutes(); i++ ) {
+        route = GetSimRoute( i );
+        if ( routeName && strcmp( routeName, route->name ) ) {
+            continue;
+        }
+        metrics = RunSimulation( &config, &params, route->waypoints, route->numWaypoints, records ? &recorder : NULL );
+        PrintSimMetrics( route->name, &metrics );
+        failures += !metrics.finished;
+    }
+
+    // With several routes the dump holds the end of the last one.
+    if ( dumpName && DumpFlightRecorder( &recorder, dumpName ) ) {
+        fprintf( stderr, "Sim: could not write %s\n", dumpName );
+    }
+    free( records );
+
+    return failures ? 1 : 0;
+}
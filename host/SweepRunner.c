@@ -0,0 +1,103 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "Sim.h"
+
+
+/********************************************************************************************************************************
+**  ParseSweepRange
+**
+**      Parses name=min:max:steps into the sweep configuration.
+**
+**      Input:
+**
+**      Output: Returns 0, or -1 if the text is not a valid range of a known parameter.
+**
+********************************************************************************************************************************/
+int ParseSweepRange (sweepConfig_t *config, const char *text) {
+    const char *equals;
+    sweepRange_t range;
+    size_t length;
+    int i;
+
+    equals = strchr( text, '=' );
+    if ( !equals || sscanf( equals + 1, "%lf:%lf:%d", &range.min, &range.max, &range.steps ) != 3 || range.steps < 1 ) {
+        return -1;
+    }
+    length = (size_t) ( equals - text );
+    for ( i = 0; i < SWEEP_NUM_PARAMS; i++ ) {
+        if ( strlen( GetSweepParamName( (sweepParam_t) i ) ) == length && !strncmp( text, GetSweepParamName( (sweepParam_t) i ), length ) ) {
+            config->ranges[i] = range;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+
+/********************************************************************************************************************************
+**  main
+**
+**      Ranks controller parameter sets by how they drive the simulator route corpus.  Each -p varies one parameter; without
+**      any, a default grid over the lookahead distances and the inertia gain is swept.  With -N the given number of random
+**      sets is drawn from the ranges instead of the full grid.
+**
+**      Usage: sweep.out [-p name=min:max:steps ...] [-N random_sets] [-S seed] [-j threads] [-k top] [-w cte_weight]
+**                       [-l lag_s] [-n noise_ips] [-s slip] [-R sim_seed]
+**
+********************************************************************************************************************************/
+int main(int argc, char *argv[]) {
+    sweepConfig_t config;
+    sweepResult_t *results;
+    int opt, i, numResults, top = 10, ranges = 0;
+
+    InitSweepConfig( &config );
+    while ( ( opt = getopt( argc, argv, "p:N:S:j:k:w:l:n:s:R:" ) ) != -1 ) {
+        switch ( opt ) {
+            case 'p':
+                if ( ParseSweepRange( &config, optarg ) ) {
+                    fprintf( stderr, "Sweep: bad range %s\n", optarg );
+                    return 2;
+                }
+                ranges += 1;
+                break;
+            case 'N': config.randomSamples = atoi( optarg ); break;
+            case 'S': config.seed = strtoull( optarg, NULL, 0 ); break;
+            case 'j': config.numThreads = atoi( optarg ); break;
+            case 'k': top = atoi( optarg ); break;
+            case 'w': config.crossTrackWeight = atof( optarg ); break;
+            case 'l': config.sim.actuatorTimeConstant = atof( optarg ); break;
+            case 'n': config.sim.wheelSpeedNoise_ips = atof( optarg ); break;
+            case 's': config.sim.wheelSlip = atof( optarg ); break;
+            case 'R': config.sim.seed = strtoull( optarg, NULL, 0 ); break;
+            default:
+                fprintf( stderr, "usage: %s [-p name=min:max:steps ...] [-N random_sets] [-S seed] [-j threads] [-k top] [-w cte_weight]\n"
+                                 "       [-l lag_s] [-n noise_ips] [-s slip] [-R sim_seed]\n", argv[0] );
+                fprintf( stderr, "parameters:" );
+                for ( i = 0; i < SWEEP_NUM_PARAMS; i++ ) {
+                    fprintf( stderr, " %s", GetSweepParamName( (sweepParam_t) i ) );
+                }
+                fprintf( stderr, "\n" );
+                return 2;
+        }
+    }
+    if ( !ranges ) {
+        ParseSweepRange( &config, "lookahead_min_distance=6:18:3" );
+        ParseSweepRange( &config, "lookahead_max_distance=24:48:3" );
+        ParseSweepRange( &config, "inertia_gain=0:0.004:3" );
+    }
+
+    results = RunSweep( &config, &numResults );
+    if ( !results ) {
+        fprintf( stderr, "Sweep: out of memory\n" );
+        return 1;
+    }
+    printf( "sets=%d routes=%d threads=%d\n", numResults, GetNumSimRoutes(), config.numThreads );
+    for ( i = 0; i < numResults && i < top; i++ ) {
+        PrintSweepResult( i + 1, &results[i] );
+    }
+    free( results );
+
+    return 0;
+}
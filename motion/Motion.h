@@ -45,11 +45,25 @@ typedef struct motionSegment {
     motionState_t end;
 } motionSegment_t;
 
+// A motion segment as a profile keeps it: the start state, driven at a constant acceleration for dt.  The end state follows
+// from these (see SegmentEnd).  A segment with infinite acceleration has no duration, and keeps the velocity it ends at in
+// dt instead.
+typedef struct compactMotionSegment {
+    double t;
+    double pos;
+    double vel;
+    double acc;
+    double dt;
+} compactMotionSegment_t;
+
 typedef struct motionProfileNode {
-    motionSegment_t segment;
+    compactMotionSegment_t segment;
     struct motionProfileNode *next;
 } motionProfileNode_t;
 
+// Largest number of released profile nodes each thread keeps for reuse (see NewProfileNode).
+#define PROFILE_NODE_POOL_SIZE 64
+
 typedef struct motionProfileList {
     motionProfileNode_t *head;
     motionProfileNode_t *tail;
@@ -63,13 +77,20 @@ typedef struct setpoint {
 
 static const setpoint_t kInvalidSetpoint = {{NAN, NAN, NAN, NAN}, 0};
 
+// goalReplanTolerance
+// Largest change in goal position that is handled by re-targeting the existing profile (see ReplanProfileGoal) instead of
+// regenerating it.  The goal position, the goal velocity and the velocity limit may change; 0.0 disables incremental
+// replanning.
 typedef struct setpointGenerator {
     motionProfileList_t *profile;
     motionProfileGoal_t *goal;
     motionProfileConstraints_t *constraints;
+    double goalReplanTolerance;
+    int fullRegenerations;
+    int incrementalRegenerations;
 } setpointGenerator_t;
 
-static const setpointGenerator_t kInvalidSetpointGenerator = {NULL, NULL, NULL};
+static const setpointGenerator_t kInvalidSetpointGenerator = {NULL, NULL, NULL, 0.0, 0, 0};
 
 typedef struct profileFollower {
     double kP;
@@ -101,6 +122,12 @@ int MotionStatesAreEqual (motionState_t *stateA, motionState_t *stateB);
 int IsSegmentValid (motionSegment_t *segment);
 int ContainsTime (motionSegment_t *segment, double t);
 int ContainsPosition (motionSegment_t *segment, double pos);
+compactMotionSegment_t CompactSegment (motionSegment_t *segment);
+motionSegment_t ExpandSegment (compactMotionSegment_t *segment);
+motionState_t SegmentStart (compactMotionSegment_t *segment);
+motionState_t SegmentEnd (compactMotionSegment_t *segment);
+double SegmentEndTime (compactMotionSegment_t *segment);
+int IsCompactSegmentValid (compactMotionSegment_t *segment);
 
 //MotionProfileGoal.c
 motionProfileGoal_t FlippedGoal (motionProfileGoal_t *goal);
@@ -110,6 +137,9 @@ int GoalsAreEqual (motionProfileGoal_t *goalA, motionProfileGoal_t *goalB);
 int ConstraintsAreEqual (motionProfileConstraints_t *constraintsA, motionProfileConstraints_t *constraintsB);
 
 //MotionProfile.c
+motionProfileNode_t * NewProfileNode (void);
+void DeleteProfileNode (motionProfileNode_t *node);
+void ReleaseProfileNodes (void);
 void PrintProfile (motionProfileList_t *profile);
 int IsProfileValid (motionProfileList_t *profile);
 motionState_t StateByTime (motionProfileList_t *profile, double t);
@@ -126,16 +156,22 @@ void AppendProfile (motionProfileList_t *currentProfile, motionProfileList_t *ad
 // MotionProfileGenerator.c
 motionProfileList_t GenerateFlippedProfile (motionProfileConstraints_t *constraints, motionProfileGoal_t *goalState, motionState_t *prevState);
 motionProfileList_t GenerateProfile (motionProfileConstraints_t *constraints, motionProfileGoal_t *goalState, motionState_t *prevState);
+motionState_t GetProfileEndState (motionProfileConstraints_t *constraints, motionProfileGoal_t *goalState, motionState_t *prevState);
+int ReplanProfileGoal (motionProfileList_t *profile, motionProfileConstraints_t *planned, motionProfileConstraints_t *constraints, motionProfileGoal_t *goalState, double t);
 
 // SetpointGenerator.c
 void ClearSetpointGenerator (setpointGenerator_t *setpointGenerator);
 void SetSetpointGenerator (setpointGenerator_t *setpointGenerator, motionProfileConstraints_t *constraints, motionProfileGoal_t *goal, motionState_t *prevState);
+void RegenerateSetpointGenerator (setpointGenerator_t *setpointGenerator, motionProfileConstraints_t *constraints, motionProfileGoal_t *goal, motionState_t *prevState);
+void SetGoalReplanTolerance (setpointGenerator_t *setpointGenerator, double tolerance);
+int CanReplanIncrementally (setpointGenerator_t *setpointGenerator, motionProfileConstraints_t *constraints, motionProfileGoal_t *goal, motionState_t *prevState);
 setpoint_t GetSetpoint (setpointGenerator_t *setpointGenerator, motionProfileConstraints_t *constraints, motionProfileGoal_t *goal, motionState_t *prevState, double t);
 
 // ProfileFollower.c
 profileFollower_t * CreateProfileFollower ();
-void ClearSetpointGenerator (setpointGenerator_t *setpointGenerator);
+void InitProfileFollower (profileFollower_t *profileFollower);
 void SetProfileFollowerGains (profileFollower_t *profileFollower, double kp, double ki, double kv, double kffv, double kffa);
+void SetProfileFollowerReplanTolerance (profileFollower_t *profileFollower, double tolerance);
 void SetProfileFollowerGoalAndConstraints (profileFollower_t *profileFollower, motionProfileGoal_t *goal, motionProfileConstraints_t *constraints);
 void ClearProfileFollower (profileFollower_t *profileFollower);
 double ProfileFollowerUpdate (profileFollower_t *profileFollower, motionState_t *latestState, double t);
@@ -5,6 +5,126 @@
 #include "../utils/Utils.h"
 #include "../robot/RobotMap.h"
 
+#ifdef __linux__
+#include <pthread.h>
+#endif
+
+// Nodes released by profiles are kept for reuse, so that regenerating a profile every control tick does not touch the heap
+// once the pool has filled.  Each thread has its own pool (handed back to the heap when the thread exits).
+typedef struct profileNodePool {
+    motionProfileNode_t *nodes;
+    int size;
+} profileNodePool_t;
+
+#ifdef __linux__
+static _Thread_local profileNodePool_t tProfileNodePool;
+static pthread_key_t gProfileNodePoolKey;
+static pthread_once_t gProfileNodePoolOnce = PTHREAD_ONCE_INIT;
+#else
+static profileNodePool_t tProfileNodePool;
+#endif
+
+
+#ifdef __linux__
+/******************************************************************************************************************************** 
+**  ReleaseThreadProfileNodes
+**
+**      Thread exit destructor of the calling thread's node pool.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+static void ReleaseThreadProfileNodes (void *unused) {
+    ReleaseProfileNodes();
+}
+
+
+/******************************************************************************************************************************** 
+**  CreateProfileNodePoolKey
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+static void CreateProfileNodePoolKey (void) {
+    pthread_key_create( &gProfileNodePoolKey, ReleaseThreadProfileNodes );
+}
+#endif
+
+
+/******************************************************************************************************************************** 
+**  NewProfileNode
+**
+**      Input:
+**
+**      Output: An uninitialized profile node, from the calling thread's pool if it has one.
+**
+********************************************************************************************************************************/
+motionProfileNode_t * NewProfileNode (void) {
+    motionProfileNode_t *node;
+
+    node = tProfileNodePool.nodes;
+    if ( node ) {
+        tProfileNodePool.nodes = node->next;
+        tProfileNodePool.size -= 1;
+        return node;
+    }
+    return malloc( sizeof( motionProfileNode_t ) );
+}
+
+
+/******************************************************************************************************************************** 
+**  DeleteProfileNode
+**
+**      Returns a node to the calling thread's pool, or to the heap once the pool holds PROFILE_NODE_POOL_SIZE nodes.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void DeleteProfileNode (motionProfileNode_t *node) {
+    if ( tProfileNodePool.size >= PROFILE_NODE_POOL_SIZE ) {
+        free( node );
+        return;
+    }
+#ifdef __linux__
+    if ( !tProfileNodePool.nodes ) {
+        // Have the pool freed when the thread exits.
+        pthread_once( &gProfileNodePoolOnce, CreateProfileNodePoolKey );
+        pthread_setspecific( gProfileNodePoolKey, &tProfileNodePool );
+    }
+#endif
+    node->next = tProfileNodePool.nodes;
+    tProfileNodePool.nodes = node;
+    tProfileNodePool.size += 1;
+}
+
+
+/******************************************************************************************************************************** 
+**  ReleaseProfileNodes
+**
+**      Hands every node in the calling thread's pool back to the heap.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void ReleaseProfileNodes (void) {
+    motionProfileNode_t *node;
+
+    while ( tProfileNodePool.nodes ) {
+        node = tProfileNodePool.nodes;
+        tProfileNodePool.nodes = node->next;
+        free( node );
+    }
+    tProfileNodePool.size = 0;
+}
+
 
 /******************************************************************************************************************************** 
 **  PrintProfile
@@ -16,6 +136,7 @@
 ********************************************************************************************************************************/
 void PrintProfile (motionProfileList_t *profile) {
     motionProfileNode_t *profileNode;
+    motionSegment_t segment;
     
     profileNode = profile->head;
     printf("====================================\n");
@@ -23,7 +144,8 @@ void PrintProfile (motionProfileList_t *profile) {
     printf("====================================\n");
     printf("%8s %8s %8s %8s %8s %8s %8s %8s\n","s_t", "s_pos", "s_vel", "s_acc", "e_t", "e_pos", "e_vel", "e_acc");
     while ( profileNode ) {
-        printf("%8.4f %8.4f %8.4f %8.4f %8.4f %8.4f %8.4f %8.4f\n", profileNode->segment.start.t, profileNode->segment.start.pos, profileNode->segment.start.vel, profileNode->segment.start.acc, profileNode->segment.end.t, profileNode->segment.end.pos, profileNode->segment.end.vel, profileNode->segment.end.acc);
+        segment = ExpandSegment( &profileNode->segment );
+        printf("%8.4f %8.4f %8.4f %8.4f %8.4f %8.4f %8.4f %8.4f\n", segment.start.t, segment.start.pos, segment.start.vel, segment.start.acc, segment.end.t, segment.end.pos, segment.end.vel, segment.end.acc);
         profileNode = profileNode->next;
     }
 }
@@ -44,7 +166,7 @@ void ClearProfile (motionProfileList_t *profile) {
     while ( profileNode ) {
         removeNode = profileNode;    
         profileNode = profileNode->next;
-        free (removeNode);
+        DeleteProfileNode( removeNode );
     }
     profile->head = NULL;
     profile->tail = NULL;
@@ -61,12 +183,14 @@ void ClearProfile (motionProfileList_t *profile) {
 ********************************************************************************************************************************/
 void ResetProfile (motionProfileList_t *profile, motionState_t *initialState) {
     motionProfileNode_t *newSegment;
+    motionSegment_t segment;
 
     ClearProfile( profile );
-    newSegment = malloc( sizeof( motionProfileNode_t ));
+    newSegment = NewProfileNode();
     
-    newSegment->segment.start = *initialState;
-    newSegment->segment.end = *initialState;
+    segment.start = *initialState;
+    segment.end = *initialState;
+    newSegment->segment = CompactSegment( &segment );
     newSegment->next = NULL;
     profile->head = newSegment;
     profile->tail = newSegment;
@@ -86,8 +210,8 @@ void ResetProfile (motionProfileList_t *profile, motionState_t *initialState) {
 void AppendSegment (motionProfileList_t *profile, motionSegment_t *segment) {
     motionProfileNode_t *newSegment;
     
-    newSegment = malloc( sizeof( motionProfileNode_t ));
-    newSegment->segment = *segment;
+    newSegment = NewProfileNode();
+    newSegment->segment = CompactSegment( segment );
     newSegment->next = NULL;
     profile->tail->next = newSegment;
     profile->tail = newSegment;
@@ -107,7 +231,7 @@ void AppendControl (motionProfileList_t *profile, double acc, double dt) {
     motionState_t lastEndState, newStartState, newEndState;
     motionSegment_t newSegment;
 
-    lastEndState = profile->tail->segment.end;
+    lastEndState = SegmentEnd( &profile->tail->segment );
     newStartState.t = lastEndState.t;
     newStartState.pos = lastEndState.pos;
     newStartState.vel = lastEndState.vel;
@@ -132,11 +256,13 @@ void AppendControl (motionProfileList_t *profile, double acc, double dt) {
 ********************************************************************************************************************************/
 void Consolidate (motionProfileList_t *profile) {
     motionProfileNode_t *currentNode, *prevNode, *freeNode;
+    motionSegment_t segment;
     
     currentNode = profile->head;
     prevNode = NULL;
     while ( currentNode && profile->length > 1 ) {
-        if ( Coincident( &currentNode->segment.start, &currentNode->segment.end ) ) {
+        segment = ExpandSegment( &currentNode->segment );
+        if ( Coincident( &segment.start, &segment.end ) ) {
             if ( prevNode ) {
                 prevNode->next = currentNode->next;
             } else {
@@ -144,7 +270,10 @@ void Consolidate (motionProfileList_t *profile) {
             }
             freeNode = currentNode;
             currentNode = currentNode->next;
-            free( freeNode );
+            if ( freeNode == profile->tail ) {
+                profile->tail = prevNode;
+            }
+            DeleteProfileNode( freeNode );
             profile->length = profile->length - 1;
         } else {
             prevNode = currentNode;
@@ -163,13 +292,16 @@ void Consolidate (motionProfileList_t *profile) {
 **
 ********************************************************************************************************************************/
 void AppendProfile (motionProfileList_t *currentProfile, motionProfileList_t *addProfile) {
-    motionProfileNode_t *addNode;
-    motionSegment_t newSegment;
+    motionProfileNode_t *addNode, *newNode;
     
     addNode = addProfile->head;
     while ( addNode ) {
-        newSegment = addNode->segment;
-        AppendSegment( currentProfile, &newSegment);
+        newNode = NewProfileNode();
+        newNode->segment = addNode->segment;
+        newNode->next = NULL;
+        currentProfile->tail->next = newNode;
+        currentProfile->tail = newNode;
+        currentProfile->length += 1;
         addNode = addNode->next;
     }
 }
@@ -186,23 +318,30 @@ void AppendProfile (motionProfileList_t *currentProfile, motionProfileList_t *ad
 ********************************************************************************************************************************/
 void TrimBeforeTime(motionProfileList_t *profile, double t) {
     motionProfileNode_t *currentNode, *deleteNode;
-    motionState_t trimmedState;
+    motionState_t startState, trimmedState;
 
     currentNode = profile->head;
     while ( currentNode ) {
-        if ( currentNode->segment.end.t <= t ) {
+        if ( SegmentEndTime( &currentNode->segment ) <= t ) {
             // Segment is fully before t. 
             deleteNode = currentNode;
             currentNode = currentNode->next;
             profile->head = currentNode;
-            free (deleteNode);
+            DeleteProfileNode( deleteNode );
             profile->length = profile->length - 1; 
+            if ( !currentNode ) {
+                profile->tail = NULL;
+            }
             continue;
         }
-        if ( currentNode->segment.start.t <= t ) {
+        if ( currentNode->segment.t <= t ) {
             // Segment begins before t; let's shorten the segment.
-            trimmedState = Extrapolate( &currentNode->segment.start, t, currentNode->segment.start.acc );
-            currentNode->segment.start = trimmedState;
+            startState = SegmentStart( &currentNode->segment );
+            trimmedState = Extrapolate( &startState, t, startState.acc );
+            currentNode->segment.dt = SegmentEndTime( &currentNode->segment ) - t;
+            currentNode->segment.t = trimmedState.t;
+            currentNode->segment.pos = trimmedState.pos;
+            currentNode->segment.vel = trimmedState.vel;
         }
         break;
     }
@@ -214,7 +353,7 @@ void TrimBeforeTime(motionProfileList_t *profile, double t) {
 **  IsProfileValid
 **
 **    Checks if the given MotionProfile is valid. This checks that:
-**      1. All segments are valid.
+**      1. All segments are valid (see IsCompactSegmentValid).
 **      2. Successive segments are C1 continuous in position and C0 continuous in velocity.
 **      Input:
 **
@@ -222,22 +361,24 @@ void TrimBeforeTime(motionProfileList_t *profile, double t) {
 **
 ********************************************************************************************************************************/
 int IsProfileValid (motionProfileList_t *profile) {
-    motionProfileNode_t *currentNode, *prevNode;
+    motionProfileNode_t *currentNode;
+    motionSegment_t segment;
+    motionState_t prevEnd;
 
     currentNode = profile->head;
-    prevNode = NULL;
     while ( currentNode ) {
-        if ( !IsSegmentValid( &currentNode->segment ) ) {
+        if ( !IsCompactSegmentValid( &currentNode->segment ) ) {
             return 0;
         }
-        if ( prevNode ) {
-            if ( !Coincident( &currentNode->segment.start, &prevNode->segment.end ) ) {      
+        segment = ExpandSegment( &currentNode->segment );
+        if ( currentNode != profile->head ) {
+            if ( !Coincident( &segment.start, &prevEnd ) ) {      
               // Adjacent segments are not continuous.
               //System.err.println("Segments not continuous! End: " + prev_segment.end() + ", Start: " + s.start());
               return 0;
             }
         }
-        prevNode = currentNode;
+        prevEnd = segment.end;
         currentNode = currentNode->next;
     }
     return 1;
@@ -253,19 +394,23 @@ int IsProfileValid (motionProfileList_t *profile) {
 ********************************************************************************************************************************/
 motionState_t StateByTime (motionProfileList_t *profile, double t) {
     motionState_t rv = {NAN, NAN, NAN, NAN};
+    motionState_t startState, endState;
     motionProfileNode_t *profileNode;
 
-    if ( t < profile->head->segment.start.t && t + kEpsilon >= profile->head->segment.start.t ) {
-        rv = profile->head->segment.start;
+    startState = SegmentStart( &profile->head->segment );
+    endState = SegmentEnd( &profile->tail->segment );
+    if ( t < startState.t && t + kEpsilon >= startState.t ) {
+        rv = startState;
     
-    } else if ( t > profile->tail->segment.end.t && t - kEpsilon <= profile->tail->segment.end.t ) {
-        rv = profile->tail->segment.end;
+    } else if ( t > endState.t && t - kEpsilon <= endState.t ) {
+        rv = endState;
     
     } else {
-        profileNode = profile->head;
+        profileNode = ( t >= profile->head->segment.t ) ? profile->head : NULL;
         while ( profileNode ) {
-            if ( ContainsTime( &profileNode->segment, t ) ) {
-                rv = Extrapolate( &profileNode->segment.start, t, profileNode->segment.start.acc );
+            if ( t <= SegmentEndTime( &profileNode->segment ) ) {
+                startState = SegmentStart( &profileNode->segment );
+                rv = Extrapolate( &startState, t, startState.acc );
                 break;
             }
             profileNode = profileNode->next;
@@ -286,19 +431,23 @@ motionState_t StateByTime (motionProfileList_t *profile, double t) {
 ********************************************************************************************************************************/
 motionState_t StateByTimeClamped (motionProfileList_t *profile, double t) {
     motionState_t rv = {NAN, NAN, NAN, NAN};
+    motionState_t startState, endState;
     motionProfileNode_t *profileNode;
 
-    if ( t < profile->head->segment.start.t ) {
-        rv = profile->head->segment.start;
+    startState = SegmentStart( &profile->head->segment );
+    endState = SegmentEnd( &profile->tail->segment );
+    if ( t < startState.t ) {
+        rv = startState;
     
-    } else if ( t > profile->tail->segment.end.t ) {
-        rv = profile->tail->segment.end;
+    } else if ( t > endState.t ) {
+        rv = endState;
     
     } else {
-        profileNode = profile->head;
+        profileNode = ( t >= profile->head->segment.t ) ? profile->head : NULL;
         while ( profileNode ) {
-            if ( ContainsTime( &profileNode->segment, t ) ) {
-                rv = Extrapolate( &profileNode->segment.start, t, profileNode->segment.start.acc );
+            if ( t <= SegmentEndTime( &profileNode->segment ) ) {
+                startState = SegmentStart( &profileNode->segment );
+                rv = Extrapolate( &startState, t, startState.acc );
                 break;
             }
             profileNode = profileNode->next;
@@ -320,21 +469,23 @@ motionState_t StateByTimeClamped (motionProfileList_t *profile, double t) {
 motionState_t FirstStateByPosition (motionProfileList_t *profile, double pos) {
     motionState_t rv = {NAN, NAN, NAN, NAN};
     motionProfileNode_t *profileNode;
+    motionSegment_t segment;
     double t;
 
     profileNode = profile->head;
     while ( profileNode ) {
-        if ( ContainsPosition( &profileNode->segment, pos ) ) {
-            if ( EpsilonEquals( profileNode->segment.end.pos , pos, kEpsilon ) ) {
-                rv = profileNode->segment.end;
+        segment = ExpandSegment( &profileNode->segment );
+        if ( ContainsPosition( &segment, pos ) ) {
+            if ( EpsilonEquals( segment.end.pos, pos, kEpsilon ) ) {
+                rv = segment.end;
                 return rv;
             }
-            t = fmin( NextTimeAtPos( &profileNode->segment.start, pos ), profileNode->segment.end.t );
+            t = fmin( NextTimeAtPos( &segment.start, pos ), segment.end.t );
             if ( isnan( t ) ) {
                 // Print an error
                 return rv;
             }
-            rv = Extrapolate( &profileNode->segment.start, t, profileNode->segment.start.acc );
+            rv = Extrapolate( &segment.start, t, segment.start.acc );
             return rv;
 
         }
@@ -343,5 +494,3 @@ motionState_t FirstStateByPosition (motionProfileList_t *profile, double pos) {
 
     return rv;
 }
-
-
@@ -5,52 +5,184 @@
 #include "../robot/RobotMap.h"
 
 
+// A profile being planned: its segments go into the profile, if there is one, and the last of them are kept so where the
+// profile ends is known without one.
+typedef struct profilePlan {
+    motionProfileList_t *profile;       // The profile, or NULL to only plan where it ends
+    compactMotionSegment_t tail;        // The last segment planned
+    compactMotionSegment_t lastMoving;  // The last one that is not a single point, the tail Consolidate leaves
+    int moving;                         // Whether there is one
+} profilePlan_t;
+
+static void PlanProfile (profilePlan_t *plan, motionProfileConstraints_t *constraints, motionProfileGoal_t *goalState, motionState_t *prevState);
+
+
 /******************************************************************************************************************************** 
-**  GenerateFlippedProfile
+**  PlanSegment
+**
+**      Appends a segment to the plan, as AppendSegment appends it to a profile.  Whether it is a single point is judged the way
+**      Consolidate judges it, from the segment as the profile keeps it.
 **
 **      Input:
 **
 **      Output:
 **
 ********************************************************************************************************************************/
-motionProfileList_t GenerateFlippedProfile (motionProfileConstraints_t *constraints, motionProfileGoal_t *goalState, motionState_t *prevState) {
-    motionProfileList_t flippedProfile;
+static void PlanSegment (profilePlan_t *plan, motionSegment_t *segment) {
+    motionSegment_t kept;
+
+    if ( plan->profile ) {
+        AppendSegment( plan->profile, segment );
+    }
+    plan->tail = CompactSegment( segment );
+    kept = ExpandSegment( &plan->tail );
+    if ( !Coincident( &kept.start, &kept.end ) ) {
+        plan->lastMoving = plan->tail;
+        plan->moving = 1;
+    }
+}
+
+
+/******************************************************************************************************************************** 
+**  PlanReset
+**
+**      ResetProfile, on a plan.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+static void PlanReset (profilePlan_t *plan, motionState_t *initialState) {
+    motionSegment_t segment;
+
+    if ( plan->profile ) {
+        ResetProfile( plan->profile, initialState );
+    }
+    segment.start = *initialState;
+    segment.end = *initialState;
+    plan->tail = CompactSegment( &segment );
+    plan->moving = 0;
+}
+
+
+/******************************************************************************************************************************** 
+**  PlanControl
+**
+**      AppendControl, on a plan: the control starts from the end of the last segment planned.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+static void PlanControl (profilePlan_t *plan, double acc, double dt) {
+    motionState_t lastEndState, newStartState;
+    motionSegment_t newSegment;
+
+    lastEndState = SegmentEnd( &plan->tail );
+    newStartState.t = lastEndState.t;
+    newStartState.pos = lastEndState.pos;
+    newStartState.vel = lastEndState.vel;
+    newStartState.acc = acc;
+
+    newSegment.start = newStartState;
+    newSegment.end = Extrapolate( &newStartState, newStartState.t + dt, acc );
+    PlanSegment( plan, &newSegment );
+}
+
+
+/******************************************************************************************************************************** 
+**  FlipSegment
+**
+**      Input:
+**
+**      Output:
+**          compactMotionSegment_t      Return the segment with its positions, velocities and accelerations flipped
+**
+********************************************************************************************************************************/
+static compactMotionSegment_t FlipSegment (compactMotionSegment_t *compact) {
+    motionSegment_t segment;
+
+    segment = ExpandSegment( compact );
+    segment.start = FlippedState( &segment.start );
+    segment.end = FlippedState( &segment.end );
+    return CompactSegment( &segment );
+}
+
+
+/******************************************************************************************************************************** 
+**  PlanFlippedProfile
+**
+**      Plans the profile to the flipped goal from the flipped state, then flips it back.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+static void PlanFlippedProfile (profilePlan_t *plan, motionProfileConstraints_t *constraints, motionProfileGoal_t *goalState, motionState_t *prevState) {
     motionProfileGoal_t flippedGoal;
     motionState_t flippedState;
     motionProfileNode_t *profileNode;
 
     flippedGoal = FlippedGoal(goalState);
     flippedState = FlippedState(prevState);
-    flippedProfile = GenerateProfile( constraints, &flippedGoal, &flippedState);
+    PlanProfile( plan, constraints, &flippedGoal, &flippedState );
 
-    profileNode = flippedProfile.head;
-    while ( profileNode ) {
-        profileNode->segment.start = FlippedState(&profileNode->segment.start);
-        profileNode->segment.end = FlippedState(&profileNode->segment.end);
-        profileNode = profileNode->next;
+    if ( plan->profile ) {
+        profileNode = plan->profile->head;
+        while ( profileNode ) {
+            profileNode->segment = FlipSegment( &profileNode->segment );
+            profileNode = profileNode->next;
+        }
     }
+    plan->tail = FlipSegment( &plan->tail );
+    plan->lastMoving = FlipSegment( &plan->lastMoving );
+}
+
+
+/******************************************************************************************************************************** 
+**  GenerateFlippedProfile
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+motionProfileList_t GenerateFlippedProfile (motionProfileConstraints_t *constraints, motionProfileGoal_t *goalState, motionState_t *prevState) {
+    motionProfileList_t flippedProfile;
+    profilePlan_t plan;
+
+    plan.profile = &flippedProfile;
+    PlanFlippedProfile( &plan, constraints, goalState, prevState );
 
     return flippedProfile;
 }
 
 
 /******************************************************************************************************************************** 
-**  GenerateProfile
+**  PlanProfile
+**
+**      The body of GenerateProfile, on a plan.
 **
 **      Input:
 **
 **      Output:
 **
 ********************************************************************************************************************************/
-motionProfileList_t GenerateProfile (motionProfileConstraints_t *constraints, motionProfileGoal_t *goalState, motionState_t *prevState) {
-    motionProfileList_t profile, flippedProfile;
+static void PlanProfile (profilePlan_t *plan, motionProfileConstraints_t *constraints, motionProfileGoal_t *goalState, motionState_t *prevState) {
+    motionProfileList_t flippedProfile;
+    profilePlan_t flippedPlan;
     motionState_t startState;
     motionSegment_t segment;
     double deltaPos, stoppingTime, minAbsVelAtGoalSqr, minAbsVelAtGoal, maxAbsVelAtGoal, goalVel, maxAcc, vMax, accelTime, distanceDecel, distanceCruise, cruiseTime, decelTime;
 
-    profile.head = NULL;
-    profile.tail = NULL;
-    profile.length = 0;
+    if ( plan->profile ) {
+        plan->profile->head = NULL;
+        plan->profile->tail = NULL;
+        plan->profile->length = 0;
+    }
     flippedProfile.head = NULL;
     flippedProfile.tail = NULL;
     flippedProfile.length = 0;
@@ -59,8 +191,8 @@ motionProfileList_t GenerateProfile (motionProfileConstraints_t *constraints, mo
     if ( deltaPos < 0.0 || ( deltaPos == 0.0 && prevState->vel < 0.0) ) {
         // For simplicity, we always assume the goal requires positive movement. If negative, we flip to solve, then
         // flip the solution.
-        flippedProfile = GenerateFlippedProfile(constraints, goalState, prevState);
-        return flippedProfile;
+        PlanFlippedProfile( plan, constraints, goalState, prevState );
+        return;
     }
 
     // Invariant from this point on: delta_pos >= 0.0.  Clamp the start state to be valid.
@@ -69,13 +201,13 @@ motionProfileList_t GenerateProfile (motionProfileConstraints_t *constraints, mo
     startState.vel = SignNum( prevState->vel ) * fmin( fabs ( prevState->vel ), constraints->maxAbsVel );
     startState.acc = SignNum( prevState->acc ) * fmin( fabs ( prevState->acc ), constraints->maxAbsAcc );
     
-    ResetProfile(&profile, &startState);
+    PlanReset( plan, &startState );
 
     // If our velocity is headed away from the goal, the first thing we need to do is to stop.
     if (startState.vel < 0.0 && deltaPos > 0.0) {
         stoppingTime = fabs( startState.vel / constraints->maxAbsAcc );
-        AppendControl( &profile, constraints->maxAbsAcc, stoppingTime );
-        startState = profile.tail->segment.end;
+        PlanControl( plan, constraints->maxAbsAcc, stoppingTime );
+        startState = SegmentEnd( &plan->tail );
         deltaPos = goalState->pos - startState.pos;
     }
 
@@ -97,17 +229,16 @@ motionProfileList_t GenerateProfile (motionProfileConstraints_t *constraints, mo
             if ( fabs( deltaPos ) < goalState->posTolerance ) {
                 // Special case: We are at the goal but moving too fast. This requires 'infinite' acceleration,
                 // which will result in NaNs below, so we can return the profile immediately.
-                segment.start.t = profile.tail->segment.end.t;
-                segment.start.pos = profile.tail->segment.end.pos;
-                segment.start.vel = profile.tail->segment.end.vel;
+                segment.start = SegmentEnd( &plan->tail );
                 segment.start.acc = -INFINITY;
-                segment.end.t = profile.tail->segment.end.t;
-                segment.end.pos = profile.tail->segment.end.pos;
+                segment.end = segment.start;
                 segment.end.vel = goalVel;
                 segment.end.acc = -INFINITY;
-                AppendSegment( &profile, &segment );
-                Consolidate( &profile );
-                return profile;
+                PlanSegment( plan, &segment );
+                if ( plan->profile ) {
+                    Consolidate( plan->profile );
+                }
+                return;
             }
             // Adjust the max acceleration.
             maxAcc = fabs( goalVel * goalVel - startState.vel * startState.vel ) / (2.0 * deltaPos);
@@ -115,13 +246,23 @@ motionProfileList_t GenerateProfile (motionProfileConstraints_t *constraints, mo
         } else {
             // We are going to overshoot the goal, so the first thing we need to do is come to a stop.
             stoppingTime = fabs( startState.vel / constraints->maxAbsAcc );
-            AppendControl( &profile, -constraints->maxAbsAcc, stoppingTime );
+            PlanControl( plan, -constraints->maxAbsAcc, stoppingTime );
       
-            // Now we need to travel backwards, so generate a flipped profile.
-            flippedProfile = GenerateFlippedProfile( constraints, goalState, &profile.tail->segment.end );
-            AppendProfile( &profile, &flippedProfile );
-            Consolidate( &profile );
-            return profile;
+            // Now we need to travel backwards, so plan a flipped profile.
+            startState = SegmentEnd( &plan->tail );
+            flippedPlan.profile = plan->profile ? &flippedProfile : NULL;
+            PlanFlippedProfile( &flippedPlan, constraints, goalState, &startState );
+            plan->tail = flippedPlan.tail;
+            if ( flippedPlan.moving ) {
+                plan->lastMoving = flippedPlan.lastMoving;
+                plan->moving = 1;
+            }
+            if ( plan->profile ) {
+                AppendProfile( plan->profile, &flippedProfile );
+                ClearProfile( &flippedProfile );
+                Consolidate( plan->profile );
+            }
+            return;
         }
     }
 
@@ -139,8 +280,8 @@ motionProfileList_t GenerateProfile (motionProfileConstraints_t *constraints, mo
     // Accelerate to v_max
     if ( vMax > startState.vel ) {
         accelTime = ( vMax - startState.vel ) / maxAcc;
-        AppendControl( &profile, maxAcc, accelTime );
-        startState = profile.tail->segment.end;
+        PlanControl( plan, maxAcc, accelTime );
+        startState = SegmentEnd( &plan->tail );
     }
 
     // Figure out how much distance will be covered during deceleration.
@@ -150,17 +291,181 @@ motionProfileList_t GenerateProfile (motionProfileConstraints_t *constraints, mo
     // Cruise at constant velocity.
     if ( distanceCruise > 0.0 ) {
         cruiseTime = distanceCruise / startState.vel;
-        AppendControl( &profile, 0.0, cruiseTime );
-        startState = profile.tail->segment.end;
+        PlanControl( plan, 0.0, cruiseTime );
+        startState = SegmentEnd( &plan->tail );
     }
 
     // Decelerate to goal velocity.
     if ( distanceDecel > 0.0 ) {
         decelTime = ( startState.vel - goalVel ) / maxAcc;
-        AppendControl( &profile, -maxAcc, decelTime );
+        PlanControl( plan, -maxAcc, decelTime );
+    }
+
+    if ( plan->profile ) {
+        Consolidate( plan->profile );
     }
+}
+
+
+/******************************************************************************************************************************** 
+**  GenerateProfile
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+motionProfileList_t GenerateProfile (motionProfileConstraints_t *constraints, motionProfileGoal_t *goalState, motionState_t *prevState) {
+    motionProfileList_t profile;
+    profilePlan_t plan;
+
+    plan.profile = &profile;
+    PlanProfile( &plan, constraints, goalState, prevState );
 
-    Consolidate( &profile );
     return profile;
 }
 
+
+
+/******************************************************************************************************************************** 
+**  GetProfileEndState
+**
+**      The state the profile GenerateProfile generates ends in.  The profile is planned the same way but only its last
+**      segments are kept, never its nodes, so this is a handful of arithmetic whatever the profile.  Planning a long chain of
+**      profiles, each starting where the one before ends, only needs these.
+**
+**      Input:
+**          As GenerateProfile
+**
+**      Output:
+**          motionState_t               Return the end state of the profile
+**
+********************************************************************************************************************************/
+motionState_t GetProfileEndState (motionProfileConstraints_t *constraints, motionProfileGoal_t *goalState, motionState_t *prevState) {
+    profilePlan_t plan;
+
+    plan.profile = NULL;
+    PlanProfile( &plan, constraints, goalState, prevState );
+
+    return SegmentEnd( plan.moving ? &plan.lastMoving : &plan.tail );
+}
+
+
+
+/******************************************************************************************************************************** 
+**  ReplanProfileGoal
+**
+**      Re-targets an existing profile at a goal that has moved slightly, without regenerating it.  Everything up to the start
+**      of the cruise segment is kept as is; only the end of the cruise and the deceleration to the new goal are recomputed.
+**      When the velocity limit has changed as well, the cruise is cut short at time t and the profile speeds up to, or
+**      drops to, a cruise at the new limit from there.  This matches what GenerateProfile would produce from any state on the
+**      kept part of the profile, provided the cruise is at the velocity constraint and the new goal still leaves a cruise of
+**      zero length or more.
+**
+**      Input:
+**          motionProfileList_t profile                 The profile to re-target
+**          motionProfileConstraints_t planned          The constraints the profile was generated with
+**          motionProfileConstraints_t constraints      The new constraints, which may only differ in the velocity limit
+**          motionProfileGoal_t goalState               The new goal
+**          double t                                    The time a change of cruise velocity starts at, within the cruise
+**
+**      Output:
+**          int                                         Return 1 if the profile was re-targeted, 0 if it must be regenerated
+**                                                      (the profile is left untouched)
+**
+********************************************************************************************************************************/
+int ReplanProfileGoal (motionProfileList_t *profile, motionProfileConstraints_t *planned, motionProfileConstraints_t *constraints, motionProfileGoal_t *goalState, double t) {
+    motionProfileNode_t *profileNode, *cruiseNode, *removeNode;
+    motionState_t cruiseStart, branch;
+    motionSegment_t slower;
+    double dir, vel, newVel, goalVel, distanceChange, distanceDecel, distanceCruise;
+    int changeVel;
+
+    if ( planned->maxAbsAcc != constraints->maxAbsAcc || constraints->maxAbsVel <= 0.0 ) {
+        return 0;
+    }
+
+    // Find the cruise segment.
+    cruiseNode = NULL;
+    profileNode = profile->head;
+    while ( profileNode ) {
+        if ( profileNode->segment.acc == 0.0 && EpsilonEquals( fabs( profileNode->segment.vel ), planned->maxAbsVel, kEpsilon ) ) {
+            cruiseNode = profileNode;
+            break;
+        }
+        profileNode = profileNode->next;
+    }
+    if ( !cruiseNode ) {
+        return 0;
+    }
+    cruiseStart = SegmentStart( &cruiseNode->segment );
+    dir = SignNum( cruiseStart.vel );
+
+    // The segments before the cruise must not be heading away from it (that would mean a stop and reverse was planned).
+    profileNode = profile->head;
+    while ( profileNode != cruiseNode ) {
+        if ( profileNode->segment.vel * dir < -kEpsilon ) {
+            return 0;
+        }
+        profileNode = profileNode->next;
+    }
+
+    vel = fabs( cruiseStart.vel );
+    newVel = constraints->maxAbsVel;
+    changeVel = !EpsilonEquals( vel, newVel, kEpsilon );
+    branch = cruiseStart;
+    distanceChange = 0.0;
+    if ( changeVel ) {
+        // Only a cruise already under way turns straight to the new velocity, as a fresh profile from t would.
+        if ( t < cruiseNode->segment.t || t > SegmentEndTime( &cruiseNode->segment ) ) {
+            return 0;
+        }
+        branch = Extrapolate( &cruiseStart, t, 0.0 );
+        if ( newVel > vel ) {
+            distanceChange = ( newVel * newVel - vel * vel ) / ( 2.0 * constraints->maxAbsAcc );
+        }
+    } else {
+        newVel = vel;
+    }
+    goalVel = fmin( goalState->maxAbsVel, newVel );
+    distanceDecel = ( newVel * newVel - goalVel * goalVel ) / ( 2.0 * constraints->maxAbsAcc );
+    distanceCruise = dir * ( goalState->pos - branch.pos ) - distanceChange - distanceDecel;
+    if ( distanceCruise < 0.0 || ( distanceCruise < kEpsilon && distanceDecel < kEpsilon && !changeVel ) ) {
+        // The goal moved too far back to keep cruising; the profile has to change phase.
+        return 0;
+    }
+
+    // Drop the old tail and move the cruise boundary.
+    profileNode = cruiseNode->next;
+    while ( profileNode ) {
+        removeNode = profileNode;
+        profileNode = profileNode->next;
+        DeleteProfileNode( removeNode );
+        profile->length -= 1;
+    }
+    cruiseNode->next = NULL;
+    profile->tail = cruiseNode;
+    if ( changeVel && newVel > vel ) {
+        cruiseNode->segment.dt = t - cruiseNode->segment.t;
+        AppendControl( profile, dir * constraints->maxAbsAcc, ( newVel - vel ) / constraints->maxAbsAcc );
+        AppendControl( profile, 0.0, distanceCruise / newVel );
+    } else if ( changeVel ) {
+        // A lower limit clamps the velocity at once, as GenerateProfile clamps its start state.
+        cruiseNode->segment.dt = t - cruiseNode->segment.t;
+        slower.start = branch;
+        slower.start.vel = dir * newVel;
+        slower.start.acc = 0.0;
+        slower.end = Extrapolate( &slower.start, t + distanceCruise / newVel, 0.0 );
+        AppendSegment( profile, &slower );
+    } else {
+        cruiseNode->segment.dt = distanceCruise / vel;
+    }
+
+    // Decelerate to goal velocity.
+    if ( distanceDecel > 0.0 ) {
+        AppendControl( profile, -dir * constraints->maxAbsAcc, ( newVel - goalVel ) / constraints->maxAbsAcc );
+    }
+
+    Consolidate( profile );
+    return 1;
+}
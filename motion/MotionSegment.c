@@ -77,3 +77,140 @@ int ContainsPosition (motionSegment_t *segment, double pos) {
     
     return rv;
 }
+
+
+/******************************************************************************************************************************** 
+**  CompactSegment
+**
+**      Input:
+**          motionSegment_t segment     A valid segment (see IsSegmentValid)
+**
+**      Output:
+**          compactMotionSegment_t      Return the segment as a profile keeps it
+**
+********************************************************************************************************************************/
+compactMotionSegment_t CompactSegment (motionSegment_t *segment) {
+    compactMotionSegment_t rv;
+
+    rv.t = segment->start.t;
+    rv.pos = segment->start.pos;
+    rv.vel = segment->start.vel;
+    rv.acc = segment->start.acc;
+    rv.dt = isinf( segment->start.acc ) ? segment->end.vel : segment->end.t - segment->start.t;
+
+    return rv;
+}
+
+
+/******************************************************************************************************************************** 
+**  ExpandSegment
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+motionSegment_t ExpandSegment (compactMotionSegment_t *segment) {
+    motionSegment_t rv;
+
+    rv.start = SegmentStart( segment );
+    rv.end = SegmentEnd( segment );
+
+    return rv;
+}
+
+
+/******************************************************************************************************************************** 
+**  SegmentStart
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+motionState_t SegmentStart (compactMotionSegment_t *segment) {
+    motionState_t rv;
+
+    rv.t = segment->t;
+    rv.pos = segment->pos;
+    rv.vel = segment->vel;
+    rv.acc = segment->acc;
+
+    return rv;
+}
+
+
+/******************************************************************************************************************************** 
+**  SegmentEnd
+**
+**      Input:
+**
+**      Output:
+**          motionState_t               Return the start state extrapolated over the segment
+**
+********************************************************************************************************************************/
+motionState_t SegmentEnd (compactMotionSegment_t *segment) {
+    motionState_t rv;
+
+    rv.acc = segment->acc;
+    if ( isinf( segment->acc ) ) {
+        rv.t = segment->t;
+        rv.pos = segment->pos;
+        rv.vel = segment->dt;
+    } else {
+        rv.t = segment->t + segment->dt;
+        rv.pos = segment->pos + segment->vel * segment->dt + 0.5 * segment->acc * segment->dt * segment->dt;
+        rv.vel = segment->vel + segment->acc * segment->dt;
+    }
+
+    return rv;
+}
+
+
+/******************************************************************************************************************************** 
+**  SegmentEndTime
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+double SegmentEndTime (compactMotionSegment_t *segment) {
+    double rv;
+
+    rv = isinf( segment->acc ) ? segment->t : segment->t + segment->dt;
+
+    return rv;
+}
+
+
+/******************************************************************************************************************************** 
+**  IsCompactSegmentValid
+**
+**      IsSegmentValid for a segment as a profile keeps it.  The acceleration is constant and the end state consistent with
+**      the start by construction, which leaves the velocity reversing within the segment and NaNs.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+int IsCompactSegmentValid (compactMotionSegment_t *segment) {
+    double endVel;
+
+    if ( isnan( segment->t ) || isnan( segment->pos ) || isnan( segment->vel ) || isnan( segment->acc ) || isnan( segment->dt ) ) {
+        return 0;
+    }
+    if ( isinf( segment->acc ) ) {
+        // A step in velocity (no duration), see CompactSegment.
+        endVel = segment->dt;
+    } else {
+        endVel = segment->vel + segment->acc * segment->dt;
+    }
+    if ( SignNum( segment->vel ) * SignNum( endVel ) < 0.0 && !EpsilonEquals( segment->vel, 0.0, kEpsilon ) && !EpsilonEquals( endVel, 0.0, kEpsilon ) ) {
+        // Velocity direction reverses within the segment.
+        return 0;
+    }
+
+    return 1;
+}
@@ -2,19 +2,45 @@
 #include <math.h>
 #include "Motion.h"
 #include "../utils/Utils.h"
+#include "../utils/Instrument.h"
 
 
+/******************************************************************************************************************************** 
+**  CreateProfileFollower
+**
+**      Input:
+**
+**      Output: A newly allocated and initialized profile follower.
+**
+********************************************************************************************************************************/
 profileFollower_t * CreateProfileFollower () {
     profileFollower_t *profileFollower;
 
     profileFollower = ( profileFollower_t * ) malloc( sizeof( profileFollower_t ) );
+    InitProfileFollower( profileFollower );
+
+    return profileFollower;
+}
+
+
+/******************************************************************************************************************************** 
+**  InitProfileFollower
+**
+**      Initializes a profile follower that is embedded in another structure (zero gains, no goal, unlimited output).
+**
+**      Input:
+**
+**      Output: 
+**
+********************************************************************************************************************************/
+void InitProfileFollower (profileFollower_t *profileFollower) {
     profileFollower->kP = 0.0;
     profileFollower->kI = 0.0;
     profileFollower->kV = 0.0;
     profileFollower->kFFV = 0.0;
     profileFollower->kFFA = 0.0;
-    profileFollower->minOutput = 0.0;
-    profileFollower->maxOutput = 0.0;
+    profileFollower->minOutput = -INFINITY;
+    profileFollower->maxOutput = INFINITY;
     profileFollower->latestActualState = kInvalidMotionState;
     profileFollower->initialState = kInvalidMotionState;
     profileFollower->latestPosError = 0.0;
@@ -28,8 +54,6 @@ profileFollower_t * CreateProfileFollower () {
     *(profileFollower->setpointGenerator) = kInvalidSetpointGenerator;
     profileFollower->latestSetpoint = ( setpoint_t * ) malloc( sizeof( setpoint_t ) );
     *(profileFollower->latestSetpoint) = kInvalidSetpoint;
-
-    return profileFollower;
 }
 
 /******************************************************************************************************************************** 
@@ -49,6 +73,21 @@ void SetProfileFollowerGains (profileFollower_t *profileFollower, double kp, dou
 }
 
 
+/******************************************************************************************************************************** 
+**  SetProfileFollowerReplanTolerance
+**
+**      Goal position changes up to the tolerance re-target the current profile instead of regenerating it (see GetSetpoint).
+**
+**      Input:
+**
+**      Output: 
+**
+********************************************************************************************************************************/
+void SetProfileFollowerReplanTolerance (profileFollower_t *profileFollower, double tolerance) {
+    SetGoalReplanTolerance( profileFollower->setpointGenerator, tolerance );
+}
+
+
 /******************************************************************************************************************************** 
 **  SetProfileFollowerGoalAndConstraints
 **
@@ -63,6 +102,10 @@ void SetProfileFollowerGoalAndConstraints (profileFollower_t *profileFollower, m
             // Clear the final state bit since the goal has changed.
             profileFollower->latestSetpoint->finalSetpoint = 0;
         }
+    } else {
+        // The follower has been cleared.
+        profileFollower->goal = ( motionProfileGoal_t * ) malloc( sizeof( motionProfileGoal_t ) );
+        profileFollower->constraints = ( motionProfileConstraints_t * ) malloc( sizeof( motionProfileConstraints_t ) );
     }
     *(profileFollower->goal) = *goal;
     *(profileFollower->constraints) = *constraints;
@@ -109,14 +152,18 @@ double ProfileFollowerUpdate (profileFollower_t *profileFollower, motionState_t
     motionState_t prevState;
     double dt, output;
 
+    INSTRUMENT_SCOPE( INSTRUMENT_PROFILE_FOLLOWER_UPDATE );
     profileFollower->latestActualState = *latestState;
     prevState = *latestState;
-    if ( profileFollower->latestSetpoint ) {
+    if ( profileFollower->latestSetpoint && !isnan( profileFollower->latestSetpoint->motionState.t ) ) {
         prevState = profileFollower->latestSetpoint->motionState;
     } else {
         profileFollower->initialState = prevState;
     }
-    dt = fmax( 0.0, prevState.t );
+    if ( !profileFollower->latestSetpoint ) {
+        profileFollower->latestSetpoint = ( setpoint_t * ) malloc( sizeof( setpoint_t ) );
+    }
+    dt = fmax( 0.0, t - prevState.t );
     *(profileFollower->latestSetpoint) = GetSetpoint(profileFollower->setpointGenerator, profileFollower->constraints, profileFollower->goal, &prevState, t);
    
     // Update error
@@ -2,6 +2,7 @@
 #include <math.h>
 #include "Motion.h"
 #include "../utils/Utils.h"
+#include "../utils/Instrument.h"
 
 
 /******************************************************************************************************************************** 
@@ -23,7 +24,7 @@ void ClearSetpointGenerator (setpointGenerator_t *setpointGenerator) {
         while ( node ) {
             removeNode = node;
             node = node->next;
-            free (removeNode);
+            DeleteProfileNode( removeNode );
         }
     }
     free ( setpointGenerator->profile );
@@ -49,6 +50,76 @@ void SetSetpointGenerator (setpointGenerator_t *setpointGenerator, motionProfile
 }
 
 
+/******************************************************************************************************************************** 
+**  RegenerateSetpointGenerator
+**      
+**      Same as ClearSetpointGenerator followed by SetSetpointGenerator, but reuses the generator's storage when it has any so
+**      that regenerating every control tick does not allocate (the profile nodes come from the node pool).
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void RegenerateSetpointGenerator (setpointGenerator_t *setpointGenerator, motionProfileConstraints_t *constraints, motionProfileGoal_t *goal, motionState_t *prevState) {
+    if ( !setpointGenerator->constraints || !setpointGenerator->goal || !setpointGenerator->profile ) {
+        ClearSetpointGenerator( setpointGenerator );
+        SetSetpointGenerator( setpointGenerator, constraints, goal, prevState );
+        return;
+    }
+    ClearProfile( setpointGenerator->profile );
+    *(setpointGenerator->constraints) = *constraints;
+    *(setpointGenerator->goal) = *goal;
+    *(setpointGenerator->profile) = GenerateProfile( constraints, goal, prevState );
+}
+
+
+/******************************************************************************************************************************** 
+**  SetGoalReplanTolerance
+**      
+**      Input:
+**          double tolerance        Largest goal position change handled incrementally, 0.0 to always regenerate
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void SetGoalReplanTolerance (setpointGenerator_t *setpointGenerator, double tolerance) {
+    setpointGenerator->goalReplanTolerance = tolerance;
+}
+
+
+/******************************************************************************************************************************** 
+**  CanReplanIncrementally
+**      
+**      The current profile can be re-targeted rather than regenerated when the acceleration limit and completion settings
+**      are unchanged, the goal position moved by no more than the replan tolerance and the profile still agrees with
+**      prevState.  The velocity limit may change (e.g. with the speed limit of the path segment being driven), which
+**      ReplanProfileGoal turns into a change of cruise velocity.
+**
+**      Input:
+**
+**      Output:
+**          int                     Return 1 if ReplanProfileGoal may be tried, else 0
+**
+********************************************************************************************************************************/
+int CanReplanIncrementally (setpointGenerator_t *setpointGenerator, motionProfileConstraints_t *constraints, motionProfileGoal_t *goal, motionState_t *prevState) {
+    motionState_t expectedState;
+
+    if ( setpointGenerator->goalReplanTolerance <= 0.0 || !setpointGenerator->constraints || !setpointGenerator->goal || !setpointGenerator->profile || !setpointGenerator->profile->length ) {
+        return 0;
+    }
+    if ( setpointGenerator->constraints->maxAbsAcc != constraints->maxAbsAcc || setpointGenerator->goal->completionBehavior != goal->completionBehavior ||
+         setpointGenerator->goal->posTolerance != goal->posTolerance || setpointGenerator->goal->velTolerance != goal->velTolerance ) {
+        return 0;
+    }
+    if ( fabs( setpointGenerator->goal->pos - goal->pos ) > setpointGenerator->goalReplanTolerance ) {
+        return 0;
+    }
+    expectedState = StateByTime( setpointGenerator->profile, prevState->t );
+    return MotionStatesAreEqual( &expectedState, prevState );
+}
+
+
 /******************************************************************************************************************************** 
 **  GetSetpoint
 **      
@@ -69,18 +140,27 @@ setpoint_t GetSetpoint (setpointGenerator_t *setpointGenerator, motionProfileCon
         regenerate = expectedState.t == NAN || !MotionStatesAreEqual( &expectedState, prevState ) ;
     }
     if ( regenerate ) {
-        // Regenerate the profile, as our current profile does not satisfy the inputs.
-        ClearSetpointGenerator( setpointGenerator );
-        SetSetpointGenerator( setpointGenerator, constraints, goal, prevState);
+        INSTRUMENT_SCOPE( INSTRUMENT_SETPOINT_REGENERATION );
+        if ( CanReplanIncrementally( setpointGenerator, constraints, goal, prevState ) &&
+             ReplanProfileGoal( setpointGenerator->profile, setpointGenerator->constraints, constraints, goal, prevState->t ) ) {
+            // The goal only moved slightly, the current profile has been re-targeted in place.
+            *(setpointGenerator->constraints) = *constraints;
+            *(setpointGenerator->goal) = *goal;
+            setpointGenerator->incrementalRegenerations += 1;
+        } else {
+            // Regenerate the profile, as our current profile does not satisfy the inputs.
+            RegenerateSetpointGenerator( setpointGenerator, constraints, goal, prevState );
+            setpointGenerator->fullRegenerations += 1;
+        }
     }
 
     rv.finalSetpoint = -1;
     // Sample the profile at time t.
-    if ( setpointGenerator->profile && IsProfileValid( setpointGenerator->profile ) ) {
-        if ( t > setpointGenerator->profile->tail->segment.end.t ) {
-            rv.motionState = setpointGenerator->profile->tail->segment.end;
-        } else if ( t < setpointGenerator->profile->head->segment.start.t ) {
-            rv.motionState = setpointGenerator->profile->head->segment.start;
+    if ( setpointGenerator->profile && setpointGenerator->profile->length && IsProfileValid( setpointGenerator->profile ) ) {
+        if ( t > SegmentEndTime( &setpointGenerator->profile->tail->segment ) ) {
+            rv.motionState = SegmentEnd( &setpointGenerator->profile->tail->segment );
+        } else if ( t < setpointGenerator->profile->head->segment.t ) {
+            rv.motionState = SegmentStart( &setpointGenerator->profile->head->segment );
         } else {
             rv.motionState = StateByTime( setpointGenerator->profile, t );
         } 
@@ -7,8 +7,8 @@
 #include <math.h>
 #include "Utils.h"
 #include "Geometry.h"
+#include "Instrument.h"
 #include "Path.h"
-#include "RobotStateEstimator.h"
 
 
 /******************************************************************************************************************************** 
@@ -24,6 +24,7 @@ translation2d_t GetCenter (transform2d_t *robotPose, translation2d_t *lookaheadP
     rotation2d_t normalRot;
     transform2d_t perpendicularBisector, normalFromPose, perpendicularBisectorNormal;
 
+    INSTRUMENT_SCOPE( INSTRUMENT_GET_CENTER );
     poseToPointHalfway = TranslationInterpolate( &robotPose->translation, lookaheadPoint, 0.5 );
     normalTrans = TranslationInverse(  &robotPose->translation );
     normalTrans = TranslateAbyB( &normalTrans, &poseToPointHalfway );
@@ -59,7 +60,7 @@ double GetDirection (transform2d_t *robotPose, translation2d_t *point) {
     translation2d_t robotPoseToPoint, robotRotToTrans;
     double cross;
 
-    robotPoseToPoint = TranslationDelta( point, &robotPose->translation );
+    robotPoseToPoint = TranslationDelta( &robotPose->translation, point );
     robotRotToTrans = RotationToTranslation( &robotPose->rotation );
     cross = TranslationCross( &robotRotToTrans, &robotPoseToPoint );
     return (cross < 0.0) ? -1.0 : 1.0;
@@ -73,23 +74,24 @@ double GetDirection (transform2d_t *robotPose, translation2d_t *point) {
 **      Output:
 **
 ********************************************************************************************************************************/
-double GetSteeringArcLength (transform2d_t *robotPose, translation2d_t *point, transform2d_t *center, double radius) {
+double GetSteeringArcLength (transform2d_t *robotPose, translation2d_t *point, translation2d_t *center, double radius) {
     translation2d_t centerToPoint, centerToRobotPose, robotPoseToPoint, robotPoseRotNormal;
     rotation2d_t rot;
     double c, angle, length;
-    
+
+    INSTRUMENT_SCOPE( INSTRUMENT_GET_STEERING_ARC_LENGTH );
+    robotPoseToPoint = TranslationDelta( &robotPose->translation, point );
     if ( radius < 1E6 ) {
-        centerToPoint = TranslationDelta( &center->translation, point );
-        centerToRobotPose = TranslationDelta( &center->translation, &robotPose->translation );
+        centerToPoint = TranslationDelta( center, point );
+        centerToRobotPose = TranslationDelta( center, &robotPose->translation );
 
         // If the point is behind pose, we want the opposite of this angle. To determine if the point is behind,
         // check the sign of the cross-product between the normal vector and the vector from pose to point.
-        robotPoseToPoint = TranslationDelta( point, &robotPose->translation );
         rot = RotationNormal( &robotPose->rotation );
         robotPoseRotNormal = RotationToTranslation( &rot );
-        //c = TranslationCross( &RotationNormal, &robotPoseToPoint );
+        c = TranslationCross( &robotPoseRotNormal, &robotPoseToPoint );
         angle = TranslationGetAngle( &centerToRobotPose, &centerToPoint );
-        length = radius * ( SignNum( c ) ? 2.0 * 3.14159265358979323846 - fabs(angle) : fabs(angle) );
+        length = radius * ( c > 0.0 ? 2.0 * 3.14159265358979323846 - fabs(angle) : fabs(angle) );
 
     } else {
         length = TranslationNormal( &robotPoseToPoint );
@@ -112,9 +114,19 @@ steeringComamnd_t GetSteeringUpdate (adaptivePurePursuitController_t *controller
     steeringComamnd_t steeringCommand;
     targetPoint_t targetPoint;
     translation2d_t radius;
+    transform2d_t pose;
+    rotation2d_t flip = {0.0, -1.0};
     double scale = 1.0;
 
+    // A reversed robot drives the path backwards, so steer as if it were facing the other way.
+    pose = *robotPose;
+    if ( controller->reversed ) {
+        pose.rotation = RotateAbyB( &robotPose->rotation, &flip );
+    }
+    robotPose = &pose;
+
     targetPoint = GetTargetPoint( controller->path, &controller->lookahead, &robotPose->translation );
+    controller->lastTargetPoint = targetPoint;
 
     if ( controller->atEndOfPath ) {
         steeringCommand.delta.dx_in = 0.0;
@@ -141,6 +153,9 @@ steeringComamnd_t GetSteeringUpdate (adaptivePurePursuitController_t *controller
             controller->atEndOfPath = 0;
 
         }
+        if ( controller->reversed ) {
+            scale *= -1.0;
+        }
         steeringCommand.delta.dx_in = scale * arc.length;
         steeringCommand.delta.dy_in = 0.0;
         steeringCommand.delta.dtheta_rad = arc.length * GetDirection( robotPose, &targetPoint.lookaheadPoint ) * fabs( scale ) / arc.radius; 
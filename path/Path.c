@@ -1,9 +1,11 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <math.h>
-#include "Constants.h"
+#include "RobotMap.h"
 #include "Geometry.h"
+#include "Instrument.h"
 #include "Path.h"
+#include "Utils.h"
 
 
 /******************************************************************************************************************************** 
@@ -28,13 +30,14 @@ void ExtrapolateLast (pathSegmentsList_t *segments) {
 **
 ********************************************************************************************************************************/
 motionState_t GetLastMotionState (pathSegmentsList_t *segments) {
-    motionState_t rv;
+    motionState_t rv, endState;
 
     if ( segments->length > 0 ) {
+        endState = GetSegmentEndState( &segments->tail->segment );
         rv.t = 0.0;
         rv.pos = 0.0;
-        rv.vel = segments->tail->segment.speedController->tail->segment.end.vel;
-        rv.acc = segments->tail->segment.speedController->tail->segment.end.acc;
+        rv.vel = endState.vel;
+        rv.acc = endState.acc;
     } else {
         rv.t = 0.0;
         rv.pos = 0.0;
@@ -46,6 +49,160 @@ motionState_t GetLastMotionState (pathSegmentsList_t *segments) {
 }
 
 
+/******************************************************************************************************************************** 
+**  ClearPath
+**
+**      Frees every segment of the path along with its speed profile, including the segments already driven, and the rest
+**      of a lazy path's route.
+**
+**      Input:
+**
+**      Output: 
+**
+********************************************************************************************************************************/
+void ClearPath (pathSegmentsList_t *segments) {
+    pathSegmentNode_t *segmentNode, *removeSegmentNode;
+
+    // Segments already driven are still linked in front of the head (see CheckSegmentDone).
+    segmentNode = segments->head;
+    while ( segmentNode && segmentNode->prev ) {
+        segmentNode = segmentNode->prev;
+    }
+    while ( segmentNode ) {
+        removeSegmentNode = segmentNode;
+        segmentNode = segmentNode->next;
+        ClearProfile( &removeSegmentNode->segment.speedController );
+        free( removeSegmentNode );
+    }
+    ClearPathProfile( segments );
+    free( segments->nodes );
+    free( segments->route );
+    segments->head = NULL;
+    segments->tail = NULL;
+    segments->length = 0;
+    segments->nodes = NULL;
+    segments->capacity = 0;
+    segments->profileWindow = 0;
+    segments->route = NULL;
+}
+
+
+/******************************************************************************************************************************** 
+**  ClearPathProfile
+**
+**      Frees the path-wide profile (see BuildPathProfile); the segments' own profiles are generated again as they are needed.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void ClearPathProfile (pathSegmentsList_t *segments) {
+    free( segments->profile );
+    segments->profile = NULL;
+    segments->profileLength = 0;
+}
+
+
+/******************************************************************************************************************************** 
+**  GetPieceStateByDistance
+**
+**      FirstStateByPosition on pieces low to high of the path-wide profile: a binary search for the last piece that starts
+**      before the distance, or low.
+**
+**      Input:
+**          double distance_in          Path distance from the start of the first segment, clamped to the pieces
+**
+**      Output: The state, its time counted from the start of the first segment (all NaN if there is no such state).
+**
+********************************************************************************************************************************/
+static motionState_t GetPieceStateByDistance (pathSegmentsList_t *segments, int low, int high, double distance_in) {
+    motionSegment_t segment;
+    double t;
+    int middle;
+
+    while ( low < high ) {
+        middle = low + ( high - low + 1 ) / 2;
+        if ( segments->profile[middle].pos < distance_in ) {
+            low = middle;
+        } else {
+            high = middle - 1;
+        }
+    }
+
+    segment = ExpandSegment( &segments->profile[low] );
+    if ( distance_in <= segment.start.pos ) {
+        return segment.start;
+    }
+    if ( distance_in >= segment.end.pos || EpsilonEquals( segment.end.pos, distance_in, kEpsilon ) ) {
+        return segment.end;
+    }
+    t = fmin( NextTimeAtPos( &segment.start, distance_in ), segment.end.t );
+    if ( isnan( t ) ) {
+        return kInvalidMotionState;
+    }
+    return Extrapolate( &segment.start, t, segment.start.acc );
+}
+
+
+/******************************************************************************************************************************** 
+**  GetSegmentPieceStateByDistance
+**
+**      GetPieceStateByDistance over the pieces of one segment, found from the segments' offsets into the path-wide profile.
+**
+**      Input:
+**          double distance_in          Path distance from the start of the first segment
+**
+**      Output:
+**
+********************************************************************************************************************************/
+static motionState_t GetSegmentPieceStateByDistance (pathSegmentsList_t *segments, pathSegmentNode_t *segmentNode, double distance_in) {
+    int high;
+
+    high = segmentNode->next ? segmentNode->next->profileOffset - 1 : segments->profileLength - 1;
+    return GetPieceStateByDistance( segments, segmentNode->profileOffset, high, distance_in );
+}
+
+
+/******************************************************************************************************************************** 
+**  GetPathStateByDistance
+**
+**      Input:
+**          double distance_in          Path distance from the start of the first segment, clamped to the path-wide profile
+**                                      from the head on (see BuildPathProfile)
+**
+**      Output: The first state of the path-wide profile at the distance, its time counted from the start of the first segment
+**              (all NaN if the profile has no such state).
+**
+********************************************************************************************************************************/
+motionState_t GetPathStateByDistance (pathSegmentsList_t *segments, double distance_in) {
+    return GetPieceStateByDistance( segments, segments->head->profileOffset, segments->profileLength - 1, distance_in );
+}
+
+
+/******************************************************************************************************************************** 
+**  UpdateProfileWindow
+**
+**      Generates the speed profiles of a lazy path's window, the profileWindow segments from the head (see
+**      BuildLazyPathFromWaypoints).  Nothing to do for a path whose segments all keep their profile.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void UpdateProfileWindow (pathSegmentsList_t *segments) {
+    pathSegmentNode_t *segmentNode;
+    int i;
+
+    segmentNode = segments->head;
+    for ( i = 0; i < segments->profileWindow && segmentNode; i++ ) {
+        EnsureSegmentProfile( &segmentNode->segment );
+        segmentNode = segmentNode->next;
+    }
+}
+
+
 /******************************************************************************************************************************** 
 **  CheckSegmentDone
 **
@@ -55,25 +212,65 @@ motionState_t GetLastMotionState (pathSegmentsList_t *segments) {
 **
 ********************************************************************************************************************************/
 void CheckSegmentDone (pathSegmentsList_t *segments, translation2d_t *closestPoint) {
-    pathSegmentNode_t *nextSgmentNode, *removeSegmentNode;
+    pathSegmentNode_t *nextSgmentNode;
     double remainingDist;
 
     remainingDist = GetRemainingDistance( &segments->head->segment, closestPoint );
-    if (remainingDist < kSegmentCompletionTolerance) {
-        removeSegmentNode = segments->head;
+    // The last segment is never removed, the path always has a segment to steer towards.  The finished segment stays linked
+    // behind the new head and is freed with the rest of the path by ClearPath, so the control tick never touches the heap.
+    if (remainingDist < kSegmentCompletionTolerance && segments->head->next) {
         nextSgmentNode = segments->head->next;
-        nextSgmentNode->prev = NULL;
+        if ( segments->profileWindow ) {
+            // A lazy path: the profile is not needed any more, and the window moves on one segment.
+            DropSegmentProfile( &segments->head->segment );
+        }
         segments->head = nextSgmentNode;
         segments->length -= 1;
-        ClearProfile ( removeSegmentNode->segment.speedController );
-        free( removeSegmentNode->segment.speedController );
-        free ( removeSegmentNode );
+        ExtendLazyPath( segments, segments->profileWindow + 2, 0.0 );
+        UpdateProfileWindow( segments );
     }
 }
 
+/******************************************************************************************************************************** 
+**  FindSegmentByDistance
+**
+**      Binary search of the path's index for the segment a path distance falls in, between the segment after the head and
+**      the tail.  Same rule as walking the segments one by one: the first segment that ends at or beyond the distance, or the
+**      tail when the distance is beyond the end of the path.
+**
+**      Input:
+**          double distance_in          Path distance from the start of the first segment
+**
+**      Output: The segment.
+**
+********************************************************************************************************************************/
+static pathSegmentNode_t * FindSegmentByDistance (pathSegmentsList_t *segments, double distance_in) {
+    pathSegmentNode_t *segmentNode;
+    int low, high, middle;
+
+    low = segments->head->index + 1;
+    high = segments->tail->index;
+    while ( low < high ) {
+        middle = low + ( high - low ) / 2;
+        segmentNode = segments->nodes[middle];
+        if ( segmentNode->startDistance_in + segmentNode->length_in < distance_in ) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return segments->nodes[low];
+}
+
+
 /******************************************************************************************************************************** 
 **  GetTargetPoint
 **
+**      The distances down the path come from the path's index of segments (see AddPathSegment): the remaining path distance
+**      and time are subtractions and the segment the lookahead point falls in a binary search, so the cost does not grow
+**      with the number of segments left.  With a path-wide profile the speeds are read from it by path distance, searching
+**      only the segment's own pieces.  A lazy path is built on here as the lookahead point nears the end of the part built.
+**
 **      Input:  Input the current 2D translational position of the robot.
 **
 **      Output: This function will calculate and return the data for targetPoint_t.
@@ -86,57 +283,66 @@ void CheckSegmentDone (pathSegmentsList_t *segments, translation2d_t *closestPoi
 **                  maxSpeed_ips:                   The max speed of the lookahead point(segment).
 **                  lookaheadPoint:                 The point at a lookahead distance down the path.
 **                  lookaheadPointSpeed_ips         The target speed at the lookahead point.
+**                  remainingPathTime_s:            The planned time from the closest point to the end of the path.
 **
 ********************************************************************************************************************************/
 targetPoint_t GetTargetPoint (pathSegmentsList_t *segments, lookahead_t *lookahead, translation2d_t *robotPosition) {
     pathSegmentNode_t *segmentNode;    
-    pathSegment_t currentSegment;
+    pathSegment_t *currentSegment;
     targetPoint_t targetPoint;
     translation2d_t closestPointDistance_in;
-    double lookaheadDistance, length;
-    int numSegments = 1;
+    motionState_t closestPointState, lookaheadState;
+    double lookaheadDistance, headEnd_in, pathEnd_in, pathEnd_s;
 
-    currentSegment = segments->head->segment;
+    INSTRUMENT_SCOPE( INSTRUMENT_GET_TARGET_POINT );
+    segmentNode = segments->head;
+    currentSegment = &segmentNode->segment;
 
-    targetPoint.closestPoint = GetClosestPoint( &currentSegment, robotPosition );
+    targetPoint.closestPoint = GetClosestPoint( currentSegment, robotPosition );
     closestPointDistance_in = TranslationDelta( robotPosition, &targetPoint.closestPoint );
     targetPoint.closestPointDistance_in = TranslationNormal( &closestPointDistance_in );
-    targetPoint.closestPointSpeed_ips = GetSpeedByDistance( &currentSegment, GetLength( &currentSegment ) - targetPoint.remainingSegmentDistance_in );
-    targetPoint.remainingSegmentDistance_in = GetRemainingDistance( &currentSegment, &targetPoint.closestPoint );
-    
-    targetPoint.remainingPathDistance_in = targetPoint.remainingSegmentDistance_in;
-    segmentNode = segments->head->next;
-    while (segmentNode != NULL) {
-        targetPoint.remainingPathDistance_in += GetLength( &segmentNode->segment );
-        segmentNode = segmentNode->next;
-        ++numSegments;
+    targetPoint.remainingSegmentDistance_in = GetRemainingDistance( currentSegment, &targetPoint.closestPoint );
+    headEnd_in = segmentNode->startDistance_in + segmentNode->length_in;
+    if ( segments->profile ) {
+        closestPointState = GetSegmentPieceStateByDistance( segments, segmentNode, headEnd_in - targetPoint.remainingSegmentDistance_in );
+        closestPointState.t -= segmentNode->startTime_s;
+    } else {
+        closestPointState = GetStateByDistance( currentSegment, segmentNode->length_in - targetPoint.remainingSegmentDistance_in );
     }
+    targetPoint.closestPointSpeed_ips = isnan( closestPointState.vel ) ? 0.0 : closestPointState.vel;
 
     // Calclate the lookahead distance as a funtion of target speed at the closest point on the segment
     lookaheadDistance = GetLookaheadForSpeed( lookahead, targetPoint.closestPointSpeed_ips) + targetPoint.closestPointDistance_in;
 
+    // A lazy path is built on before the lookahead point reaches its last segment (see ExtendLazyPath).
+    if ( segments->route ) {
+        ExtendLazyPath( segments, 1, headEnd_in - targetPoint.remainingSegmentDistance_in + lookaheadDistance );
+    }
+    
+    pathEnd_in = segments->tail->startDistance_in + segments->tail->length_in;
+    targetPoint.remainingPathDistance_in = targetPoint.remainingSegmentDistance_in + ( pathEnd_in - headEnd_in );
+    pathEnd_s = segments->tail->startTime_s + segments->tail->duration_s;
+    targetPoint.remainingPathTime_s = pathEnd_s - segmentNode->startTime_s - ( isnan( closestPointState.t ) ? 0.0 : closestPointState.t );
+
     // The lookahead distance extends beyond the end of the current segment, find which segment the lookahead distance ends in
-    if ( targetPoint.remainingSegmentDistance_in < lookaheadDistance && numSegments > 1 ) {
-        lookaheadDistance -= targetPoint.remainingSegmentDistance_in;
-        segmentNode = segments->head->next;
-        while (segmentNode != NULL) {
-            currentSegment = segmentNode->segment;
-            length = GetLength( &segmentNode->segment );
-            if ( length < lookaheadDistance && segmentNode->next ) {
-                lookaheadDistance -= length;
-            } else {
-                break;
-            }
-            segmentNode = segmentNode->next;
-        }
+    if ( targetPoint.remainingSegmentDistance_in < lookaheadDistance && segments->length > 1 ) {
+        lookaheadDistance += headEnd_in - targetPoint.remainingSegmentDistance_in;
+        segmentNode = FindSegmentByDistance( segments, lookaheadDistance );
+        currentSegment = &segmentNode->segment;
+        lookaheadDistance -= segmentNode->startDistance_in;
 
     // The lookahead is within the length of the current segment.
     } else {
-        lookaheadDistance += GetLength( &currentSegment ) - targetPoint.remainingSegmentDistance_in;
+        lookaheadDistance += segmentNode->length_in - targetPoint.remainingSegmentDistance_in;
+    }
+    targetPoint.maxSpeed_ips = currentSegment->maxSpeed_ips;
+    targetPoint.lookaheadPoint = GetPointByDistance( currentSegment, lookaheadDistance );
+    if ( segments->profile ) {
+        lookaheadState = GetSegmentPieceStateByDistance( segments, segmentNode, segmentNode->startDistance_in + lookaheadDistance );
+        targetPoint.lookaheadPointSpeed_ips = isnan( lookaheadState.vel ) ? 0.0 : lookaheadState.vel;
+    } else {
+        targetPoint.lookaheadPointSpeed_ips = GetSpeedByDistance( currentSegment, lookaheadDistance );
     }
-    targetPoint.maxSpeed_ips = currentSegment.maxSpeed_ips;
-    targetPoint.lookaheadPoint = GetPointByDistance( &currentSegment, lookaheadDistance );
-    targetPoint.lookaheadPointSpeed_ips = GetSpeedByDistance( &currentSegment, lookaheadDistance );
     CheckSegmentDone( segments, &targetPoint.closestPoint );
 
     return targetPoint;
@@ -1,8 +1,12 @@
 #ifndef PATH_H
 #define PATH_H
 
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include "Geometry.h"
 #include "Motion.h"
+#include "ThreadPool.h"
 
 typedef struct waypoint {
     translation2d_t position;
@@ -35,20 +39,37 @@ typedef struct pathSegment {
     translation2d_t deltaEnd;
     double maxSpeed_ips;
     int isLine;
-    motionProfileList_t *speedController;
+    motionProfileList_t speedController;
     int extrapolateLookahead;
+    motionState_t startState;       // What the speed profile is planned from, so it can be generated again (see
+    double endSpeed_ips;            // EnsureSegmentProfile)
 } pathSegment_t;  
 
 typedef struct pathSegmentNode {
     pathSegment_t segment;
     struct pathSegmentNode *prev;
     struct pathSegmentNode *next;
+    int index;                  // Position in the path, from 0 at its first segment
+    double startDistance_in;    // Path distance from the start of the first segment to the start of this one
+    double length_in;
+    double startTime_s;         // Planned time from the start of the first segment to the start of this one
+    double duration_s;          // Planned time to drive this segment
+    int profileOffset;          // First piece of this segment in the path-wide profile (see BuildPathProfile)
 } pathSegmentNode_t;
 
+// The segments are linked from the next one to drive (the head) to the end of the path.  Every segment, the ones already
+// driven included, is also kept in order in nodes, so GetTargetPoint can find a path distance by binary search.  A path
+// may instead hold its speed plan as one profile in path distance and time, the segments' own profiles then left empty.
 typedef struct pathSegmentsList {
     pathSegmentNode_t *head;
     pathSegmentNode_t *tail;
     int length;
+    pathSegmentNode_t **nodes;
+    int capacity;
+    int profileWindow;          // Segments from the head that keep a speed profile, 0 for all of them (see BuildLazyPathFromWaypoints)
+    compactMotionSegment_t *profile;    // The path-wide profile, NULL when every segment has its own (see BuildPathProfile)
+    int profileLength;
+    struct lazyRoute *route;    // Waypoints of a lazy path not built into segments yet, NULL for none (see ExtendLazyPath)
 } pathSegmentsList_t;
 
 typedef struct targetPoint {
@@ -60,6 +81,7 @@ typedef struct targetPoint {
     double maxSpeed_ips;
     translation2d_t lookaheadPoint;
     double lookaheadPointSpeed_ips;
+    double remainingPathTime_s;
 } targetPoint_t;
 
 typedef struct lookahead {
@@ -91,6 +113,7 @@ typedef struct adaptivePurePursuitController {
   int atEndOfPath;
   int reversed;
   lookahead_t lookahead;
+  targetPoint_t lastTargetPoint;
 } adaptivePurePursuitController_t;
 
 typedef struct pathFollowerParams {
@@ -106,12 +129,50 @@ typedef struct pathFollowerParams {
     double goal_pos_tolerance;
     double goal_vel_tolerance;
     double stop_steering_distance;
+    double actuation_latency;           // Delay from a command to the robot responding, s (0 steers from the pose as given)
+    double goal_replan_tolerance;       // Goal moves up to this re-target the speed profile in place, in (0 always regenerates)
 } pathFollowerParams_t;
 
+// One sample of a compiled trajectory: where the robot should be at time t and how it should be moving.  Curvature is
+// positive turning left (counter-clockwise).
+typedef struct trajectoryPoint {
+    double t;
+    transform2d_t pose;
+    double curvature;
+    double velocity;
+    double acceleration;
+    double distance;
+} trajectoryPoint_t;
+
+// A path sampled every dt seconds along its speed plan, point k at time k * dt (the last one at the end of the plan).
+typedef struct trajectory {
+    trajectoryPoint_t *points;
+    int numPoints;
+    double dt;
+    double duration;
+    double length;
+} trajectory_t;
+
+typedef struct pathProgress {
+    double distanceRemaining_in;
+    double timeRemaining_s;             // Planned time to the end of the path from the closest point
+    double percentComplete;             // Share of the path's length driven, 0 to 100
+} pathProgress_t;
+
+// The follower's progress, published every tick for other threads to poll (see GetPathProgress).  A sequence lock: the
+// follower never waits, a reader retries its few loads if a publish overlaps them.
+typedef struct pathProgressChannel {
+    _Atomic unsigned long sequence;
+    _Atomic double distanceRemaining_in;
+    _Atomic double timeRemaining_s;
+    _Atomic double percentComplete;
+} pathProgressChannel_t;
+
 typedef struct pathFollower {
     adaptivePurePursuitController_t steeringController;
     profileFollower_t velocityController;
     twist2d_t lastSteeringDelta;
+    steeringComamnd_t lastSteeringCommand;
     double inertiaGain;
     int overrideFinished;
     int doneSteering;
@@ -121,10 +182,119 @@ typedef struct pathFollower {
     double goalPosTolerance;
     double goalVelTolerance;
     double stopSteeringDistance;
+    double actuationLatency;
+    twist2d_t lastCommand;              // The twist last returned, what the robot is taken to drive until the next one acts
     double crossTrackError;
     double alongTrackError;
+    const trajectory_t *trajectory;     // When set the follower reads its commands from here (see SetPathFollowerTrajectory)
+    double trajectoryStartTime;
+    int trajectoryIndex;
+    pathProgressChannel_t progress;
 } pathFollower_t;
 
+// Builds a path one waypoint at a time (see AppendPathWaypoint).  Only the last two waypoints are kept.
+typedef struct pathBuilder {
+    pathSegmentsList_t *path;
+    waypoint_t last[2];
+    int numWaypoints;
+    pathSegmentNode_t *stopSegment;     // The final line, planned to stop, until the next waypoint replans it
+} pathBuilder_t;
+
+// The rest of a lazy path's route, built on a waypoint at a time as the path is followed.  A path is handed around by value,
+// so the builder is pointed back at it before every use.
+typedef struct lazyRoute {
+    pathBuilder_t builder;
+    int numWaypoints;
+    int next;                   // The next waypoint to build to
+    waypoint_t waypoints[];
+} lazyRoute_t;
+
+// A compiled path handed from a planning thread to the controller.  Once adopted the controller owns (and consumes) the
+// segments; when it moves on to a newer path the old one is pushed on the retired list for the planning side to free.
+typedef struct publishedPath {
+    pathSegmentsList_t segments;
+    struct publishedPath *next;
+} publishedPath_t;
+
+typedef struct pathSwap {
+    _Atomic(publishedPath_t *) pending;
+    _Atomic(publishedPath_t *) retired;
+    publishedPath_t *current;
+    long swaps;
+} pathSwap_t;
+
+// The next route built on a worker thread while the robot drives the current one (see PrefetchPath).  The request and the
+// finished path are handed over through status, so the control loop can poll for the path without ever blocking.
+enum pathPrefetchStatus_e {PATH_PREFETCH_IDLE, PATH_PREFETCH_BUILDING, PATH_PREFETCH_READY};
+
+typedef struct pathPrefetch {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int shutdown;
+    _Atomic int status;
+    waypoint_t *waypoints;      // The requested route, copied
+    waypoint_t **wps;
+    int numWaypoints;
+    int capacity;
+    motionState_t startState;
+    pathSegmentsList_t path;    // The finished path, while status is PATH_PREFETCH_READY
+} pathPrefetch_t;
+
+#define ROUTE_SEQUENCER_MAX_ROUTES 16
+
+typedef struct sequencedRoute {
+    pathSegmentsList_t *path;
+    double handoffSpeed_ips;    // Speed carried onto the next route, 0 to stop at the end of this one
+} sequencedRoute_t;
+
+// Drives a list of paths one after the other with a single follower, so its speed profile and steering carry across (see
+// GetRouteSequencerUpdate).  The routes are held in place: a tick never allocates and costs the same as a follower tick.
+typedef struct routeSequencer {
+    pathFollower_t *follower;
+    sequencedRoute_t routes[ROUTE_SEQUENCER_MAX_ROUTES];
+    int numRoutes;
+    int current;
+} routeSequencer_t;
+
+// A compiled path held by a path cache, found by a hash of its waypoints and the speed constraints.  The segments are
+// shared by everyone who acquired the entry: they are never changed while the entry is in use, and following a copy of the
+// list only moves the copy's head.
+#define PATH_CACHE_BUCKETS 64        // Power of two
+
+typedef struct pathCacheEntry {
+    uint64_t key;
+    waypoint_t *waypoints;
+    int numWaypoints;
+    pathSegmentsList_t segments;
+    size_t bytes;
+    int refs;
+    struct pathCacheEntry *prev;
+    struct pathCacheEntry *next;
+    struct pathCacheEntry *bucketNext;  // Next entry in the same bucket
+} pathCacheEntry_t;
+
+typedef struct pathCacheStats {
+    long hits;
+    long misses;                // Not in memory, either loaded from disk or built
+    long diskHits;
+    long evictions;
+    int entries;
+    size_t bytes;
+} pathCacheStats_t;
+
+// Entries are kept in least recently used order under a memory budget, and optionally written to a directory from which
+// they are loaded again once evicted (or by the next run).  They are found through a table of buckets by key.
+typedef struct pathCache {
+    pthread_mutex_t lock;
+    pathCacheEntry_t *head;     // Most recently used
+    pathCacheEntry_t *tail;
+    pathCacheEntry_t *buckets[PATH_CACHE_BUCKETS];
+    size_t budgetBytes;
+    char *directory;            // NULL keeps the cache in memory only
+    pathCacheStats_t stats;
+} pathCache_t;
+
 
 // PathSegment.c
 motionProfileList_t CreateMotionProfiler (motionState_t *startState, double endSpeed, double maxSpeed, double length);
@@ -134,14 +304,30 @@ double GetRemainingDistance (pathSegment_t *segment, translation2d_t *position);
 translation2d_t GetPointByDistance (pathSegment_t *segment, double dist);
 double GetDistanceTravelled (pathSegment_t *segment, translation2d_t *robotPosition);
 double GetSpeedByDistance(pathSegment_t *segment, double dist);
+motionState_t GetStateByDistance (pathSegment_t *segment, double dist);
 double GetSpeedByClosePoint (pathSegment_t *segment, translation2d_t *robotPosition);
+motionState_t GetMotionProfilerEndState (motionState_t *startState, double endSpeed, double maxSpeed, double length);
+void EnsureSegmentProfile (pathSegment_t *segment);
+void DropSegmentProfile (pathSegment_t *segment);
+motionState_t GetSegmentEndState (pathSegment_t *segment);
 
 // PathBuilder.c
 pathSegmentsList_t BuildPathFromWaypoints (waypoint_t *wps[], int size);
+pathSegmentsList_t BuildPathFromState (waypoint_t *wps[], int size, motionState_t *startState);
 line_t CreateLine (waypoint_t *a, waypoint_t *b);
 translation2d_t Intersect (line_t *lineA, line_t *lineB);
 arc_t CreateArc(waypoint_t *a, waypoint_t *b, waypoint_t *c);
 void AddPathSegment (pathSegmentsList_t *segments, pathSegmentNode_t *segment);
+pathSegmentNode_t * CreateLineSegment (line_t *line, motionState_t *startState, double endSpeed);
+pathSegmentNode_t * CreateArcSegment (arc_t *arc, motionState_t *startState);
+pathSegmentsList_t BuildPathFromWaypointsParallel (waypoint_t *wps[], int size, threadPool_t *pool);
+void InitPathBuilder (pathBuilder_t *builder, pathSegmentsList_t *path);
+int AppendPathWaypoint (pathBuilder_t *builder, waypoint_t *waypoint);
+pathSegmentsList_t BuildLazyPathFromWaypoints (waypoint_t *wps[], int size, int window);
+void ExtendLazyPath (pathSegmentsList_t *path, int segments, double distance_in);
+void CompleteLazyPath (pathSegmentsList_t *path);
+void ReplanPath (pathSegmentsList_t *path, motionState_t *startState, double endSpeed);
+int BuildPathProfile (pathSegmentsList_t *path);
 
 
 // Lookahead.c
@@ -152,18 +338,62 @@ targetPoint_t GetTargetPoint (pathSegmentsList_t *segments, lookahead_t *lookahe
 void ExtrapolateLast (pathSegmentsList_t *segments);
 motionState_t GetLastMotionState (pathSegmentsList_t *segments);
 void CheckSegmentDone (pathSegmentsList_t *segments, translation2d_t *closestPoint);
+void ClearPath (pathSegmentsList_t *segments);
+void UpdateProfileWindow (pathSegmentsList_t *segments);
+void ClearPathProfile (pathSegmentsList_t *segments);
+motionState_t GetPathStateByDistance (pathSegmentsList_t *segments, double distance_in);
 
 
 // AdaptivePurePursuit.c
 steeringComamnd_t GetSteeringUpdate (adaptivePurePursuitController_t *controller, transform2d_t *robotPose);
-double GetSteeringArcLength (transform2d_t *robotPose, translation2d_t *point, transform2d_t *center, double radius);
+double GetSteeringArcLength (transform2d_t *robotPose, translation2d_t *point, translation2d_t *center, double radius);
 translation2d_t GetCenter (transform2d_t *robotPose, translation2d_t *lookaheadPoint);
 double GetDirection (transform2d_t *robotPose, translation2d_t *point);
-double GetSteeringArcLength (transform2d_t *robotPose, translation2d_t *point, transform2d_t *center, double radius);
 
 
 // PathFollower.c
+pathFollowerParams_t GetDefaultPathFollowerParams (void);
+void InitPathFollower (pathFollower_t *pathFollower, pathSegmentsList_t *path, int reversed, pathFollowerParams_t *params);
+void ClearPathFollower (pathFollower_t *pathFollower);
+void SetPathFollowerPath (pathFollower_t *pathFollower, pathSegmentsList_t *path);
+transform2d_t PredictPathFollowerPose (pathFollower_t *pathFollower, transform2d_t *robotPose);
+twist2d_t GetPathFollowerUpdate (pathFollower_t *pathFollower, double t, double displacement, double velocity, transform2d_t *robotPose);
+int PathFollowerIsFinished (pathFollower_t *pathFollower);
+void GetPathProgress (pathFollower_t *pathFollower, pathProgress_t *progress);
+
+// Trajectory.c
+int CompileTrajectory (pathSegmentsList_t *path, double dt, trajectory_t *trajectory);
+void ClearTrajectory (trajectory_t *trajectory);
+const trajectoryPoint_t * GetTrajectoryPoint (const trajectory_t *trajectory, double t);
+void GetTrajectoryWheelSpeeds (const trajectoryPoint_t *point, double trackWidth_in, double *left_ips, double *right_ips);
+void SetPathFollowerTrajectory (pathFollower_t *pathFollower, const trajectory_t *trajectory, double startTime);
+twist2d_t GetTrajectoryFollowerUpdate (pathFollower_t *pathFollower, double t, transform2d_t *robotPose);
+
+// PathSwap.c
+void InitPathSwap (pathSwap_t *swap);
+void DestroyPathSwap (pathSwap_t *swap);
+int PublishPath (pathSwap_t *swap, pathSegmentsList_t *path);
+int AdoptPublishedPath (pathSwap_t *swap, pathFollower_t *pathFollower);
+int ReclaimRetiredPaths (pathSwap_t *swap);
+
+// PathCache.c
+int InitPathCache (pathCache_t *cache, size_t budgetBytes, const char *directory);
+void DestroyPathCache (pathCache_t *cache);
+pathCacheEntry_t * AcquireCachedPath (pathCache_t *cache, waypoint_t *wps[], int size, pathSegmentsList_t *path);
+void ReleaseCachedPath (pathCache_t *cache, pathCacheEntry_t *entry);
+void GetPathCacheStats (pathCache_t *cache, pathCacheStats_t *stats);
+
+// PathPrefetch.c
+int InitPathPrefetch (pathPrefetch_t *prefetch);
+void DestroyPathPrefetch (pathPrefetch_t *prefetch);
+int PrefetchPath (pathPrefetch_t *prefetch, waypoint_t *wps[], int size, pathSegmentsList_t *current);
+int TakePrefetchedPath (pathPrefetch_t *prefetch, pathSegmentsList_t *path);
 
+// RouteSequencer.c
+void InitRouteSequencer (routeSequencer_t *sequencer, pathFollower_t *pathFollower);
+int AddSequencerRoute (routeSequencer_t *sequencer, pathSegmentsList_t *path, double handoffSpeed_ips);
+twist2d_t GetRouteSequencerUpdate (routeSequencer_t *sequencer, double t, double displacement, double velocity, transform2d_t *robotPose);
+int RouteSequencerIsFinished (routeSequencer_t *sequencer);
 
 
 #endif
\ No newline at end of file
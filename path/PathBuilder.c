@@ -1,7 +1,23 @@
+#include <limits.h>
+#include <math.h>
 #include <stdlib.h>
 #include "Geometry.h"
 #include "Motion.h"
 #include "Path.h"
+#include "ThreadPool.h"
+
+// Corners given to each task of a parallel build, at least (see BuildPathFromWaypointsParallel).
+#define PARALLEL_BUILD_MIN_CORNERS 64
+
+// A parallel build: slot 2i is the line into corner i, 2i + 1 its arc, the last slot the final line (NULL where there is no
+// segment).
+typedef struct parallelPathBuild {
+    waypoint_t **wps;
+    int numCorners;
+    int numSlots;
+    int numChunks;
+    pathSegmentNode_t **slots;
+} parallelPathBuild_t;
 
 
 /******************************************************************************************************************************** 
@@ -45,10 +61,12 @@ translation2d_t Intersect (line_t *lineA, line_t *lineB) {
     transformA.rotation.cosTheta_rad = lineA->slope.x_in;
     transformA.rotation.sinTheta_rad = lineA->slope.y_in; 
     transformA.rotation = RotationNormalize ( &transformA.rotation );      
+    transformA.rotation = RotationNormal ( &transformA.rotation );
     transformB.translation = lineB->start;
     transformB.rotation.cosTheta_rad = lineB->slope.x_in;
     transformB.rotation.sinTheta_rad = lineB->slope.y_in; 
     transformB.rotation = RotationNormalize ( &transformB.rotation );      
+    transformB.rotation = RotationNormal ( &transformB.rotation );
     rv = Intersection( &transformA, &transformB);
 
     return rv;
@@ -81,29 +99,251 @@ arc_t CreateArc(waypoint_t *a, waypoint_t *b, waypoint_t *c) {
 }
 
 /******************************************************************************************************************************** 
-**  AddPathSegment
+**  UpdatePathTiming
+**
+**      Works out the planned duration of the segment from its speed plan, and the start times of it and every segment after
+**      it.  Called whenever a segment is added or planned again.
 **
 **      Input:
 **
 **      Output:
 **
 ********************************************************************************************************************************/
-void AddPathSegment (pathSegmentsList_t *segments, pathSegmentNode_t *segment) {
-    if ( !segments ) {
+static void UpdatePathTiming (pathSegmentNode_t *segmentNode) {
+    for ( ; segmentNode; segmentNode = segmentNode->next ) {
+        segmentNode->startTime_s = segmentNode->prev ? segmentNode->prev->startTime_s + segmentNode->prev->duration_s : 0.0;
+        segmentNode->duration_s = GetSegmentEndState( &segmentNode->segment ).t;
+    }
+}
+
+
+/******************************************************************************************************************************** 
+**  LinkPathSegment
+**
+**      Links the segment, whose length and planned duration are set, at the end of the path and records its place, path
+**      distance and start time in the path's index of segments.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+static void LinkPathSegment (pathSegmentsList_t *segments, pathSegmentNode_t *segment) {
+    int count;
+
+    if ( !segments->length ) {
         segment->next = NULL;
         segment->prev = NULL;    
-        segments = malloc( sizeof( pathSegmentsList_t ) );
+        segment->index = 0;
+        segment->startDistance_in = 0.0;
         segments->head = segment;
         segments->tail = segment;
         segments->length = 1;                    
     } else {
         segment->next = NULL;
         segment->prev = segments->tail;
+        segment->index = segments->tail->index + 1;
+        segment->startDistance_in = segments->tail->startDistance_in + segments->tail->length_in;
+        segments->tail->next = segment;
         segments->tail = segment;
         segments->length += 1;    
     }
+    segment->startTime_s = segment->prev ? segment->prev->startTime_s + segment->prev->duration_s : 0.0;
+
+    count = segment->index + 1;
+    if ( count > segments->capacity ) {
+        segments->capacity = segments->capacity ? 2 * segments->capacity : 16;
+        while ( segments->capacity < count ) {
+            segments->capacity *= 2;
+        }
+        segments->nodes = realloc( segments->nodes, segments->capacity * sizeof( pathSegmentNode_t * ) );
+    }
+    segments->nodes[segment->index] = segment;
+}
+
+
+/******************************************************************************************************************************** 
+**  AddPathSegment
+**
+**      Links the segment at the end of the path and records its place, path distance and planned time in the path's index of
+**      segments.  A path-wide profile no longer covers the path, so it is dropped for the segments' own (see BuildPathProfile).
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void AddPathSegment (pathSegmentsList_t *segments, pathSegmentNode_t *segment) {
+    ClearPathProfile( segments );
+    segment->length_in = GetLength( &segment->segment );
+    segment->duration_s = GetSegmentEndState( &segment->segment ).t;
+    LinkPathSegment( segments, segment );
+}
+
+/******************************************************************************************************************************** 
+**  GetEndMotionState
+**
+**      Input:
+**
+**      Output: The state the speed profile of the segment ends in, as the start of the next one (see GetLastMotionState).
+**
+********************************************************************************************************************************/
+static motionState_t GetEndMotionState (pathSegmentNode_t *segmentNode) {
+    motionState_t rv = {0.0, 0.0, 0.0, 0.0};
+    motionState_t endState;
+
+    endState = GetSegmentEndState( &segmentNode->segment );
+    rv.vel = endState.vel;
+    rv.acc = endState.acc;
+    return rv;
+}
+
+
+/******************************************************************************************************************************** 
+**  NewLineSegment, NewArcSegment
+**
+**      A new segment planned from the given start state, without its speed profile yet (see EnsureSegmentProfile).
+**
+**      Output: The segment, or NULL if it has no length.
+**
+********************************************************************************************************************************/
+static pathSegmentNode_t * NewLineSegment (line_t *line, motionState_t *startState, double endSpeed) {
+    pathSegmentNode_t *nextSegment;
+    translation2d_t deltaStart;
+
+    deltaStart = TranslationDelta( &line->start, &line->end );
+    if ( TranslationNormal( &deltaStart ) <= 1e-9 ) {
+        return NULL;
+    }
+    nextSegment = malloc( sizeof( pathSegmentNode_t ) );
+    nextSegment->segment.start = line->start;
+    nextSegment->segment.end = line->end;
+    nextSegment->segment.deltaStart = deltaStart;
+    nextSegment->segment.maxSpeed_ips = line->speed_ips;
+    nextSegment->segment.isLine = 1;
+    nextSegment->segment.center.x_in = 0.0;
+    nextSegment->segment.center.y_in = 0.0;
+    nextSegment->segment.deltaEnd.x_in = 0.0;
+    nextSegment->segment.deltaEnd.y_in = 0.0;
+    nextSegment->segment.extrapolateLookahead = 0;
+    nextSegment->segment.startState = *startState;
+    nextSegment->segment.endSpeed_ips = endSpeed;
+    nextSegment->segment.speedController.head = NULL;
+    nextSegment->segment.speedController.tail = NULL;
+    nextSegment->segment.speedController.length = 0;
+
+    return nextSegment;
+}
+
+static pathSegmentNode_t * NewArcSegment (arc_t *arc, motionState_t *startState) {
+    pathSegmentNode_t *nextSegment;
+
+    if ( !( arc->radius > 1e-9 && arc->radius < 1e9 ) ) {
+        return NULL;
+    }
+    nextSegment = malloc( sizeof( pathSegmentNode_t ) );
+    nextSegment->segment.start = arc->lineA.end;
+    nextSegment->segment.end = arc->lineB.start;
+    nextSegment->segment.deltaStart = TranslationDelta( &arc->center, &arc->lineA.end );
+    nextSegment->segment.deltaEnd = TranslationDelta( &arc->center, &arc->lineB.start );
+    nextSegment->segment.maxSpeed_ips = arc->speed_ips;
+    nextSegment->segment.isLine = 0;
+    nextSegment->segment.center = arc->center;
+    nextSegment->segment.extrapolateLookahead = 0;
+    nextSegment->segment.startState = *startState;
+    nextSegment->segment.endSpeed_ips = arc->lineB.speed_ips;
+    nextSegment->segment.speedController.head = NULL;
+    nextSegment->segment.speedController.tail = NULL;
+    nextSegment->segment.speedController.length = 0;
+
+    return nextSegment;
+}
+
+
+/******************************************************************************************************************************** 
+**  CreateLineSegment
+**
+**      Input:
+**          line_t line                 The line, driven at up to the speed of its end waypoint
+**          motionState_t startState    State the speed profile starts in
+**          double endSpeed             Speed to plan for at the end of the line
+**
+**      Output: A new segment, or NULL if the line has no length.
+**
+********************************************************************************************************************************/
+pathSegmentNode_t * CreateLineSegment (line_t *line, motionState_t *startState, double endSpeed) {
+    pathSegmentNode_t *nextSegment;
+
+    nextSegment = NewLineSegment( line, startState, endSpeed );
+    if ( nextSegment ) {
+        EnsureSegmentProfile( &nextSegment->segment );
+    }
+
+    return nextSegment;
+}
+
+
+/******************************************************************************************************************************** 
+**  CreateArcSegment
+**
+**      Input:
+**          motionState_t startState    State the speed profile starts in
+**
+**      Output: A new segment, or NULL if the corner has no arc.
+**
+********************************************************************************************************************************/
+pathSegmentNode_t * CreateArcSegment (arc_t *arc, motionState_t *startState) {
+    pathSegmentNode_t *nextSegment;
+
+    nextSegment = NewArcSegment( arc, startState );
+    if ( nextSegment ) {
+        EnsureSegmentProfile( &nextSegment->segment );
+    }
+
+    return nextSegment;
+}
+
+
+/******************************************************************************************************************************** 
+**  AddLineSegment, AddArcSegment
+**
+**      Append a segment whose speed profile carries on from the end of the path, or from firstState if the path is empty.
+**      A lazy path's segment is only planned; it gets its profile in the window (see UpdateProfileWindow).
+**
+**      Output: The segment appended to the path, or NULL if there is none (nothing is appended).
+**
+********************************************************************************************************************************/
+static pathSegmentNode_t * AddLineSegment (pathSegmentsList_t *path, line_t *line, double endSpeed, motionState_t *firstState) {
+    pathSegmentNode_t *nextSegment;
+    motionState_t startState;
+
+    startState = path->length ? GetLastMotionState( path ) : *firstState;
+    nextSegment = NewLineSegment( line, &startState, endSpeed );
+    if ( nextSegment ) {
+        if ( !path->profileWindow ) {
+            EnsureSegmentProfile( &nextSegment->segment );
+        }
+        AddPathSegment( path, nextSegment );
+    }
+    return nextSegment;
 }
 
+static pathSegmentNode_t * AddArcSegment (pathSegmentsList_t *path, arc_t *arc, motionState_t *firstState) {
+    pathSegmentNode_t *nextSegment;
+    motionState_t startState;
+
+    startState = path->length ? GetLastMotionState( path ) : *firstState;
+    nextSegment = NewArcSegment( arc, &startState );
+    if ( nextSegment ) {
+        if ( !path->profileWindow ) {
+            EnsureSegmentProfile( &nextSegment->segment );
+        }
+        AddPathSegment( path, nextSegment );
+    }
+    return nextSegment;
+}
+
+
 /******************************************************************************************************************************** 
 **  BuildPathFromWaypoints
 **
@@ -113,77 +353,475 @@ void AddPathSegment (pathSegmentsList_t *segments, pathSegmentNode_t *segment) {
 **
 ********************************************************************************************************************************/
 pathSegmentsList_t BuildPathFromWaypoints (waypoint_t *wps[], int size) {
+    motionState_t rest = {0.0, 0.0, 0.0, 0.0};
+
+    return BuildPathFromState( wps, size, &rest );
+}
+
+
+/******************************************************************************************************************************** 
+**  BuildPathFromState
+**
+**      Builds a path whose speed plan starts in the given state rather than at rest, e.g. the state the path before it ends
+**      in (see GetLastMotionState) when one route follows another.
+**
+**      Input:
+**          motionState_t startState    State the first segment's speed profile starts in (only vel and acc are used)
+**
+**      Output:
+**
+********************************************************************************************************************************/
+pathSegmentsList_t BuildPathFromState (waypoint_t *wps[], int size, motionState_t *startState) {
     pathSegmentsList_t path = {NULL, NULL, 0};
-    pathSegmentNode_t *nextSegment;
+    motionState_t firstState = {0.0, 0.0, startState->vel, startState->acc};
     arc_t arc;
     line_t line;
-    translation2d_t deltaStart, deltaEnd;
-    motionProfileList_t speedController;
-    motionState_t startState;
-    int i = 0;
-
-    if (size > 2) {
-        do {
-            arc = CreateArc( wps[i], wps[i+1], wps[i+2] );  
-            deltaStart = TranslationDelta( &arc.lineA.start, &arc.lineA.end );
-            if ( TranslationNormal( &deltaStart ) > 1e-9 ) {
-                nextSegment = malloc( sizeof( pathSegmentNode_t ) );
-                nextSegment->segment.start = arc.lineA.start;
-                nextSegment->segment.end = arc.lineA.end;
-                nextSegment->segment.deltaStart = deltaStart;
-                nextSegment->segment.maxSpeed_ips = arc.lineA.speed_ips;
-                nextSegment->segment.isLine = 1;
-                nextSegment->segment.center.x_in = 0.0;
-                nextSegment->segment.center.y_in = 0.0;
-                nextSegment->segment.deltaEnd.x_in = 0.0;
-                nextSegment->segment.deltaEnd.y_in = 0.0;
-                nextSegment->segment.extrapolateLookahead = 0;
-                startState = GetLastMotionState( &path );
-                speedController = CreateMotionProfiler( &startState, arc.speed_ips, arc.lineA.waypointB.speed_ips, GetLength( &nextSegment->segment ) );
-                nextSegment->segment.speedController = &speedController;
-                AddPathSegment( &path, nextSegment );
-            }
+    int i;
 
-            if ( arc.radius > 1e-9 && arc.radius < 1e9 ) {
-                nextSegment = malloc( sizeof( pathSegment_t ) );
-                deltaStart = TranslationDelta( &arc.center, &arc.lineA.end );
-                deltaEnd = TranslationDelta( &arc.center, &arc.lineB.start );
-                nextSegment->segment.start = arc.lineA.end;
-                nextSegment->segment.end = arc.lineB.start;
-                nextSegment->segment.deltaStart = deltaStart;
-                nextSegment->segment.deltaEnd = deltaEnd;
-                nextSegment->segment.maxSpeed_ips = arc.speed_ips;
-                nextSegment->segment.isLine = 0;
-                nextSegment->segment.center = arc.center;
-                nextSegment->segment.extrapolateLookahead = 0;
-                startState = GetLastMotionState( &path );
-                speedController = CreateMotionProfiler( &startState, arc.lineB.speed_ips, arc.speed_ips, GetLength( &nextSegment->segment ) );
-                nextSegment->segment.speedController = &speedController;
-                AddPathSegment( &path, nextSegment );
-            }
-            ++i;
-        } while (i < size - 2);
+    if ( size < 2 ) {
+        return path;
+    }
+
+    for ( i = 0; i < size - 2; i++ ) {
+        arc = CreateArc( wps[i], wps[i+1], wps[i+2] );
+        AddLineSegment( &path, &arc.lineA, arc.speed_ips, &firstState );
+        AddArcSegment( &path, &arc, &firstState );
     }
 
+    // The path stops at its last waypoint.
     line = CreateLine( wps[size - 2], wps[size - 1] );
-    deltaStart = TranslationDelta( &line.start, &line.end );
-    if ( TranslationNormal( &deltaStart ) > 1e-9 ) {
-        nextSegment = malloc( sizeof( pathSegment_t ) );
-        nextSegment->segment.start = line.start;
-        nextSegment->segment.end = line.end;
-        nextSegment->segment.deltaStart = deltaStart;
-        nextSegment->segment.maxSpeed_ips = line.speed_ips;
-        nextSegment->segment.isLine = 1;
-        nextSegment->segment.center.x_in = 0.0;
-        nextSegment->segment.center.y_in = 0.0;
-        nextSegment->segment.deltaEnd.x_in = 0.0;
-        nextSegment->segment.deltaEnd.y_in = 0.0;
-        nextSegment->segment.extrapolateLookahead = 0;
-        startState = GetLastMotionState( &path );
-        speedController = CreateMotionProfiler( &startState, 0.0, line.waypointB.speed_ips, GetLength( &nextSegment->segment ) );
-        nextSegment->segment.speedController = &speedController;
-        AddPathSegment( &path, nextSegment );
-    }    
+    AddLineSegment( &path, &line, 0.0, &firstState );
+    if ( path.length ) {
+        ExtrapolateLast( &path );
+    }
 
     return path;
 }
+
+
+/******************************************************************************************************************************** 
+**  InitPathBuilder
+**
+**      Sets up building a path one waypoint at a time with AppendPathWaypoint, e.g. while a planner is still producing them.
+**
+**      Input:
+**          pathSegmentsList_t path     The path to build, empty; it may be followed from its first segment on
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void InitPathBuilder (pathBuilder_t *builder, pathSegmentsList_t *path) {
+    path->head = NULL;
+    path->tail = NULL;
+    path->length = 0;
+    path->nodes = NULL;
+    path->capacity = 0;
+    path->profileWindow = 0;
+    path->profile = NULL;
+    path->profileLength = 0;
+    path->route = NULL;
+    builder->path = path;
+    builder->numWaypoints = 0;
+    builder->stopSegment = NULL;
+}
+
+
+/******************************************************************************************************************************** 
+**  AppendPathWaypoint
+**
+**      Extends the path to one more waypoint.  The path always stops at its last waypoint, so the new corner is planned from
+**      the last three waypoints: the final line is replanned to carry the corner speed instead of stopping, and the corner's
+**      arc and a new final line are appended.  Nothing before the final line is touched, so the path is never rebuilt, and
+**      after all the waypoints it is the same as BuildPathFromWaypoints builds from them.  A path being followed may be
+**      extended between control ticks, as long as the follower has not reached its end yet.  A lazy path's segments are
+**      only planned, their profiles are left to its window (see ExtendLazyPath).
+**
+**      Input:
+**          waypoint_t waypoint         The next waypoint (copied)
+**
+**      Output: The number of segments appended.
+**
+********************************************************************************************************************************/
+int AppendPathWaypoint (pathBuilder_t *builder, waypoint_t *waypoint) {
+    pathSegmentNode_t *stopSegment;
+    motionState_t startState = {0.0, 0.0, 0.0, 0.0}, rest = {0.0, 0.0, 0.0, 0.0};
+    arc_t arc;
+    line_t line;
+    int segments;
+
+    ClearPathProfile( builder->path );
+    segments = builder->path->length;
+    if ( builder->numWaypoints < 2 ) {
+        builder->last[builder->numWaypoints] = *waypoint;
+        builder->numWaypoints += 1;
+        if ( builder->numWaypoints < 2 ) {
+            return 0;
+        }
+    } else {
+        arc = CreateArc( &builder->last[0], &builder->last[1], waypoint );
+        stopSegment = builder->stopSegment;
+        if ( stopSegment ) {
+            // Same plan as BuildPathFromWaypoints gives the first line of a corner, from the end of the segment before.
+            if ( stopSegment->prev ) {
+                startState = GetEndMotionState( stopSegment->prev );
+            }
+            stopSegment->segment.startState = startState;
+            stopSegment->segment.endSpeed_ips = arc.speed_ips;
+            DropSegmentProfile( &stopSegment->segment );
+            if ( !builder->path->profileWindow ) {
+                EnsureSegmentProfile( &stopSegment->segment );
+            }
+            UpdatePathTiming( stopSegment );
+        }
+        if ( builder->path->length ) {
+            builder->path->tail->segment.extrapolateLookahead = 0;
+        }
+        AddArcSegment( builder->path, &arc, &rest );
+        builder->last[0] = builder->last[1];
+        builder->last[1] = *waypoint;
+        builder->numWaypoints += 1;
+    }
+
+    line = CreateLine( &builder->last[0], &builder->last[1] );
+    builder->stopSegment = AddLineSegment( builder->path, &line, 0.0, &rest );
+    if ( builder->path->length ) {
+        ExtrapolateLast( builder->path );
+    }
+
+    return builder->path->length - segments;
+}
+
+
+/******************************************************************************************************************************** 
+**  BuildPathChunk
+**
+**      Thread pool task: creates the segments of one range of corners in their slots, with their lengths but without speed
+**      profiles yet.
+**
+**      Input:
+**          int index                   The chunk
+**
+**      Output:
+**
+********************************************************************************************************************************/
+static void BuildPathChunk (void *context, int index) {
+    parallelPathBuild_t *build = context;
+    motionState_t state = {0.0, 0.0, 0.0, 0.0};
+    arc_t arc;
+    line_t line;
+    int first, last, i;
+
+    first = (int) ( (long) build->numCorners * index / build->numChunks );
+    last = (int) ( (long) build->numCorners * ( index + 1 ) / build->numChunks );
+    for ( i = first; i < last; i++ ) {
+        arc = CreateArc( build->wps[i], build->wps[i+1], build->wps[i+2] );
+        build->slots[2 * i] = NewLineSegment( &arc.lineA, &state, arc.speed_ips );
+        build->slots[2 * i + 1] = NewArcSegment( &arc, &state );
+    }
+    if ( index == build->numChunks - 1 ) {
+        line = CreateLine( build->wps[build->numCorners], build->wps[build->numCorners + 1] );
+        build->slots[2 * build->numCorners] = NewLineSegment( &line, &state, 0.0 );
+    }
+    for ( i = 2 * first; i < 2 * last + ( index == build->numChunks - 1 ); i++ ) {
+        if ( build->slots[i] ) {
+            build->slots[i]->length_in = GetLength( &build->slots[i]->segment );
+        }
+    }
+}
+
+
+/******************************************************************************************************************************** 
+**  ProfilePathChunk
+**
+**      Thread pool task: generates the speed profiles of one range of slots, whose start states have been planned, and sets
+**      the durations they plan.
+**
+**      Input:
+**          int index                   The chunk
+**
+**      Output:
+**
+********************************************************************************************************************************/
+static void ProfilePathChunk (void *context, int index) {
+    parallelPathBuild_t *build = context;
+    int first, last, slot;
+
+    first = (int) ( (long) build->numSlots * index / build->numChunks );
+    last = (int) ( (long) build->numSlots * ( index + 1 ) / build->numChunks );
+    for ( slot = first; slot < last; slot++ ) {
+        if ( build->slots[slot] ) {
+            EnsureSegmentProfile( &build->slots[slot]->segment );
+            build->slots[slot]->duration_s = GetSegmentEndState( &build->slots[slot]->segment ).t;
+        }
+    }
+}
+
+
+/******************************************************************************************************************************** 
+**  BuildPathFromWaypointsParallel
+**
+**      Builds the same path as BuildPathFromWaypoints on the thread pool.  The geometry of each segment only depends on its
+**      waypoints, so the segments are created in ranges of corners in parallel.  A speed profile starts where the one before
+**      ends, so one pass in order then plans the state every segment starts in, working out where each profile ends
+**      without generating it (see GetProfileEndState).  With those fixed, the profiles are generated in ranges in
+**      parallel, and the segments linked in order, their lengths and durations already worked out in the parallel passes.
+**      The result is identical to the serial build.
+**
+**      Input:
+**          threadPool_t pool           The threads to build on
+**
+**      Output: The path, empty if there are fewer than 2 waypoints or memory ran out.
+**
+********************************************************************************************************************************/
+pathSegmentsList_t BuildPathFromWaypointsParallel (waypoint_t *wps[], int size, threadPool_t *pool) {
+    pathSegmentsList_t path = {NULL, NULL, 0};
+    parallelPathBuild_t build;
+    pathSegmentNode_t *segmentNode;
+    motionState_t state = {0.0, 0.0, 0.0, 0.0}, endState;
+    int i;
+
+    if ( size < 2 ) {
+        return path;
+    }
+    build.wps = wps;
+    build.numCorners = size - 2;
+    build.numSlots = 2 * build.numCorners + 1;
+    build.numChunks = ( build.numCorners + PARALLEL_BUILD_MIN_CORNERS - 1 ) / PARALLEL_BUILD_MIN_CORNERS;
+    if ( build.numChunks > 4 * pool->numThreads ) {
+        build.numChunks = 4 * pool->numThreads;
+    }
+    if ( build.numChunks < 1 ) {
+        build.numChunks = 1;
+    }
+    build.slots = malloc( build.numSlots * sizeof( pathSegmentNode_t * ) );
+    if ( !build.slots ) {
+        return path;
+    }
+
+    RunThreadPool( pool, BuildPathChunk, &build, build.numChunks );
+    for ( i = 0; i < build.numSlots; i++ ) {
+        segmentNode = build.slots[i];
+        if ( segmentNode ) {
+            segmentNode->segment.startState = state;
+            endState = GetMotionProfilerEndState( &state, segmentNode->segment.endSpeed_ips, segmentNode->segment.maxSpeed_ips, segmentNode->length_in );
+            state.vel = endState.vel;
+            state.acc = endState.acc;
+        }
+    }
+    RunThreadPool( pool, ProfilePathChunk, &build, build.numChunks );
+
+    path.nodes = malloc( build.numSlots * sizeof( pathSegmentNode_t * ) );
+    path.capacity = path.nodes ? build.numSlots : 0;
+    for ( i = 0; i < build.numSlots; i++ ) {
+        if ( build.slots[i] ) {
+            LinkPathSegment( &path, build.slots[i] );
+        }
+    }
+    if ( path.length ) {
+        ExtrapolateLast( &path );
+    } else {
+        ClearPath( &path );
+    }
+
+    free( build.slots );
+    return path;
+}
+
+
+/******************************************************************************************************************************** 
+**  BuildLazyPathFromWaypoints
+**
+**      Builds the same path as BuildPathFromWaypoints, but only as far as it is needed, and only the segments in a window
+**      from the head get a speed profile.  The waypoints are copied, and the path is built a waypoint at a time as the
+**      window moves on and the lookahead point nears its end (see ExtendLazyPath).  The speeds are planned forward, each
+**      segment from the end of the one before to the speed of the next corner, so the part built is planned the same as the
+**      whole route.  As the robot moves on, the profiles of segments passed are dropped and the window's generated (see
+**      CheckSegmentDone), and a lookahead point beyond the window has its segment's profile generated on demand (see
+**      GetSpeedByDistance).  So the build, the segments held ahead of the robot and the profiles held do not grow with the
+**      route's length.  Until the route is all built, the remaining distance and time the follower reports are to the end
+**      of the part built.
+**
+**      Input:
+**          int window                  Segments from the head to keep a speed profile for, 1 or more
+**
+**      Output: The path, empty if there are fewer than 2 waypoints or memory ran out.
+**
+********************************************************************************************************************************/
+pathSegmentsList_t BuildLazyPathFromWaypoints (waypoint_t *wps[], int size, int window) {
+    pathSegmentsList_t path = {NULL, NULL, 0};
+    lazyRoute_t *route;
+    int k;
+
+    route = ( size >= 2 ) ? malloc( sizeof( lazyRoute_t ) + size * sizeof( waypoint_t ) ) : NULL;
+    if ( !route ) {
+        return path;
+    }
+    InitPathBuilder( &route->builder, &path );
+    route->numWaypoints = size;
+    route->next = 0;
+    for ( k = 0; k < size; k++ ) {
+        route->waypoints[k] = *wps[k];
+    }
+    path.profileWindow = ( window > 1 ) ? window : 1;
+    path.route = route;
+    ExtendLazyPath( &path, path.profileWindow + 2, 0.0 );
+
+    return path;
+}
+
+
+/******************************************************************************************************************************** 
+**  ExtendLazyPath
+**
+**      Builds a lazy path on from the rest of its route until it holds a number of segments from the head and its last
+**      segment starts beyond a path distance, or the route is all built.  The last segment is planned to stop until the
+**      waypoint after it replans it (see AppendPathWaypoint), so it is kept beyond the window and the lookahead point: the
+**      segments the follower reads are then planned as BuildPathFromWaypoints plans them.  Building allocates the new
+**      segments, and freeing the route once it is built, so the ticks that extend the path touch the heap.
+**
+**      Input:
+**          int segments                Segments from the head, the head included, to build
+**          double distance_in          Path distance from the start of the first segment the last segment must start beyond
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void ExtendLazyPath (pathSegmentsList_t *path, int segments, double distance_in) {
+    lazyRoute_t *route = path->route;
+
+    if ( !route ) {
+        return;
+    }
+    route->builder.path = path;
+    while ( route->next < route->numWaypoints && ( path->length < segments || path->tail->startDistance_in <= distance_in ) ) {
+        AppendPathWaypoint( &route->builder, &route->waypoints[route->next] );
+        route->next += 1;
+    }
+    if ( route->next == route->numWaypoints ) {
+        free( route );
+        path->route = NULL;
+    }
+    UpdateProfileWindow( path );
+}
+
+
+/******************************************************************************************************************************** 
+**  CompleteLazyPath
+**
+**      Builds the rest of a lazy path's route, for what needs the whole path.  Nothing to do for any other path.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void CompleteLazyPath (pathSegmentsList_t *path) {
+    ExtendLazyPath( path, INT_MAX, INFINITY );
+}
+
+
+/******************************************************************************************************************************** 
+**  ReplanPath
+**
+**      Plans the speeds of the path from its head again, from another start state and to another end speed, e.g. to carry
+**      speed from one path onto the next (see AddSequencerRoute).  The geometry is kept and the profiles are generated
+**      again, only within the window for a lazy path, or as one path-wide profile again for a path that has one.  The rest
+**      of a lazy path's route is built first, as the end speed is the route's.
+**
+**      Input:
+**          motionState_t startState    State the head's speed profile starts in (only vel and acc are used)
+**          double endSpeed             Speed to plan for at the end of the path
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void ReplanPath (pathSegmentsList_t *path, motionState_t *startState, double endSpeed) {
+    pathSegmentNode_t *segmentNode;
+    motionState_t state = {0.0, 0.0, startState->vel, startState->acc};
+    int pathWide;
+
+    CompleteLazyPath( path );
+    if ( !path->length ) {
+        return;
+    }
+    pathWide = ( path->profile != NULL );
+    path->tail->segment.endSpeed_ips = endSpeed;
+    for ( segmentNode = path->head; segmentNode; segmentNode = segmentNode->next ) {
+        segmentNode->segment.startState = state;
+        DropSegmentProfile( &segmentNode->segment );
+        if ( !path->profileWindow && !pathWide ) {
+            EnsureSegmentProfile( &segmentNode->segment );
+        }
+        state = GetEndMotionState( segmentNode );
+    }
+    UpdatePathTiming( path->head );
+    UpdateProfileWindow( path );
+    if ( pathWide ) {
+        BuildPathProfile( path );
+    }
+}
+
+
+/********************************************************************************************************************************
+**  BuildPathProfile
+**
+**      Switches the path over to one speed profile for the whole path: every segment's profile, shifted to the segment's
+**      path distance and start time, end to end in a single array, with each segment's first piece recorded in its
+**      profileOffset.  The segments' own profiles are handed back to the node pool, and GetTargetPoint finds the speeds at
+**      the closest and lookahead points with one binary search over the array (see GetPathStateByDistance) instead of
+**      walking a segment's profile.  The rest of a lazy path's route is built first; its segments are profiled one at a time
+**      on the way, and it no longer keeps a window.  Appending to the path drops the path-wide profile again (see AddPathSegment).
+**
+**      This saves building the per-segment profile nodes only for a lazy path: a path from BuildPathFromWaypoints has
+**      already generated every segment's profile, and only hands the nodes back here.  To compile a path-wide profile
+**      without ever holding the whole path's profile nodes, build with BuildLazyPathFromWaypoints (a window of 1 will do).
+**
+**      Input:
+**
+**      Output: Returns 0, or -1 if the path is empty or memory ran out (the path then goes on with its segments' profiles).
+**
+********************************************************************************************************************************/
+int BuildPathProfile (pathSegmentsList_t *path) {
+    pathSegmentNode_t *segmentNode;
+    motionProfileNode_t *profileNode;
+    compactMotionSegment_t *profile, *grown;
+    int length = 0, capacity = 0, i;
+
+    CompleteLazyPath( path );
+    ClearPathProfile( path );
+    if ( !path->length ) {
+        return -1;
+    }
+    profile = NULL;
+    for ( i = 0; i <= path->tail->index; i++ ) {
+        segmentNode = path->nodes[i];
+        EnsureSegmentProfile( &segmentNode->segment );
+        if ( length + segmentNode->segment.speedController.length > capacity ) {
+            capacity = capacity ? 2 * capacity : 64;
+            while ( capacity < length + segmentNode->segment.speedController.length ) {
+                capacity *= 2;
+            }
+            grown = realloc( profile, capacity * sizeof( compactMotionSegment_t ) );
+            if ( !grown ) {
+                free( profile );
+                UpdateProfileWindow( path );
+                return -1;
+            }
+            profile = grown;
+        }
+        segmentNode->profileOffset = length;
+        for ( profileNode = segmentNode->segment.speedController.head; profileNode; profileNode = profileNode->next ) {
+            profile[length] = profileNode->segment;
+            profile[length].t += segmentNode->startTime_s;
+            profile[length].pos += segmentNode->startDistance_in;
+            length += 1;
+        }
+        DropSegmentProfile( &segmentNode->segment );
+    }
+    grown = realloc( profile, length * sizeof( compactMotionSegment_t ) );
+    path->profile = grown ? grown : profile;
+    path->profileLength = length;
+    path->profileWindow = 0;
+
+    return 0;
+}
@@ -0,0 +1,701 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "../robot/RobotMap.h"
+#include "Path.h"
+
+#define PATH_CACHE_MAGIC "PATHC001"
+#define PATH_CACHE_VERSION 3
+
+// A cache file is this header, the waypoints, then per segment a pathCacheFileSegment_t followed by its speed profile
+// segments, in the host's byte order.
+typedef struct pathCacheFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t numWaypoints;
+    uint64_t key;
+    uint32_t numSegments;
+    uint32_t reserved;
+} pathCacheFileHeader_t;
+
+typedef struct pathCacheFileSegment {
+    translation2d_t start;
+    translation2d_t end;
+    translation2d_t center;
+    translation2d_t deltaStart;
+    translation2d_t deltaEnd;
+    double maxSpeed_ips;
+    motionState_t startState;
+    double endSpeed_ips;
+    int32_t isLine;
+    int32_t extrapolateLookahead;
+    int32_t profileLength;
+    int32_t reserved;
+} pathCacheFileSegment_t;
+
+
+/********************************************************************************************************************************
+**  HashWords
+**
+**      FNV-1a over 64 bit words instead of bytes, which is plenty to tell routes apart (a hit still compares the waypoints).
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+static uint64_t HashWords (uint64_t hash, const void *data, size_t size) {
+    uint64_t word;
+    size_t i;
+
+    for ( i = 0; i < size; i += sizeof( word ) ) {
+        word = 0;
+        memcpy( &word, (const char *) data + i, ( size - i < sizeof( word ) ) ? size - i : sizeof( word ) );
+        hash ^= word;
+        hash *= 0x100000001B3ULL;
+    }
+    return hash ^ ( hash >> 29 );
+}
+
+
+/********************************************************************************************************************************
+**  HashWaypoints
+**
+**      The key of a path: its waypoints, the acceleration limit its speed profiles are planned with and the cache format.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+static uint64_t HashWaypoints (waypoint_t *wps[], int size) {
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    uint32_t version = PATH_CACHE_VERSION;
+    double maxAccel = kPathFollowingMaxAccel;
+    int i;
+
+    hash = HashWords( hash, &version, sizeof( version ) );
+    hash = HashWords( hash, &maxAccel, sizeof( maxAccel ) );
+    hash = HashWords( hash, &size, sizeof( size ) );
+    for ( i = 0; i < size; i++ ) {
+        hash = HashWords( hash, wps[i], sizeof( waypoint_t ) );
+    }
+    return hash;
+}
+
+
+/********************************************************************************************************************************
+**  EntryMatches
+**
+**      Input:
+**
+**      Output: Returns 1 if the entry was compiled from exactly these waypoints.
+**
+********************************************************************************************************************************/
+static int EntryMatches (pathCacheEntry_t *entry, uint64_t key, waypoint_t *wps[], int size) {
+    int i;
+
+    if ( entry->key != key || entry->numWaypoints != size ) {
+        return 0;
+    }
+    for ( i = 0; i < size; i++ ) {
+        if ( memcmp( &entry->waypoints[i], wps[i], sizeof( waypoint_t ) ) ) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+
+/********************************************************************************************************************************
+**  GetPathBytes
+**
+**      Input:
+**
+**      Output: Heap held by the path's segments and speed profiles.
+**
+********************************************************************************************************************************/
+static size_t GetPathBytes (pathSegmentsList_t *path) {
+    pathSegmentNode_t *node;
+    size_t bytes = 0;
+
+    for ( node = path->head; node; node = node->next ) {
+        bytes += sizeof( pathSegmentNode_t );
+        bytes += node->segment.speedController.length * sizeof( motionProfileNode_t );
+    }
+    bytes += path->capacity * sizeof( pathSegmentNode_t * );
+    return bytes;
+}
+
+
+/********************************************************************************************************************************
+**  NewEntry
+**
+**      Input:
+**          pathSegmentsList_t path     The compiled path, which the entry takes over
+**
+**      Output: The entry, or NULL if it could not be allocated (the path is left with the caller).
+**
+********************************************************************************************************************************/
+static pathCacheEntry_t * NewEntry (uint64_t key, waypoint_t *wps[], int size, pathSegmentsList_t *path) {
+    pathCacheEntry_t *entry;
+    int i;
+
+    entry = malloc( sizeof( pathCacheEntry_t ) );
+    if ( !entry ) {
+        return NULL;
+    }
+    entry->waypoints = malloc( size * sizeof( waypoint_t ) );
+    if ( !entry->waypoints ) {
+        free( entry );
+        return NULL;
+    }
+    for ( i = 0; i < size; i++ ) {
+        entry->waypoints[i] = *wps[i];
+    }
+    entry->key = key;
+    entry->numWaypoints = size;
+    entry->segments = *path;
+    entry->bytes = sizeof( pathCacheEntry_t ) + size * sizeof( waypoint_t ) + GetPathBytes( path );
+    entry->refs = 0;
+    entry->prev = NULL;
+    entry->next = NULL;
+    entry->bucketNext = NULL;
+    return entry;
+}
+
+
+/********************************************************************************************************************************
+**  FreeEntry
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+static void FreeEntry (pathCacheEntry_t *entry) {
+    ClearPath( &entry->segments );
+    free( entry->waypoints );
+    free( entry );
+}
+
+
+/********************************************************************************************************************************
+**  UnlinkEntry, LinkEntryFirst
+**
+**      Least recently used order.  The cache must be locked.
+**
+********************************************************************************************************************************/
+static void UnlinkEntry (pathCache_t *cache, pathCacheEntry_t *entry) {
+    if ( entry->prev ) {
+        entry->prev->next = entry->next;
+    } else {
+        cache->head = entry->next;
+    }
+    if ( entry->next ) {
+        entry->next->prev = entry->prev;
+    } else {
+        cache->tail = entry->prev;
+    }
+    entry->prev = NULL;
+    entry->next = NULL;
+    cache->stats.entries -= 1;
+    cache->stats.bytes -= entry->bytes;
+}
+
+static void LinkEntryFirst (pathCache_t *cache, pathCacheEntry_t *entry) {
+    entry->prev = NULL;
+    entry->next = cache->head;
+    if ( cache->head ) {
+        cache->head->prev = entry;
+    } else {
+        cache->tail = entry;
+    }
+    cache->head = entry;
+    cache->stats.entries += 1;
+    cache->stats.bytes += entry->bytes;
+}
+
+
+/********************************************************************************************************************************
+**  FindEntry, AddBucketEntry, RemoveBucketEntry
+**
+**      The bucket table, indexed by the low bits of the key.  The cache must be locked.
+**
+********************************************************************************************************************************/
+static pathCacheEntry_t * FindEntry (pathCache_t *cache, uint64_t key, waypoint_t *wps[], int size) {
+    pathCacheEntry_t *entry;
+
+    entry = cache->buckets[key & ( PATH_CACHE_BUCKETS - 1 )];
+    while ( entry && !EntryMatches( entry, key, wps, size ) ) {
+        entry = entry->bucketNext;
+    }
+    return entry;
+}
+
+static void AddBucketEntry (pathCache_t *cache, pathCacheEntry_t *entry) {
+    pathCacheEntry_t **bucket = &cache->buckets[entry->key & ( PATH_CACHE_BUCKETS - 1 )];
+
+    entry->bucketNext = *bucket;
+    *bucket = entry;
+}
+
+static void RemoveBucketEntry (pathCache_t *cache, pathCacheEntry_t *entry) {
+    pathCacheEntry_t **link;
+
+    for ( link = &cache->buckets[entry->key & ( PATH_CACHE_BUCKETS - 1 )]; *link != entry; link = &( *link )->bucketNext );
+    *link = entry->bucketNext;
+    entry->bucketNext = NULL;
+}
+
+
+/********************************************************************************************************************************
+**  EvictOverBudget
+**
+**      Drops the least recently used entries nobody holds until the cache fits its budget.  The cache must be locked.
+**
+**      Input:
+**
+**      Output: The evicted entries, linked by next, for the caller to free once unlocked.
+**
+********************************************************************************************************************************/
+static pathCacheEntry_t * EvictOverBudget (pathCache_t *cache) {
+    pathCacheEntry_t *entry, *prev, *evicted = NULL;
+
+    for ( entry = cache->tail; entry && cache->stats.bytes > cache->budgetBytes; entry = prev ) {
+        prev = entry->prev;
+        if ( !entry->refs ) {
+            UnlinkEntry( cache, entry );
+            RemoveBucketEntry( cache, entry );
+            entry->next = evicted;
+            evicted = entry;
+            cache->stats.evictions += 1;
+        }
+    }
+    return evicted;
+}
+
+
+/********************************************************************************************************************************
+**  FreeEntries
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+static void FreeEntries (pathCacheEntry_t *entry) {
+    pathCacheEntry_t *next;
+
+    for ( ; entry; entry = next ) {
+        next = entry->next;
+        FreeEntry( entry );
+    }
+}
+
+
+/********************************************************************************************************************************
+**  GetCacheFileName
+**
+**      Input:
+**
+**      Output: Returns 0, or -1 if the name does not fit.
+**
+********************************************************************************************************************************/
+static int GetCacheFileName (pathCache_t *cache, uint64_t key, char *fileName, size_t size) {
+    int length;
+
+    length = snprintf( fileName, size, "%s/%016llx.path", cache->directory, (unsigned long long) key );
+    return ( length < 0 || (size_t) length >= size ) ? -1 : 0;
+}
+
+
+/********************************************************************************************************************************
+**  WriteCacheFile
+**
+**      Writes the path to a temporary file that is then renamed into place, so readers never see a partial file.
+**
+**      Input:
+**
+**      Output: Returns 0, or -1 if the file could not be written.
+**
+********************************************************************************************************************************/
+static int WriteCacheFile (pathCache_t *cache, uint64_t key, waypoint_t *wps[], int size, pathSegmentsList_t *path) {
+    pathCacheFileHeader_t header;
+    pathCacheFileSegment_t fileSegment;
+    pathSegmentNode_t *node;
+    motionProfileNode_t *profileNode;
+    char fileName[4096], tempName[4096 + 32];
+    FILE *file;
+    int i, rv = 0;
+
+    if ( GetCacheFileName( cache, key, fileName, sizeof( fileName ) ) ) {
+        return -1;
+    }
+    snprintf( tempName, sizeof( tempName ), "%s.%ld.tmp", fileName, (long) getpid() );
+    file = fopen( tempName, "wb" );
+    if ( !file ) {
+        return -1;
+    }
+
+    memset( &header, 0, sizeof( header ) );
+    memcpy( header.magic, PATH_CACHE_MAGIC, sizeof( header.magic ) );
+    header.version = PATH_CACHE_VERSION;
+    header.numWaypoints = (uint32_t) size;
+    header.key = key;
+    header.numSegments = (uint32_t) path->length;
+    rv |= fwrite( &header, sizeof( header ), 1, file ) != 1;
+    for ( i = 0; i < size; i++ ) {
+        rv |= fwrite( wps[i], sizeof( waypoint_t ), 1, file ) != 1;
+    }
+    for ( node = path->head; node; node = node->next ) {
+        memset( &fileSegment, 0, sizeof( fileSegment ) );
+        fileSegment.start = node->segment.start;
+        fileSegment.end = node->segment.end;
+        fileSegment.center = node->segment.center;
+        fileSegment.deltaStart = node->segment.deltaStart;
+        fileSegment.deltaEnd = node->segment.deltaEnd;
+        fileSegment.maxSpeed_ips = node->segment.maxSpeed_ips;
+        fileSegment.startState = node->segment.startState;
+        fileSegment.endSpeed_ips = node->segment.endSpeed_ips;
+        fileSegment.isLine = node->segment.isLine;
+        fileSegment.extrapolateLookahead = node->segment.extrapolateLookahead;
+        fileSegment.profileLength = node->segment.speedController.length;
+        rv |= fwrite( &fileSegment, sizeof( fileSegment ), 1, file ) != 1;
+        for ( profileNode = node->segment.speedController.head; profileNode; profileNode = profileNode->next ) {
+            rv |= fwrite( &profileNode->segment, sizeof( compactMotionSegment_t ), 1, file ) != 1;
+        }
+    }
+    rv |= fclose( file ) != 0;
+    if ( rv || rename( tempName, fileName ) ) {
+        unlink( tempName );
+        return -1;
+    }
+    return 0;
+}
+
+
+/********************************************************************************************************************************
+**  ReadCacheBytes
+**
+**      Input:
+**
+**      Output: Returns 0, or -1 if the file ends first.
+**
+********************************************************************************************************************************/
+static int ReadCacheBytes (const char **cursor, const char *end, void *data, size_t size) {
+    if ( (size_t) ( end - *cursor ) < size ) {
+        return -1;
+    }
+    memcpy( data, *cursor, size );
+    *cursor += size;
+    return 0;
+}
+
+
+/********************************************************************************************************************************
+**  ReadCacheSegment
+**
+**      Input:
+**
+**      Output: Returns 0, or -1 if the file is short or memory ran out (what was read is left on the path).
+**
+********************************************************************************************************************************/
+static int ReadCacheSegment (const char **cursor, const char *end, pathSegmentsList_t *path) {
+    pathCacheFileSegment_t fileSegment;
+    pathSegmentNode_t *node;
+    motionProfileList_t *profile;
+    motionProfileNode_t *profileNode;
+    int j;
+
+    if ( ReadCacheBytes( cursor, end, &fileSegment, sizeof( fileSegment ) ) || fileSegment.profileLength < 0 ||
+         (size_t) ( end - *cursor ) / sizeof( compactMotionSegment_t ) < (size_t) fileSegment.profileLength ) {
+        return -1;
+    }
+    node = malloc( sizeof( pathSegmentNode_t ) );
+    if ( !node ) {
+        return -1;
+    }
+    profile = &node->segment.speedController;
+    profile->head = NULL;
+    profile->tail = NULL;
+    profile->length = 0;
+    node->segment.start = fileSegment.start;
+    node->segment.end = fileSegment.end;
+    node->segment.center = fileSegment.center;
+    node->segment.deltaStart = fileSegment.deltaStart;
+    node->segment.deltaEnd = fileSegment.deltaEnd;
+    node->segment.maxSpeed_ips = fileSegment.maxSpeed_ips;
+    node->segment.startState = fileSegment.startState;
+    node->segment.endSpeed_ips = fileSegment.endSpeed_ips;
+    node->segment.isLine = fileSegment.isLine;
+    node->segment.extrapolateLookahead = fileSegment.extrapolateLookahead;
+    AddPathSegment( path, node );
+
+    for ( j = 0; j < fileSegment.profileLength; j++ ) {
+        profileNode = NewProfileNode();
+        if ( !profileNode ) {
+            return -1;
+        }
+        ReadCacheBytes( cursor, end, &profileNode->segment, sizeof( compactMotionSegment_t ) );
+        profileNode->next = NULL;
+        if ( profile->tail ) {
+            profile->tail->next = profileNode;
+        } else {
+            profile->head = profileNode;
+        }
+        profile->tail = profileNode;
+        profile->length += 1;
+    }
+    return 0;
+}
+
+
+/********************************************************************************************************************************
+**  ReadCacheFile
+**
+**      Maps the file and decodes it.
+**
+**      Input:
+**
+**      Output:
+**          pathSegmentsList_t path     The path stored for exactly these waypoints
+**          int                         Return 0, or -1 if there is no such file or it does not match
+**
+********************************************************************************************************************************/
+static int ReadCacheFile (pathCache_t *cache, uint64_t key, waypoint_t *wps[], int size, pathSegmentsList_t *path) {
+    pathCacheFileHeader_t header;
+    waypoint_t waypoint;
+    struct stat info;
+    char fileName[4096], *data;
+    const char *cursor, *end;
+    uint32_t i;
+    int fd;
+    int rv = 0;
+
+    path->head = NULL;
+    path->tail = NULL;
+    path->length = 0;
+    path->nodes = NULL;
+    path->capacity = 0;
+    path->profileWindow = 0;
+    path->profile = NULL;
+    path->profileLength = 0;
+    path->route = NULL;
+    if ( GetCacheFileName( cache, key, fileName, sizeof( fileName ) ) ) {
+        return -1;
+    }
+    fd = open( fileName, O_RDONLY );
+    if ( fd < 0 ) {
+        return -1;
+    }
+    if ( fstat( fd, &info ) || info.st_size <= 0 ) {
+        close( fd );
+        return -1;
+    }
+    data = mmap( NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    close( fd );
+    if ( data == MAP_FAILED ) {
+        return -1;
+    }
+
+    cursor = data;
+    end = data + info.st_size;
+    if ( ReadCacheBytes( &cursor, end, &header, sizeof( header ) ) || memcmp( header.magic, PATH_CACHE_MAGIC, sizeof( header.magic ) ) ||
+         header.version != PATH_CACHE_VERSION || header.key != key || header.numWaypoints != (uint32_t) size || !header.numSegments ) {
+        rv = -1;
+    }
+    for ( i = 0; !rv && i < header.numWaypoints; i++ ) {
+        if ( ReadCacheBytes( &cursor, end, &waypoint, sizeof( waypoint ) ) || memcmp( &waypoint, wps[i], sizeof( waypoint ) ) ) {
+            rv = -1;
+        }
+    }
+    for ( i = 0; !rv && i < header.numSegments; i++ ) {
+        rv = ReadCacheSegment( &cursor, end, path );
+    }
+    munmap( data, info.st_size );
+    if ( rv ) {
+        ClearPath( path );
+    }
+    return rv;
+}
+
+
+/********************************************************************************************************************************
+**  InitPathCache
+**
+**      Input:
+**          size_t budgetBytes          Memory the unused entries may hold; entries in use are never evicted
+**          const char directory        Existing directory for the disk tier, or NULL
+**
+**      Output: Returns 0, or -1 if the cache could not be set up.
+**
+********************************************************************************************************************************/
+int InitPathCache (pathCache_t *cache, size_t budgetBytes, const char *directory) {
+    memset( cache, 0, sizeof( pathCache_t ) );
+    cache->budgetBytes = budgetBytes;
+    if ( directory ) {
+        cache->directory = strdup( directory );
+        if ( !cache->directory ) {
+            return -1;
+        }
+    }
+    if ( pthread_mutex_init( &cache->lock, NULL ) ) {
+        free( cache->directory );
+        return -1;
+    }
+    return 0;
+}
+
+
+/********************************************************************************************************************************
+**  DestroyPathCache
+**
+**      Frees every entry.  No path acquired from the cache may still be in use.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void DestroyPathCache (pathCache_t *cache) {
+    FreeEntries( cache->head );
+    cache->head = NULL;
+    cache->tail = NULL;
+    memset( cache->buckets, 0, sizeof( cache->buckets ) );
+    free( cache->directory );
+    cache->directory = NULL;
+    pthread_mutex_destroy( &cache->lock );
+}
+
+
+/********************************************************************************************************************************
+**  AcquireCachedPath
+**
+**      Returns the path compiled from these waypoints, built (and written to the disk tier) on a miss.  The path's segments
+**      are shared: the caller may follow its list, but must not change or free the segments (no ClearPath, PublishPath or
+**      PathSwap), and gives them back with ReleaseCachedPath.  Thread safe; paths are built and read from disk unlocked.
+**
+**      Input:
+**          waypoint_t wps              The waypoints, as for BuildPathFromWaypoints
+**
+**      Output:
+**          pathSegmentsList_t path     The caller's own list of the shared segments
+**          pathCacheEntry_t            The entry to release, or NULL if no path could be compiled (the list is then empty)
+**
+********************************************************************************************************************************/
+pathCacheEntry_t * AcquireCachedPath (pathCache_t *cache, waypoint_t *wps[], int size, pathSegmentsList_t *path) {
+    pathCacheEntry_t *entry, *newEntry, *evicted;
+    pathSegmentsList_t built;
+    uint64_t key;
+    int fromDisk = 0;
+
+    path->head = NULL;
+    path->tail = NULL;
+    path->length = 0;
+    path->nodes = NULL;
+    path->capacity = 0;
+    path->profileWindow = 0;
+    path->profile = NULL;
+    path->profileLength = 0;
+    path->route = NULL;
+    if ( size < 2 ) {
+        return NULL;
+    }
+    key = HashWaypoints( wps, size );
+
+    pthread_mutex_lock( &cache->lock );
+    entry = FindEntry( cache, key, wps, size );
+    if ( entry ) {
+        entry->refs += 1;
+        UnlinkEntry( cache, entry );
+        LinkEntryFirst( cache, entry );
+        cache->stats.hits += 1;
+        *path = entry->segments;
+        pthread_mutex_unlock( &cache->lock );
+        return entry;
+    }
+    cache->stats.misses += 1;
+    pthread_mutex_unlock( &cache->lock );
+
+    if ( cache->directory && !ReadCacheFile( cache, key, wps, size, &built ) ) {
+        fromDisk = 1;
+    } else {
+        built = BuildPathFromWaypoints( wps, size );
+        if ( !built.length ) {
+            return NULL;
+        }
+        if ( cache->directory ) {
+            WriteCacheFile( cache, key, wps, size, &built );
+        }
+    }
+    newEntry = NewEntry( key, wps, size, &built );
+    if ( !newEntry ) {
+        ClearPath( &built );
+        return NULL;
+    }
+
+    // Another thread may have compiled the same path meanwhile; everyone shares the first one in.
+    pthread_mutex_lock( &cache->lock );
+    if ( fromDisk ) {
+        cache->stats.diskHits += 1;
+    }
+    entry = FindEntry( cache, key, wps, size );
+    if ( !entry ) {
+        entry = newEntry;
+        newEntry = NULL;
+        LinkEntryFirst( cache, entry );
+        AddBucketEntry( cache, entry );
+    }
+    entry->refs += 1;
+    *path = entry->segments;
+    evicted = EvictOverBudget( cache );
+    pthread_mutex_unlock( &cache->lock );
+
+    if ( newEntry ) {
+        FreeEntry( newEntry );
+    }
+    FreeEntries( evicted );
+    return entry;
+}
+
+
+/********************************************************************************************************************************
+**  ReleaseCachedPath
+**
+**      Gives back a path from AcquireCachedPath.  The entry stays cached until it is evicted to keep within the budget.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void ReleaseCachedPath (pathCache_t *cache, pathCacheEntry_t *entry) {
+    pathCacheEntry_t *evicted;
+
+    pthread_mutex_lock( &cache->lock );
+    entry->refs -= 1;
+    evicted = EvictOverBudget( cache );
+    pthread_mutex_unlock( &cache->lock );
+    FreeEntries( evicted );
+}
+
+
+/********************************************************************************************************************************
+**  GetPathCacheStats
+**
+**      Input:
+**
+**      Output:
+**          pathCacheStats_t stats      Counters since InitPathCache, and the entries and bytes held now
+**
+********************************************************************************************************************************/
+void GetPathCacheStats (pathCache_t *cache, pathCacheStats_t *stats) {
+    pthread_mutex_lock( &cache->lock );
+    *stats = cache->stats;
+    pthread_mutex_unlock( &cache->lock );
+}
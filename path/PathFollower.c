@@ -1,22 +1,288 @@
 #include <math.h>
+#include <stdlib.h>
+#include <string.h>
 #include "../utils/Geometry.h"
 #include "../motion/Motion.h"
 #include "Path.h"
 
 
+/********************************************************************************************************************************
+**  GetDefaultPathFollowerParams
+**
+**      The standard controller parameters the runners start from: speed feedforward only, 60 in/s and 120 in/s^2, no
+**      inertia gain, actuation latency or goal replan tolerance.
+**
+**      Input:
+**
+**      Output: The parameters.
+**
+********************************************************************************************************************************/
+pathFollowerParams_t GetDefaultPathFollowerParams (void) {
+    pathFollowerParams_t params = {
+        .lookahead = { .minDistance_in = 12.0, .maxDistance_in = 36.0, .minSpeed_ips = 4.0, .maxSpeed_ips = 120.0 },
+        .profile_kffv = 1.0,
+        .profile_max_abs_vel = 60.0,
+        .profile_max_abs_acc = 120.0,
+        .goal_pos_tolerance = 0.75,
+        .goal_vel_tolerance = 12.0,
+        .stop_steering_distance = 9.0,
+    };
+
+    return params;
+}
+
+
+/******************************************************************************************************************************** 
+**  InitPathFollower
+**
+**      Sets up a path follower for the given path.  The follower steers along the path (which it then owns and consumes) and
+**      controls its speed with a profile follower using the given parameters.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void InitPathFollower (pathFollower_t *pathFollower, pathSegmentsList_t *path, int reversed, pathFollowerParams_t *params) {
+    motionProfileConstraints_t constraints;
+
+    pathFollower->steeringController.path = path;
+    pathFollower->steeringController.atEndOfPath = 0;
+    pathFollower->steeringController.reversed = reversed;
+    pathFollower->steeringController.lookahead = params->lookahead;
+    pathFollower->steeringController.lookahead.deltaDistance_in = params->lookahead.maxDistance_in - params->lookahead.minDistance_in;
+    pathFollower->steeringController.lookahead.deltaSpeed_ips = params->lookahead.maxSpeed_ips - params->lookahead.minSpeed_ips;
+    pathFollower->lastSteeringDelta.dx_in = 0.0;
+    pathFollower->lastSteeringDelta.dy_in = 0.0;
+    pathFollower->lastSteeringDelta.dtheta_rad = 0.0;
+    memset( &pathFollower->steeringController.lastTargetPoint, 0, sizeof( targetPoint_t ) );
+    memset( &pathFollower->lastSteeringCommand, 0, sizeof( steeringComamnd_t ) );
+
+    InitProfileFollower( &pathFollower->velocityController );
+    SetProfileFollowerGains( &pathFollower->velocityController, params->profile_kp, params->profile_ki, params->profile_kv, params->profile_kffv, params->profile_kffa );
+    constraints.maxAbsVel = params->profile_max_abs_vel;
+    constraints.maxAbsAcc = params->profile_max_abs_acc;
+    *(pathFollower->velocityController.constraints) = constraints;
+    SetProfileFollowerReplanTolerance( &pathFollower->velocityController, params->goal_replan_tolerance );
+
+    pathFollower->inertiaGain = params->inertiaGain;
+    pathFollower->overrideFinished = 0;
+    pathFollower->doneSteering = 0;
+    pathFollower->maxProfileVel = params->profile_max_abs_vel;
+    pathFollower->maxProfileAcc = params->profile_max_abs_acc;
+    pathFollower->goalPosTolerance = params->goal_pos_tolerance;
+    pathFollower->goalVelTolerance = params->goal_vel_tolerance;
+    pathFollower->stopSteeringDistance = params->stop_steering_distance;
+    pathFollower->actuationLatency = params->actuation_latency;
+    pathFollower->lastCommand.dx_in = 0.0;
+    pathFollower->lastCommand.dy_in = 0.0;
+    pathFollower->lastCommand.dtheta_rad = 0.0;
+    pathFollower->crossTrackError = 0.0;
+    pathFollower->alongTrackError = 0.0;
+    pathFollower->trajectory = NULL;
+    pathFollower->trajectoryStartTime = 0.0;
+    pathFollower->trajectoryIndex = 0;
+    atomic_init( &pathFollower->progress.sequence, 0 );
+    atomic_init( &pathFollower->progress.distanceRemaining_in, 0.0 );
+    atomic_init( &pathFollower->progress.timeRemaining_s, 0.0 );
+    atomic_init( &pathFollower->progress.percentComplete, 0.0 );
+}
+
+
+/******************************************************************************************************************************** 
+**  ClearPathFollower
+**
+**      Frees what InitPathFollower allocated for the speed controller.  The path is left to its owner to clear.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void ClearPathFollower (pathFollower_t *pathFollower) {
+    ClearProfileFollower( &pathFollower->velocityController );
+    free( pathFollower->velocityController.setpointGenerator );
+    pathFollower->velocityController.setpointGenerator = NULL;
+}
+
+
+/******************************************************************************************************************************** 
+**  SetPathFollowerPath
+**
+**      Switches the follower to another path at once.  The speed controller is left running, so the velocity profile
+**      carries on from the current motion state and is only re-targeted by the new path's goals.  Never allocates.
+**
+**      Input:
+**          pathSegmentsList_t path     The path to follow from its head on (owned and consumed by the follower)
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void SetPathFollowerPath (pathFollower_t *pathFollower, pathSegmentsList_t *path) {
+    pathFollower->steeringController.path = path;
+    pathFollower->steeringController.atEndOfPath = 0;
+    pathFollower->doneSteering = 0;
+    pathFollower->overrideFinished = 0;
+}
+
+
+/******************************************************************************************************************************** 
+**  PublishPathProgress
+**
+**      Follower side, the only writer.
+**
+**      Input:
+**          double distance_in          Distance left to the end of the path
+**          double time_s               Time left to the end of the path
+**
+**      Output:
+**
+********************************************************************************************************************************/
+static void PublishPathProgress (pathFollower_t *pathFollower, double distance_in, double time_s) {
+    pathProgressChannel_t *channel = &pathFollower->progress;
+    pathSegmentsList_t *path = pathFollower->steeringController.path;
+    unsigned long sequence;
+    double length_in, percent;
+
+    length_in = path->tail->startDistance_in + path->tail->length_in;
+    percent = ( length_in > 0.0 ) ? 100.0 * ( 1.0 - distance_in / length_in ) : 100.0;
+
+    sequence = atomic_load_explicit( &channel->sequence, memory_order_relaxed );
+    atomic_store_explicit( &channel->sequence, sequence + 1, memory_order_relaxed );
+    atomic_thread_fence( memory_order_release );
+    atomic_store_explicit( &channel->distanceRemaining_in, distance_in, memory_order_relaxed );
+    atomic_store_explicit( &channel->timeRemaining_s, time_s, memory_order_relaxed );
+    atomic_store_explicit( &channel->percentComplete, percent, memory_order_relaxed );
+    atomic_store_explicit( &channel->sequence, sequence + 2, memory_order_release );
+}
+
+
+/******************************************************************************************************************************** 
+**  GetPathProgress
+**
+**      How far the follower has to go, as of its latest tick (all 0 before the first): from the closest point on the path and
+**      its speed plan while steering, then from the stopping profile for the last stretch.  Safe to call from any thread,
+**      any number of them, while the follower runs; it costs a handful of loads whatever the length of the path.
+**
+**      Input:
+**
+**      Output:
+**          pathProgress_t progress     Distance and planned time remaining from the closest point, and the share driven
+**
+********************************************************************************************************************************/
+void GetPathProgress (pathFollower_t *pathFollower, pathProgress_t *progress) {
+    pathProgressChannel_t *channel = &pathFollower->progress;
+    unsigned long before, after;
+
+    do {
+        before = atomic_load_explicit( &channel->sequence, memory_order_acquire );
+        progress->distanceRemaining_in = atomic_load_explicit( &channel->distanceRemaining_in, memory_order_relaxed );
+        progress->timeRemaining_s = atomic_load_explicit( &channel->timeRemaining_s, memory_order_relaxed );
+        progress->percentComplete = atomic_load_explicit( &channel->percentComplete, memory_order_relaxed );
+        atomic_thread_fence( memory_order_acquire );
+        after = atomic_load_explicit( &channel->sequence, memory_order_relaxed );
+    } while ( ( before & 1 ) || before != after );
+}
+
+
+/******************************************************************************************************************************** 
+**  GetMeasuredCrossTrackError
+**
+**      Distance from the measured pose to the path when steering from a predicted one.  The steering may already have moved
+**      on to the next segment, so the one finished before it (still linked behind the head) is looked at as well.
+**
+**      Input:
+**
+**      Output: The distance to the closer of the two segments.
+**
+********************************************************************************************************************************/
+static double GetMeasuredCrossTrackError (pathSegmentsList_t *path, transform2d_t *robotPose) {
+    pathSegmentNode_t *node = path->head;
+    translation2d_t closestPoint, offset;
+    double rv;
+
+    closestPoint = GetClosestPoint( &node->segment, &robotPose->translation );
+    offset = TranslationDelta( &robotPose->translation, &closestPoint );
+    rv = TranslationNormal( &offset );
+    if ( node->prev ) {
+        closestPoint = GetClosestPoint( &node->prev->segment, &robotPose->translation );
+        offset = TranslationDelta( &robotPose->translation, &closestPoint );
+        rv = fmin( rv, TranslationNormal( &offset ) );
+    }
+
+    return rv;
+}
+
+
+/******************************************************************************************************************************** 
+**  PredictPathFollowerPose
+**
+**      Where the robot will be when the next command acts: the pose moved on by the last command over the actuation
+**      latency, along the arc it drives (see Exp).  The command in flight until then cannot be changed any more, so steering
+**      from here instead of from the measured pose keeps the latency out of the steering loop.
+**
+**      Input:
+**          transform2d_t robotPose     The measured pose
+**
+**      Output: The predicted pose, the measured one when the latency is 0.
+**
+********************************************************************************************************************************/
+transform2d_t PredictPathFollowerPose (pathFollower_t *pathFollower, transform2d_t *robotPose) {
+    transform2d_t motion;
+    twist2d_t delta;
+
+    if ( pathFollower->actuationLatency <= 0.0 ) {
+        return *robotPose;
+    }
+    delta.dx_in = pathFollower->lastCommand.dx_in * pathFollower->actuationLatency;
+    delta.dy_in = pathFollower->lastCommand.dy_in * pathFollower->actuationLatency;
+    delta.dtheta_rad = pathFollower->lastCommand.dtheta_rad * pathFollower->actuationLatency;
+    motion = Exp( &delta );
+
+    return TranformAByB( robotPose, &motion );
+}
+
+
+/******************************************************************************************************************************** 
+**  GetPathFollowerUpdate
+**
+**      Input:
+**          double t                    The current time
+**          double displacement         Distance driven so far along the robot's heading
+**          double velocity             Current speed along the robot's heading
+**          transform2d_t robotPose     Current pose of the robot, steered from as predicted over the actuation latency (see
+**                                      PredictPathFollowerPose)
+**
+**      Output: The twist to command for the next control period.  With a trajectory set this is GetTrajectoryFollowerUpdate.
+**
+********************************************************************************************************************************/
 twist2d_t GetPathFollowerUpdate (pathFollower_t *pathFollower, double t, double displacement, double velocity, transform2d_t *robotPose) {
     twist2d_t rv;
+    transform2d_t predictedPose;
     steeringComamnd_t steeringCmd;
     motionProfileConstraints_t constraints;
     motionProfileGoal_t goal;
     motionState_t lastMotionState, setpoint;
-    double velocityCmd, curvature, dTheta_rad, absVelocitySetpoint, scale;
+    motionProfileList_t *profile;
+    double velocityCmd, curvature, dTheta_rad, absVelocitySetpoint, scale, stopTime_s, ahead;
+    int steered = 0;
 
-    if ( pathFollower->steeringController.atEndOfPath ) {
-        steeringCmd = GetSteeringUpdate( &pathFollower->steeringController, robotPose );
+    if ( pathFollower->trajectory ) {
+        return GetTrajectoryFollowerUpdate( pathFollower, t, robotPose );
+    }
+    if ( !pathFollower->steeringController.atEndOfPath ) {
+        predictedPose = PredictPathFollowerPose( pathFollower, robotPose );
+        steeringCmd = GetSteeringUpdate( &pathFollower->steeringController, &predictedPose );
         pathFollower->crossTrackError = steeringCmd.crossTrackError;
         pathFollower->lastSteeringDelta = steeringCmd.delta;
-        goal.pos = displacement + steeringCmd.delta.dx_in;
+        pathFollower->lastSteeringCommand = steeringCmd;
+        // The distance left is from the predicted pose, which the robot drives to first, and the cross-track error is the
+        // measured one.
+        ahead = pathFollower->lastCommand.dx_in * fmax( pathFollower->actuationLatency, 0.0 );
+        goal.pos = displacement + ahead + steeringCmd.delta.dx_in;
+        if ( ahead != 0.0 ) {
+            pathFollower->crossTrackError = GetMeasuredCrossTrackError( pathFollower->steeringController.path, robotPose );
+        }
         goal.maxAbsVel = fabs( steeringCmd.endSpeed_ips );
         goal.completionBehavior = VIOLATE_MAX_ACCEL;
         goal.posTolerance = pathFollower->goalPosTolerance;
@@ -28,6 +294,9 @@ twist2d_t GetPathFollowerUpdate (pathFollower_t *pathFollower, double t, double
             pathFollower->doneSteering = 1;
 
         }
+        PublishPathProgress( pathFollower, pathFollower->steeringController.lastTargetPoint.remainingPathDistance_in,
+                             pathFollower->steeringController.lastTargetPoint.remainingPathTime_s );
+        steered = 1;
     }
 
     lastMotionState.t = t;
@@ -36,6 +305,12 @@ twist2d_t GetPathFollowerUpdate (pathFollower_t *pathFollower, double t, double
     lastMotionState.acc = 0.0;
     velocityCmd = ProfileFollowerUpdate( &pathFollower->velocityController, &lastMotionState, t );
     pathFollower->alongTrackError = pathFollower->velocityController.latestPosError;
+    if ( !steered ) {
+        // Past the last steering update the robot is stopping at the goal of its speed profile.
+        profile = pathFollower->velocityController.setpointGenerator->profile;
+        stopTime_s = profile->length ? fmax( 0.0, SegmentEndTime( &profile->tail->segment ) - t ) : 0.0;
+        PublishPathProgress( pathFollower, fabs( pathFollower->velocityController.goal->pos - displacement ), stopTime_s );
+    }
     curvature = pathFollower->lastSteeringDelta.dtheta_rad / pathFollower->lastSteeringDelta.dx_in;
     dTheta_rad = pathFollower->lastSteeringDelta.dtheta_rad;
     if ( !isnan( curvature ) && fabs( curvature ) < 1E6 ) {
@@ -44,17 +319,39 @@ twist2d_t GetPathFollowerUpdate (pathFollower_t *pathFollower, double t, double
         absVelocitySetpoint = fabs( setpoint.vel );
         dTheta_rad = pathFollower->lastSteeringDelta.dx_in * curvature * ( 1.0 + pathFollower->inertiaGain * absVelocitySetpoint );
     }
+    if ( fabs( pathFollower->lastSteeringDelta.dx_in ) < 1E-9 ) {
+        // Nothing left to steer along (e.g. stopped exactly at the end of the path).
+        rv.dtheta_rad = 0.0;
+        rv.dx_in = 0.0;
+        rv.dy_in = 0.0;
+        pathFollower->lastCommand = rv;
+        return rv;
+    }
     scale = velocityCmd / pathFollower->lastSteeringDelta.dx_in;
     rv.dtheta_rad = dTheta_rad * scale;
     rv.dx_in = pathFollower->lastSteeringDelta.dx_in * scale;
     rv.dy_in = 0.0;
+    pathFollower->lastCommand = rv;
 
     return rv;
 }
-  
+
+
+/******************************************************************************************************************************** 
+**  PathFollowerIsFinished
+**
+**      Input:
+**
+**      Output: Returns 1 once the end of the path has been reached and the speed profile has settled on its goal, or when
+**              following a trajectory, once its last point is due.
+**
+********************************************************************************************************************************/
 int PathFollowerIsFinished (pathFollower_t *pathFollower) {
     int rv;
 
+    if ( pathFollower->trajectory ) {
+        return pathFollower->trajectoryIndex >= pathFollower->trajectory->numPoints - 1 || pathFollower->overrideFinished;
+    }
     rv =  ( pathFollower->steeringController.atEndOfPath && IsProfileFinished( &pathFollower->velocityController ) && IsProfileOnTarget( &pathFollower->velocityController ) ) || pathFollower->overrideFinished;
     return rv;
 }
@@ -0,0 +1,174 @@
+#include <stdlib.h>
+#include <string.h>
+#include "Path.h"
+
+
+/********************************************************************************************************************************
+**  PrefetchWorker
+**
+**      Worker thread.  Waits for a request, builds it and hands the path over by setting the status to ready.  There is
+**      only ever one request at a time: PrefetchPath refuses another until the path has been taken.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+static void * PrefetchWorker (void *arg) {
+    pathPrefetch_t *prefetch = arg;
+    pathSegmentsList_t path;
+
+    while ( 1 ) {
+        pthread_mutex_lock( &prefetch->lock );
+        while ( !prefetch->shutdown && atomic_load_explicit( &prefetch->status, memory_order_relaxed ) != PATH_PREFETCH_BUILDING ) {
+            pthread_cond_wait( &prefetch->cond, &prefetch->lock );
+        }
+        if ( prefetch->shutdown ) {
+            pthread_mutex_unlock( &prefetch->lock );
+            break;
+        }
+        pthread_mutex_unlock( &prefetch->lock );
+
+        // The request is left alone by the control side until the path has been taken.
+        path = BuildPathFromState( prefetch->wps, prefetch->numWaypoints, &prefetch->startState );
+        prefetch->path = path;
+        atomic_store_explicit( &prefetch->status, PATH_PREFETCH_READY, memory_order_release );
+    }
+
+    return NULL;
+}
+
+
+/********************************************************************************************************************************
+**  InitPathPrefetch
+**
+**      Starts the worker thread that builds prefetched paths.
+**
+**      Input:
+**
+**      Output: Returns 0, or -1 if the worker could not be started.
+**
+********************************************************************************************************************************/
+int InitPathPrefetch (pathPrefetch_t *prefetch) {
+    memset( prefetch, 0, sizeof( pathPrefetch_t ) );
+    atomic_init( &prefetch->status, PATH_PREFETCH_IDLE );
+    if ( pthread_mutex_init( &prefetch->lock, NULL ) ) {
+        return -1;
+    }
+    if ( pthread_cond_init( &prefetch->cond, NULL ) ) {
+        pthread_mutex_destroy( &prefetch->lock );
+        return -1;
+    }
+    if ( pthread_create( &prefetch->thread, NULL, PrefetchWorker, prefetch ) ) {
+        pthread_cond_destroy( &prefetch->cond );
+        pthread_mutex_destroy( &prefetch->lock );
+        return -1;
+    }
+    return 0;
+}
+
+
+/********************************************************************************************************************************
+**  DestroyPathPrefetch
+**
+**      Stops the worker, waiting for a build in progress to finish, and frees a path that was never taken.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void DestroyPathPrefetch (pathPrefetch_t *prefetch) {
+    pthread_mutex_lock( &prefetch->lock );
+    prefetch->shutdown = 1;
+    pthread_cond_signal( &prefetch->cond );
+    pthread_mutex_unlock( &prefetch->lock );
+    pthread_join( prefetch->thread, NULL );
+
+    if ( atomic_load( &prefetch->status ) == PATH_PREFETCH_READY ) {
+        ClearPath( &prefetch->path );
+    }
+    atomic_store( &prefetch->status, PATH_PREFETCH_IDLE );
+    pthread_cond_destroy( &prefetch->cond );
+    pthread_mutex_destroy( &prefetch->lock );
+    free( prefetch->wps );
+    free( prefetch->waypoints );
+    prefetch->wps = NULL;
+    prefetch->waypoints = NULL;
+    prefetch->capacity = 0;
+}
+
+
+/********************************************************************************************************************************
+**  PrefetchPath
+**
+**      Control side.  Starts building the next route on the worker thread and returns at once; the path is collected with
+**      TakePrefetchedPath.  Its speed plan starts in the state the current path ends in, so the robot can go from one to the
+**      other without stopping.  Only copying the waypoints is done on the calling thread (and growing the copy, the first
+**      time a longer route is requested).
+**
+**      Input:
+**          waypoint_t wps[]            The next route (copied)
+**          pathSegmentsList_t current  The path being driven, whose GetLastMotionState seeds the new one, or NULL to start at
+**                                      rest
+**
+**      Output: Returns 0, or -1 if a prefetched path is still building or waiting to be taken, or memory ran out.
+**
+********************************************************************************************************************************/
+int PrefetchPath (pathPrefetch_t *prefetch, waypoint_t *wps[], int size, pathSegmentsList_t *current) {
+    motionState_t rest = {0.0, 0.0, 0.0, 0.0};
+    waypoint_t *waypoints, **pointers;
+    int i;
+
+    if ( atomic_load_explicit( &prefetch->status, memory_order_acquire ) != PATH_PREFETCH_IDLE ) {
+        return -1;
+    }
+    if ( size > prefetch->capacity ) {
+        waypoints = realloc( prefetch->waypoints, size * sizeof( waypoint_t ) );
+        if ( !waypoints ) {
+            return -1;
+        }
+        prefetch->waypoints = waypoints;
+        pointers = realloc( prefetch->wps, size * sizeof( waypoint_t * ) );
+        if ( !pointers ) {
+            return -1;
+        }
+        prefetch->wps = pointers;
+        prefetch->capacity = size;
+    }
+    for ( i = 0; i < size; i++ ) {
+        prefetch->waypoints[i] = *wps[i];
+        prefetch->wps[i] = &prefetch->waypoints[i];
+    }
+
+    pthread_mutex_lock( &prefetch->lock );
+    prefetch->numWaypoints = size;
+    prefetch->startState = current ? GetLastMotionState( current ) : rest;
+    atomic_store_explicit( &prefetch->status, PATH_PREFETCH_BUILDING, memory_order_relaxed );
+    pthread_cond_signal( &prefetch->cond );
+    pthread_mutex_unlock( &prefetch->lock );
+
+    return 0;
+}
+
+
+/********************************************************************************************************************************
+**  TakePrefetchedPath
+**
+**      Control side.  Hands over the prefetched path if it is ready, e.g. to SetPathFollowerPath.  Never blocks or allocates.
+**
+**      Input:
+**
+**      Output: Returns 1 and the path (now owned by the caller) if it is ready, 0 if it is still building or none was asked for.
+**
+********************************************************************************************************************************/
+int TakePrefetchedPath (pathPrefetch_t *prefetch, pathSegmentsList_t *path) {
+    if ( atomic_load_explicit( &prefetch->status, memory_order_acquire ) != PATH_PREFETCH_READY ) {
+        return 0;
+    }
+    *path = prefetch->path;
+    memset( &prefetch->path, 0, sizeof( pathSegmentsList_t ) );
+    atomic_store_explicit( &prefetch->status, PATH_PREFETCH_IDLE, memory_order_release );
+
+    return 1;
+}
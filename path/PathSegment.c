@@ -4,6 +4,30 @@
 #include "Path.h"
 
 
+/******************************************************************************************************************************** 
+**  SetMotionProfilerGoal
+**
+**      The constraints and goal of a segment's speed profile.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+static void SetMotionProfilerGoal (double endSpeed, double maxSpeed, double length, motionProfileConstraints_t *motionConstraints, motionProfileGoal_t *goalState) {
+    motionConstraints->maxAbsVel = maxSpeed;
+    motionConstraints->maxAbsAcc = kPathFollowingMaxAccel;
+    goalState->completionBehavior = OVERSHOOT;
+    goalState->maxAbsVel = endSpeed;
+    goalState->pos = length;
+    goalState->posTolerance = 1e-3;
+    goalState->velTolerance = 1e-2;
+    if ( motionConstraints->maxAbsVel > goalState->velTolerance && goalState->completionBehavior == OVERSHOOT ) {
+        goalState->completionBehavior = VIOLATE_MAX_ACCEL;
+    }
+}
+
+
 /******************************************************************************************************************************** 
 **  CreateMotionProfiler
 **
@@ -17,22 +41,88 @@ motionProfileList_t CreateMotionProfiler (motionState_t *startState, double endS
     motionProfileConstraints_t motionConstraints;
     motionProfileGoal_t goalState;
 
-    motionConstraints.maxAbsVel = maxSpeed;
-    motionConstraints.maxAbsAcc = kPathFollowingMaxAccel;
-    goalState.completionBehavior = OVERSHOOT;
-    goalState.maxAbsVel = endSpeed;
-    goalState.pos = length;
-    goalState.posTolerance = 1e-3;
-    goalState.velTolerance = 1e-2;
-    if ( motionConstraints.maxAbsVel > goalState.velTolerance && goalState.completionBehavior == OVERSHOOT ) {
-        goalState.completionBehavior = VIOLATE_MAX_ACCEL;
-    }
+    SetMotionProfilerGoal( endSpeed, maxSpeed, length, &motionConstraints, &goalState );
     rv = GenerateProfile( &motionConstraints, &goalState, startState );
 
     return rv;
 }
 
 
+/******************************************************************************************************************************** 
+**  GetMotionProfilerEndState
+**
+**      Input:
+**
+**      Output: The state the profile CreateMotionProfiler creates ends in, without creating it (see GetProfileEndState).
+**
+********************************************************************************************************************************/
+motionState_t GetMotionProfilerEndState (motionState_t *startState, double endSpeed, double maxSpeed, double length) {
+    motionState_t rv;
+    motionProfileConstraints_t motionConstraints;
+    motionProfileGoal_t goalState;
+
+    SetMotionProfilerGoal( endSpeed, maxSpeed, length, &motionConstraints, &goalState );
+    rv = GetProfileEndState( &motionConstraints, &goalState, startState );
+
+    return rv;
+}
+
+
+/******************************************************************************************************************************** 
+**  EnsureSegmentProfile
+**
+**      Generates the segment's speed profile from its plan if it has none (a segment of a lazy path, see
+**      BuildLazyPathFromWaypoints).  The nodes come from the profile node pool, so once the pool has filled this does not touch
+**      the heap.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void EnsureSegmentProfile (pathSegment_t *segment) {
+    if ( !segment->speedController.length ) {
+        segment->speedController = CreateMotionProfiler( &segment->startState, segment->endSpeed_ips, segment->maxSpeed_ips, GetLength( segment ) );
+    }
+}
+
+
+/******************************************************************************************************************************** 
+**  DropSegmentProfile
+**
+**      Hands the segment's speed profile back to the node pool; EnsureSegmentProfile generates it again when needed.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void DropSegmentProfile (pathSegment_t *segment) {
+    ClearProfile( &segment->speedController );
+}
+
+
+/******************************************************************************************************************************** 
+**  GetSegmentEndState
+**
+**      Input:
+**
+**      Output: The state the segment's speed profile ends in, worked out from its plan when it has no profile.
+**
+********************************************************************************************************************************/
+motionState_t GetSegmentEndState (pathSegment_t *segment) {
+    motionState_t rv;
+
+    if ( segment->speedController.length ) {
+        rv = SegmentEnd( &segment->speedController.tail->segment );
+    } else {
+        rv = GetMotionProfilerEndState( &segment->startState, segment->endSpeed_ips, segment->maxSpeed_ips, GetLength( segment ) );
+    }
+
+    return rv;
+}
+
+
 /******************************************************************************************************************************** 
 **  GetLength
 **
@@ -91,8 +181,8 @@ translation2d_t GetClosestPoint (pathSegment_t *segment, translation2d_t *robotP
             closestPoint = TranslateAbyB( &segment->center, &delta );
 
         } else {
-            startDist = TranslateAbyB( &segment->start, robotPosition );
-            endDist = TranslateAbyB( &segment->end, robotPosition );
+            startDist = TranslationDelta( robotPosition, &segment->start );
+            endDist = TranslationDelta( robotPosition, &segment->end );
             closestPoint = ( TranslationNormal( &endDist ) < TranslationNormal( &startDist ) ) ? segment->end : segment->start;
         }
     }
@@ -181,6 +271,32 @@ double GetDistanceTravelled (pathSegment_t *segment, translation2d_t *robotPosit
 }
 
 
+/******************************************************************************************************************************** 
+**  GetStateByDistance
+**
+**      Input:
+**          double dist                 Distance along the segment, clamped to the segment
+**
+**      Output: The first state of the segment's speed profile at the distance, its time counted from the start of the
+**              segment (all NaN if the profile has no such state).
+**
+********************************************************************************************************************************/
+motionState_t GetStateByDistance (pathSegment_t *segment, double dist) {
+    motionState_t endState;
+
+    EnsureSegmentProfile( segment );
+    endState = SegmentEnd( &segment->speedController.tail->segment );
+    if ( dist < segment->speedController.head->segment.pos ) {
+        dist = segment->speedController.head->segment.pos;
+
+    } else if ( dist > endState.pos ) {
+        dist = endState.pos;
+
+    }
+    return FirstStateByPosition( &segment->speedController, dist );
+}
+
+
 /******************************************************************************************************************************** 
 **  GetSpeedByDistance
 **
@@ -193,14 +309,7 @@ double GetSpeedByDistance(pathSegment_t *segment, double dist) {
     double rv;
     motionState_t state;
 
-    if ( dist < segment->speedController->head->segment.start.pos ) {
-        dist = segment->speedController->head->segment.start.pos;
-
-    } else if ( dist > segment->speedController->tail->segment.end.pos ) {
-        dist = segment->speedController->tail->segment.end.pos;
-
-    }
-    state = FirstStateByPosition( segment->speedController, dist );
+    state = GetStateByDistance( segment, dist );
     if ( isnan( state.vel ) ) {
         rv = 0.0;
     } else {
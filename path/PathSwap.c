@@ -0,0 +1,167 @@
+#include <stdlib.h>
+#include "Path.h"
+
+
+/********************************************************************************************************************************
+**  FreePublishedPath
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+static void FreePublishedPath (publishedPath_t *published) {
+    ClearPath( &published->segments );
+    free( published );
+}
+
+
+/********************************************************************************************************************************
+**  InitPathSwap
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void InitPathSwap (pathSwap_t *swap) {
+    atomic_init( &swap->pending, NULL );
+    atomic_init( &swap->retired, NULL );
+    swap->current = NULL;
+    swap->swaps = 0;
+}
+
+
+/********************************************************************************************************************************
+**  DestroyPathSwap
+**
+**      Frees the pending, retired and current paths.  Neither side may be using the swap any more.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void DestroyPathSwap (pathSwap_t *swap) {
+    publishedPath_t *pending;
+
+    pending = atomic_exchange( &swap->pending, NULL );
+    if ( pending ) {
+        FreePublishedPath( pending );
+    }
+    ReclaimRetiredPaths( swap );
+    if ( swap->current ) {
+        FreePublishedPath( swap->current );
+        swap->current = NULL;
+    }
+}
+
+
+/********************************************************************************************************************************
+**  PublishPath
+**
+**      Planning side.  Hands a compiled path to the controller, which picks it up at its next AdoptPublishedPath.  The swap
+**      takes over the path's segments; the caller's list is emptied.  A path published earlier that the controller has not
+**      adopted yet is superseded and freed, and paths the controller has retired are reclaimed.
+**
+**      Input:
+**          pathSegmentsList_t path     The new path, typically built from the robot's current position
+**
+**      Output: Returns 0, or -1 if memory for the hand-off could not be allocated (the path is left with the caller).
+**
+********************************************************************************************************************************/
+int PublishPath (pathSwap_t *swap, pathSegmentsList_t *path) {
+    publishedPath_t *published, *superseded;
+
+    published = malloc( sizeof( publishedPath_t ) );
+    if ( !published ) {
+        return -1;
+    }
+    published->segments = *path;
+    published->next = NULL;
+    path->head = NULL;
+    path->tail = NULL;
+    path->length = 0;
+    path->nodes = NULL;
+    path->capacity = 0;
+    path->profileWindow = 0;
+    path->profile = NULL;
+    path->profileLength = 0;
+    path->route = NULL;
+
+    superseded = atomic_exchange_explicit( &swap->pending, published, memory_order_acq_rel );
+    if ( superseded ) {
+        FreePublishedPath( superseded );
+    }
+    ReclaimRetiredPaths( swap );
+
+    return 0;
+}
+
+
+/********************************************************************************************************************************
+**  AdoptPublishedPath
+**
+**      Controller side, called at the start of a tick.  If a new path has been published the follower switches to it at once
+**      (see SetPathFollowerPath).  The path being replaced is retired rather than freed: this never blocks or
+**      calls the allocator, and a retired path is by construction no longer referenced by the controller, which is the
+**      only reader of the path it follows.
+**
+**      A path the follower was started on outside of the swap stays owned by whoever created it.
+**
+**      Input:
+**
+**      Output: Returns 1 if the follower switched to a new path, 0 otherwise.
+**
+********************************************************************************************************************************/
+int AdoptPublishedPath (pathSwap_t *swap, pathFollower_t *pathFollower) {
+    publishedPath_t *published, *retired;
+
+    if ( !atomic_load_explicit( &swap->pending, memory_order_relaxed ) ) {
+        return 0;
+    }
+    published = atomic_exchange_explicit( &swap->pending, NULL, memory_order_acq_rel );
+    if ( !published ) {
+        return 0;
+    }
+
+    if ( swap->current ) {
+        retired = atomic_load_explicit( &swap->retired, memory_order_relaxed );
+        do {
+            swap->current->next = retired;
+        } while ( !atomic_compare_exchange_weak_explicit( &swap->retired, &retired, swap->current, memory_order_release, memory_order_relaxed ) );
+    }
+    swap->current = published;
+    swap->swaps += 1;
+
+    SetPathFollowerPath( pathFollower, &published->segments );
+
+    return 1;
+}
+
+
+/********************************************************************************************************************************
+**  ReclaimRetiredPaths
+**
+**      Planning side.  Frees every path the controller has retired.  Only one thread may reclaim at a time (the list is taken
+**      in one exchange, so there is no ABA problem with the controller pushing concurrently).
+**
+**      Input:
+**
+**      Output: The number of paths freed.
+**
+********************************************************************************************************************************/
+int ReclaimRetiredPaths (pathSwap_t *swap) {
+    publishedPath_t *retired, *next;
+    int count = 0;
+
+    retired = atomic_exchange_explicit( &swap->retired, NULL, memory_order_acquire );
+    while ( retired ) {
+        next = retired->next;
+        FreePublishedPath( retired );
+        retired = next;
+        count += 1;
+    }
+
+    return count;
+}
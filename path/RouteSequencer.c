@@ -0,0 +1,119 @@
+#include <math.h>
+#include "Path.h"
+
+
+/********************************************************************************************************************************
+**  InitRouteSequencer
+**
+**      Input:
+**          pathFollower_t pathFollower The follower to drive the routes with, set up by InitPathFollower (its path is
+**                                      replaced by the first route added)
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void InitRouteSequencer (routeSequencer_t *sequencer, pathFollower_t *pathFollower) {
+    sequencer->follower = pathFollower;
+    sequencer->numRoutes = 0;
+    sequencer->current = 0;
+}
+
+
+/********************************************************************************************************************************
+**  AddSequencerRoute
+**
+**      Appends a route, driven once the ones before it are done.  When the route before hands off at speed, that route is
+**      replanned to end at the handoff speed (no faster than either route allows at the join) and this one to start at the
+**      speed it actually reaches, so the robot carries on without slowing.  Both paths are changed in place, so they must
+**      not be shared (e.g. from a path cache), and a route may only be added before the robot reaches the end of the one
+**      before.  Replanning generates profiles, and builds the rest of a lazy route; call this between ticks, not on a tick
+**      that must not allocate.
+**
+**      Input:
+**          pathSegmentsList_t path     The route, starting where the one before ends; owned by the caller
+**          double handoffSpeed_ips     Speed to carry onto the route after this one, 0 to stop at the end of this one
+**
+**      Output: Returns 0, or -1 if the sequencer is full or the path is empty.
+**
+********************************************************************************************************************************/
+int AddSequencerRoute (routeSequencer_t *sequencer, pathSegmentsList_t *path, double handoffSpeed_ips) {
+    sequencedRoute_t *before;
+    motionState_t endState;
+    double speed;
+
+    if ( sequencer->numRoutes >= ROUTE_SEQUENCER_MAX_ROUTES || !path->length ) {
+        return -1;
+    }
+    if ( sequencer->numRoutes ) {
+        before = &sequencer->routes[sequencer->numRoutes - 1];
+        if ( before->handoffSpeed_ips > 0.0 ) {
+            CompleteLazyPath( before->path );
+            CompleteLazyPath( path );
+            speed = fmin( before->handoffSpeed_ips, fmin( before->path->tail->segment.maxSpeed_ips, path->head->segment.maxSpeed_ips ) );
+            ReplanPath( before->path, &before->path->head->segment.startState, speed );
+            endState = GetLastMotionState( before->path );
+            ReplanPath( path, &endState, path->tail->segment.endSpeed_ips );
+        }
+    }
+    sequencer->routes[sequencer->numRoutes].path = path;
+    sequencer->routes[sequencer->numRoutes].handoffSpeed_ips = handoffSpeed_ips;
+    sequencer->numRoutes += 1;
+    if ( sequencer->numRoutes == 1 ) {
+        SetPathFollowerPath( sequencer->follower, path );
+    }
+
+    return 0;
+}
+
+
+/********************************************************************************************************************************
+**  GetRouteSequencerUpdate
+**
+**      A follower tick on the current route (see GetPathFollowerUpdate), after which the follower is moved on to the next
+**      route: at once when the robot has reached the end of a route handing off at speed, or once it has stopped at the
+**      end.  The speed profile and steering are never reset, so there is no gap between the routes.
+**
+**      Input:
+**
+**      Output: The twist to command for the next control period, zero while there are no routes.
+**
+********************************************************************************************************************************/
+twist2d_t GetRouteSequencerUpdate (routeSequencer_t *sequencer, double t, double displacement, double velocity, transform2d_t *robotPose) {
+    twist2d_t rv = {0.0, 0.0, 0.0};
+    pathFollower_t *pathFollower = sequencer->follower;
+    sequencedRoute_t *route;
+    int done;
+
+    if ( !sequencer->numRoutes ) {
+        return rv;
+    }
+    rv = GetPathFollowerUpdate( pathFollower, t, displacement, velocity, robotPose );
+
+    if ( sequencer->current + 1 < sequencer->numRoutes ) {
+        route = &sequencer->routes[sequencer->current];
+        if ( route->handoffSpeed_ips > 0.0 ) {
+            done = pathFollower->steeringController.lastTargetPoint.remainingPathDistance_in <= pathFollower->goalPosTolerance;
+        } else {
+            done = PathFollowerIsFinished( pathFollower );
+        }
+        if ( done ) {
+            sequencer->current += 1;
+            SetPathFollowerPath( pathFollower, sequencer->routes[sequencer->current].path );
+        }
+    }
+
+    return rv;
+}
+
+
+/********************************************************************************************************************************
+**  RouteSequencerIsFinished
+**
+**      Input:
+**
+**      Output: Returns 1 once the robot has stopped at the end of the last route added (or there are none).
+**
+********************************************************************************************************************************/
+int RouteSequencerIsFinished (routeSequencer_t *sequencer) {
+    return !sequencer->numRoutes || ( sequencer->current == sequencer->numRoutes - 1 && PathFollowerIsFinished( sequencer->follower ) );
+}
@@ -0,0 +1,285 @@
+#include <math.h>
+#include <stdlib.h>
+#include "Geometry.h"
+#include "Motion.h"
+#include "Path.h"
+
+
+/********************************************************************************************************************************
+**  GetSegmentDuration
+**
+**      Input:
+**
+**      Output: Time the segment's speed plan takes to drive it.
+**
+********************************************************************************************************************************/
+static double GetSegmentDuration (pathSegment_t *segment) {
+    if ( !segment->speedController.length ) {
+        return 0.0;
+    }
+    return SegmentEndTime( &segment->speedController.tail->segment ) - segment->speedController.head->segment.t;
+}
+
+
+/********************************************************************************************************************************
+**  ReleaseSampledProfile
+**
+**      Drops the speed profile of a lazy path's segment once sampled, unless the segment is in the path's window (see
+**      BuildLazyPathFromWaypoints), and of every segment of a path with a path-wide profile (see BuildPathProfile).
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+static void ReleaseSampledProfile (pathSegmentsList_t *path, pathSegmentNode_t *node) {
+    if ( path->profile || ( path->profileWindow && node->index >= path->head->index + path->profileWindow ) ) {
+        DropSegmentProfile( &node->segment );
+    }
+}
+
+
+/********************************************************************************************************************************
+**  SampleSegment
+**
+**      Input:
+**          pathSegment_t segment       The segment to sample
+**          double t                    Time since the start of the segment's speed plan
+**
+**      Output:
+**          trajectoryPoint_t point     Pose, curvature, velocity and acceleration (distance is along the segment)
+**
+********************************************************************************************************************************/
+static void SampleSegment (pathSegment_t *segment, double t, trajectoryPoint_t *point) {
+    motionState_t state;
+    translation2d_t radial, tangent;
+    double length, turn;
+
+    length = GetLength( segment );
+    state = StateByTimeClamped( &segment->speedController, segment->speedController.head->segment.t + t );
+    point->distance = fmin( fmax( state.pos, 0.0 ), length );
+    point->velocity = state.vel;
+    point->acceleration = isfinite( state.acc ) ? state.acc : 0.0;
+    point->pose.translation = GetPointByDistance( segment, point->distance );
+    if ( segment->isLine ) {
+        point->pose.rotation = TranslationDirection( &segment->deltaStart );
+        point->curvature = 0.0;
+    } else {
+        turn = ( TranslationCross( &segment->deltaStart, &segment->deltaEnd ) >= 0.0 ) ? 1.0 : -1.0;
+        radial = TranslationDelta( &segment->center, &point->pose.translation );
+        tangent.x_in = -turn * radial.y_in;
+        tangent.y_in = turn * radial.x_in;
+        point->pose.rotation = TranslationDirection( &tangent );
+        point->curvature = turn / TranslationNormal( &segment->deltaStart );
+    }
+}
+
+
+/********************************************************************************************************************************
+**  CompileTrajectory
+**
+**      Samples a built path every dt seconds along the speed plans of its segments, so that a follower (or a motor
+**      controller the table is streamed to) can look up where the robot should be at any time without walking the path.
+**      The path is left untouched but for a lazy path, whose route is built to its end first; its speed profiles are
+**      generated as the segments are sampled and dropped again after.
+**
+**      Input:
+**          pathSegmentsList_t path     The path to compile, from its head
+**          double dt                   Sample period, normally the control period
+**
+**      Output:
+**          trajectory_t trajectory     The samples, to be freed with ClearTrajectory
+**          int                         Return 0, or -1 if the path is empty or the table could not be allocated
+**
+********************************************************************************************************************************/
+int CompileTrajectory (pathSegmentsList_t *path, double dt, trajectory_t *trajectory) {
+    pathSegmentNode_t *node;
+    trajectoryPoint_t *point;
+    double duration, length, segmentStart, segmentDistance, t;
+    long numPoints, k;
+
+    trajectory->points = NULL;
+    trajectory->numPoints = 0;
+    trajectory->dt = dt;
+    trajectory->duration = 0.0;
+    trajectory->length = 0.0;
+    if ( !path->head || dt <= 0.0 ) {
+        return -1;
+    }
+    CompleteLazyPath( path );
+
+    duration = 0.0;
+    length = 0.0;
+    for ( node = path->head; node; node = node->next ) {
+        EnsureSegmentProfile( &node->segment );
+        duration += GetSegmentDuration( &node->segment );
+        length += GetLength( &node->segment );
+        ReleaseSampledProfile( path, node );
+    }
+    numPoints = (long) ceil( duration / dt ) + 1;
+    if ( numPoints > 0x7FFFFFFF ) {
+        return -1;
+    }
+    trajectory->points = malloc( numPoints * sizeof( trajectoryPoint_t ) );
+    if ( !trajectory->points ) {
+        return -1;
+    }
+
+    node = path->head;
+    EnsureSegmentProfile( &node->segment );
+    segmentStart = 0.0;
+    segmentDistance = 0.0;
+    for ( k = 0; k < numPoints; k++ ) {
+        t = fmin( k * dt, duration );
+        while ( node->next && t > segmentStart + GetSegmentDuration( &node->segment ) ) {
+            segmentStart += GetSegmentDuration( &node->segment );
+            segmentDistance += GetLength( &node->segment );
+            ReleaseSampledProfile( path, node );
+            node = node->next;
+            EnsureSegmentProfile( &node->segment );
+        }
+        point = &trajectory->points[k];
+        SampleSegment( &node->segment, t - segmentStart, point );
+        point->t = t;
+        point->distance += segmentDistance;
+    }
+    ReleaseSampledProfile( path, node );
+    trajectory->numPoints = (int) numPoints;
+    trajectory->duration = duration;
+    trajectory->length = length;
+
+    return 0;
+}
+
+
+/********************************************************************************************************************************
+**  ClearTrajectory
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void ClearTrajectory (trajectory_t *trajectory) {
+    free( trajectory->points );
+    trajectory->points = NULL;
+    trajectory->numPoints = 0;
+}
+
+
+/********************************************************************************************************************************
+**  GetTrajectoryPoint
+**
+**      Input:
+**          double t                    Time since the start of the trajectory
+**
+**      Output: The sample nearest to t, clamped to the first and last one (NULL for an empty trajectory).
+**
+********************************************************************************************************************************/
+const trajectoryPoint_t * GetTrajectoryPoint (const trajectory_t *trajectory, double t) {
+    double index;
+
+    if ( !trajectory->numPoints ) {
+        return NULL;
+    }
+    index = floor( t / trajectory->dt + 0.5 );
+    if ( !( index > 0.0 ) ) {
+        return &trajectory->points[0];
+    }
+    if ( index >= trajectory->numPoints - 1 ) {
+        return &trajectory->points[trajectory->numPoints - 1];
+    }
+    return &trajectory->points[(int) index];
+}
+
+
+/********************************************************************************************************************************
+**  GetTrajectoryWheelSpeeds
+**
+**      Converts a sample to the speeds of the wheels of a differential drive, e.g. to stream the table to the motor
+**      controllers.
+**
+**      Input:
+**          double trackWidth_in        Distance between the wheels
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void GetTrajectoryWheelSpeeds (const trajectoryPoint_t *point, double trackWidth_in, double *left_ips, double *right_ips) {
+    *left_ips = point->velocity * ( 1.0 - point->curvature * trackWidth_in / 2.0 );
+    *right_ips = point->velocity * ( 1.0 + point->curvature * trackWidth_in / 2.0 );
+}
+
+
+/********************************************************************************************************************************
+**  SetPathFollowerTrajectory
+**
+**      Switches the follower to feedforward from a compiled trajectory of its path (NULL switches back to pure pursuit).
+**      The trajectory is not copied and must outlive its use.
+**
+**      Input:
+**          double startTime            Control time at which the robot is at the first point of the trajectory
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void SetPathFollowerTrajectory (pathFollower_t *pathFollower, const trajectory_t *trajectory, double startTime) {
+    pathFollower->trajectory = trajectory;
+    pathFollower->trajectoryStartTime = startTime;
+    pathFollower->trajectoryIndex = 0;
+}
+
+
+/********************************************************************************************************************************
+**  GetTrajectoryFollowerUpdate
+**
+**      O(1) control update from the trajectory sample due at t.  The sample's speed and curvature are the feedforward; pure
+**      pursuit only corrects for the robot being off the sample: it steers towards the point the lookahead distance ahead of
+**      the sample along its heading, which lies straight ahead while the robot is on the trajectory.  The along-track error
+**      is corrected with the velocity controller's proportional gain.
+**
+**      Input:
+**          double t                    The current time
+**          transform2d_t robotPose     Current pose of the robot
+**
+**      Output: The twist to command for the next control period.
+**
+********************************************************************************************************************************/
+twist2d_t GetTrajectoryFollowerUpdate (pathFollower_t *pathFollower, double t, transform2d_t *robotPose) {
+    const trajectoryPoint_t *point;
+    transform2d_t robotInverse, reference, error;
+    translation2d_t ahead, target;
+    twist2d_t rv = {0.0, 0.0, 0.0};
+    double lookahead, distanceSqr, curvature, velocity;
+
+    point = GetTrajectoryPoint( pathFollower->trajectory, t - pathFollower->trajectoryStartTime );
+    if ( !point ) {
+        return rv;
+    }
+    pathFollower->trajectoryIndex = (int) ( point - pathFollower->trajectory->points );
+
+    // The sample as seen from the robot: x ahead, y to the left.
+    robotInverse = TransformInverse( robotPose );
+    reference = point->pose;
+    error = TranformAByB( &robotInverse, &reference );
+    pathFollower->alongTrackError = error.translation.x_in;
+    pathFollower->crossTrackError = fabs( error.translation.y_in );
+
+    lookahead = GetLookaheadForSpeed( &pathFollower->steeringController.lookahead, fabs( point->velocity ) );
+    ahead.x_in = lookahead;
+    ahead.y_in = 0.0;
+    ahead = TranslationRotate( &ahead, &error.rotation );
+    target = TranslateAbyB( &error.translation, &ahead );
+    distanceSqr = target.x_in * target.x_in + target.y_in * target.y_in;
+    curvature = point->curvature + ( ( distanceSqr > 1E-9 ) ? 2.0 * target.y_in / distanceSqr : 0.0 );
+
+    velocity = point->velocity + pathFollower->velocityController.kP * error.translation.x_in;
+    if ( pathFollower->trajectoryIndex >= pathFollower->trajectory->numPoints - 1 ) {
+        velocity = 0.0;
+    }
+    rv.dx_in = velocity;
+    rv.dtheta_rad = velocity * curvature;
+    pathFollower->lastSteeringDelta = rv;
+
+    return rv;
+}
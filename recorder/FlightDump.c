@@ -0,0 +1,128 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "Recorder.h"
+
+
+/********************************************************************************************************************************
+**  WriteAll
+**
+**      Input:
+**
+**      Output: Returns 0, or -1 on a write error.
+**
+********************************************************************************************************************************/
+static int WriteAll (int fd, const void *data, size_t size) {
+    const char *bytes = data;
+    ssize_t written;
+
+    while ( size > 0 ) {
+        written = write( fd, bytes, size );
+        if ( written < 0 ) {
+            return -1;
+        }
+        bytes += written;
+        size -= (size_t) written;
+    }
+    return 0;
+}
+
+
+/********************************************************************************************************************************
+**  WriteFlightDump
+**
+**      Writes the header and the retained records, oldest first.  Only uses write(2), so it is safe in a signal handler.
+**
+**      Input:
+**
+**      Output: Returns 0, or -1 on a write error.
+**
+********************************************************************************************************************************/
+int WriteFlightDump (flightRecorder_t *recorder, int fd) {
+    flightDumpHeader_t header;
+    uint64_t oldest;
+    uint32_t numRecords, first;
+
+    numRecords = recorder->count < recorder->capacity ? (uint32_t) recorder->count : recorder->capacity;
+    oldest = recorder->count - numRecords;
+    first = (uint32_t) ( oldest & recorder->mask );
+
+    memcpy( header.magic, FLIGHT_RECORDER_MAGIC, sizeof( header.magic ) );
+    header.version = FLIGHT_RECORDER_VERSION;
+    header.recordSize = sizeof( flightRecord_t );
+    header.capacity = recorder->capacity;
+    header.numRecords = numRecords;
+    header.totalRecorded = recorder->count;
+
+    if ( WriteAll( fd, &header, sizeof( header ) ) ) {
+        return -1;
+    }
+    if ( first + numRecords <= recorder->capacity ) {
+        return WriteAll( fd, &recorder->records[first], numRecords * sizeof( flightRecord_t ) );
+    }
+    if ( WriteAll( fd, &recorder->records[first], ( recorder->capacity - first ) * sizeof( flightRecord_t ) ) ) {
+        return -1;
+    }
+    return WriteAll( fd, recorder->records, ( first + numRecords - recorder->capacity ) * sizeof( flightRecord_t ) );
+}
+
+
+/********************************************************************************************************************************
+**  DumpFlightRecorder
+**
+**      Input:
+**
+**      Output: Returns 0, or -1 if the file could not be written.
+**
+********************************************************************************************************************************/
+int DumpFlightRecorder (flightRecorder_t *recorder, const char *fileName) {
+    int fd, rv;
+
+    fd = open( fileName, O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+    if ( fd < 0 ) {
+        return -1;
+    }
+    rv = WriteFlightDump( recorder, fd );
+    if ( close( fd ) ) {
+        rv = -1;
+    }
+    return rv;
+}
+
+
+/********************************************************************************************************************************
+**  LoadFlightDump
+**
+**      Reads a dump written on a machine with the same byte order.
+**
+**      Input:
+**
+**      Output:
+**          flightDumpHeader_t header   The dump's header
+**          flightRecord_t *            The records, oldest first, to be freed by the caller (NULL if the file is not a valid
+**                                      dump or holds no records)
+**
+********************************************************************************************************************************/
+flightRecord_t * LoadFlightDump (const char *fileName, flightDumpHeader_t *header) {
+    flightRecord_t *records;
+    FILE *file;
+
+    file = fopen( fileName, "rb" );
+    if ( !file ) {
+        return NULL;
+    }
+    records = NULL;
+    if ( fread( header, sizeof( flightDumpHeader_t ), 1, file ) == 1 && !memcmp( header->magic, FLIGHT_RECORDER_MAGIC, sizeof( header->magic ) ) &&
+         header->version == FLIGHT_RECORDER_VERSION && header->recordSize == sizeof( flightRecord_t ) && header->numRecords > 0 ) {
+        records = malloc( header->numRecords * sizeof( flightRecord_t ) );
+        if ( records && fread( records, sizeof( flightRecord_t ), header->numRecords, file ) != header->numRecords ) {
+            free( records );
+            records = NULL;
+        }
+    }
+    fclose( file );
+
+    return records;
+}
@@ -0,0 +1,155 @@
+#include <fcntl.h>
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+#include "Recorder.h"
+
+#define FLIGHT_RECORDER_MAX_PATH 256
+
+static flightRecorder_t *gFaultRecorder = NULL;
+static char gFaultDumpName[FLIGHT_RECORDER_MAX_PATH];
+
+
+/********************************************************************************************************************************
+**  InitFlightRecorder
+**
+**      Input:
+**          flightRecord_t *records     Storage for the ring, owned by the caller
+**          uint32_t capacity           Number of records, a power of two
+**
+**      Output: Returns 0, or -1 if the capacity is not a power of two.
+**
+********************************************************************************************************************************/
+int InitFlightRecorder (flightRecorder_t *recorder, flightRecord_t *records, uint32_t capacity) {
+    if ( capacity == 0 || ( capacity & ( capacity - 1 ) ) ) {
+        return -1;
+    }
+    recorder->records = records;
+    recorder->capacity = capacity;
+    recorder->mask = capacity - 1;
+    recorder->count = 0;
+
+    return 0;
+}
+
+
+/********************************************************************************************************************************
+**  RecordFlightTick
+**
+**      Stores the follower's inputs and outputs of one tick over the oldest record.  Call right after GetPathFollowerUpdate.
+**
+**      Input:
+**          double t                    The time passed to GetPathFollowerUpdate
+**          transform2d_t robotPose     The pose passed to GetPathFollowerUpdate
+**          twist2d_t output            The twist it returned
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void RecordFlightTick (flightRecorder_t *recorder, pathFollower_t *pathFollower, double t, transform2d_t *robotPose, twist2d_t *output) {
+    flightRecord_t *record;
+    targetPoint_t *target;
+    steeringComamnd_t *steering;
+    setpoint_t *setpoint;
+
+    record = &recorder->records[recorder->count & recorder->mask];
+    target = &pathFollower->steeringController.lastTargetPoint;
+    steering = &pathFollower->lastSteeringCommand;
+    setpoint = pathFollower->velocityController.latestSetpoint;
+
+    record->sequence = (uint32_t) recorder->count;
+    record->t = (float) t;
+    record->poseX = (float) robotPose->translation.x_in;
+    record->poseY = (float) robotPose->translation.y_in;
+    record->poseSin = (float) robotPose->rotation.sinTheta_rad;
+    record->poseCos = (float) robotPose->rotation.cosTheta_rad;
+    record->closestX = (float) target->closestPoint.x_in;
+    record->closestY = (float) target->closestPoint.y_in;
+    record->closestDistance = (float) target->closestPointDistance_in;
+    record->closestSpeed = (float) target->closestPointSpeed_ips;
+    record->remainingSegmentDistance = (float) target->remainingSegmentDistance_in;
+    record->remainingPathDistance = (float) target->remainingPathDistance_in;
+    record->maxSpeed = (float) target->maxSpeed_ips;
+    record->lookaheadX = (float) target->lookaheadPoint.x_in;
+    record->lookaheadY = (float) target->lookaheadPoint.y_in;
+    record->lookaheadSpeed = (float) target->lookaheadPointSpeed_ips;
+    record->steerDx = (float) steering->delta.dx_in;
+    record->steerDy = (float) steering->delta.dy_in;
+    record->steerDtheta = (float) steering->delta.dtheta_rad;
+    record->crossTrackError = (float) steering->crossTrackError;
+    record->steerMaxSpeed = (float) steering->maxSpeed_ips;
+    record->steerEndSpeed = (float) steering->endSpeed_ips;
+    record->remainingPathLength = (float) steering->remainingPathLength;
+    if ( setpoint ) {
+        record->setpointT = (float) setpoint->motionState.t;
+        record->setpointPos = (float) setpoint->motionState.pos;
+        record->setpointVel = (float) setpoint->motionState.vel;
+        record->setpointAcc = (float) setpoint->motionState.acc;
+    } else {
+        record->setpointT = record->setpointPos = record->setpointVel = record->setpointAcc = 0.0f;
+    }
+    record->outputDx = (float) output->dx_in;
+    record->outputDy = (float) output->dy_in;
+    record->outputDtheta = (float) output->dtheta_rad;
+    record->flags = ( pathFollower->steeringController.atEndOfPath ? FLIGHT_AT_END_OF_PATH : 0 ) |
+                    ( pathFollower->doneSteering ? FLIGHT_DONE_STEERING : 0 ) |
+                    ( PathFollowerIsFinished( pathFollower ) ? FLIGHT_FINISHED : 0 );
+    record->reserved = 0;
+
+    recorder->count += 1;
+}
+
+
+/********************************************************************************************************************************
+**  FaultHandler
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+static void FaultHandler (int sig) {
+    int fd;
+
+    fd = open( gFaultDumpName, O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+    if ( fd >= 0 ) {
+        WriteFlightDump( gFaultRecorder, fd );
+        close( fd );
+    }
+    raise( sig );
+}
+
+
+/********************************************************************************************************************************
+**  InstallFlightRecorderFaultDump
+**
+**      Dumps the recorder to the given file if the process dies of SIGSEGV, SIGBUS, SIGFPE, SIGILL or SIGABRT, then lets the
+**      signal take its default action.  Only one recorder can be installed.
+**
+**      Input:
+**
+**      Output: Returns 0, or -1 if the file name is too long or a handler could not be installed.
+**
+********************************************************************************************************************************/
+int InstallFlightRecorderFaultDump (flightRecorder_t *recorder, const char *fileName) {
+    const int signals[] = {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT};
+    struct sigaction action;
+    size_t i;
+
+    if ( strlen( fileName ) >= sizeof( gFaultDumpName ) ) {
+        return -1;
+    }
+    strcpy( gFaultDumpName, fileName );
+    gFaultRecorder = recorder;
+
+    memset( &action, 0, sizeof( action ) );
+    action.sa_handler = FaultHandler;
+    sigemptyset( &action.sa_mask );
+    action.sa_flags = SA_RESETHAND;
+    for ( i = 0; i < sizeof( signals ) / sizeof( signals[0] ); i++ ) {
+        if ( sigaction( signals[i], &action, NULL ) ) {
+            return -1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,83 @@
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include <stdint.h>
+#include "Geometry.h"
+#include "Path.h"
+
+#define FLIGHT_RECORDER_MAGIC "FLTREC01"
+#define FLIGHT_RECORDER_VERSION 1
+
+// Flags of a flight record.
+#define FLIGHT_AT_END_OF_PATH 0x1
+#define FLIGHT_DONE_STEERING 0x2
+#define FLIGHT_FINISHED 0x4
+
+// One control tick, stored as floats (and the heading as sin/cos, so recording needs no trig) in exactly two cache lines.
+typedef struct flightRecord {
+    uint32_t sequence;
+    float t;
+    float poseX;
+    float poseY;
+    float poseSin;
+    float poseCos;
+    float closestX;
+    float closestY;
+    float closestDistance;
+    float closestSpeed;
+    float remainingSegmentDistance;
+    float remainingPathDistance;
+    float maxSpeed;
+    float lookaheadX;
+    float lookaheadY;
+    float lookaheadSpeed;
+    float steerDx;
+    float steerDy;
+    float steerDtheta;
+    float crossTrackError;
+    float steerMaxSpeed;
+    float steerEndSpeed;
+    float remainingPathLength;
+    float setpointT;
+    float setpointPos;
+    float setpointVel;
+    float setpointAcc;
+    float outputDx;
+    float outputDy;
+    float outputDtheta;
+    uint32_t flags;
+    uint32_t reserved;
+} flightRecord_t;
+
+_Static_assert( sizeof( flightRecord_t ) == 128, "flight records are two cache lines" );
+
+// A dump is this header followed by min(count, capacity) records, oldest first, in the host's byte order.
+typedef struct flightDumpHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+    uint32_t capacity;
+    uint32_t numRecords;
+    uint64_t totalRecorded;
+} flightDumpHeader_t;
+
+// Single writer (the control loop).  The records are supplied by the caller so recording never allocates.
+typedef struct flightRecorder {
+    flightRecord_t *records;
+    uint32_t capacity;
+    uint32_t mask;
+    uint64_t count;
+} flightRecorder_t;
+
+
+// FlightRecorder.c
+int InitFlightRecorder (flightRecorder_t *recorder, flightRecord_t *records, uint32_t capacity);
+void RecordFlightTick (flightRecorder_t *recorder, pathFollower_t *pathFollower, double t, transform2d_t *robotPose, twist2d_t *output);
+int InstallFlightRecorderFaultDump (flightRecorder_t *recorder, const char *fileName);
+
+// FlightDump.c
+int WriteFlightDump (flightRecorder_t *recorder, int fd);
+int DumpFlightRecorder (flightRecorder_t *recorder, const char *fileName);
+flightRecord_t * LoadFlightDump (const char *fileName, flightDumpHeader_t *header);
+
+#endif
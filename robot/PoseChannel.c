@@ -0,0 +1,80 @@
+#include "PoseChannel.h"
+
+
+/********************************************************************************************************************************
+**  InitPoseChannel
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void InitPoseChannel (poseChannel_t *channel) {
+    int i;
+
+    for ( i = 0; i < 3; i++ ) {
+        channel->buffers[i].sample.pose.translation.x_in = 0.0;
+        channel->buffers[i].sample.pose.translation.y_in = 0.0;
+        channel->buffers[i].sample.pose.rotation.sinTheta_rad = 0.0;
+        channel->buffers[i].sample.pose.rotation.cosTheta_rad = 1.0;
+        channel->buffers[i].sample.t = 0.0;
+        channel->buffers[i].sample.sequence = 0;
+    }
+    channel->back = 0;
+    atomic_init( &channel->middle, 1 );
+    channel->front = 2;
+    channel->sequence = 0;
+}
+
+
+/********************************************************************************************************************************
+**  PublishPose
+**
+**      Writer side, only ever called from the estimator.  Never blocks.
+**
+**      Input:
+**          transform2d_t pose      The new robot pose
+**          double t                The time the pose was measured at
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void PublishPose (poseChannel_t *channel, transform2d_t *pose, double t) {
+    timestampedPose_t *sample;
+    uint32_t previous;
+
+    sample = &channel->buffers[channel->back].sample;
+    sample->pose = *pose;
+    sample->t = t;
+    sample->sequence = ++channel->sequence;
+
+    previous = atomic_exchange_explicit( &channel->middle, channel->back | POSECHANNEL_FRESH, memory_order_acq_rel );
+    channel->back = previous & POSECHANNEL_INDEX;
+}
+
+
+/********************************************************************************************************************************
+**  ReadLatestPose
+**
+**      Reader side, only ever called from the controller.  Never blocks.
+**
+**      Input:
+**
+**      Output:
+**          timestampedPose_t sample    The most recently published pose (sequence 0 if nothing has been published yet)
+**          int                         Return 1 if the pose is new since the previous read, else 0
+**
+********************************************************************************************************************************/
+int ReadLatestPose (poseChannel_t *channel, timestampedPose_t *sample) {
+    uint32_t previous;
+    int rv = 0;
+
+    if ( atomic_load_explicit( &channel->middle, memory_order_relaxed ) & POSECHANNEL_FRESH ) {
+        previous = atomic_exchange_explicit( &channel->middle, channel->front, memory_order_acq_rel );
+        channel->front = previous & POSECHANNEL_INDEX;
+        rv = 1;
+    }
+    *sample = channel->buffers[channel->front].sample;
+
+    return rv;
+}
@@ -0,0 +1,37 @@
+#ifndef POSECHANNEL_H
+#define POSECHANNEL_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include "Geometry.h"
+
+#define POSECHANNEL_FRESH 0x4u
+#define POSECHANNEL_INDEX 0x3u
+
+typedef struct timestampedPose {
+    transform2d_t pose;
+    double t;
+    uint32_t sequence;
+} timestampedPose_t;
+
+// Single-producer/single-consumer triple buffer.  The writer owns one buffer, the reader owns one and the third is shared
+// through an atomic index (with a flag marking it as not yet read).  Publishing and reading each swap that index once, so
+// neither side ever waits for the other and the reader always gets a whole pose from a single publish.
+typedef struct poseBuffer {
+    _Alignas(64) timestampedPose_t sample;
+} poseBuffer_t;
+
+typedef struct poseChannel {
+    poseBuffer_t buffers[3];
+    _Alignas(64) _Atomic uint32_t middle;
+    _Alignas(64) uint32_t back;
+    uint32_t sequence;
+    _Alignas(64) uint32_t front;
+} poseChannel_t;
+
+// PoseChannel.c
+void InitPoseChannel (poseChannel_t *channel);
+void PublishPose (poseChannel_t *channel, transform2d_t *pose, double t);
+int ReadLatestPose (poseChannel_t *channel, timestampedPose_t *sample);
+
+#endif
@@ -0,0 +1,562 @@
+#include <math.h>
+#include "RobotStateEstimator.h"
+
+
+/********************************************************************************************************************************
+**  InitPoseHistory
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void InitPoseHistory (poseHistory_t *history) {
+    int i;
+
+    for ( i = 0; i < POSE_HISTORY_SIZE; i++ ) {
+        atomic_init( &history->entries[i].t, 0.0 );
+        atomic_init( &history->entries[i].x_in, 0.0 );
+        atomic_init( &history->entries[i].y_in, 0.0 );
+        atomic_init( &history->entries[i].sinTheta_rad, 0.0 );
+        atomic_init( &history->entries[i].cosTheta_rad, 1.0 );
+    }
+    atomic_init( &history->count, 0 );
+    atomic_init( &history->started, 0 );
+}
+
+
+/********************************************************************************************************************************
+**  RecordPose
+**
+**      Recording side, only ever called from one thread.  Writes over the oldest pose once the history is full.  Never
+**      blocks or allocates.
+**
+**      Input:
+**          transform2d_t pose          The robot pose
+**          double t                    The time of the pose, no earlier than the last one recorded
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void RecordPose (poseHistory_t *history, transform2d_t *pose, double t) {
+    poseHistoryEntry_t *entry;
+    uint32_t count;
+
+    count = atomic_load_explicit( &history->count, memory_order_relaxed );
+    entry = &history->entries[count % POSE_HISTORY_SIZE];
+
+    // Readers that may have loaded the entry being written over see started move on and try again.
+    atomic_store_explicit( &history->started, count + 1, memory_order_relaxed );
+    atomic_thread_fence( memory_order_release );
+    atomic_store_explicit( &entry->t, t, memory_order_relaxed );
+    atomic_store_explicit( &entry->x_in, pose->translation.x_in, memory_order_relaxed );
+    atomic_store_explicit( &entry->y_in, pose->translation.y_in, memory_order_relaxed );
+    atomic_store_explicit( &entry->sinTheta_rad, pose->rotation.sinTheta_rad, memory_order_relaxed );
+    atomic_store_explicit( &entry->cosTheta_rad, pose->rotation.cosTheta_rad, memory_order_relaxed );
+    atomic_store_explicit( &history->count, count + 1, memory_order_release );
+}
+
+
+/********************************************************************************************************************************
+**  LoadPoseEntry
+**
+**      Input:
+**          uint32_t index              Which pose, counted from the first one ever recorded
+**
+**      Output:
+**
+********************************************************************************************************************************/
+static void LoadPoseEntry (poseHistory_t *history, uint32_t index, transform2d_t *pose) {
+    poseHistoryEntry_t *entry = &history->entries[index % POSE_HISTORY_SIZE];
+
+    pose->translation.x_in = atomic_load_explicit( &entry->x_in, memory_order_relaxed );
+    pose->translation.y_in = atomic_load_explicit( &entry->y_in, memory_order_relaxed );
+    pose->rotation.sinTheta_rad = atomic_load_explicit( &entry->sinTheta_rad, memory_order_relaxed );
+    pose->rotation.cosTheta_rad = atomic_load_explicit( &entry->cosTheta_rad, memory_order_relaxed );
+}
+
+
+/********************************************************************************************************************************
+**  LoadPoseTime
+**
+**      Input:
+**          uint32_t index              Which pose, counted from the first one ever recorded
+**
+**      Output: The time of the pose.
+**
+********************************************************************************************************************************/
+static double LoadPoseTime (poseHistory_t *history, uint32_t index) {
+    return atomic_load_explicit( &history->entries[index % POSE_HISTORY_SIZE].t, memory_order_relaxed );
+}
+
+
+/********************************************************************************************************************************
+**  InterpolatePose
+**
+**      Moves from the start pose towards the end one along the constant curvature arc joining them (see Exp), e.g. to find
+**      where the robot was between two odometry updates.
+**
+**      Input:
+**          double scale                Share of the way to the end pose, clamped to 0 to 1
+**
+**      Output: The pose.
+**
+********************************************************************************************************************************/
+transform2d_t InterpolatePose (transform2d_t *start, transform2d_t *end, double scale) {
+    transform2d_t inverse, delta, motion;
+    twist2d_t twist;
+
+    if ( scale <= 0.0 ) {
+        return *start;
+    }
+    if ( scale >= 1.0 ) {
+        return *end;
+    }
+    inverse = TransformInverse( start );
+    delta = TranformAByB( &inverse, end );
+    twist = Log( &delta );
+    twist.dx_in *= scale;
+    twist.dy_in *= scale;
+    twist.dtheta_rad *= scale;
+    motion = Exp( &twist );
+
+    return TranformAByB( start, &motion );
+}
+
+
+/********************************************************************************************************************************
+**  GetPoseAtTime
+**
+**      Where the robot was at a time, e.g. when a camera frame was taken: a binary search of the history for the poses
+**      either side, interpolated between (see InterpolatePose).  Safe to call from any thread, any number of them, while
+**      poses are recorded.  Never blocks or allocates.
+**
+**      Input:
+**          double t                    The time
+**
+**      Output:
+**          transform2d_t pose          The pose at the time, the newest pose for a time after it, the oldest for a time
+**                                      before the history
+**          int                         Returns 0, or -1 if the time is before the oldest pose kept or none was recorded
+**
+********************************************************************************************************************************/
+int GetPoseAtTime (poseHistory_t *history, double t, transform2d_t *pose) {
+    transform2d_t before, after;
+    double beforeT, afterT;
+    uint32_t count, started, oldest, low, high, middle;
+    int rv;
+
+    do {
+        count = atomic_load_explicit( &history->count, memory_order_acquire );
+        if ( !count ) {
+            return -1;
+        }
+        // Once full, the oldest slot is the next one written over, so it is left out.
+        oldest = ( count >= POSE_HISTORY_SIZE ) ? count - POSE_HISTORY_SIZE + 1 : 0;
+        low = oldest;
+        high = count - 1;
+        rv = 0;
+
+        if ( t <= LoadPoseTime( history, low ) ) {
+            // The oldest pose, unless the time is before it.
+            rv = ( t < LoadPoseTime( history, low ) ) ? -1 : 0;
+            LoadPoseEntry( history, low, pose );
+            high = low;
+        } else if ( t >= LoadPoseTime( history, high ) ) {
+            LoadPoseEntry( history, high, pose );
+            low = high;
+        } else {
+            // The last pose at or before the time, and the one after it.
+            while ( low + 1 < high ) {
+                middle = low + ( high - low ) / 2;
+                if ( LoadPoseTime( history, middle ) <= t ) {
+                    low = middle;
+                } else {
+                    high = middle;
+                }
+            }
+            beforeT = LoadPoseTime( history, low );
+            afterT = LoadPoseTime( history, high );
+            LoadPoseEntry( history, low, &before );
+            LoadPoseEntry( history, high, &after );
+            *pose = InterpolatePose( &before, &after, ( afterT > beforeT ) ? ( t - beforeT ) / ( afterT - beforeT ) : 1.0 );
+        }
+
+        // The oldest entry looked at may have been written over in the meantime; then look again.
+        atomic_thread_fence( memory_order_acquire );
+        started = atomic_load_explicit( &history->started, memory_order_relaxed );
+    } while ( oldest + POSE_HISTORY_SIZE < started );
+
+    return rv;
+}
+
+
+/********************************************************************************************************************************
+**  InitRobotStateEstimator
+**
+**      The robot starts at the origin at time 0 with nothing recorded; see ResetRobotStateEstimator to start elsewhere.
+**
+**      Input:
+**          double trackWidth_in        Distance between the left and right wheels
+**          poseChannel_t channel       Where to publish every new pose for a reader on another thread, or NULL
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void InitRobotStateEstimator (robotStateEstimator_t *estimator, double trackWidth_in, poseChannel_t *channel) {
+    estimator->pose.translation.x_in = 0.0;
+    estimator->pose.translation.y_in = 0.0;
+    estimator->pose.rotation.sinTheta_rad = 0.0;
+    estimator->pose.rotation.cosTheta_rad = 1.0;
+    estimator->t = 0.0;
+    estimator->leftDistance_in = 0.0;
+    estimator->rightDistance_in = 0.0;
+    estimator->trackWidth_in = trackWidth_in;
+    estimator->channel = channel;
+    InitPoseHistory( &estimator->history );
+}
+
+
+/********************************************************************************************************************************
+**  ResetRobotStateEstimator
+**
+**      Puts the robot at a known pose, e.g. at the start of a route, and records it.
+**
+**      Input:
+**          transform2d_t pose          Where the robot is
+**          double t                    The time
+**          double leftDistance_in      Wheel distances at the time, as read from the encoders
+**          double rightDistance_in
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void ResetRobotStateEstimator (robotStateEstimator_t *estimator, transform2d_t *pose, double t, double leftDistance_in, double rightDistance_in) {
+    estimator->pose = *pose;
+    estimator->t = t;
+    estimator->leftDistance_in = leftDistance_in;
+    estimator->rightDistance_in = rightDistance_in;
+    RecordPose( &estimator->history, pose, t );
+    if ( estimator->channel ) {
+        PublishPose( estimator->channel, pose, t );
+    }
+}
+
+
+/********************************************************************************************************************************
+**  UpdateRobotStateEstimator
+**
+**      Integrates the wheel odometry since the last update: the robot is taken to have driven a constant curvature arc (see
+**      Exp) of the mean of the wheel distances, turning by their difference over the track width.  The new pose is recorded
+**      in the history and published.
+**
+**      Input:
+**          double t                    The time the encoders were read at
+**          double leftDistance_in      Distance each side's wheels have driven, as read from the encoders
+**          double rightDistance_in
+**
+**      Output: The new pose.
+**
+********************************************************************************************************************************/
+transform2d_t UpdateRobotStateEstimator (robotStateEstimator_t *estimator, double t, double leftDistance_in, double rightDistance_in) {
+    transform2d_t motion;
+    twist2d_t delta;
+    double left_in, right_in;
+
+    left_in = leftDistance_in - estimator->leftDistance_in;
+    right_in = rightDistance_in - estimator->rightDistance_in;
+    delta.dx_in = 0.5 * ( left_in + right_in );
+    delta.dy_in = 0.0;
+    delta.dtheta_rad = ( right_in - left_in ) / estimator->trackWidth_in;
+    motion = Exp( &delta );
+    estimator->pose = TranformAByB( &estimator->pose, &motion );
+    estimator->t = t;
+    estimator->leftDistance_in = leftDistance_in;
+    estimator->rightDistance_in = rightDistance_in;
+
+    RecordPose( &estimator->history, &estimator->pose, t );
+    if ( estimator->channel ) {
+        PublishPose( estimator->channel, &estimator->pose, t );
+    }
+
+    return estimator->pose;
+}
+
+
+/********************************************************************************************************************************
+**  SetPoseFilterCovariance
+**
+**      Input:
+**          double c00..c22             The upper triangle of the covariance, mirrored into the lower one
+**
+**      Output:
+**
+********************************************************************************************************************************/
+static void SetPoseFilterCovariance (poseFilter_t *filter, double c00, double c01, double c02, double c11, double c12, double c22) {
+    filter->covariance[0][0] = c00;
+    filter->covariance[0][1] = c01;
+    filter->covariance[0][2] = c02;
+    filter->covariance[1][0] = c01;
+    filter->covariance[1][1] = c11;
+    filter->covariance[1][2] = c12;
+    filter->covariance[2][0] = c02;
+    filter->covariance[2][1] = c12;
+    filter->covariance[2][2] = c22;
+}
+
+
+/********************************************************************************************************************************
+**  InitPoseFilter
+**
+**      The robot starts at the origin at time 0, its pose known exactly; see ResetPoseFilter to start elsewhere.
+**
+**      Input:
+**          double trackWidth_in        Distance between the left and right wheels
+**          double wheelVariance        Variance of a wheel's travel per inch it travels, in^2 / in
+**          double gyroVariance         Variance the gyro heading gains per second, rad^2 / s
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void InitPoseFilter (poseFilter_t *filter, double trackWidth_in, double wheelVariance, double gyroVariance) {
+    filter->x_in = 0.0;
+    filter->y_in = 0.0;
+    filter->theta_rad = 0.0;
+    SetPoseFilterCovariance( filter, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 );
+    filter->t = 0.0;
+    filter->leftDistance_in = 0.0;
+    filter->rightDistance_in = 0.0;
+    filter->stepTurn_rad = 0.0;
+    filter->stepCovariance[0] = 0.0;
+    filter->stepCovariance[1] = 0.0;
+    filter->stepCovariance[2] = 0.0;
+    filter->trackWidth_in = trackWidth_in;
+    filter->wheelVariance = wheelVariance;
+    filter->gyroVariance = gyroVariance;
+}
+
+
+/********************************************************************************************************************************
+**  ResetPoseFilter
+**
+**      Puts the robot at a known pose, e.g. at the start of a route.
+**
+**      Input:
+**          transform2d_t pose          Where the robot is
+**          double t                    The time
+**          double leftDistance_in      Wheel distances at the time, as read from the encoders
+**          double rightDistance_in
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void ResetPoseFilter (poseFilter_t *filter, transform2d_t *pose, double t, double leftDistance_in, double rightDistance_in) {
+    filter->x_in = pose->translation.x_in;
+    filter->y_in = pose->translation.y_in;
+    filter->theta_rad = atan2( pose->rotation.sinTheta_rad, pose->rotation.cosTheta_rad );
+    SetPoseFilterCovariance( filter, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 );
+    filter->t = t;
+    filter->leftDistance_in = leftDistance_in;
+    filter->rightDistance_in = rightDistance_in;
+    filter->stepTurn_rad = 0.0;
+    filter->stepCovariance[0] = 0.0;
+    filter->stepCovariance[1] = 0.0;
+    filter->stepCovariance[2] = 0.0;
+}
+
+
+/********************************************************************************************************************************
+**  PredictPoseFilter
+**
+**      Moves the pose on by the wheel travel since the last step, along the arc it makes as in UpdateRobotStateEstimator,
+**      and grows the covariance by the motion's Jacobian F and by each wheel's travel variance through G, the Jacobian by
+**      the wheel travels: P = F P F' + G V G'.  F only differs from the identity in its last column, so the products are
+**      written out term by term.  The step's turn and the pose's covariance with its error are kept for CorrectPoseFilterTurn.
+**
+**      Input:
+**          double t                    The time the encoders were read at
+**          double leftDistance_in      Distance each side's wheels have driven, as read from the encoders
+**          double rightDistance_in
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void PredictPoseFilter (poseFilter_t *filter, double t, double leftDistance_in, double rightDistance_in) {
+    double (*p)[3] = filter->covariance;
+    double left_in, right_in, distance_in, dtheta_rad, chord, c, s, a, b, halfInverseTrack, vl, vr;
+    double lx, ly, lt, rx, ry, rt;
+
+    left_in = leftDistance_in - filter->leftDistance_in;
+    right_in = rightDistance_in - filter->rightDistance_in;
+    filter->leftDistance_in = leftDistance_in;
+    filter->rightDistance_in = rightDistance_in;
+    filter->t = t;
+    distance_in = 0.5 * ( left_in + right_in );
+    dtheta_rad = ( right_in - left_in ) / filter->trackWidth_in;
+
+    // The chord of the arc runs along the heading half way round it.
+    chord = ( fabs( dtheta_rad ) < 1E-9 ) ? distance_in : distance_in * sin( 0.5 * dtheta_rad ) / ( 0.5 * dtheta_rad );
+    c = cos( filter->theta_rad + 0.5 * dtheta_rad );
+    s = sin( filter->theta_rad + 0.5 * dtheta_rad );
+    a = -chord * s;
+    b = chord * c;
+
+    // The columns of G for the left and right wheel travel, the chord taken as the arc length.
+    halfInverseTrack = 0.5 / filter->trackWidth_in;
+    lx = 0.5 * c - a * halfInverseTrack;
+    ly = 0.5 * s - b * halfInverseTrack;
+    lt = -1.0 / filter->trackWidth_in;
+    rx = 0.5 * c + a * halfInverseTrack;
+    ry = 0.5 * s + b * halfInverseTrack;
+    rt = 1.0 / filter->trackWidth_in;
+    vl = filter->wheelVariance * fabs( left_in );
+    vr = filter->wheelVariance * fabs( right_in );
+
+    SetPoseFilterCovariance( filter,
+                             p[0][0] + 2.0 * a * p[0][2] + a * a * p[2][2] + vl * lx * lx + vr * rx * rx,
+                             p[0][1] + a * p[1][2] + b * p[0][2] + a * b * p[2][2] + vl * lx * ly + vr * rx * ry,
+                             p[0][2] + a * p[2][2] + vl * lx * lt + vr * rx * rt,
+                             p[1][1] + 2.0 * b * p[1][2] + b * b * p[2][2] + vl * ly * ly + vr * ry * ry,
+                             p[1][2] + b * p[2][2] + vl * ly * lt + vr * ry * rt,
+                             p[2][2] + vl * lt * lt + vr * rt * rt );
+    filter->x_in += b;
+    filter->y_in -= a;
+    filter->theta_rad += dtheta_rad;
+
+    // G V g', g the row of G for the turn: how the wheels' error in the turn moved the pose.
+    filter->stepTurn_rad = dtheta_rad;
+    filter->stepCovariance[0] = vl * lx * lt + vr * rx * rt;
+    filter->stepCovariance[1] = vl * ly * lt + vr * ry * rt;
+    filter->stepCovariance[2] = vl * lt * lt + vr * rt * rt;
+}
+
+
+/********************************************************************************************************************************
+**  CorrectPoseFilterTurn
+**
+**      Kalman update by a measurement of the turn over the last step, e.g. the gyro's.  The innovation is the measured turn
+**      less the wheels', whose errors are the wheels' error in the turn and the measurement's, so its variance is theirs
+**      summed; the gain is the pose's covariance with the wheels' error (see PredictPoseFilter) over it, and P = P - K S K'.
+**      One turn measurement per step.
+**
+**      Input:
+**          double turn_rad             The measured turn since the last step, counter-clockwise
+**          double variance             Its variance, rad^2
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void CorrectPoseFilterTurn (poseFilter_t *filter, double turn_rad, double variance) {
+    double *g = filter->stepCovariance;
+    double innovation_rad, innovationVariance, k0, k1, k2;
+
+    innovationVariance = g[2] + variance;
+    if ( innovationVariance <= 0.0 ) {
+        // Both turns are exact: there is nothing to weigh.
+        return;
+    }
+    k0 = g[0] / innovationVariance;
+    k1 = g[1] / innovationVariance;
+    k2 = g[2] / innovationVariance;
+    innovation_rad = turn_rad - filter->stepTurn_rad;
+    filter->x_in += k0 * innovation_rad;
+    filter->y_in += k1 * innovation_rad;
+    filter->theta_rad += k2 * innovation_rad;
+
+    SetPoseFilterCovariance( filter,
+                             filter->covariance[0][0] - k0 * g[0],
+                             filter->covariance[0][1] - k0 * g[1],
+                             filter->covariance[0][2] - k0 * g[2],
+                             filter->covariance[1][1] - k1 * g[1],
+                             filter->covariance[1][2] - k1 * g[2],
+                             filter->covariance[2][2] - k2 * g[2] );
+    filter->stepTurn_rad = turn_rad;
+    g[0] = 0.0;
+    g[1] = 0.0;
+    g[2] = 0.0;
+}
+
+
+/********************************************************************************************************************************
+**  CorrectPoseFilterHeading
+**
+**      Kalman update by a measurement of the heading alone, H = [0 0 1]: the gain is the covariance's last column over the
+**      innovation variance, and P = P - K H P.
+**
+**      Input:
+**          double heading_rad          The measured heading, not wrapped (as theta_rad)
+**          double variance             Its variance, rad^2
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void CorrectPoseFilterHeading (poseFilter_t *filter, double heading_rad, double variance) {
+    double (*p)[3] = filter->covariance;
+    double innovation_rad, innovationVariance, k0, k1, k2;
+
+    innovationVariance = p[2][2] + variance;
+    if ( innovationVariance <= 0.0 ) {
+        // Both headings are exact: there is nothing to weigh.
+        return;
+    }
+    k0 = p[0][2] / innovationVariance;
+    k1 = p[1][2] / innovationVariance;
+    k2 = p[2][2] / innovationVariance;
+    innovation_rad = heading_rad - filter->theta_rad;
+    filter->x_in += k0 * innovation_rad;
+    filter->y_in += k1 * innovation_rad;
+    filter->theta_rad += k2 * innovation_rad;
+
+    SetPoseFilterCovariance( filter,
+                             p[0][0] - k0 * p[0][2],
+                             p[0][1] - k0 * p[1][2],
+                             p[0][2] - k0 * p[2][2],
+                             p[1][1] - k1 * p[1][2],
+                             p[1][2] - k1 * p[2][2],
+                             p[2][2] - k2 * p[2][2] );
+}
+
+
+/********************************************************************************************************************************
+**  UpdatePoseFilter
+**
+**      One filter step: predicts from the wheel odometry, then corrects by the turn the gyro rate gives over the time since
+**      the last step, its variance growing with that time.
+**
+**      Input:
+**          double t                    The time the encoders and gyro were read at
+**          double leftDistance_in      Distance each side's wheels have driven, as read from the encoders
+**          double rightDistance_in
+**          double gyroRate_rps         The gyro's turn rate, counter-clockwise, taken as the mean since the last step
+**
+**      Output: The new pose.
+**
+********************************************************************************************************************************/
+transform2d_t UpdatePoseFilter (poseFilter_t *filter, double t, double leftDistance_in, double rightDistance_in, double gyroRate_rps) {
+    double dt = t - filter->t;
+
+    PredictPoseFilter( filter, t, leftDistance_in, rightDistance_in );
+    CorrectPoseFilterTurn( filter, gyroRate_rps * dt, filter->gyroVariance * fabs( dt ) );
+
+    return GetPoseFilterPose( filter );
+}
+
+
+/********************************************************************************************************************************
+**  GetPoseFilterPose
+**
+**      Input:
+**
+**      Output: The filter's pose estimate.
+**
+********************************************************************************************************************************/
+transform2d_t GetPoseFilterPose (poseFilter_t *filter) {
+    transform2d_t pose;
+
+    pose.translation.x_in = filter->x_in;
+    pose.translation.y_in = filter->y_in;
+    pose.rotation.sinTheta_rad = sin( filter->theta_rad );
+    pose.rotation.cosTheta_rad = cos( filter->theta_rad );
+
+    return pose;
+}
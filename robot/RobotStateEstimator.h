@@ -1,8 +1,75 @@
 #ifndef ROBOTSTATEESTIMATOR_H
 #define ROBOTSTATEESTIMATOR_H
 
+#include <stdatomic.h>
+#include <stdint.h>
 #include "Geometry.h"
+#include "PoseChannel.h"
 
-transform2d_t *gROBOTPOSE;
+// Poses kept in the history, a power of 2 (about 10 s of 100 Hz odometry).
+#define POSE_HISTORY_SIZE 1024
 
-#endif
\ No newline at end of file
+typedef struct poseHistoryEntry {
+    _Atomic double t;
+    _Atomic double x_in;
+    _Atomic double y_in;
+    _Atomic double sinTheta_rad;
+    _Atomic double cosTheta_rad;
+} poseHistoryEntry_t;
+
+// The last POSE_HISTORY_SIZE poses in time order, entry i of all those ever recorded in slot i % POSE_HISTORY_SIZE.  One
+// thread records, any number look poses up (see GetPoseAtTime): a reader checks after its loads that none of the entries it
+// used has been written over since, and retries if one was, so neither side ever waits on a lock.  Once full, the oldest
+// slot is left out of lookups, being the next written over.
+typedef struct poseHistory {
+    poseHistoryEntry_t entries[POSE_HISTORY_SIZE];
+    _Atomic uint32_t count;             // Poses recorded so far
+    _Atomic uint32_t started;           // Poses the recording thread has started writing, one ahead of count while it writes
+} poseHistory_t;
+
+typedef struct robotStateEstimator {
+    transform2d_t pose;
+    double t;
+    double leftDistance_in;             // Wheel distances at the last update
+    double rightDistance_in;
+    double trackWidth_in;
+    poseChannel_t *channel;             // Where every new pose is published, or NULL
+    poseHistory_t history;
+} robotStateEstimator_t;
+
+// Extended Kalman filter over the pose (x, y, theta).  Each step predicts from the wheel encoders and corrects by the turn
+// the gyro measured over it, each weighted by its own variance: the wheels' grows with the distance they travel (slip), the
+// gyro's with the time (noise and drift).  An absolute heading, when there is one, is folded in with
+// CorrectPoseFilterHeading.  The covariance is a fixed 3x3 held in place, so a step never allocates.
+typedef struct poseFilter {
+    double x_in;
+    double y_in;
+    double theta_rad;                   // Not wrapped
+    double covariance[3][3];            // Of x, y and theta, symmetric
+    double t;
+    double leftDistance_in;             // Wheel distances at the last step
+    double rightDistance_in;
+    double stepTurn_rad;                // The last step's turn, and the pose's covariance with the wheels' error in it
+    double stepCovariance[3];
+    double trackWidth_in;
+    double wheelVariance;               // Variance of a wheel's travel per inch it travels (slip and scrub), in^2 / in
+    double gyroVariance;                // Variance the gyro heading gains per second (noise and drift), rad^2 / s
+} poseFilter_t;
+
+// RobotStateEstimator.c
+void InitPoseHistory (poseHistory_t *history);
+void RecordPose (poseHistory_t *history, transform2d_t *pose, double t);
+int GetPoseAtTime (poseHistory_t *history, double t, transform2d_t *pose);
+transform2d_t InterpolatePose (transform2d_t *start, transform2d_t *end, double scale);
+void InitRobotStateEstimator (robotStateEstimator_t *estimator, double trackWidth_in, poseChannel_t *channel);
+void ResetRobotStateEstimator (robotStateEstimator_t *estimator, transform2d_t *pose, double t, double leftDistance_in, double rightDistance_in);
+transform2d_t UpdateRobotStateEstimator (robotStateEstimator_t *estimator, double t, double leftDistance_in, double rightDistance_in);
+void InitPoseFilter (poseFilter_t *filter, double trackWidth_in, double wheelVariance, double gyroVariance);
+void ResetPoseFilter (poseFilter_t *filter, transform2d_t *pose, double t, double leftDistance_in, double rightDistance_in);
+void PredictPoseFilter (poseFilter_t *filter, double t, double leftDistance_in, double rightDistance_in);
+void CorrectPoseFilterTurn (poseFilter_t *filter, double turn_rad, double variance);
+void CorrectPoseFilterHeading (poseFilter_t *filter, double heading_rad, double variance);
+transform2d_t UpdatePoseFilter (poseFilter_t *filter, double t, double leftDistance_in, double rightDistance_in, double gyroRate_rps);
+transform2d_t GetPoseFilterPose (poseFilter_t *filter);
+
+#endif
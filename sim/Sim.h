@@ -0,0 +1,115 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+#include "Geometry.h"
+#include "Path.h"
+#include "Recorder.h"
+
+#define SIM_MAX_WAYPOINTS 16
+#define SIM_MAX_DELAY_TICKS 64
+
+// How the simulated differential-drive robot responds to the commanded twist.  All zero except dt, maxTime and
+// trackWidth_in gives an ideal robot that does exactly what it is told.
+typedef struct simConfig {
+    double dt;                      // Control period, s
+    double maxTime;                 // A run that has not finished by then is stopped, s
+    double trackWidth_in;           // Distance between the wheels
+    double actuatorTimeConstant;    // First order lag of the wheel speeds behind their commands, s (0 for none)
+    double actuationDelay_s;        // Dead time before a command reaches the wheels, e.g. CAN and motor controller, rounded
+                                    // to whole ticks up to SIM_MAX_DELAY_TICKS (0 for none)
+    double wheelSpeedNoise_ips;     // Standard deviation of the noise on each wheel's speed
+    double wheelSlip;               // Each tick a wheel loses a uniformly random fraction in [0, wheelSlip] of its travel
+    uint64_t seed;                  // Seed of the noise and slip, equal seeds give identical runs
+} simConfig_t;
+
+typedef struct simMetrics {
+    int finished;
+    long ticks;
+    double completionTime;
+    double maxCrossTrackError;
+    double meanCrossTrackError;
+    double finalPositionError;
+    double meanTickCost_ns;
+    double maxTickCost_ns;
+    double realTimeFactor;
+} simMetrics_t;
+
+typedef struct simRoute {
+    const char *name;
+    int numWaypoints;
+    waypoint_t waypoints[SIM_MAX_WAYPOINTS];
+} simRoute_t;
+
+typedef struct simRandom {
+    uint64_t state;
+} simRandom_t;
+
+// The tunable controller parameters a sweep can vary.
+typedef enum sweepParam {
+    SWEEP_LOOKAHEAD_MIN_DISTANCE,
+    SWEEP_LOOKAHEAD_MAX_DISTANCE,
+    SWEEP_LOOKAHEAD_MIN_SPEED,
+    SWEEP_LOOKAHEAD_MAX_SPEED,
+    SWEEP_INERTIA_GAIN,
+    SWEEP_PROFILE_KP,
+    SWEEP_PROFILE_KI,
+    SWEEP_PROFILE_KV,
+    SWEEP_PROFILE_KFFV,
+    SWEEP_PROFILE_KFFA,
+    SWEEP_NUM_PARAMS
+} sweepParam_t;
+
+// A grid takes steps evenly spaced values from min to max, random samples are uniform in [min, max].  A range with
+// steps = 0 keeps the base value.
+typedef struct sweepRange {
+    double min;
+    double max;
+    int steps;
+} sweepRange_t;
+
+typedef struct sweepConfig {
+    pathFollowerParams_t base;
+    sweepRange_t ranges[SWEEP_NUM_PARAMS];
+    int randomSamples;              // 0 evaluates the full grid, otherwise this many random parameter sets
+    uint64_t seed;                  // Seed of the random parameter sets
+    double crossTrackWeight;        // Seconds of completion time one inch of mean cross-track error is worth
+    simConfig_t sim;                // Robot model, its seed is offset per route
+    int numThreads;
+} sweepConfig_t;
+
+typedef struct sweepResult {
+    int index;
+    pathFollowerParams_t params;
+    int routesFinished;
+    double totalCompletionTime;
+    double maxCrossTrackError;
+    double meanCrossTrackError;
+    double cost;
+} sweepResult_t;
+
+
+// Simulator.c
+void InitSimConfig (simConfig_t *config);
+simMetrics_t RunSimulation (simConfig_t *config, pathFollowerParams_t *params, waypoint_t *waypoints, int numWaypoints, flightRecorder_t *recorder);
+void PrintSimMetrics (const char *name, simMetrics_t *metrics);
+
+// SimRandom.c
+void SeedSimRandom (simRandom_t *random, uint64_t seed);
+uint64_t SimRandomNext (simRandom_t *random);
+double SimRandomUniform (simRandom_t *random);
+double SimRandomGaussian (simRandom_t *random);
+
+// Sweep.c
+void InitSweepConfig (sweepConfig_t *config);
+const char * GetSweepParamName (sweepParam_t param);
+double * GetSweepParam (pathFollowerParams_t *params, sweepParam_t param);
+int GetSweepSize (sweepConfig_t *config);
+sweepResult_t * RunSweep (sweepConfig_t *config, int *numResults);
+void PrintSweepResult (int rank, sweepResult_t *result);
+
+// SimRoutes.c
+int GetNumSimRoutes (void);
+simRoute_t * GetSimRoute (int index);
+
+#endif
@@ -0,0 +1,70 @@
+#include <math.h>
+#include "Sim.h"
+
+
+/********************************************************************************************************************************
+**  SeedSimRandom
+**
+**      Small, fast and fully reproducible generator (splitmix64 seeding an xorshift64*), so that a simulation run only
+**      depends on its seed and not on the C library.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void SeedSimRandom (simRandom_t *random, uint64_t seed) {
+    uint64_t z;
+
+    z = seed + 0x9E3779B97F4A7C15ULL;
+    z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9ULL;
+    z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBULL;
+    z = z ^ ( z >> 31 );
+    random->state = z ? z : 0x9E3779B97F4A7C15ULL;
+}
+
+
+/********************************************************************************************************************************
+**  SimRandomNext
+**
+**      Input:
+**
+**      Output: The next 64 random bits.
+**
+********************************************************************************************************************************/
+uint64_t SimRandomNext (simRandom_t *random) {
+    random->state ^= random->state >> 12;
+    random->state ^= random->state << 25;
+    random->state ^= random->state >> 27;
+    return random->state * 0x2545F4914F6CDD1DULL;
+}
+
+
+/********************************************************************************************************************************
+**  SimRandomUniform
+**
+**      Input:
+**
+**      Output: A uniform random number in [0, 1).
+**
+********************************************************************************************************************************/
+double SimRandomUniform (simRandom_t *random) {
+    return ( SimRandomNext( random ) >> 11 ) * ( 1.0 / 9007199254740992.0 );
+}
+
+
+/********************************************************************************************************************************
+**  SimRandomGaussian
+**
+**      Input:
+**
+**      Output: A standard normal random number (Box-Muller).
+**
+********************************************************************************************************************************/
+double SimRandomGaussian (simRandom_t *random) {
+    double u1, u2;
+
+    u1 = 1.0 - SimRandomUniform( random );
+    u2 = SimRandomUniform( random );
+    return sqrt( -2.0 * log( u1 ) ) * cos( 2.0 * 3.14159265358979323846 * u2 );
+}
@@ -0,0 +1,38 @@
+#include "Sim.h"
+
+// Regression corpus: {x, y}, corner radius, speed.  The first waypoint is where the robot starts, facing the second.
+static simRoute_t kSimRoutes[] = {
+    {"Straight", 2, {{{0.0, 0.0}, 0.0, 60.0}, {{240.0, 0.0}, 0.0, 60.0}}},
+    {"LTurn", 3, {{{0.0, 0.0}, 0.0, 60.0}, {{120.0, 0.0}, 24.0, 60.0}, {{120.0, 120.0}, 0.0, 60.0}}},
+    {"SCurve", 4, {{{0.0, 0.0}, 0.0, 60.0}, {{100.0, 0.0}, 30.0, 60.0}, {{100.0, 100.0}, 30.0, 60.0}, {{200.0, 100.0}, 0.0, 60.0}}},
+    {"Slalom", 6, {{{0.0, 0.0}, 0.0, 60.0}, {{120.0, 0.0}, 24.0, 60.0}, {{120.0, 120.0}, 24.0, 48.0},
+                   {{240.0, 120.0}, 24.0, 60.0}, {{240.0, 0.0}, 24.0, 60.0}, {{360.0, 0.0}, 0.0, 60.0}}},
+    {"Hairpin", 4, {{{0.0, 0.0}, 0.0, 60.0}, {{150.0, 0.0}, 30.0, 48.0}, {{150.0, 60.0}, 30.0, 48.0}, {{0.0, 60.0}, 0.0, 60.0}}},
+    {"Diagonal", 4, {{{0.0, 0.0}, 0.0, 60.0}, {{80.0, 60.0}, 20.0, 60.0}, {{200.0, 60.0}, 20.0, 60.0}, {{280.0, 0.0}, 0.0, 60.0}}},
+};
+
+
+/********************************************************************************************************************************
+**  GetNumSimRoutes
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+int GetNumSimRoutes (void) {
+    return sizeof( kSimRoutes ) / sizeof( kSimRoutes[0] );
+}
+
+
+/********************************************************************************************************************************
+**  GetSimRoute
+**
+**      Input:
+**
+**      Output: The route, or NULL if there is no route with that index.
+**
+********************************************************************************************************************************/
+simRoute_t * GetSimRoute (int index) {
+    return ( index >= 0 && index < GetNumSimRoutes() ) ? &kSimRoutes[index] : NULL;
+}
@@ -0,0 +1,182 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "Sim.h"
+
+
+/********************************************************************************************************************************
+**  SimNow
+**
+**      Input:
+**
+**      Output: Monotonic time in nanoseconds.
+**
+********************************************************************************************************************************/
+static double SimNow (void) {
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+
+/********************************************************************************************************************************
+**  InitSimConfig
+**
+**      An ideal robot, ticked at 100 Hz for at most a minute.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void InitSimConfig (simConfig_t *config) {
+    config->dt = 0.01;
+    config->maxTime = 60.0;
+    config->trackWidth_in = 24.0;
+    config->actuatorTimeConstant = 0.0;
+    config->actuationDelay_s = 0.0;
+    config->wheelSpeedNoise_ips = 0.0;
+    config->wheelSlip = 0.0;
+    config->seed = 1;
+}
+
+
+/********************************************************************************************************************************
+**  RunSimulation
+**
+**      Drives a simulated differential-drive robot along the route in closed loop.  Every tick the follower is given the
+**      robot's true pose and its wheel odometry; the commanded twist reaches the wheels after the actuation delay and is split
+**      into wheel speeds, which lag, pick up noise and slip before being integrated back into the pose with Exp.  The
+**      follower sees the encoder travel (which includes the noise but not the slip), the pose sees the travel over the
+**      ground.
+**
+**      Input:
+**          simConfig_t config              Robot model and run limits
+**          pathFollowerParams_t params     Controller parameters
+**          waypoint_t *waypoints           The route; the robot starts on the first waypoint facing the second
+**          flightRecorder_t recorder       Optional, records every tick when not NULL
+**
+**      Output: The metrics of the run.  A run that does not finish in time has finished = 0 and the completion time of the
+**              whole run.
+**
+********************************************************************************************************************************/
+simMetrics_t RunSimulation (simConfig_t *config, pathFollowerParams_t *params, waypoint_t *waypoints, int numWaypoints, flightRecorder_t *recorder) {
+    simMetrics_t metrics = {0};
+    waypoint_t *wps[SIM_MAX_WAYPOINTS];
+    pathSegmentsList_t path;
+    pathFollower_t follower;
+    simRandom_t random;
+    transform2d_t pose, motion;
+    translation2d_t heading, toGoal;
+    twist2d_t command, acting, delta, stopped = {0.0, 0.0, 0.0}, delayed[SIM_MAX_DELAY_TICKS + 1];
+    double t, displacement, velocity, alpha, halfTrack, sumCrossTrackError;
+    double wheelLeft, wheelRight, speedLeft, speedRight, travelLeft, travelRight, groundLeft, groundRight;
+    double start, tickStart, tickCost;
+    int i, delayTicks;
+    long tick;
+
+    if ( numWaypoints < 2 || numWaypoints > SIM_MAX_WAYPOINTS ) {
+        return metrics;
+    }
+    for ( i = 0; i < numWaypoints; i++ ) {
+        wps[i] = &waypoints[i];
+    }
+    path = BuildPathFromWaypoints( wps, numWaypoints );
+    InitPathFollower( &follower, &path, 0, params );
+    SeedSimRandom( &random, config->seed );
+
+    pose.translation = waypoints[0].position;
+    heading = TranslationDelta( &waypoints[0].position, &waypoints[1].position );
+    pose.rotation = TranslationDirection( &heading );
+    alpha = ( config->actuatorTimeConstant > 0.0 ) ? 1.0 - exp( -config->dt / config->actuatorTimeConstant ) : 1.0;
+    halfTrack = 0.5 * config->trackWidth_in;
+    delayTicks = (int) fmin( fmax( round( config->actuationDelay_s / config->dt ), 0.0 ), SIM_MAX_DELAY_TICKS );
+    displacement = 0.0;
+    velocity = 0.0;
+    wheelLeft = 0.0;
+    wheelRight = 0.0;
+    sumCrossTrackError = 0.0;
+    metrics.maxTickCost_ns = 0.0;
+
+    start = SimNow();
+    for ( t = 0.0; t <= config->maxTime; t += config->dt ) {
+        tickStart = SimNow();
+        command = GetPathFollowerUpdate( &follower, t, displacement, velocity, &pose );
+        tickCost = SimNow() - tickStart;
+        if ( recorder ) {
+            RecordFlightTick( recorder, &follower, t, &pose, &command );
+        }
+
+        metrics.ticks += 1;
+        metrics.meanTickCost_ns += tickCost;
+        metrics.maxTickCost_ns = fmax( metrics.maxTickCost_ns, tickCost );
+        metrics.maxCrossTrackError = fmax( metrics.maxCrossTrackError, follower.crossTrackError );
+        sumCrossTrackError += follower.crossTrackError;
+        if ( PathFollowerIsFinished( &follower ) ) {
+            metrics.finished = 1;
+            break;
+        }
+
+        // The command acting now is the one given delayTicks ticks ago (none before the first).
+        tick = metrics.ticks - 1;
+        delayed[tick % ( delayTicks + 1 )] = command;
+        acting = ( tick >= delayTicks ) ? delayed[( tick - delayTicks ) % ( delayTicks + 1 )] : stopped;
+        wheelLeft += alpha * ( acting.dx_in - acting.dtheta_rad * halfTrack - wheelLeft );
+        wheelRight += alpha * ( acting.dx_in + acting.dtheta_rad * halfTrack - wheelRight );
+        speedLeft = wheelLeft;
+        speedRight = wheelRight;
+        if ( config->wheelSpeedNoise_ips > 0.0 ) {
+            speedLeft += config->wheelSpeedNoise_ips * SimRandomGaussian( &random );
+            speedRight += config->wheelSpeedNoise_ips * SimRandomGaussian( &random );
+        }
+        travelLeft = speedLeft * config->dt;
+        travelRight = speedRight * config->dt;
+        groundLeft = travelLeft;
+        groundRight = travelRight;
+        if ( config->wheelSlip > 0.0 ) {
+            groundLeft *= 1.0 - config->wheelSlip * SimRandomUniform( &random );
+            groundRight *= 1.0 - config->wheelSlip * SimRandomUniform( &random );
+        }
+
+        displacement += 0.5 * ( travelLeft + travelRight );
+        velocity = 0.5 * ( speedLeft + speedRight );
+        delta.dx_in = 0.5 * ( groundLeft + groundRight );
+        delta.dy_in = 0.0;
+        delta.dtheta_rad = ( groundRight - groundLeft ) / config->trackWidth_in;
+        motion = Exp( &delta );
+        pose = TranformAByB( &pose, &motion );
+    }
+
+    metrics.realTimeFactor = fmin( t, config->maxTime ) * 1e9 / fmax( SimNow() - start, 1.0 );
+    metrics.completionTime = fmin( t, config->maxTime );
+    metrics.meanTickCost_ns /= metrics.ticks;
+    metrics.meanCrossTrackError = sumCrossTrackError / metrics.ticks;
+    toGoal = TranslationDelta( &pose.translation, &waypoints[numWaypoints - 1].position );
+    metrics.finalPositionError = TranslationNormal( &toGoal );
+
+    ClearPath( &path );
+    ClearPathFollower( &follower );
+
+    return metrics;
+}
+
+
+/********************************************************************************************************************************
+**  PrintSimMetrics
+**
+**      Prints the metrics as one line of key=value pairs, e.g.
+**          sim=LTurn finished=1 completion_time=5.42 max_cte=2.104 ...
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void PrintSimMetrics (const char *name, simMetrics_t *metrics) {
+    printf( "sim=%s finished=%d completion_time=%.2f max_cte=%.3f mean_cte=%.3f final_error=%.3f ticks=%ld tick_ns_mean=%.0f "
+            "tick_ns_max=%.0f realtime_factor=%.0f\n", name, metrics->finished, metrics->completionTime, metrics->maxCrossTrackError,
+            metrics->meanCrossTrackError, metrics->finalPositionError, metrics->ticks, metrics->meanTickCost_ns,
+            metrics->maxTickCost_ns, metrics->realTimeFactor );
+}
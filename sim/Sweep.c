@@ -0,0 +1,275 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "Sim.h"
+#include "ThreadPool.h"
+
+typedef struct sweepRun {
+    sweepConfig_t *config;
+    sweepResult_t *results;
+} sweepRun_t;
+
+static const char *kSweepParamNames[SWEEP_NUM_PARAMS] = {
+    "lookahead_min_distance",
+    "lookahead_max_distance",
+    "lookahead_min_speed",
+    "lookahead_max_speed",
+    "inertia_gain",
+    "kp",
+    "ki",
+    "kv",
+    "kffv",
+    "kffa",
+};
+
+
+/********************************************************************************************************************************
+**  InitSweepConfig
+**
+**      Starts from the standard controller parameters with nothing varied, on an ideal robot, using every core.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void InitSweepConfig (sweepConfig_t *config) {
+    pathFollowerParams_t base = GetDefaultPathFollowerParams();
+    int i;
+
+    config->base = base;
+    for ( i = 0; i < SWEEP_NUM_PARAMS; i++ ) {
+        config->ranges[i].min = *GetSweepParam( &base, (sweepParam_t) i );
+        config->ranges[i].max = config->ranges[i].min;
+        config->ranges[i].steps = 0;
+    }
+    config->randomSamples = 0;
+    config->seed = 1;
+    config->crossTrackWeight = 1.0;
+    InitSimConfig( &config->sim );
+    config->numThreads = GetNumCores();
+}
+
+
+/********************************************************************************************************************************
+**  GetSweepParamName
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+const char * GetSweepParamName (sweepParam_t param) {
+    return ( param >= 0 && param < SWEEP_NUM_PARAMS ) ? kSweepParamNames[param] : NULL;
+}
+
+
+/********************************************************************************************************************************
+**  GetSweepParam
+**
+**      Input:
+**
+**      Output: A pointer to the given parameter within params.
+**
+********************************************************************************************************************************/
+double * GetSweepParam (pathFollowerParams_t *params, sweepParam_t param) {
+    switch ( param ) {
+        case SWEEP_LOOKAHEAD_MIN_DISTANCE: return &params->lookahead.minDistance_in;
+        case SWEEP_LOOKAHEAD_MAX_DISTANCE: return &params->lookahead.maxDistance_in;
+        case SWEEP_LOOKAHEAD_MIN_SPEED: return &params->lookahead.minSpeed_ips;
+        case SWEEP_LOOKAHEAD_MAX_SPEED: return &params->lookahead.maxSpeed_ips;
+        case SWEEP_INERTIA_GAIN: return &params->inertiaGain;
+        case SWEEP_PROFILE_KP: return &params->profile_kp;
+        case SWEEP_PROFILE_KI: return &params->profile_ki;
+        case SWEEP_PROFILE_KV: return &params->profile_kv;
+        case SWEEP_PROFILE_KFFV: return &params->profile_kffv;
+        default: return &params->profile_kffa;
+    }
+}
+
+
+/********************************************************************************************************************************
+**  GetSweepSize
+**
+**      Input:
+**
+**      Output: The number of parameter sets the sweep evaluates.
+**
+********************************************************************************************************************************/
+int GetSweepSize (sweepConfig_t *config) {
+    long size = 1;
+    int i;
+
+    if ( config->randomSamples > 0 ) {
+        return config->randomSamples;
+    }
+    for ( i = 0; i < SWEEP_NUM_PARAMS; i++ ) {
+        if ( config->ranges[i].steps > 0 ) {
+            size *= config->ranges[i].steps;
+        }
+    }
+    return ( size > 0x7FFFFFFF ) ? 0x7FFFFFFF : (int) size;
+}
+
+
+/********************************************************************************************************************************
+**  GetSweepCandidate
+**
+**      Input:
+**
+**      Output: The index-th parameter set.  Grid indices count through the varied parameters in order, the first one fastest;
+**              random sets are seeded from the sweep seed and the index alone, so neither depends on the thread count.
+**
+********************************************************************************************************************************/
+static pathFollowerParams_t GetSweepCandidate (sweepConfig_t *config, int index) {
+    pathFollowerParams_t params;
+    sweepRange_t *range;
+    simRandom_t random;
+    int i, digit, rest;
+
+    params = config->base;
+    SeedSimRandom( &random, config->seed + (uint64_t) index );
+    rest = index;
+    for ( i = 0; i < SWEEP_NUM_PARAMS; i++ ) {
+        range = &config->ranges[i];
+        if ( range->steps <= 0 ) {
+            continue;
+        }
+        if ( config->randomSamples > 0 ) {
+            *GetSweepParam( &params, (sweepParam_t) i ) = range->min + ( range->max - range->min ) * SimRandomUniform( &random );
+        } else {
+            digit = rest % range->steps;
+            rest /= range->steps;
+            *GetSweepParam( &params, (sweepParam_t) i ) = ( range->steps > 1 ) ? range->min + ( range->max - range->min ) * digit / ( range->steps - 1 ) : range->min;
+        }
+    }
+    return params;
+}
+
+
+/********************************************************************************************************************************
+**  EvaluateSweepCandidate
+**
+**      Thread pool task: runs one parameter set over the whole route corpus.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+static void EvaluateSweepCandidate (void *context, int index) {
+    sweepRun_t *run = context;
+    sweepResult_t *result = &run->results[index];
+    simConfig_t sim;
+    simMetrics_t metrics;
+    simRoute_t *route;
+    int i;
+
+    result->index = index;
+    result->params = GetSweepCandidate( run->config, index );
+    result->routesFinished = 0;
+    result->totalCompletionTime = 0.0;
+    result->maxCrossTrackError = 0.0;
+    result->meanCrossTrackError = 0.0;
+    result->cost = INFINITY;
+
+    // The lookahead has to grow with speed.
+    if ( result->params.lookahead.maxDistance_in < result->params.lookahead.minDistance_in ||
+         result->params.lookahead.maxSpeed_ips <= result->params.lookahead.minSpeed_ips ) {
+        return;
+    }
+
+    sim = run->config->sim;
+    for ( i = 0; i < GetNumSimRoutes(); i++ ) {
+        route = GetSimRoute( i );
+        sim.seed = run->config->sim.seed + (uint64_t) i;
+        metrics = RunSimulation( &sim, &result->params, route->waypoints, route->numWaypoints, NULL );
+        result->routesFinished += metrics.finished;
+        result->totalCompletionTime += metrics.completionTime;
+        result->maxCrossTrackError = fmax( result->maxCrossTrackError, metrics.maxCrossTrackError );
+        result->meanCrossTrackError += metrics.meanCrossTrackError / GetNumSimRoutes();
+    }
+    result->cost = result->totalCompletionTime + run->config->crossTrackWeight * result->meanCrossTrackError;
+}
+
+
+/********************************************************************************************************************************
+**  CompareSweepResults
+**
+**      Input:
+**
+**      Output: Orders by routes finished (most first), then cost, then index so the ranking is total.
+**
+********************************************************************************************************************************/
+static int CompareSweepResults (const void *a, const void *b) {
+    const sweepResult_t *ra = a, *rb = b;
+
+    if ( ra->routesFinished != rb->routesFinished ) {
+        return ( ra->routesFinished > rb->routesFinished ) ? -1 : 1;
+    }
+    if ( ra->cost != rb->cost ) {
+        return ( ra->cost < rb->cost ) ? -1 : 1;
+    }
+    return ( ra->index > rb->index ) - ( ra->index < rb->index );
+}
+
+
+/********************************************************************************************************************************
+**  RunSweep
+**
+**      Evaluates every parameter set of the sweep against the simulator route corpus, spread over config->numThreads threads,
+**      and ranks them: most routes finished first, then by total completion time plus crossTrackWeight times the mean
+**      cross-track error.  The result only depends on the configuration, not on the number of threads.
+**
+**      Input:
+**
+**      Output:
+**          int numResults              Number of results
+**          sweepResult_t *             The ranked results, best first, to be freed by the caller (NULL on failure)
+**
+********************************************************************************************************************************/
+sweepResult_t * RunSweep (sweepConfig_t *config, int *numResults) {
+    sweepRun_t run;
+    threadPool_t *pool;
+
+    *numResults = GetSweepSize( config );
+    run.config = config;
+    run.results = malloc( *numResults * sizeof( sweepResult_t ) );
+    pool = CreateThreadPool( config->numThreads );
+    if ( !run.results || !pool ) {
+        free( run.results );
+        if ( pool ) {
+            DestroyThreadPool( pool );
+        }
+        *numResults = 0;
+        return NULL;
+    }
+
+    RunThreadPool( pool, EvaluateSweepCandidate, &run, *numResults );
+    DestroyThreadPool( pool );
+    qsort( run.results, *numResults, sizeof( sweepResult_t ), CompareSweepResults );
+
+    return run.results;
+}
+
+
+/********************************************************************************************************************************
+**  PrintSweepResult
+**
+**      Prints one ranked result as key=value pairs, the parameters last.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void PrintSweepResult (int rank, sweepResult_t *result) {
+    int i;
+
+    printf( "rank=%d set=%d routes_finished=%d completion_time=%.2f max_cte=%.3f mean_cte=%.3f cost=%.3f", rank, result->index,
+            result->routesFinished, result->totalCompletionTime, result->maxCrossTrackError, result->meanCrossTrackError, result->cost );
+    for ( i = 0; i < SWEEP_NUM_PARAMS; i++ ) {
+        printf( " %s=%g", GetSweepParamName( (sweepParam_t) i ), *GetSweepParam( &result->params, (sweepParam_t) i ) );
+    }
+    printf( "\n" );
+}
@@ -0,0 +1,191 @@
+#include <check.h>
+#include <stdlib.h>
+#include "../path/Path.h"
+#include "../utils/AllocTrack.h"
+#include "test_Helpers.h"
+
+
+__attribute__((noinline)) void * AllocTrackTestMalloc (size_t size) {
+    return malloc( size );
+}
+
+
+pathSegmentsList_t BuildAllocTrackTestPath (int numWaypoints, int window) {
+    waypoint_t waypoints[numWaypoints];
+    waypoint_t *wps[numWaypoints];
+    int k;
+
+    for ( k = 0; k < numWaypoints; k++ ) {
+        waypoints[k].position.x_in = 120.0 * k;
+        waypoints[k].position.y_in = ( k % 2 ) * 96.0;
+        waypoints[k].radius = ( k == 0 || k == numWaypoints - 1 ) ? 0.0 : 24.0;
+        waypoints[k].speed_ips = 60.0;
+        wps[k] = &waypoints[k];
+    }
+    return window ? BuildLazyPathFromWaypoints( wps, numWaypoints, window ) : BuildPathFromWaypoints( wps, numWaypoints );
+}
+
+
+START_TEST(test_AllocTracking) {
+    allocStats_t stats;
+    allocSite_t sites[ALLOC_TRACK_MAX_SITES];
+    void *a, *b, *c;
+    int count;
+
+    a = malloc( 16 );
+    StartAllocTracking();
+    b = AllocTrackTestMalloc( 100 );
+    free( b );
+    b = AllocTrackTestMalloc( 50 );
+    c = calloc( 4, 8 );
+    c = realloc( c, 64 );
+    free( a );
+    free( b );
+    free( c );
+    StopAllocTracking();
+    a = malloc( 16 );
+    free( a );
+
+    GetAllocStats( &stats );
+    ck_assert_int_eq(4, stats.allocations);
+    ck_assert_int_eq(4, stats.frees);
+    ck_assert_int_eq(100 + 50 + 32 + 64, stats.bytes);
+    ck_assert_int_ge(stats.peakBytes, 100);
+    ck_assert_int_lt(stats.liveBytes, 0);
+
+    // Both calls of the helper are one site, calloc and realloc each another one.
+    count = GetAllocSites( sites, ALLOC_TRACK_MAX_SITES );
+    ck_assert_int_eq(3, count);
+    ck_assert_int_eq(2, sites[0].allocations);
+    ck_assert_int_eq(150, sites[0].bytes);
+    ck_assert_int_eq(1, sites[1].allocations);
+    ck_assert_int_eq(32, sites[1].bytes);
+    ck_assert_int_eq(64, sites[2].bytes);
+    ck_assert_ptr_ne(sites[0].caller, sites[1].caller);
+    ck_assert_int_eq(1, GetAllocSites( sites, 1 ));
+
+} END_TEST
+
+
+START_TEST(test_SteadyStateTickAllocations) {
+    pathFollowerParams_t params = GetTestFollowerParams();
+    pathFollower_t follower;
+    pathSegmentsList_t path;
+    allocStats_t stats;
+    transform2d_t pose;
+    twist2d_t command;
+    double displacement, dt = 0.01;
+    int tick, segmentsAtStart, mode, built, heapTicks;
+
+    // Built whole, built lazily where every step onto a new segment profiles the next one in the window, and with one
+    // path-wide profile.
+    for ( mode = 0; mode < 3; mode++ ) {
+        path = BuildAllocTrackTestPath( 6, ( mode == 1 ) ? 2 : 0 );
+        if ( mode == 2 ) {
+            ck_assert_int_eq(0, BuildPathProfile( &path ));
+        }
+        pose = GetTestPathStartPose( &path );
+        command.dx_in = command.dy_in = command.dtheta_rad = 0.0;
+        displacement = 0.0;
+        InitPathFollower( &follower, &path, 0, &params );
+
+        // Let the first ticks fill the profile node pool, then no tick may touch the heap until the robot is done, but for
+        // the ticks a lazy path is built on in (see ExtendLazyPath).
+        tick = DriveTestRobot( &follower, &command, &pose, &displacement, 0, 10, dt );
+        segmentsAtStart = path.length;
+        heapTicks = 0;
+        while ( tick < 3000 && !PathFollowerIsFinished( &follower ) ) {
+            built = path.route ? path.tail->index : -1;
+            StartAllocTracking();
+            tick = DriveTestRobot( &follower, &command, &pose, &displacement, tick, tick + 1, dt );
+            StopAllocTracking();
+            GetAllocStats( &stats );
+            if ( stats.allocations || stats.frees ) {
+                if ( built < 0 || ( path.route && path.tail->index == built ) ) {
+                    PrintAllocSites();
+                }
+                ck_assert_int_ge(built, 0);
+                ck_assert(!path.route || path.tail->index > built);
+                heapTicks += 1;
+            }
+        }
+
+        ck_assert_int_eq(1, PathFollowerIsFinished( &follower ));
+        ck_assert_int_lt(path.length, segmentsAtStart);
+        ck_assert_ptr_null(path.route);
+        ck_assert_int_eq(mode == 1, heapTicks > 0);
+
+        ClearPath( &path );
+        ClearPathFollower( &follower );
+    }
+
+} END_TEST
+
+
+START_TEST(test_PathBuildPeakHeap) {
+    pathSegmentsList_t path;
+    allocStats_t small, large, lazy, wide;
+    int pieces;
+
+    StartAllocTracking();
+    path = BuildAllocTrackTestPath( 10, 0 );
+    StopAllocTracking();
+    GetAllocStats( &small );
+    ClearPath( &path );
+
+    StartAllocTracking();
+    path = BuildAllocTrackTestPath( 100, 0 );
+    StopAllocTracking();
+    GetAllocStats( &large );
+    ClearPath( &path );
+
+    StartAllocTracking();
+    path = BuildAllocTrackTestPath( 100, 2 );
+    StopAllocTracking();
+    GetAllocStats( &lazy );
+    ClearPath( &path );
+
+    path = BuildAllocTrackTestPath( 100, 2 );
+    CompleteLazyPath( &path );
+    StartAllocTracking();
+    BuildPathProfile( &path );
+    StopAllocTracking();
+    GetAllocStats( &wide );
+    pieces = path.profileLength;
+    ClearPath( &path );
+
+    // The path is all there is on the heap at the end of the build, and it grows about linearly with the waypoints (17
+    // segments against 197).
+    ck_assert_int_gt(small.peakBytes, 0);
+    ck_assert_int_eq(small.peakBytes, small.liveBytes);
+    ck_assert_int_eq(large.peakBytes, large.liveBytes);
+    ck_assert_int_gt(large.peakBytes, 8 * small.peakBytes);
+    ck_assert_int_lt(large.peakBytes, 20 * small.peakBytes);
+
+    // Built lazily, only the segments up to just past the window are built, and only the window holds speed profiles.
+    ck_assert_int_eq(lazy.peakBytes, lazy.liveBytes);
+    ck_assert_int_lt(lazy.peakBytes, large.peakBytes);
+
+    // With one path-wide profile the pieces are held in one array instead of a list node each: all BuildPathProfile keeps
+    // is the array, and it only allocates to grow it and trim it to fit.
+    ck_assert_int_gt(pieces, 100);
+    ck_assert_int_ge(wide.liveBytes, pieces * sizeof( compactMotionSegment_t ));
+    ck_assert_int_lt(wide.liveBytes, ( pieces + 1 ) * sizeof( compactMotionSegment_t ));
+    ck_assert_int_le(wide.allocations, 8);
+
+} END_TEST
+
+
+Suite *allocTrack_suite(void) {
+    Suite *s;
+    TCase *tc;
+
+    s = suite_create("AllocTrack");
+    tc = tcase_create("Core");
+
+    tcase_add_test(tc, test_AllocTracking);
+    tcase_add_test(tc, test_SteadyStateTickAllocations);
+    tcase_add_test(tc, test_PathBuildPeakHeap);
+    suite_add_tcase(s, tc);
+    return s;
+}
@@ -0,0 +1,119 @@
+#include <check.h>
+#include <math.h>
+#include <time.h>
+#include "../host/ControlLoop.h"
+
+#define CONTROL_LOOP_TEST_TICKS 50
+#define CONTROL_LOOP_TEST_PERIOD_NS 1000000
+
+typedef struct controlLoopTestTicks {
+    double t[CONTROL_LOOP_TEST_TICKS];
+    int calls;
+    int stopAt;                         // Call to stop the loop on, 0 to run them all
+    int slowEvery;                      // Calls 5, 5 + slowEvery, ... sleep 2.5 periods, 0 for none
+} controlLoopTestTicks_t;
+
+
+int ControlLoopTestTick (void *context, double t) {
+    controlLoopTestTicks_t *ticks = context;
+    struct timespec slow = {0, 5 * CONTROL_LOOP_TEST_PERIOD_NS / 2};
+
+    if ( ticks->calls < CONTROL_LOOP_TEST_TICKS ) {
+        ticks->t[ticks->calls] = t;
+    }
+    ticks->calls += 1;
+    if ( ticks->slowEvery && ticks->calls % ticks->slowEvery == 5 ) {
+        nanosleep( &slow, NULL );
+    }
+
+    return ticks->calls == ticks->stopAt;
+}
+
+
+// Checks the recorded times run on whole periods from the start and that the gaps between them agree with the stats: each
+// tick followed by a gap missed its deadline, the periods in the gaps were skipped.  Only the last tick's miss leaves no gap.
+void CheckControlLoopTestTimes (controlLoopTestTicks_t *ticks, controlLoopStats_t *stats) {
+    long periods, missed = 0, skipped = 0;
+    int k;
+
+    ck_assert_double_eq(0.0, ticks->t[0]);
+    for ( k = 1; k < ticks->calls; k++ ) {
+        periods = lround( ( ticks->t[k] - ticks->t[k-1] ) * 1E9 / CONTROL_LOOP_TEST_PERIOD_NS );
+        ck_assert_int_ge(periods, 1);
+        ck_assert_double_eq_tol(periods * CONTROL_LOOP_TEST_PERIOD_NS / 1E9, ticks->t[k] - ticks->t[k-1], 1E-9);
+        if ( periods > 1 ) {
+            missed += 1;
+            skipped += periods - 1;
+        }
+    }
+    ck_assert_int_ge(stats->deadlineMisses, missed);
+    ck_assert_int_le(stats->deadlineMisses, missed + 1);
+    ck_assert_int_ge(stats->skippedPeriods, skipped);
+    if ( stats->deadlineMisses == missed ) {
+        ck_assert_int_eq(skipped, stats->skippedPeriods);
+    }
+}
+
+
+START_TEST(test_RunControlLoop) {
+    controlLoopConfig_t config = {CONTROL_LOOP_TEST_PERIOD_NS, CONTROL_LOOP_TEST_TICKS, 0, -1, 0};
+    controlLoopStats_t stats;
+    controlLoopTestTicks_t ticks = {{0.0}, 0, 0, 0};
+
+    ck_assert_int_eq(0, RunControlLoop( &config, ControlLoopTestTick, &ticks, &stats ));
+    ck_assert_int_eq(CONTROL_LOOP_TEST_TICKS, ticks.calls);
+    ck_assert_int_eq(CONTROL_LOOP_TEST_TICKS, stats.ticks);
+    ck_assert_int_eq(0, stats.appliedPriority);
+    ck_assert_int_eq(-1, stats.appliedCpu);
+    ck_assert_int_eq(0, stats.memoryLocked);
+
+    // Every tick is timed, jitter needs two wake ups and only misses overrun.
+    ck_assert_int_eq(CONTROL_LOOP_TEST_TICKS, stats.wakeLatency.count);
+    ck_assert_int_eq(CONTROL_LOOP_TEST_TICKS, stats.execution.count);
+    ck_assert_int_eq(CONTROL_LOOP_TEST_TICKS - 1, stats.jitter.count);
+    ck_assert_int_eq(stats.deadlineMisses, stats.overrun.count);
+    ck_assert_int_ge(stats.skippedPeriods, stats.deadlineMisses);
+    CheckControlLoopTestTimes( &ticks, &stats );
+
+} END_TEST
+
+
+START_TEST(test_RunControlLoopMisses) {
+    controlLoopConfig_t config = {CONTROL_LOOP_TEST_PERIOD_NS, CONTROL_LOOP_TEST_TICKS, 0, -1, 0};
+    controlLoopStats_t stats;
+    controlLoopTestTicks_t ticks = {{0.0}, 0, 0, 10};
+
+    // Each slow tick finishes past the next deadline and skips at least two periods.
+    ck_assert_int_eq(0, RunControlLoop( &config, ControlLoopTestTick, &ticks, &stats ));
+    ck_assert_int_eq(CONTROL_LOOP_TEST_TICKS, stats.ticks);
+    ck_assert_int_ge(stats.deadlineMisses, CONTROL_LOOP_TEST_TICKS / 10);
+    ck_assert_int_le(stats.deadlineMisses, stats.ticks);
+    ck_assert_int_eq(stats.deadlineMisses, stats.overrun.count);
+    ck_assert_int_ge(stats.skippedPeriods, 2 * ( CONTROL_LOOP_TEST_TICKS / 10 ));
+    ck_assert_uint_ge(stats.execution.max, 5 * CONTROL_LOOP_TEST_PERIOD_NS / 2);
+    CheckControlLoopTestTimes( &ticks, &stats );
+
+    // A tick returning non-zero ends the run there.
+    ticks.calls = 0;
+    ticks.stopAt = 20;
+    ticks.slowEvery = 0;
+    ck_assert_int_eq(0, RunControlLoop( &config, ControlLoopTestTick, &ticks, &stats ));
+    ck_assert_int_eq(20, ticks.calls);
+    ck_assert_int_eq(20, stats.ticks);
+    ck_assert_int_eq(20, stats.execution.count);
+
+} END_TEST
+
+
+Suite *controlLoop_suite(void) {
+    Suite *s;
+    TCase *tc;
+
+    s = suite_create("ControlLoop");
+    tc = tcase_create("Core");
+
+    tcase_add_test(tc, test_RunControlLoop);
+    tcase_add_test(tc, test_RunControlLoopMisses);
+    suite_add_tcase(s, tc);
+    return s;
+}
@@ -0,0 +1,79 @@
+#include <check.h>
+#include "../fleet/Fleet.h"
+#include "test_Helpers.h"
+
+
+void AddTestFleet (fleetEngine_t *engine, int count) {
+    pathFollowerParams_t params = GetTestFollowerParams();
+    waypoint_t waypoints[4];
+    waypoint_t *wps[4];
+    pathSegmentsList_t path;
+    transform2d_t startPose = {{0.0, 0.0}, {0.0, 1.0}};
+    int i, k;
+
+    for ( i = 0; i < count; i++ ) {
+        for ( k = 0; k < 4; k++ ) {
+            waypoints[k].position.x_in = 100.0 * ( ( k + 1 ) / 2 ) + i;
+            waypoints[k].position.y_in = 100.0 * ( k / 2 );
+            waypoints[k].radius = ( k == 0 || k == 3 ) ? 0.0 : 20.0;
+            waypoints[k].speed_ips = 60.0;
+            wps[k] = &waypoints[k];
+        }
+        path = BuildPathFromWaypoints( wps, 4 );
+        startPose.translation = waypoints[0].position;
+        ck_assert_int_eq(i, AddFleetFollower( engine, &path, 0, &params, &startPose ));
+        ck_assert_ptr_null(path.head);
+        ck_assert_ptr_null(path.nodes);
+        ClearPath( &path );
+    }
+}
+
+
+START_TEST(test_StepFleet) {
+    fleetEngine_t *serial, *parallel;
+    twist2d_t delta;
+    transform2d_t motion;
+    int tick, i;
+
+    serial = CreateFleetEngine( 37, 1 );
+    parallel = CreateFleetEngine( 37, 4 );
+    AddTestFleet( serial, 37 );
+    AddTestFleet( parallel, 37 );
+    ck_assert_int_eq(-1, AddFleetFollower( serial, &serial->slots[0].path, 0, NULL, NULL ));
+
+    // Drive both fleets with the serial fleet's commands, the parallel one has to agree exactly.
+    for ( tick = 0; tick < 1000 && !FleetIsFinished( serial ); tick++ ) {
+        StepFleet( serial, tick * 0.01 );
+        StepFleet( parallel, tick * 0.01 );
+        for ( i = 0; i < 37; i++ ) {
+            ck_assert_double_eq(serial->slots[i].command.dx_in, parallel->slots[i].command.dx_in);
+            ck_assert_double_eq(serial->slots[i].command.dtheta_rad, parallel->slots[i].command.dtheta_rad);
+            delta.dx_in = serial->slots[i].command.dx_in * 0.01;
+            delta.dy_in = 0.0;
+            delta.dtheta_rad = serial->slots[i].command.dtheta_rad * 0.01;
+            motion = Exp( &delta );
+            motion = TranformAByB( &serial->slots[i].pose, &motion );
+            SetFleetFollowerState( serial, i, &motion, serial->slots[i].displacement + delta.dx_in, serial->slots[i].command.dx_in );
+            SetFleetFollowerState( parallel, i, &motion, parallel->slots[i].displacement + delta.dx_in, parallel->slots[i].command.dx_in );
+        }
+    }
+    ck_assert_int_eq(1, FleetIsFinished( serial ));
+    ck_assert_int_eq(1, FleetIsFinished( parallel ));
+
+    DestroyFleetEngine( serial );
+    DestroyFleetEngine( parallel );
+
+} END_TEST
+
+
+Suite *fleetEngine_suite(void) {
+    Suite *s;
+    TCase *tc;
+
+    s = suite_create("FleetEngine");
+    tc = tcase_create("Core");
+
+    tcase_add_test(tc, test_StepFleet);
+    suite_add_tcase(s, tc);
+    return s;
+}
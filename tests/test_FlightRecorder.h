@@ -0,0 +1,75 @@
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "../recorder/Recorder.h"
+#include "test_Helpers.h"
+
+#define FLIGHT_TEST_CAPACITY 64
+
+
+START_TEST(test_RecordFlightTick) {
+    pathFollowerParams_t params = GetTestFollowerParams();
+    waypoint_t waypoints[3] = {{{0.0, 0.0}, 0.0, 60.0}, {{100.0, 0.0}, 20.0, 60.0}, {{100.0, 100.0}, 0.0, 60.0}};
+    waypoint_t *wps[3] = {&waypoints[0], &waypoints[1], &waypoints[2]};
+    flightRecord_t records[FLIGHT_TEST_CAPACITY], *loaded;
+    flightDumpHeader_t header;
+    flightRecorder_t recorder;
+    pathSegmentsList_t path;
+    pathFollower_t follower;
+    transform2d_t pose = {{0.0, 0.0}, {0.0, 1.0}};
+    twist2d_t command;
+    char fileName[] = "/tmp/flightXXXXXX";
+    double displacement = 0.0, velocity = 0.0;
+    int tick, fd;
+
+    ck_assert_int_eq(-1, InitFlightRecorder( &recorder, records, 48 ));
+    ck_assert_int_eq(0, InitFlightRecorder( &recorder, records, FLIGHT_TEST_CAPACITY ));
+    path = BuildPathFromWaypoints( wps, 3 );
+    InitPathFollower( &follower, &path, 0, &params );
+
+    // Run past the capacity so the ring wraps, only the newest ticks are kept.
+    for ( tick = 0; tick < 100; tick++ ) {
+        command = GetPathFollowerUpdate( &follower, tick * 0.01, displacement, velocity, &pose );
+        RecordFlightTick( &recorder, &follower, tick * 0.01, &pose, &command );
+        StepTestRobot( &command, &pose, &displacement, 0.01 );
+        velocity = command.dx_in;
+    }
+    ck_assert_uint_eq(100, recorder.count);
+    ck_assert_uint_eq(99, records[99 & ( FLIGHT_TEST_CAPACITY - 1 )].sequence);
+    ck_assert_double_eq((float) velocity, records[99 & ( FLIGHT_TEST_CAPACITY - 1 )].outputDx);
+
+    fd = mkstemp( fileName );
+    ck_assert_int_ge(fd, 0);
+    close( fd );
+    ck_assert_int_eq(0, DumpFlightRecorder( &recorder, fileName ));
+    loaded = LoadFlightDump( fileName, &header );
+    unlink( fileName );
+    ck_assert_ptr_nonnull(loaded);
+    ck_assert_uint_eq(FLIGHT_TEST_CAPACITY, header.numRecords);
+    ck_assert_uint_eq(100, header.totalRecorded);
+    for ( tick = 0; tick < FLIGHT_TEST_CAPACITY; tick++ ) {
+        ck_assert_uint_eq(100 - FLIGHT_TEST_CAPACITY + tick, loaded[tick].sequence);
+        ck_assert_double_eq_tol(( 100 - FLIGHT_TEST_CAPACITY + tick ) * 0.01, loaded[tick].t, 1e-6);
+    }
+    ck_assert_double_gt(loaded[FLIGHT_TEST_CAPACITY - 1].poseX, loaded[0].poseX);
+    ck_assert_double_gt(loaded[FLIGHT_TEST_CAPACITY - 1].lookaheadX, loaded[FLIGHT_TEST_CAPACITY - 1].closestX);
+    free( loaded );
+
+    ClearPath( &path );
+    ClearPathFollower( &follower );
+
+} END_TEST
+
+
+Suite *flightRecorder_suite(void) {
+    Suite *s;
+    TCase *tc;
+
+    s = suite_create("FlightRecorder");
+    tc = tcase_create("Core");
+
+    tcase_add_test(tc, test_RecordFlightTick);
+    suite_add_tcase(s, tc);
+    return s;
+}
@@ -0,0 +1,81 @@
+#ifndef TEST_HELPERS_H
+#define TEST_HELPERS_H
+
+#include <check.h>
+#include <string.h>
+#include "../path/Path.h"
+
+
+// The path follower tuning the tests drive with: 60 in/s cruise, 120 in/s^2, feed forward only on the speed.
+pathFollowerParams_t GetTestFollowerParams (void) {
+    pathFollowerParams_t params = {
+        .lookahead = { .minDistance_in = 12.0, .maxDistance_in = 36.0, .minSpeed_ips = 4.0, .maxSpeed_ips = 120.0 },
+        .profile_kffv = 1.0,
+        .profile_max_abs_vel = 60.0,
+        .profile_max_abs_acc = 120.0,
+        .goal_pos_tolerance = 0.75,
+        .goal_vel_tolerance = 12.0,
+        .stop_steering_distance = 9.0,
+    };
+
+    return params;
+}
+
+
+// Where a robot starting on the path stands: at its start, facing along its first segment.
+transform2d_t GetTestPathStartPose (pathSegmentsList_t *path) {
+    transform2d_t pose;
+
+    pose.translation = path->head->segment.start;
+    pose.rotation = TranslationDirection( &path->head->segment.deltaStart );
+    return pose;
+}
+
+
+// Moves an ideal robot along the arc of the command for dt seconds.
+void StepTestRobot (twist2d_t *command, transform2d_t *pose, double *displacement, double dt) {
+    twist2d_t delta;
+    transform2d_t motion;
+
+    delta.dx_in = command->dx_in * dt;
+    delta.dy_in = 0.0;
+    delta.dtheta_rad = command->dtheta_rad * dt;
+    motion = Exp( &delta );
+    *pose = TranformAByB( pose, &motion );
+    *displacement += delta.dx_in;
+}
+
+
+// Drives an ideal robot with the follower every dt seconds from tick on, until the path is finished or maxTicks is reached.
+// Returns the tick it stopped at.
+int DriveTestRobot (pathFollower_t *follower, twist2d_t *command, transform2d_t *pose, double *displacement, int tick, int maxTicks, double dt) {
+    for ( ; tick < maxTicks && !PathFollowerIsFinished( follower ); tick++ ) {
+        *command = GetPathFollowerUpdate( follower, tick * dt, *displacement, command->dx_in, pose );
+        StepTestRobot( command, pose, displacement, dt );
+    }
+    return tick;
+}
+
+
+// Asserts two paths have the same geometry, speed limits and speed profiles, segment by segment.
+void AssertPathsEqual (pathSegmentsList_t *a, pathSegmentsList_t *b) {
+    pathSegmentNode_t *nodeA, *nodeB;
+    motionProfileNode_t *profileA, *profileB;
+
+    ck_assert_int_eq(a->length, b->length);
+    for ( nodeA = a->head, nodeB = b->head; nodeA && nodeB; nodeA = nodeA->next, nodeB = nodeB->next ) {
+        ck_assert_int_eq(0, memcmp( &nodeA->segment.start, &nodeB->segment.start, 5 * sizeof( translation2d_t ) ));
+        ck_assert_double_eq(nodeA->segment.maxSpeed_ips, nodeB->segment.maxSpeed_ips);
+        ck_assert_int_eq(nodeA->segment.isLine, nodeB->segment.isLine);
+        ck_assert_int_eq(nodeA->segment.extrapolateLookahead, nodeB->segment.extrapolateLookahead);
+        ck_assert_int_eq(nodeA->segment.speedController.length, nodeB->segment.speedController.length);
+        for ( profileA = nodeA->segment.speedController.head, profileB = nodeB->segment.speedController.head; profileA && profileB;
+              profileA = profileA->next, profileB = profileB->next ) {
+            ck_assert_int_eq(0, memcmp( &profileA->segment, &profileB->segment, sizeof( compactMotionSegment_t ) ));
+        }
+    }
+    ck_assert_ptr_null(nodeA);
+    ck_assert_ptr_null(nodeB);
+}
+
+#endif
@@ -0,0 +1,112 @@
+#include <check.h>
+#include <pthread.h>
+#include "../utils/AllocTrack.h"
+#include "../utils/Instrument.h"
+#include "../path/Path.h"
+#include "test_Helpers.h"
+
+
+void * InstrumentRecorder (void *arg) {
+    uint64_t i;
+
+    for ( i = 1; i <= 100; i++ ) {
+        InstrumentRecord( INSTRUMENT_GET_CENTER, 1000, 1000 + 10 * i );
+    }
+    return NULL;
+}
+
+
+START_TEST(test_GetInstrumentStats) {
+    instrumentStats_t stats;
+    allocStats_t allocs;
+    pthread_t recorder;
+    uint64_t i;
+
+    ResetInstrument();
+    ck_assert_int_eq(0, GetInstrumentStats( INSTRUMENT_GET_CENTER, &stats ));
+    ck_assert_uint_eq(0, stats.max);
+
+    for ( i = 1; i <= 100; i++ ) {
+        InstrumentRecord( INSTRUMENT_GET_CENTER, 50, 50 + i );
+    }
+    ck_assert_int_eq(100, GetInstrumentStats( INSTRUMENT_GET_CENTER, &stats ));
+    ck_assert_uint_eq(1, stats.min);
+    ck_assert_uint_eq(100, stats.max);
+    ck_assert_double_eq_tol(50.5, stats.mean, 1e-9);
+    ck_assert_uint_ge(stats.p99, 90);
+    ck_assert_uint_le(stats.p99, 100);
+    ck_assert_int_eq(0, GetInstrumentStats( INSTRUMENT_GET_TARGET_POINT, &stats ));
+
+    // A second thread records into its own table, queries see both.
+    pthread_create(&recorder, NULL, InstrumentRecorder, NULL);
+    pthread_join(recorder, NULL);
+    ck_assert_int_eq(200, GetInstrumentStats( INSTRUMENT_GET_CENTER, &stats ));
+    ck_assert_uint_eq(1, stats.min);
+    ck_assert_uint_eq(1000, stats.max);
+
+    // Threads that have exited hand their tables on, so a stream of short-lived threads never runs out, loses nothing, and
+    // no thread's first call allocates.
+    StartAllocTracking();
+    for ( i = 0; i < 3 * INSTRUMENT_MAX_THREADS; i++ ) {
+        pthread_create(&recorder, NULL, InstrumentRecorder, NULL);
+        pthread_join(recorder, NULL);
+    }
+    StopAllocTracking();
+    GetAllocStats( &allocs );
+    ck_assert_int_eq(0, allocs.allocations);
+    ck_assert_int_eq(200 + 300 * INSTRUMENT_MAX_THREADS, GetInstrumentStats( INSTRUMENT_GET_CENTER, &stats ));
+
+    ResetInstrument();
+    ck_assert_int_eq(0, GetInstrumentStats( INSTRUMENT_GET_CENTER, &stats ));
+    ck_assert_str_eq("SetpointRegeneration", GetInstrumentStageName( INSTRUMENT_SETPOINT_REGENERATION ));
+
+} END_TEST
+
+
+START_TEST(test_InstrumentScope) {
+    pathFollowerParams_t params = GetTestFollowerParams();
+    waypoint_t waypoints[3] = {{{0.0, 0.0}, 0.0, 60.0}, {{100.0, 0.0}, 20.0, 60.0}, {{100.0, 100.0}, 0.0, 60.0}};
+    waypoint_t *wps[3] = {&waypoints[0], &waypoints[1], &waypoints[2]};
+    pathSegmentsList_t path;
+    pathFollower_t follower;
+    transform2d_t pose = {{0.0, 0.0}, {0.0, 1.0}};
+    instrumentStats_t stats;
+    int tick;
+
+    InitInstrument();
+    path = BuildPathFromWaypoints( wps, 3 );
+    InitPathFollower( &follower, &path, 0, &params );
+    for ( tick = 0; tick < 10; tick++ ) {
+        GetPathFollowerUpdate( &follower, tick * 0.01, 0.0, 0.0, &pose );
+    }
+
+#ifdef INSTRUMENT
+    ck_assert_int_eq(10, GetInstrumentStats( INSTRUMENT_GET_TARGET_POINT, &stats ));
+    ck_assert_int_eq(10, GetInstrumentStats( INSTRUMENT_GET_CENTER, &stats ));
+    ck_assert_int_eq(10, GetInstrumentStats( INSTRUMENT_PROFILE_FOLLOWER_UPDATE, &stats ));
+    ck_assert_int_ge(GetInstrumentStats( INSTRUMENT_SETPOINT_REGENERATION, &stats ), 1);
+    ck_assert_uint_le(stats.min, stats.max);
+#else
+    // Compiled out, the hot path records nothing.
+    ck_assert_int_eq(0, GetInstrumentStats( INSTRUMENT_GET_TARGET_POINT, &stats ));
+    ck_assert_int_eq(0, GetInstrumentStats( INSTRUMENT_PROFILE_FOLLOWER_UPDATE, &stats ));
+#endif
+
+    ClearPath( &path );
+    ClearPathFollower( &follower );
+
+} END_TEST
+
+
+Suite *instrument_suite(void) {
+    Suite *s;
+    TCase *tc;
+
+    s = suite_create("Instrument");
+    tc = tcase_create("Core");
+
+    tcase_add_test(tc, test_GetInstrumentStats);
+    tcase_add_test(tc, test_InstrumentScope);
+    suite_add_tcase(s, tc);
+    return s;
+}
@@ -80,22 +80,22 @@ START_TEST(test_AppendSegment) {
     segment.start.vel = 5.0;
     segment.start.acc = 5.0;
     segment.end.t = 1.0;
-    segment.end.pos = 10.0;
-    segment.end.vel = 5.0;
+    segment.end.pos = 7.5;
+    segment.end.vel = 10.0;
     segment.end.acc = 5.0;
 
     AppendSegment(&profile, &segment);
     ck_assert_ptr_nonnull(profile.head);
     ck_assert_ptr_nonnull(profile.tail);
     ck_assert_int_eq(4, profile.length);
-    ck_assert_double_eq(0.0, profile.tail->segment.start.t);
-    ck_assert_double_eq(0.0, profile.tail->segment.start.pos);
-    ck_assert_double_eq(5.0, profile.tail->segment.start.vel);
-    ck_assert_double_eq(5.0, profile.tail->segment.start.acc);
-    ck_assert_double_eq(1.0, profile.tail->segment.end.t);
-    ck_assert_double_eq(10.0, profile.tail->segment.end.pos);
-    ck_assert_double_eq(5.0, profile.tail->segment.end.vel);
-    ck_assert_double_eq(5.0, profile.tail->segment.end.acc);
+    ck_assert_double_eq(0.0, profile.tail->segment.t);
+    ck_assert_double_eq(0.0, profile.tail->segment.pos);
+    ck_assert_double_eq(5.0, profile.tail->segment.vel);
+    ck_assert_double_eq(5.0, profile.tail->segment.acc);
+    ck_assert_double_eq(1.0, SegmentEnd( &profile.tail->segment ).t);
+    ck_assert_double_eq(7.5, SegmentEnd( &profile.tail->segment ).pos);
+    ck_assert_double_eq(10.0, SegmentEnd( &profile.tail->segment ).vel);
+    ck_assert_double_eq(5.0, SegmentEnd( &profile.tail->segment ).acc);
 
 
 } END_TEST
@@ -104,6 +104,7 @@ START_TEST(test_AppendSegment) {
 START_TEST(test_AppendControl) {
     motionProfileList_t profile;
     motionProfileNode_t *head, *middle, *tail;
+    motionSegment_t segment;
 
     head = (motionProfileNode_t *) malloc( sizeof( motionProfileNode_t ) );
     middle = (motionProfileNode_t *) malloc( sizeof( motionProfileNode_t ) );
@@ -114,27 +115,28 @@ START_TEST(test_AppendControl) {
     profile.head = head;
     profile.tail = tail;
     profile.length = 3;
-    tail->segment.start.t = 0.0;
-    tail->segment.start.pos = 0.0;
-    tail->segment.start.vel = 5.0;
-    tail->segment.start.acc = 5.0;
-    tail->segment.end.t = 0.5;
-    tail->segment.end.pos = 2.5;
-    tail->segment.end.vel = 5.0;
-    tail->segment.end.acc = 5.0;
+    segment.start.t = 0.0;
+    segment.start.pos = 0.0;
+    segment.start.vel = 5.0;
+    segment.start.acc = 0.0;
+    segment.end.t = 0.5;
+    segment.end.pos = 2.5;
+    segment.end.vel = 5.0;
+    segment.end.acc = 0.0;
+    tail->segment = CompactSegment( &segment );
 
     AppendControl (&profile, 2.5, 1.5);
     ck_assert_ptr_nonnull(profile.head);
     ck_assert_ptr_nonnull(profile.tail);
     ck_assert_int_eq(4, profile.length);
-    ck_assert_double_eq(tail->segment.end.t, profile.tail->segment.start.t);
-    ck_assert_double_eq(tail->segment.end.pos, profile.tail->segment.start.pos);
-    ck_assert_double_eq(tail->segment.end.vel, profile.tail->segment.start.vel);
-    ck_assert_double_eq(2.5, profile.tail->segment.start.acc);
-    ck_assert_double_eq(tail->segment.end.t + 1.5, profile.tail->segment.end.t);
-    ck_assert_double_eq(12.8125, profile.tail->segment.end.pos);
-    ck_assert_double_eq(8.75, profile.tail->segment.end.vel);
-    ck_assert_double_eq(2.5, profile.tail->segment.end.acc);
+    ck_assert_double_eq(SegmentEnd( &tail->segment ).t, profile.tail->segment.t);
+    ck_assert_double_eq(SegmentEnd( &tail->segment ).pos, profile.tail->segment.pos);
+    ck_assert_double_eq(SegmentEnd( &tail->segment ).vel, profile.tail->segment.vel);
+    ck_assert_double_eq(2.5, profile.tail->segment.acc);
+    ck_assert_double_eq(SegmentEnd( &tail->segment ).t + 1.5, SegmentEnd( &profile.tail->segment ).t);
+    ck_assert_double_eq(12.8125, SegmentEnd( &profile.tail->segment ).pos);
+    ck_assert_double_eq(8.75, SegmentEnd( &profile.tail->segment ).vel);
+    ck_assert_double_eq(2.5, SegmentEnd( &profile.tail->segment ).acc);
 
 } END_TEST
 
@@ -142,6 +144,7 @@ START_TEST(test_AppendControl) {
 START_TEST(test_Consolidate) {
     motionProfileList_t profile;
     motionProfileNode_t *head, *middle, *tail;
+    motionSegment_t segment;
 
     head = (motionProfileNode_t *) malloc( sizeof( motionProfileNode_t ) );
     middle = (motionProfileNode_t *) malloc( sizeof( motionProfileNode_t ) );
@@ -152,30 +155,33 @@ START_TEST(test_Consolidate) {
     profile.head = head;
     profile.tail = tail;
     profile.length = 3;
-    head->segment.start.t = 0.0;
-    head->segment.start.pos = 0.0;
-    head->segment.start.vel = 5.0;
-    head->segment.start.acc = 0.0;
-    head->segment.end.t = 0.5;
-    head->segment.end.pos = 2.5;
-    head->segment.end.vel = 5.0;
-    head->segment.end.acc = 0.0;
-    middle->segment.start.t = 0.5;
-    middle->segment.start.pos = 2.5;
-    middle->segment.start.vel = 5.0;
-    middle->segment.start.acc = 0.0;
-    middle->segment.end.t = 0.5;
-    middle->segment.end.pos = 2.5;
-    middle->segment.end.vel = 5.0;
-    middle->segment.end.acc = 0.0;
-    tail->segment.start.t = 1.0;
-    tail->segment.start.pos = 5.0;
-    tail->segment.start.vel = 5.0;
-    tail->segment.start.acc = 0.0;
-    tail->segment.end.t = 1.5;
-    tail->segment.end.pos = 7.5;
-    tail->segment.end.vel = 5.0;
-    tail->segment.end.acc = 0.0;
+    segment.start.t = 0.0;
+    segment.start.pos = 0.0;
+    segment.start.vel = 5.0;
+    segment.start.acc = 0.0;
+    segment.end.t = 0.5;
+    segment.end.pos = 2.5;
+    segment.end.vel = 5.0;
+    segment.end.acc = 0.0;
+    head->segment = CompactSegment( &segment );
+    segment.start.t = 0.5;
+    segment.start.pos = 2.5;
+    segment.start.vel = 5.0;
+    segment.start.acc = 0.0;
+    segment.end.t = 0.5;
+    segment.end.pos = 2.5;
+    segment.end.vel = 5.0;
+    segment.end.acc = 0.0;
+    middle->segment = CompactSegment( &segment );
+    segment.start.t = 1.0;
+    segment.start.pos = 5.0;
+    segment.start.vel = 5.0;
+    segment.start.acc = 0.0;
+    segment.end.t = 1.5;
+    segment.end.pos = 7.5;
+    segment.end.vel = 5.0;
+    segment.end.acc = 0.0;
+    tail->segment = CompactSegment( &segment );
 
     Consolidate(&profile);
     ck_assert_ptr_nonnull(profile.head);
@@ -220,6 +226,7 @@ START_TEST(test_AppendProfile) {
 START_TEST(test_TrimBeforeTime) {
     motionProfileList_t profile;
     motionProfileNode_t *head, *middle, *tail;
+    motionSegment_t segment;
 
     head = (motionProfileNode_t *) malloc( sizeof( motionProfileNode_t ) );
     middle = (motionProfileNode_t *) malloc( sizeof( motionProfileNode_t ) );
@@ -230,38 +237,41 @@ START_TEST(test_TrimBeforeTime) {
     profile.head = head;
     profile.tail = tail;
     profile.length = 3;
-    head->segment.start.t = 0.0;
-    head->segment.start.pos = 0.0;
-    head->segment.start.vel = 5.0;
-    head->segment.start.acc = 0.0;
-    head->segment.end.t = 0.5;
-    head->segment.end.pos = 2.5;
-    head->segment.end.vel = 5.0;
-    head->segment.end.acc = 0.0;
-    middle->segment.start.t = 0.5;
-    middle->segment.start.pos = 2.5;
-    middle->segment.start.vel = 5.0;
-    middle->segment.start.acc = 0.0;
-    middle->segment.end.t = 1.0;
-    middle->segment.end.pos = 5.0;
-    middle->segment.end.vel = 5.0;
-    middle->segment.end.acc = 0.0;
-    tail->segment.start.t = 1.0;
-    tail->segment.start.pos = 5.0;
-    tail->segment.start.vel = 5.0;
-    tail->segment.start.acc = 0.0;
-    tail->segment.end.t = 1.5;
-    tail->segment.end.pos = 7.5;
-    tail->segment.end.vel = 5.0;
-    tail->segment.end.acc = 0.0;
+    segment.start.t = 0.0;
+    segment.start.pos = 0.0;
+    segment.start.vel = 5.0;
+    segment.start.acc = 0.0;
+    segment.end.t = 0.5;
+    segment.end.pos = 2.5;
+    segment.end.vel = 5.0;
+    segment.end.acc = 0.0;
+    head->segment = CompactSegment( &segment );
+    segment.start.t = 0.5;
+    segment.start.pos = 2.5;
+    segment.start.vel = 5.0;
+    segment.start.acc = 0.0;
+    segment.end.t = 1.0;
+    segment.end.pos = 5.0;
+    segment.end.vel = 5.0;
+    segment.end.acc = 0.0;
+    middle->segment = CompactSegment( &segment );
+    segment.start.t = 1.0;
+    segment.start.pos = 5.0;
+    segment.start.vel = 5.0;
+    segment.start.acc = 0.0;
+    segment.end.t = 1.5;
+    segment.end.pos = 7.5;
+    segment.end.vel = 5.0;
+    segment.end.acc = 0.0;
+    tail->segment = CompactSegment( &segment );
 
     // Shorten the segment
     TrimBeforeTime(&profile, 0.25);
     ck_assert_int_eq(3, profile.length);
-    ck_assert_double_eq(0.25, profile.head->segment.start.t);
-    ck_assert_double_eq(1.25, profile.head->segment.start.pos);
-    ck_assert_double_eq(5.0, profile.head->segment.start.vel);
-    ck_assert_double_eq(0.0, profile.head->segment.start.acc);
+    ck_assert_double_eq(0.25, profile.head->segment.t);
+    ck_assert_double_eq(1.25, profile.head->segment.pos);
+    ck_assert_double_eq(5.0, profile.head->segment.vel);
+    ck_assert_double_eq(0.0, profile.head->segment.acc);
 
     // Remove the segment
     TrimBeforeTime(&profile, 0.5);
@@ -275,6 +285,7 @@ START_TEST(test_TrimBeforeTime) {
 START_TEST(test_IsProfileValid) {
     motionProfileList_t profile;
     motionProfileNode_t *head, *middle, *tail;
+    motionSegment_t segment;
     int valid;
 
     head = (motionProfileNode_t *) malloc( sizeof( motionProfileNode_t ) );
@@ -286,44 +297,46 @@ START_TEST(test_IsProfileValid) {
     profile.head = head;
     profile.tail = tail;
     profile.length = 3;
-    head->segment.start.t = 0.0;
-    head->segment.start.pos = 0.0;
-    head->segment.start.vel = 5.0;
-    head->segment.start.acc = 0.0;
-    head->segment.end.t = 0.5;
-    head->segment.end.pos = 2.5;
-    head->segment.end.vel = 5.0;
-    head->segment.end.acc = 0.0;
-    middle->segment.start.t = 0.5;
-    middle->segment.start.pos = 2.5;
-    middle->segment.start.vel = 5.0;
-    middle->segment.start.acc = 0.0;
-    middle->segment.end.t = 1.0;
-    middle->segment.end.pos = 5.0;
-    middle->segment.end.vel = 5.0;
-    middle->segment.end.acc = 0.0;
-    tail->segment.start.t = 1.0;
-    tail->segment.start.pos = 5.0;
-    tail->segment.start.vel = 5.0;
-    tail->segment.start.acc = 0.0;
-    tail->segment.end.t = 1.5;
-    tail->segment.end.pos = 7.5;
-    tail->segment.end.vel = 5.0;
-    tail->segment.end.acc = 0.0;
+    segment.start.t = 0.0;
+    segment.start.pos = 0.0;
+    segment.start.vel = 5.0;
+    segment.start.acc = 0.0;
+    segment.end.t = 0.5;
+    segment.end.pos = 2.5;
+    segment.end.vel = 5.0;
+    segment.end.acc = 0.0;
+    head->segment = CompactSegment( &segment );
+    segment.start.t = 0.5;
+    segment.start.pos = 2.5;
+    segment.start.vel = 5.0;
+    segment.start.acc = 0.0;
+    segment.end.t = 1.0;
+    segment.end.pos = 5.0;
+    segment.end.vel = 5.0;
+    segment.end.acc = 0.0;
+    middle->segment = CompactSegment( &segment );
+    segment.start.t = 1.0;
+    segment.start.pos = 5.0;
+    segment.start.vel = 5.0;
+    segment.start.acc = 0.0;
+    segment.end.t = 1.5;
+    segment.end.pos = 7.5;
+    segment.end.vel = 5.0;
+    segment.end.acc = 0.0;
+    tail->segment = CompactSegment( &segment );
 
     // Valid
     valid = IsProfileValid(&profile);
     ck_assert_int_eq(1, valid);
 
-    // Invalid segment
-    head->segment.end.acc = 1.0;
+    // Invalid segment, the velocity reverses
+    tail->segment.acc = -20.0;
     valid = IsProfileValid(&profile);
     ck_assert_int_eq(0, valid);
 
     // Not continuous
-    head->segment.end.acc = 0.0;
-    head->segment.end.vel = 3.0;
-    middle->segment.start.vel = 4.0;
+    tail->segment.acc = 0.0;
+    middle->segment.vel = 4.0;
     valid = IsProfileValid(&profile);
     ck_assert_int_eq(0, valid);
 
@@ -334,6 +347,7 @@ START_TEST(test_IsProfileValid) {
 START_TEST(test_StateByTime) {
     motionProfileList_t profile;
     motionProfileNode_t *head, *middle, *tail;
+    motionSegment_t segment;
     motionState_t state;
 
     head = (motionProfileNode_t *) malloc( sizeof( motionProfileNode_t ) );
@@ -345,30 +359,33 @@ START_TEST(test_StateByTime) {
     profile.head = head;
     profile.tail = tail;
     profile.length = 3;
-    head->segment.start.t = 0.0;
-    head->segment.start.pos = 0.0;
-    head->segment.start.vel = 5.0;
-    head->segment.start.acc = 0.0;
-    head->segment.end.t = 0.5;
-    head->segment.end.pos = 2.5;
-    head->segment.end.vel = 5.0;
-    head->segment.end.acc = 0.0;
-    middle->segment.start.t = 0.5;
-    middle->segment.start.pos = 2.5;
-    middle->segment.start.vel = 5.0;
-    middle->segment.start.acc = 0.0;
-    middle->segment.end.t = 1.0;
-    middle->segment.end.pos = 5.0;
-    middle->segment.end.vel = 5.0;
-    middle->segment.end.acc = 0.0;
-    tail->segment.start.t = 1.0;
-    tail->segment.start.pos = 5.0;
-    tail->segment.start.vel = 5.0;
-    tail->segment.start.acc = 0.0;
-    tail->segment.end.t = 1.5;
-    tail->segment.end.pos = 7.5;
-    tail->segment.end.vel = 5.0;
-    tail->segment.end.acc = 0.0;
+    segment.start.t = 0.0;
+    segment.start.pos = 0.0;
+    segment.start.vel = 5.0;
+    segment.start.acc = 0.0;
+    segment.end.t = 0.5;
+    segment.end.pos = 2.5;
+    segment.end.vel = 5.0;
+    segment.end.acc = 0.0;
+    head->segment = CompactSegment( &segment );
+    segment.start.t = 0.5;
+    segment.start.pos = 2.5;
+    segment.start.vel = 5.0;
+    segment.start.acc = 0.0;
+    segment.end.t = 1.0;
+    segment.end.pos = 5.0;
+    segment.end.vel = 5.0;
+    segment.end.acc = 0.0;
+    middle->segment = CompactSegment( &segment );
+    segment.start.t = 1.0;
+    segment.start.pos = 5.0;
+    segment.start.vel = 5.0;
+    segment.start.acc = 0.0;
+    segment.end.t = 1.5;
+    segment.end.pos = 7.5;
+    segment.end.vel = 5.0;
+    segment.end.acc = 0.0;
+    tail->segment = CompactSegment( &segment );
 
     // Head start
     state = StateByTime(&profile, -0.0000001);
@@ -405,6 +422,7 @@ START_TEST(test_StateByTime) {
 START_TEST(test_StateByTimeClamped) {
     motionProfileList_t profile;
     motionProfileNode_t *head, *middle, *tail;
+    motionSegment_t segment;
     motionState_t state;
 
     head = (motionProfileNode_t *) malloc( sizeof( motionProfileNode_t ) );
@@ -416,30 +434,33 @@ START_TEST(test_StateByTimeClamped) {
     profile.head = head;
     profile.tail = tail;
     profile.length = 3;
-    head->segment.start.t = 0.0;
-    head->segment.start.pos = 0.0;
-    head->segment.start.vel = 5.0;
-    head->segment.start.acc = 0.0;
-    head->segment.end.t = 0.5;
-    head->segment.end.pos = 2.5;
-    head->segment.end.vel = 5.0;
-    head->segment.end.acc = 0.0;
-    middle->segment.start.t = 0.5;
-    middle->segment.start.pos = 2.5;
-    middle->segment.start.vel = 5.0;
-    middle->segment.start.acc = 0.0;
-    middle->segment.end.t = 1.0;
-    middle->segment.end.pos = 5.0;
-    middle->segment.end.vel = 5.0;
-    middle->segment.end.acc = 0.0;
-    tail->segment.start.t = 1.0;
-    tail->segment.start.pos = 5.0;
-    tail->segment.start.vel = 5.0;
-    tail->segment.start.acc = 0.0;
-    tail->segment.end.t = 1.5;
-    tail->segment.end.pos = 7.5;
-    tail->segment.end.vel = 5.0;
-    tail->segment.end.acc = 0.0;
+    segment.start.t = 0.0;
+    segment.start.pos = 0.0;
+    segment.start.vel = 5.0;
+    segment.start.acc = 0.0;
+    segment.end.t = 0.5;
+    segment.end.pos = 2.5;
+    segment.end.vel = 5.0;
+    segment.end.acc = 0.0;
+    head->segment = CompactSegment( &segment );
+    segment.start.t = 0.5;
+    segment.start.pos = 2.5;
+    segment.start.vel = 5.0;
+    segment.start.acc = 0.0;
+    segment.end.t = 1.0;
+    segment.end.pos = 5.0;
+    segment.end.vel = 5.0;
+    segment.end.acc = 0.0;
+    middle->segment = CompactSegment( &segment );
+    segment.start.t = 1.0;
+    segment.start.pos = 5.0;
+    segment.start.vel = 5.0;
+    segment.start.acc = 0.0;
+    segment.end.t = 1.5;
+    segment.end.pos = 7.5;
+    segment.end.vel = 5.0;
+    segment.end.acc = 0.0;
+    tail->segment = CompactSegment( &segment );
 
     // Head start
     state = StateByTimeClamped(&profile, -0.1);
@@ -468,6 +489,7 @@ START_TEST(test_StateByTimeClamped) {
 START_TEST(test_FirstStateByPosition) {
     motionProfileList_t profile;
     motionProfileNode_t *head, *middle, *tail;
+    motionSegment_t segment;
     motionState_t state;
 
     head = (motionProfileNode_t *) malloc( sizeof( motionProfileNode_t ) );
@@ -479,30 +501,33 @@ START_TEST(test_FirstStateByPosition) {
     profile.head = head;
     profile.tail = tail;
     profile.length = 3;
-    head->segment.start.t = 0.0;
-    head->segment.start.pos = 0.0;
-    head->segment.start.vel = 5.0;
-    head->segment.start.acc = 0.0;
-    head->segment.end.t = 0.5;
-    head->segment.end.pos = 2.5;
-    head->segment.end.vel = 5.0;
-    head->segment.end.acc = 0.0;
-    middle->segment.start.t = 0.5;
-    middle->segment.start.pos = 2.5;
-    middle->segment.start.vel = 5.0;
-    middle->segment.start.acc = 0.0;
-    middle->segment.end.t = 1.0;
-    middle->segment.end.pos = 5.0;
-    middle->segment.end.vel = 5.0;
-    middle->segment.end.acc = 0.0;
-    tail->segment.start.t = 1.0;
-    tail->segment.start.pos = 5.0;
-    tail->segment.start.vel = 5.0;
-    tail->segment.start.acc = 0.0;
-    tail->segment.end.t = 1.5;
-    tail->segment.end.pos = 7.5;
-    tail->segment.end.vel = 5.0;
-    tail->segment.end.acc = 0.0;
+    segment.start.t = 0.0;
+    segment.start.pos = 0.0;
+    segment.start.vel = 5.0;
+    segment.start.acc = 0.0;
+    segment.end.t = 0.5;
+    segment.end.pos = 2.5;
+    segment.end.vel = 5.0;
+    segment.end.acc = 0.0;
+    head->segment = CompactSegment( &segment );
+    segment.start.t = 0.5;
+    segment.start.pos = 2.5;
+    segment.start.vel = 5.0;
+    segment.start.acc = 0.0;
+    segment.end.t = 1.0;
+    segment.end.pos = 5.0;
+    segment.end.vel = 5.0;
+    segment.end.acc = 0.0;
+    middle->segment = CompactSegment( &segment );
+    segment.start.t = 1.0;
+    segment.start.pos = 5.0;
+    segment.start.vel = 5.0;
+    segment.start.acc = 0.0;
+    segment.end.t = 1.5;
+    segment.end.pos = 7.5;
+    segment.end.vel = 5.0;
+    segment.end.acc = 0.0;
+    tail->segment = CompactSegment( &segment );
 
     // Middle end
     state = FirstStateByPosition(&profile, 5.0);
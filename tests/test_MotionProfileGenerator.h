@@ -1,5 +1,7 @@
 #include <check.h>
+#include <stdlib.h>
 #include "../motion/Motion.h"
+#include "../utils/AllocTrack.h"
 
 
 START_TEST(test_GenerateProfile) {
@@ -47,6 +49,51 @@ START_TEST(test_GenerateProfile) {
 } END_TEST
 
 
+START_TEST(test_GetProfileEndState) {
+    const enum completionBehavior_e behaviors[] = {OVERSHOOT, VIOLATE_MAX_ACCEL, VIOLATE_MAX_ABS_VEL};
+    motionProfileConstraints_t constraints;
+    motionProfileGoal_t goalState;
+    motionState_t prevState, expected, actual;
+    motionProfileList_t profile;
+    allocStats_t stats;
+    int i;
+
+    // Every branch of the generator: starting too fast, moving away from the goal, overshooting, goals behind, at the goal.
+    srand( 43 );
+    for ( i = 0; i < 3000; i++ ) {
+        constraints.maxAbsVel = 1.0 + rand() % 100;
+        constraints.maxAbsAcc = 1.0 + rand() % 200;
+        goalState.completionBehavior = behaviors[rand() % 3];
+        goalState.maxAbsVel = ( rand() % 4 ) ? ( rand() % 120 ) : 0.0;
+        goalState.pos = ( rand() % 5 ) ? ( rand() % 2001 - 1000 ) / 10.0 : ( rand() % 3 - 1 ) * 1e-4;
+        goalState.posTolerance = 1e-3;
+        goalState.velTolerance = 1e-2;
+        prevState.t = ( rand() % 100 ) / 10.0;
+        prevState.pos = ( rand() % 3 ) ? 0.0 : ( rand() % 201 - 100 ) / 10.0;
+        prevState.vel = ( rand() % 241 - 120 ) / 2.0;
+        prevState.acc = ( rand() % 3 - 1 ) * constraints.maxAbsAcc;
+
+        profile = GenerateProfile( &constraints, &goalState, &prevState );
+        expected = SegmentEnd( &profile.tail->segment );
+        actual = GetProfileEndState( &constraints, &goalState, &prevState );
+        ck_assert_double_eq(expected.t, actual.t);
+        ck_assert_double_eq(expected.pos, actual.pos);
+        ck_assert_double_eq(expected.vel, actual.vel);
+        ck_assert_double_eq(expected.acc, actual.acc);
+        ClearProfile( &profile );
+    }
+
+    // Only the end is planned, so not even an empty node pool sends it to the heap.
+    ReleaseProfileNodes();
+    StartAllocTracking();
+    actual = GetProfileEndState( &constraints, &goalState, &prevState );
+    StopAllocTracking();
+    GetAllocStats( &stats );
+    ck_assert_int_eq(0, stats.allocations);
+
+} END_TEST
+
+
 Suite *motionProfileGenerator_suite(void) {
     Suite *s;
     TCase *tc;
@@ -55,6 +102,7 @@ Suite *motionProfileGenerator_suite(void) {
     tc = tcase_create("Core");
 
     tcase_add_test(tc, test_GenerateProfile);
+    tcase_add_test(tc, test_GetProfileEndState);
     suite_add_tcase(s, tc);
     return s;
 }
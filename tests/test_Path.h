@@ -0,0 +1,486 @@
+#include <check.h>
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include "../path/Path.h"
+#include "test_Helpers.h"
+
+
+// GetTargetPoint as it was before the segment index: every distance down the path found by walking the segments.
+targetPoint_t GetTargetPointByWalking (pathSegmentsList_t *segments, lookahead_t *lookahead, translation2d_t *robotPosition) {
+    pathSegmentNode_t *segmentNode;
+    pathSegment_t currentSegment;
+    targetPoint_t targetPoint;
+    translation2d_t closestPointDistance_in;
+    double lookaheadDistance, length;
+    int numSegments = 1;
+
+    currentSegment = segments->head->segment;
+    targetPoint.closestPoint = GetClosestPoint( &currentSegment, robotPosition );
+    closestPointDistance_in = TranslationDelta( robotPosition, &targetPoint.closestPoint );
+    targetPoint.closestPointDistance_in = TranslationNormal( &closestPointDistance_in );
+    targetPoint.remainingSegmentDistance_in = GetRemainingDistance( &currentSegment, &targetPoint.closestPoint );
+    targetPoint.closestPointSpeed_ips = GetSpeedByDistance( &currentSegment, GetLength( &currentSegment ) - targetPoint.remainingSegmentDistance_in );
+
+    targetPoint.remainingPathDistance_in = targetPoint.remainingSegmentDistance_in;
+    for ( segmentNode = segments->head->next; segmentNode; segmentNode = segmentNode->next ) {
+        targetPoint.remainingPathDistance_in += GetLength( &segmentNode->segment );
+        ++numSegments;
+    }
+
+    lookaheadDistance = GetLookaheadForSpeed( lookahead, targetPoint.closestPointSpeed_ips ) + targetPoint.closestPointDistance_in;
+    if ( targetPoint.remainingSegmentDistance_in < lookaheadDistance && numSegments > 1 ) {
+        lookaheadDistance -= targetPoint.remainingSegmentDistance_in;
+        for ( segmentNode = segments->head->next; segmentNode; segmentNode = segmentNode->next ) {
+            currentSegment = segmentNode->segment;
+            length = GetLength( &segmentNode->segment );
+            if ( length < lookaheadDistance && segmentNode->next ) {
+                lookaheadDistance -= length;
+            } else {
+                break;
+            }
+        }
+    } else {
+        lookaheadDistance += GetLength( &currentSegment ) - targetPoint.remainingSegmentDistance_in;
+    }
+    targetPoint.maxSpeed_ips = currentSegment.maxSpeed_ips;
+    targetPoint.lookaheadPoint = GetPointByDistance( &currentSegment, lookaheadDistance );
+    targetPoint.lookaheadPointSpeed_ips = GetSpeedByDistance( &currentSegment, lookaheadDistance );
+
+    return targetPoint;
+}
+
+
+START_TEST(test_GetTargetPointMatchesWalk) {
+    waypoint_t waypoints[200];
+    waypoint_t *wps[200];
+    pathSegmentsList_t path;
+    pathSegmentNode_t *node;
+    lookahead_t lookahead;
+    targetPoint_t expected, actual;
+    translation2d_t position;
+    int route, k, size, sample, checks = 0, farLookaheads = 0;
+
+    srand( 41 );
+    for ( route = 0; route < 40; route++ ) {
+        // Dense waypoints and tight corners give many short segments for the lookahead to cross.
+        size = 2 + rand() % 199;
+        for ( k = 0; k < size; k++ ) {
+            waypoints[k].position.x_in = 8.0 * k + ( rand() % 5 ) * 3.0;
+            waypoints[k].position.y_in = ( rand() % 5 ) * 4.0;
+            waypoints[k].radius = ( k == 0 || k == size - 1 ) ? 0.0 : ( rand() % 4 ) * 2.0;
+            waypoints[k].speed_ips = 20.0 + ( rand() % 5 ) * 15.0;
+            wps[k] = &waypoints[k];
+        }
+        path = BuildPathFromWaypoints( wps, size );
+        lookahead.minDistance_in = 2.0 + rand() % 20;
+        lookahead.maxDistance_in = lookahead.minDistance_in + rand() % 100;
+        lookahead.minSpeed_ips = 0.0;
+        lookahead.maxSpeed_ips = 80.0;
+        lookahead.deltaDistance_in = lookahead.maxDistance_in - lookahead.minDistance_in;
+        lookahead.deltaSpeed_ips = lookahead.maxSpeed_ips - lookahead.minSpeed_ips;
+
+        // Drive past every segment in order, off the path by up to 2 in, so the head moves down the path as it would.
+        for ( node = path.head; node; node = node->next ) {
+            for ( sample = 0; sample < 4; sample++ ) {
+                position = GetPointByDistance( &node->segment, GetLength( &node->segment ) * ( sample + rand() % 100 / 100.0 ) / 4.0 );
+                position.x_in += ( rand() % 41 - 20 ) / 10.0;
+                position.y_in += ( rand() % 41 - 20 ) / 10.0;
+                expected = GetTargetPointByWalking( &path, &lookahead, &position );
+                actual = GetTargetPoint( &path, &lookahead, &position );
+                ck_assert_double_eq_tol(expected.closestPoint.x_in, actual.closestPoint.x_in, 1E-9);
+                ck_assert_double_eq_tol(expected.closestPoint.y_in, actual.closestPoint.y_in, 1E-9);
+                ck_assert_double_eq_tol(expected.closestPointSpeed_ips, actual.closestPointSpeed_ips, 1E-9);
+                ck_assert_double_eq_tol(expected.remainingSegmentDistance_in, actual.remainingSegmentDistance_in, 1E-9);
+                ck_assert_double_eq_tol(expected.remainingPathDistance_in, actual.remainingPathDistance_in, 1E-9);
+                ck_assert_double_eq_tol(expected.lookaheadPoint.x_in, actual.lookaheadPoint.x_in, 1E-6);
+                ck_assert_double_eq_tol(expected.lookaheadPoint.y_in, actual.lookaheadPoint.y_in, 1E-6);
+                ck_assert_double_eq_tol(expected.lookaheadPointSpeed_ips, actual.lookaheadPointSpeed_ips, 1E-6);
+                if ( actual.remainingSegmentDistance_in < GetLookaheadForSpeed( &lookahead, actual.closestPointSpeed_ips ) ) {
+                    farLookaheads += 1;
+                }
+                checks += 1;
+            }
+        }
+        ClearPath( &path );
+        ck_assert_ptr_null(path.nodes);
+    }
+    ck_assert_int_gt(checks, 1000);
+    ck_assert_int_gt(farLookaheads, checks / 4);
+
+} END_TEST
+
+
+START_TEST(test_BuildPathProfile) {
+    waypoint_t waypoints[120];
+    waypoint_t *wps[120];
+    pathSegmentsList_t path, wide;
+    pathSegmentNode_t *node;
+    lookahead_t lookahead = {12.0, 36.0, 4.0, 120.0, 24.0, 116.0};
+    targetPoint_t expected, actual;
+    translation2d_t position;
+    motionState_t moving = {0.0, 0.0, 30.0, 0.0}, state, expectedState;
+    int route, k, size, sample, pieces;
+
+    srand( 47 );
+    for ( route = 0; route < 20; route++ ) {
+        size = 2 + rand() % 119;
+        for ( k = 0; k < size; k++ ) {
+            waypoints[k].position.x_in = 12.0 * k + ( rand() % 5 ) * 3.0;
+            waypoints[k].position.y_in = ( k % 2 ) * 12.0 + ( rand() % 3 ) * 2.0;
+            waypoints[k].radius = ( k == 0 || k == size - 1 ) ? 0.0 : ( rand() % 4 ) * 2.0;
+            waypoints[k].speed_ips = 20.0 + ( rand() % 5 ) * 15.0;
+            wps[k] = &waypoints[k];
+        }
+        path = BuildPathFromWaypoints( wps, size );
+        wide = ( route % 2 ) ? BuildLazyPathFromWaypoints( wps, size, 2 ) : BuildPathFromWaypoints( wps, size );
+        if ( route == 1 ) {
+            ReplanPath( &path, &moving, 0.0 );
+            ReplanPath( &wide, &moving, 0.0 );
+        }
+        ck_assert_int_eq(0, BuildPathProfile( &wide ));
+        if ( route == 2 ) {
+            ReplanPath( &path, &moving, 0.0 );
+            ReplanPath( &wide, &moving, 0.0 );
+        }
+
+        // One array holds every segment's pieces in path distance, and the segments hold none of their own.
+        pieces = 0;
+        for ( node = path.head; node; node = node->next ) {
+            ck_assert_int_eq(pieces, wide.nodes[node->index]->profileOffset);
+            ck_assert_int_eq(0, wide.nodes[node->index]->segment.speedController.length);
+            pieces += node->segment.speedController.length;
+        }
+        ck_assert_int_eq(pieces, wide.profileLength);
+        ck_assert_int_eq(0, wide.profileWindow);
+        for ( k = 1; k < wide.profileLength; k++ ) {
+            ck_assert_double_ge(wide.profile[k].pos, wide.profile[k - 1].pos);
+            ck_assert_double_ge(wide.profile[k].t, wide.profile[k - 1].t);
+        }
+        // A distance in the rounding gap between two pieces of a segment's own profile has no state there; the path-wide
+        // lookup takes the end of the piece before.
+        for ( node = path.head; node; node = node->next ) {
+            expectedState = GetStateByDistance( &node->segment, 0.5 * node->length_in );
+            state = GetPathStateByDistance( &wide, node->startDistance_in + 0.5 * node->length_in );
+            ck_assert(!isnan( state.vel ));
+            if ( !isnan( expectedState.vel ) ) {
+                ck_assert_double_eq_tol(expectedState.vel, state.vel, 1E-6);
+                ck_assert_double_eq_tol(expectedState.t + node->startTime_s, state.t, 1E-6);
+            }
+        }
+
+        // Following it gives the same targets as the segments' own profiles.
+        for ( node = path.head; node; node = node->next ) {
+            for ( sample = 0; sample < 4; sample++ ) {
+                position = GetPointByDistance( &node->segment, GetLength( &node->segment ) * ( sample + rand() % 100 / 100.0 ) / 4.0 );
+                position.x_in += ( rand() % 41 - 20 ) / 10.0;
+                position.y_in += ( rand() % 41 - 20 ) / 10.0;
+                expected = GetTargetPoint( &path, &lookahead, &position );
+                actual = GetTargetPoint( &wide, &lookahead, &position );
+                ck_assert_double_eq_tol(expected.closestPointSpeed_ips, actual.closestPointSpeed_ips, 1E-6);
+                ck_assert_double_eq_tol(expected.remainingPathDistance_in, actual.remainingPathDistance_in, 1E-9);
+                ck_assert_double_eq_tol(expected.remainingPathTime_s, actual.remainingPathTime_s, 1E-6);
+                ck_assert_double_eq_tol(expected.lookaheadPoint.x_in, actual.lookaheadPoint.x_in, 1E-9);
+                ck_assert_double_eq_tol(expected.lookaheadPoint.y_in, actual.lookaheadPoint.y_in, 1E-9);
+                ck_assert_double_eq_tol(expected.lookaheadPointSpeed_ips, actual.lookaheadPointSpeed_ips, 1E-6);
+            }
+        }
+        ck_assert_int_eq(0, wide.nodes[wide.head->index]->segment.speedController.length);
+        ClearPath( &path );
+        ClearPath( &wide );
+        ck_assert_ptr_null(wide.profile);
+    }
+
+} END_TEST
+
+
+START_TEST(test_PathSegmentIndex) {
+    waypoint_t waypoints[30];
+    waypoint_t *wps[30];
+    pathSegmentsList_t path;
+    pathSegmentNode_t *node;
+    double distance = 0.0;
+    int k;
+
+    for ( k = 0; k < 30; k++ ) {
+        waypoints[k].position.x_in = 120.0 * k;
+        waypoints[k].position.y_in = ( k % 2 ) * 96.0;
+        waypoints[k].radius = ( k == 0 || k == 29 ) ? 0.0 : 24.0;
+        waypoints[k].speed_ips = 60.0;
+        wps[k] = &waypoints[k];
+    }
+    path = BuildPathFromWaypoints( wps, 30 );
+    ck_assert_int_ge(path.capacity, path.length);
+    for ( k = 0, node = path.head; node; k++, node = node->next ) {
+        ck_assert_ptr_eq(node, path.nodes[k]);
+        ck_assert_int_eq(k, node->index);
+        ck_assert_double_eq_tol(distance, node->startDistance_in, 1E-9);
+        ck_assert_double_eq(GetLength( &node->segment ), node->length_in);
+        distance += node->length_in;
+    }
+    ck_assert_int_eq(path.length, k);
+    ClearPath( &path );
+    ck_assert_ptr_null(path.nodes);
+    ck_assert_int_eq(0, path.capacity);
+
+} END_TEST
+
+
+void AssertPathTiming (pathSegmentsList_t *path) {
+    pathSegmentNode_t *node;
+    double time = 0.0;
+    int k;
+
+    for ( k = 0; k < path->length; k++ ) {
+        node = path->nodes[k];
+        ck_assert_double_eq(time, node->startTime_s);
+        ck_assert_double_eq(GetSegmentEndState( &node->segment ).t, node->duration_s);
+        ck_assert_double_gt(node->duration_s, 0.0);
+        time += node->duration_s;
+    }
+}
+
+
+START_TEST(test_PathTiming) {
+    waypoint_t waypoints[30];
+    waypoint_t *wps[30];
+    pathSegmentsList_t path, lazy, streamed;
+    pathSegmentNode_t *node;
+    pathBuilder_t builder;
+    motionState_t moving = {0.0, 0.0, 30.0, 0.0};
+    int k;
+
+    for ( k = 0; k < 30; k++ ) {
+        waypoints[k].position.x_in = 120.0 * k;
+        waypoints[k].position.y_in = ( k % 2 ) * 96.0;
+        waypoints[k].radius = ( k == 0 || k == 29 ) ? 0.0 : 24.0;
+        waypoints[k].speed_ips = 40.0 + 20.0 * ( k % 2 );
+        wps[k] = &waypoints[k];
+    }
+
+    // Every way of building the path plans the same times.
+    path = BuildPathFromWaypoints( wps, 30 );
+    AssertPathTiming( &path );
+    lazy = BuildLazyPathFromWaypoints( wps, 30, 2 );
+    CompleteLazyPath( &lazy );
+    InitPathBuilder( &builder, &streamed );
+    for ( k = 0; k < 30; k++ ) {
+        AppendPathWaypoint( &builder, wps[k] );
+    }
+    for ( k = 0; k < path.length; k++ ) {
+        ck_assert_double_eq(path.nodes[k]->startTime_s, lazy.nodes[k]->startTime_s);
+        ck_assert_double_eq(path.nodes[k]->duration_s, lazy.nodes[k]->duration_s);
+        ck_assert_double_eq(path.nodes[k]->startTime_s, streamed.nodes[k]->startTime_s);
+        ck_assert_double_eq(path.nodes[k]->duration_s, streamed.nodes[k]->duration_s);
+    }
+    ClearPath( &lazy );
+    ClearPath( &streamed );
+
+    // Starting faster the path takes less time, and the times follow the new plan.
+    node = path.tail;
+    ReplanPath( &path, &moving, 0.0 );
+    AssertPathTiming( &path );
+    ck_assert_double_lt(path.nodes[0]->duration_s, path.nodes[1]->startTime_s + 1.0);
+    ck_assert_ptr_eq(node, path.tail);
+    ClearPath( &path );
+
+} END_TEST
+
+
+typedef struct pathProgressReader {
+    pathFollower_t *follower;
+    double length_in;
+    _Atomic int stop;
+    _Atomic long reads;
+    long torn;
+} pathProgressReader_t;
+
+
+void * PathProgressReader (void *arg) {
+    pathProgressReader_t *reader = arg;
+    pathProgress_t progress;
+
+    // Distance and share driven are published together, so a whole read always has them agree.
+    while ( !atomic_load( &reader->stop ) ) {
+        GetPathProgress( reader->follower, &progress );
+        if ( progress.percentComplete != 0.0 &&
+             fabs( progress.percentComplete - 100.0 * ( 1.0 - progress.distanceRemaining_in / reader->length_in ) ) > 1E-9 ) {
+            reader->torn += 1;
+        }
+        atomic_fetch_add( &reader->reads, 1 );
+    }
+    return NULL;
+}
+
+
+// Yields until the reader has read more than the given number of times, however the threads are scheduled.
+void WaitPathProgressReads (pathProgressReader_t *reader, long reads) {
+    while ( atomic_load( &reader->reads ) <= reads ) {
+        sched_yield();
+    }
+}
+
+
+START_TEST(test_GetPathProgress) {
+    pathFollowerParams_t params = GetTestFollowerParams();
+    waypoint_t waypoints[8];
+    waypoint_t *wps[8];
+    pathSegmentsList_t path;
+    pathFollower_t follower;
+    pathProgress_t progress, last;
+    pathProgressReader_t reader;
+    trajectory_t trajectory;
+    pthread_t thread;
+    transform2d_t pose;
+    twist2d_t command = {0.0, 0.0, 0.0};
+    double displacement = 0.0, dt = 0.01, plannedTime_s;
+    int tick, k;
+
+    for ( k = 0; k < 8; k++ ) {
+        waypoints[k].position.x_in = 120.0 * k;
+        waypoints[k].position.y_in = ( k % 2 ) * 96.0;
+        waypoints[k].radius = ( k == 0 || k == 7 ) ? 0.0 : 24.0;
+        waypoints[k].speed_ips = 60.0;
+        wps[k] = &waypoints[k];
+    }
+    path = BuildPathFromWaypoints( wps, 8 );
+    plannedTime_s = path.tail->startTime_s + path.tail->duration_s;
+
+    // The planned time is that of the path's speed plan, as a compiled trajectory runs it.
+    ck_assert_int_eq(0, CompileTrajectory( &path, dt, &trajectory ));
+    ck_assert_double_eq_tol(trajectory.duration, plannedTime_s, 1E-6);
+    ClearTrajectory( &trajectory );
+    pose = GetTestPathStartPose( &path );
+    InitPathFollower( &follower, &path, 0, &params );
+    GetPathProgress( &follower, &progress );
+    ck_assert_double_eq(0.0, progress.percentComplete);
+
+    reader.follower = &follower;
+    reader.length_in = path.tail->startDistance_in + path.tail->length_in;
+    atomic_init( &reader.stop, 0 );
+    atomic_init( &reader.reads, 0 );
+    reader.torn = 0;
+    pthread_create( &thread, NULL, PathProgressReader, &reader );
+    WaitPathProgressReads( &reader, 0 );
+
+    last.percentComplete = 0.0;
+    last.timeRemaining_s = plannedTime_s;
+    for ( tick = 0; tick < 3000 && !PathFollowerIsFinished( &follower ); tick++ ) {
+        command = GetPathFollowerUpdate( &follower, tick * dt, displacement, command.dx_in, &pose );
+        StepTestRobot( &command, &pose, &displacement, dt );
+
+        if ( tick % 50 == 0 ) {
+            // Let the reader run between ticks on a single core too.
+            sched_yield();
+        }
+        GetPathProgress( &follower, &progress );
+        if ( !follower.steeringController.atEndOfPath ) {
+            ck_assert_double_eq(follower.steeringController.lastTargetPoint.remainingPathDistance_in, progress.distanceRemaining_in);
+            ck_assert_double_eq(follower.steeringController.lastTargetPoint.remainingPathTime_s, progress.timeRemaining_s);
+        }
+        ck_assert_double_ge(progress.percentComplete, last.percentComplete - 0.1);
+        ck_assert_double_le(progress.timeRemaining_s, last.timeRemaining_s + 0.01);
+        ck_assert_double_le(progress.timeRemaining_s, plannedTime_s + 1E-9);
+        ck_assert_double_ge(progress.timeRemaining_s, -1E-9);
+        last = progress;
+    }
+    // Make sure the reader also sees the follower after the last tick before it is stopped.
+    WaitPathProgressReads( &reader, atomic_load( &reader.reads ) );
+    atomic_store( &reader.stop, 1 );
+    pthread_join( thread, NULL );
+
+    ck_assert_int_eq(1, PathFollowerIsFinished( &follower ));
+    ck_assert_double_gt(last.percentComplete, 99.0);
+    ck_assert_double_lt(last.timeRemaining_s, 0.5);
+    ck_assert_int_gt(atomic_load( &reader.reads ), 1);
+    ck_assert_int_eq(0, reader.torn);
+
+    ClearPath( &path );
+    ClearPathFollower( &follower );
+
+} END_TEST
+
+
+START_TEST(test_PathFollowerGoalReplan) {
+    pathFollowerParams_t params = GetTestFollowerParams();
+    waypoint_t waypoints[4];
+    waypoint_t *wps[4];
+    pathSegmentsList_t path;
+    pathFollower_t follower;
+    transform2d_t pose;
+    twist2d_t command;
+    setpointGenerator_t *generator;
+    double displacement, dt = 0.01;
+    int k, run, full[2], incremental[2], finished[2];
+
+    // A dog-leg with a slow middle leg, so the speed limit changes at the segment boundaries as well.
+    for ( k = 0; k < 4; k++ ) {
+        waypoints[k].position.x_in = 120.0 * k;
+        waypoints[k].position.y_in = ( k >= 2 ) ? 48.0 : 0.0;
+        waypoints[k].radius = ( k == 0 || k == 3 ) ? 0.0 : 24.0;
+        waypoints[k].speed_ips = ( k == 2 ) ? 30.0 : 60.0;
+        wps[k] = &waypoints[k];
+    }
+
+    // Drive the path once without and once with a replan tolerance.
+    for ( run = 0; run < 2; run++ ) {
+        params.goal_replan_tolerance = run ? 2.0 : 0.0;
+        path = BuildPathFromWaypoints( wps, 4 );
+        pose = GetTestPathStartPose( &path );
+        InitPathFollower( &follower, &path, 0, &params );
+        generator = follower.velocityController.setpointGenerator;
+        ck_assert_double_eq(params.goal_replan_tolerance, generator->goalReplanTolerance);
+
+        command.dx_in = 0.0;
+        displacement = 0.0;
+        DriveTestRobot( &follower, &command, &pose, &displacement, 0, 3000, dt );
+        full[run] = generator->fullRegenerations;
+        incremental[run] = generator->incrementalRegenerations;
+        finished[run] = PathFollowerIsFinished( &follower );
+
+        ClearPath( &path );
+        ClearPathFollower( &follower );
+    }
+
+    // The moving goal is mostly re-targeted rather than replanned from scratch once the tolerance is set.
+    ck_assert_int_eq(1, finished[0]);
+    ck_assert_int_eq(1, finished[1]);
+    ck_assert_int_eq(0, incremental[0]);
+    ck_assert_int_gt(incremental[1], 0);
+    ck_assert_int_lt(full[1], full[0]);
+
+} END_TEST
+
+
+START_TEST(test_ClearPathFollower) {
+    pathFollowerParams_t params = GetTestFollowerParams();
+    pathFollower_t follower;
+
+    InitPathFollower( &follower, NULL, 0, &params );
+    ClearPathFollower( &follower );
+    ck_assert_ptr_null(follower.velocityController.constraints);
+    ck_assert_ptr_null(follower.velocityController.goal);
+    ck_assert_ptr_null(follower.velocityController.latestSetpoint);
+    ck_assert_ptr_null(follower.velocityController.setpointGenerator);
+
+} END_TEST
+
+
+Suite *path_suite(void) {
+    Suite *s;
+    TCase *tc;
+
+    s = suite_create("Path");
+    tc = tcase_create("Core");
+
+    tcase_add_test(tc, test_PathSegmentIndex);
+    tcase_add_test(tc, test_GetTargetPointMatchesWalk);
+    tcase_add_test(tc, test_BuildPathProfile);
+    tcase_add_test(tc, test_PathTiming);
+    tcase_add_test(tc, test_GetPathProgress);
+    tcase_add_test(tc, test_PathFollowerGoalReplan);
+    tcase_add_test(tc, test_ClearPathFollower);
+    suite_add_tcase(s, tc);
+    return s;
+}
@@ -0,0 +1,271 @@
+#include <check.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../path/Path.h"
+#include "test_Helpers.h"
+
+
+START_TEST(test_AppendPathWaypointMatchesBuild) {
+    waypoint_t waypoints[12];
+    waypoint_t *wps[12];
+    pathSegmentsList_t built, streamed;
+    pathBuilder_t builder;
+    int size, k, added;
+
+    srand( 38 );
+    for ( size = 1; size <= 12; size++ ) {
+        // Mix in straight-through corners, corners without a radius and radii that use up a whole line.
+        for ( k = 0; k < size; k++ ) {
+            waypoints[k].position.x_in = 60.0 * k + ( rand() % 3 ) * 40.0;
+            waypoints[k].position.y_in = ( rand() % 3 ) * 50.0;
+            waypoints[k].radius = ( k == 0 || k == size - 1 ) ? 0.0 : ( rand() % 4 ) * 10.0;
+            waypoints[k].speed_ips = 30.0 + ( rand() % 4 ) * 10.0;
+            wps[k] = &waypoints[k];
+        }
+        built = BuildPathFromWaypoints( wps, size );
+
+        InitPathBuilder( &builder, &streamed );
+        added = 0;
+        for ( k = 0; k < size; k++ ) {
+            added += AppendPathWaypoint( &builder, &waypoints[k] );
+            ck_assert_int_eq(added, streamed.length);
+        }
+        AssertPathsEqual( &built, &streamed );
+
+        ClearPath( &built );
+        ClearPath( &streamed );
+    }
+
+} END_TEST
+
+
+START_TEST(test_StreamedPathFollowing) {
+    pathFollowerParams_t params = GetTestFollowerParams();
+    waypoint_t waypoints[8];
+    pathFollower_t follower;
+    pathSegmentsList_t path = {NULL, NULL, 0};
+    pathBuilder_t builder;
+    transform2d_t pose;
+    twist2d_t command = {0.0, 0.0, 0.0};
+    double displacement = 0.0, dt = 0.01, minSpeed = 1E9;
+    int tick, next, lastAppend = 0;
+
+    for ( next = 0; next < 8; next++ ) {
+        waypoints[next].position.x_in = 120.0 * next;
+        waypoints[next].position.y_in = ( next % 2 ) * 96.0;
+        waypoints[next].radius = ( next == 0 || next == 7 ) ? 0.0 : 24.0;
+        waypoints[next].speed_ips = 60.0;
+    }
+
+    // The robot starts as soon as there is a first line, the planner hands over another waypoint every second.
+    InitPathBuilder( &builder, &path );
+    AppendPathWaypoint( &builder, &waypoints[0] );
+    ck_assert_int_eq(0, path.length);
+    ck_assert_int_eq(1, AppendPathWaypoint( &builder, &waypoints[1] ));
+    next = 2;
+    pose = GetTestPathStartPose( &path );
+    InitPathFollower( &follower, &path, 0, &params );
+    for ( tick = 0; tick < 5000 && !PathFollowerIsFinished( &follower ); tick++ ) {
+        if ( tick % 100 == 99 && next < 8 ) {
+            ck_assert_int_eq(0, follower.steeringController.atEndOfPath);
+            ck_assert_int_eq(2, AppendPathWaypoint( &builder, &waypoints[next++] ));
+            lastAppend = tick;
+        }
+        command = GetPathFollowerUpdate( &follower, tick * dt, displacement, command.dx_in, &pose );
+        StepTestRobot( &command, &pose, &displacement, dt );
+        if ( tick > 150 && next < 8 ) {
+            minSpeed = fmin( minSpeed, command.dx_in );
+        }
+    }
+
+    // No stop at any of the streamed waypoints, and the robot ends up at the last one.
+    ck_assert_int_eq(1, PathFollowerIsFinished( &follower ));
+    ck_assert_int_eq(8, next);
+    ck_assert_int_gt(tick, lastAppend);
+    ck_assert_double_gt(minSpeed, 20.0);
+    ck_assert_double_eq_tol(840.0, pose.translation.x_in, 1.0);
+    ck_assert_double_eq_tol(96.0, pose.translation.y_in, 1.0);
+
+    ClearPath( &path );
+    ClearPathFollower( &follower );
+
+} END_TEST
+
+
+START_TEST(test_BuildPathFromWaypointsParallel) {
+    const int sizes[] = {1, 2, 3, 10, 66, 200, 1000, 3000};
+    const int threads[] = {1, 2, 4};
+    waypoint_t *waypoints;
+    waypoint_t **wps;
+    pathSegmentsList_t serial, parallel;
+    threadPool_t *pool;
+    int s, t, k, size;
+
+    waypoints = malloc( 3000 * sizeof( waypoint_t ) );
+    wps = malloc( 3000 * sizeof( waypoint_t * ) );
+    srand( 40 );
+    for ( t = 0; t < 3; t++ ) {
+        pool = CreateThreadPool( threads[t] );
+        ck_assert_ptr_nonnull(pool);
+        for ( s = 0; s < 8; s++ ) {
+            // Short legs and speed changes make ranges start part way through a speed change.
+            size = sizes[s];
+            for ( k = 0; k < size; k++ ) {
+                waypoints[k].position.x_in = 50.0 * k + ( rand() % 3 ) * 30.0;
+                waypoints[k].position.y_in = ( rand() % 3 ) * 40.0;
+                waypoints[k].radius = ( k == 0 || k == size - 1 ) ? 0.0 : ( rand() % 4 ) * 8.0;
+                waypoints[k].speed_ips = 20.0 + ( rand() % 5 ) * 15.0;
+                wps[k] = &waypoints[k];
+            }
+            serial = BuildPathFromWaypoints( wps, size );
+            parallel = BuildPathFromWaypointsParallel( wps, size, pool );
+            AssertPathsEqual( &serial, &parallel );
+            ClearPath( &serial );
+            ClearPath( &parallel );
+        }
+        DestroyThreadPool( pool );
+    }
+    free( wps );
+    free( waypoints );
+
+} END_TEST
+
+
+START_TEST(test_LazyPathMatchesBuild) {
+    waypoint_t waypoints[40];
+    waypoint_t *wps[40];
+    pathSegmentsList_t built, lazy;
+    pathSegmentNode_t *node;
+    int size, k, window, profiles;
+
+    srand( 43 );
+    for ( size = 1; size <= 40; size++ ) {
+        // Short legs and speed changes, so that some segments cannot reach the speed they were planned to end at.
+        for ( k = 0; k < size; k++ ) {
+            waypoints[k].position.x_in = 40.0 * k + ( rand() % 3 ) * 30.0;
+            waypoints[k].position.y_in = ( rand() % 3 ) * 40.0;
+            waypoints[k].radius = ( k == 0 || k == size - 1 ) ? 0.0 : ( rand() % 4 ) * 8.0;
+            waypoints[k].speed_ips = 20.0 + ( rand() % 5 ) * 15.0;
+            wps[k] = &waypoints[k];
+        }
+        window = 1 + size % 4;
+        built = BuildPathFromWaypoints( wps, size );
+        lazy = BuildLazyPathFromWaypoints( wps, size, window );
+
+        // Built as far as the window and one segment past it, the last planned to stop; a waypoint adds up to two.
+        ck_assert_int_le(lazy.length, window + 3);
+        if ( lazy.route ) {
+            ck_assert_int_ge(lazy.length, window + 2);
+        }
+        CompleteLazyPath( &lazy );
+        ck_assert_ptr_null(lazy.route);
+        ck_assert_int_eq(built.length, lazy.length);
+
+        // Only the window has a profile, the rest are generated from the same plan as the full build.
+        profiles = 0;
+        for ( node = lazy.head; node; node = node->next ) {
+            if ( node->segment.speedController.length ) {
+                ck_assert_int_lt(node->index, window);
+                profiles += 1;
+            }
+            EnsureSegmentProfile( &node->segment );
+        }
+        ck_assert_int_eq(( lazy.length < window ) ? lazy.length : window, profiles);
+        AssertPathsEqual( &built, &lazy );
+
+        ClearPath( &built );
+        ClearPath( &lazy );
+    }
+
+} END_TEST
+
+
+START_TEST(test_LazyPathFollowing) {
+    pathFollowerParams_t params = GetTestFollowerParams();
+    waypoint_t waypoints[30];
+    waypoint_t *wps[30];
+    pathFollower_t follower, lazyFollower;
+    pathSegmentsList_t path, lazy, compiled;
+    pathSegmentNode_t *node;
+    trajectory_t trajectory, lazyTrajectory;
+    transform2d_t pose;
+    twist2d_t command = {0.0, 0.0, 0.0}, lazyCommand;
+    double displacement = 0.0, dt = 0.01;
+    int tick, k, profiles, maxProfiles = 0, ahead, maxAhead = 0;
+
+    for ( k = 0; k < 30; k++ ) {
+        waypoints[k].position.x_in = 60.0 * k;
+        waypoints[k].position.y_in = ( k % 2 ) * 48.0;
+        waypoints[k].radius = ( k == 0 || k == 29 ) ? 0.0 : 12.0;
+        waypoints[k].speed_ips = 60.0;
+        wps[k] = &waypoints[k];
+    }
+    path = BuildPathFromWaypoints( wps, 30 );
+    lazy = BuildLazyPathFromWaypoints( wps, 30, 2 );
+    compiled = BuildLazyPathFromWaypoints( wps, 30, 2 );
+
+    // A compiled lazy path is the same, built to its end, and keeps only its window.
+    ck_assert_int_eq(0, CompileTrajectory( &path, dt, &trajectory ));
+    ck_assert_int_eq(0, CompileTrajectory( &compiled, dt, &lazyTrajectory ));
+    ck_assert_int_eq(trajectory.numPoints, lazyTrajectory.numPoints);
+    ck_assert_int_eq(0, memcmp( trajectory.points, lazyTrajectory.points, trajectory.numPoints * sizeof( trajectoryPoint_t ) ));
+    ck_assert_int_eq(path.length, compiled.length);
+    ck_assert_int_eq(0, compiled.nodes[2]->segment.speedController.length);
+    ClearTrajectory( &trajectory );
+    ClearTrajectory( &lazyTrajectory );
+    ClearPath( &compiled );
+
+    // Both followers see the same robot, so every command must be the same.
+    pose = GetTestPathStartPose( &path );
+    InitPathFollower( &follower, &path, 0, &params );
+    InitPathFollower( &lazyFollower, &lazy, 0, &params );
+    for ( tick = 0; tick < 5000 && !PathFollowerIsFinished( &follower ); tick++ ) {
+        command = GetPathFollowerUpdate( &follower, tick * dt, displacement, command.dx_in, &pose );
+        lazyCommand = GetPathFollowerUpdate( &lazyFollower, tick * dt, displacement, command.dx_in, &pose );
+        ck_assert_double_eq(command.dx_in, lazyCommand.dx_in);
+        ck_assert_double_eq(command.dtheta_rad, lazyCommand.dtheta_rad);
+        profiles = 0;
+        for ( node = lazy.nodes[0]; node; node = node->next ) {
+            if ( node->segment.speedController.length ) {
+                ck_assert_int_ge(node->index, lazy.head->index);
+                profiles += 1;
+            }
+        }
+        maxProfiles = ( profiles > maxProfiles ) ? profiles : maxProfiles;
+        ahead = lazy.tail->index - lazy.head->index;
+        maxAhead = ( ahead > maxAhead ) ? ahead : maxAhead;
+        StepTestRobot( &command, &pose, &displacement, dt );
+    }
+
+    // The lookahead reaches past the window at times, never far, and the path is built only a few segments ahead of it.
+    ck_assert_int_eq(1, PathFollowerIsFinished( &lazyFollower ));
+    ck_assert_int_ge(maxProfiles, 2);
+    ck_assert_int_le(maxProfiles, 4);
+    ck_assert_int_le(maxAhead, 6);
+    ck_assert_ptr_null(lazy.route);
+    ck_assert_int_eq(path.tail->index, lazy.tail->index);
+    ck_assert_double_eq_tol(1740.0, pose.translation.x_in, 1.0);
+
+    ClearPath( &path );
+    ClearPath( &lazy );
+    ClearPathFollower( &follower );
+    ClearPathFollower( &lazyFollower );
+
+} END_TEST
+
+
+Suite *pathBuilder_suite(void) {
+    Suite *s;
+    TCase *tc;
+
+    s = suite_create("PathBuilder");
+    tc = tcase_create("Core");
+
+    tcase_add_test(tc, test_AppendPathWaypointMatchesBuild);
+    tcase_add_test(tc, test_StreamedPathFollowing);
+    tcase_add_test(tc, test_BuildPathFromWaypointsParallel);
+    tcase_add_test(tc, test_LazyPathMatchesBuild);
+    tcase_add_test(tc, test_LazyPathFollowing);
+    suite_add_tcase(s, tc);
+    return s;
+}
@@ -0,0 +1,270 @@
+#include <check.h>
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "../path/Path.h"
+#include "test_Helpers.h"
+
+
+void MakeCacheTestWaypoints (waypoint_t *waypoints, waypoint_t **wps, int numWaypoints, double speed) {
+    int k;
+
+    for ( k = 0; k < numWaypoints; k++ ) {
+        waypoints[k].position.x_in = 120.0 * k;
+        waypoints[k].position.y_in = ( k % 2 ) * 96.0;
+        waypoints[k].radius = ( k == 0 || k == numWaypoints - 1 ) ? 0.0 : 24.0;
+        waypoints[k].speed_ips = speed;
+        wps[k] = &waypoints[k];
+    }
+}
+
+
+START_TEST(test_PathCacheHitsAndMisses) {
+    waypoint_t waypoints[8], slower[8];
+    waypoint_t *wps[8], *slowerWps[8];
+    pathSegmentsList_t built, first, second, other;
+    pathCacheEntry_t *entryA, *entryB, *entryC;
+    pathCacheStats_t stats;
+    pathCache_t cache;
+
+    MakeCacheTestWaypoints( waypoints, wps, 8, 60.0 );
+    MakeCacheTestWaypoints( slower, slowerWps, 8, 50.0 );
+    ck_assert_int_eq(0, InitPathCache( &cache, 1 << 20, NULL ));
+
+    entryA = AcquireCachedPath( &cache, wps, 8, &first );
+    ck_assert_ptr_nonnull(entryA);
+    built = BuildPathFromWaypoints( wps, 8 );
+    AssertPathsEqual( &built, &first );
+    ClearPath( &built );
+
+    // The same waypoints, even from another array, share the compiled path.
+    MakeCacheTestWaypoints( waypoints, wps, 8, 60.0 );
+    entryB = AcquireCachedPath( &cache, wps, 8, &second );
+    ck_assert_ptr_eq(entryA, entryB);
+    ck_assert_ptr_eq(first.head, second.head);
+
+    entryC = AcquireCachedPath( &cache, slowerWps, 8, &other );
+    ck_assert_ptr_ne(entryA, entryC);
+    ck_assert_ptr_null(AcquireCachedPath( &cache, wps, 1, &other ));
+    ck_assert_ptr_null(other.head);
+
+    GetPathCacheStats( &cache, &stats );
+    ck_assert_int_eq(1, stats.hits);
+    ck_assert_int_eq(2, stats.misses);
+    ck_assert_int_eq(0, stats.diskHits);
+    ck_assert_int_eq(2, stats.entries);
+    ck_assert_int_gt(stats.bytes, 0);
+
+    ReleaseCachedPath( &cache, entryA );
+    ReleaseCachedPath( &cache, entryB );
+    ReleaseCachedPath( &cache, entryC );
+    DestroyPathCache( &cache );
+
+} END_TEST
+
+
+START_TEST(test_PathCacheManyEntries) {
+    waypoint_t waypoints[4 * PATH_CACHE_BUCKETS][3];
+    waypoint_t *wps[4 * PATH_CACHE_BUCKETS][3];
+    pathSegmentsList_t path;
+    pathCacheEntry_t *entries[4 * PATH_CACHE_BUCKETS];
+    pathCacheStats_t stats;
+    pathCache_t cache;
+    int k;
+
+    // More routes than buckets, so buckets hold several entries each.
+    for ( k = 0; k < 4 * PATH_CACHE_BUCKETS; k++ ) {
+        MakeCacheTestWaypoints( waypoints[k], wps[k], 3, 20.0 + 0.25 * k );
+    }
+    ck_assert_int_eq(0, InitPathCache( &cache, 64 << 20, NULL ));
+    for ( k = 0; k < 4 * PATH_CACHE_BUCKETS; k++ ) {
+        entries[k] = AcquireCachedPath( &cache, wps[k], 3, &path );
+        ReleaseCachedPath( &cache, entries[k] );
+    }
+    for ( k = 0; k < 4 * PATH_CACHE_BUCKETS; k++ ) {
+        ck_assert_ptr_eq(entries[k], AcquireCachedPath( &cache, wps[k], 3, &path ));
+        ReleaseCachedPath( &cache, entries[k] );
+    }
+    GetPathCacheStats( &cache, &stats );
+    ck_assert_int_eq(4 * PATH_CACHE_BUCKETS, stats.hits);
+    ck_assert_int_eq(4 * PATH_CACHE_BUCKETS, stats.misses);
+    ck_assert_int_eq(4 * PATH_CACHE_BUCKETS, stats.entries);
+    DestroyPathCache( &cache );
+
+    // Evicted entries leave their buckets: with room for only some of the routes, the oldest miss again and the newest hit.
+    ck_assert_int_eq(0, InitPathCache( &cache, stats.bytes / 2, NULL ));
+    for ( k = 0; k < 4 * PATH_CACHE_BUCKETS; k++ ) {
+        ReleaseCachedPath( &cache, AcquireCachedPath( &cache, wps[k], 3, &path ) );
+    }
+    GetPathCacheStats( &cache, &stats );
+    ck_assert_int_gt(stats.evictions, 0);
+    ReleaseCachedPath( &cache, AcquireCachedPath( &cache, wps[0], 3, &path ) );
+    ReleaseCachedPath( &cache, AcquireCachedPath( &cache, wps[4 * PATH_CACHE_BUCKETS - 1], 3, &path ) );
+    GetPathCacheStats( &cache, &stats );
+    ck_assert_int_eq(1, stats.hits);
+    ck_assert_int_eq(4 * PATH_CACHE_BUCKETS + 1, stats.misses);
+    ck_assert_int_le(stats.bytes, cache.budgetBytes);
+    DestroyPathCache( &cache );
+
+} END_TEST
+
+
+START_TEST(test_PathCacheSharedFollowing) {
+    pathFollowerParams_t params = GetTestFollowerParams();
+    waypoint_t waypoints[5];
+    waypoint_t *wps[5];
+    pathFollower_t follower;
+    pathSegmentsList_t path, again;
+    pathCacheEntry_t *entry;
+    pathCache_t cache;
+    transform2d_t pose;
+    twist2d_t command = {0.0, 0.0, 0.0};
+    double displacement = 0.0, dt = 0.01;
+    int run, segments;
+
+    MakeCacheTestWaypoints( waypoints, wps, 5, 60.0 );
+    ck_assert_int_eq(0, InitPathCache( &cache, 1 << 20, NULL ));
+
+    // Drive the cached route twice; following only moves the follower's own list, the shared path stays whole.
+    for ( run = 0; run < 2; run++ ) {
+        entry = AcquireCachedPath( &cache, wps, 5, &path );
+        segments = path.length;
+        pose = GetTestPathStartPose( &path );
+        displacement = 0.0;
+        command.dx_in = 0.0;
+        InitPathFollower( &follower, &path, 0, &params );
+        DriveTestRobot( &follower, &command, &pose, &displacement, 0, 3000, dt );
+        ck_assert_int_eq(1, PathFollowerIsFinished( &follower ));
+        ck_assert_double_eq_tol(480.0, pose.translation.x_in, 1.0);
+        ck_assert_int_lt(path.length, segments);
+        ck_assert_ptr_eq(entry, AcquireCachedPath( &cache, wps, 5, &again ));
+        ck_assert_int_eq(segments, again.length);
+        ReleaseCachedPath( &cache, entry );
+        ReleaseCachedPath( &cache, entry );
+        ClearPathFollower( &follower );
+    }
+    DestroyPathCache( &cache );
+
+} END_TEST
+
+
+START_TEST(test_PathCacheEviction) {
+    waypoint_t waypoints[3][6];
+    waypoint_t *wps[3][6];
+    pathSegmentsList_t path;
+    pathCacheEntry_t *entry[3];
+    pathCacheStats_t stats;
+    pathCache_t cache;
+    size_t oneEntry;
+    int i;
+
+    for ( i = 0; i < 3; i++ ) {
+        MakeCacheTestWaypoints( waypoints[i], wps[i], 6, 40.0 + 10.0 * i );
+    }
+    ck_assert_int_eq(0, InitPathCache( &cache, 1 << 20, NULL ));
+    ReleaseCachedPath( &cache, AcquireCachedPath( &cache, wps[0], 6, &path ) );
+    GetPathCacheStats( &cache, &stats );
+    oneEntry = stats.bytes;
+    DestroyPathCache( &cache );
+
+    // Room for two routes: using a third evicts the least recently used one.
+    ck_assert_int_eq(0, InitPathCache( &cache, oneEntry * 5 / 2, NULL ));
+    ReleaseCachedPath( &cache, AcquireCachedPath( &cache, wps[0], 6, &path ) );
+    ReleaseCachedPath( &cache, AcquireCachedPath( &cache, wps[1], 6, &path ) );
+    ReleaseCachedPath( &cache, AcquireCachedPath( &cache, wps[0], 6, &path ) );
+    ReleaseCachedPath( &cache, AcquireCachedPath( &cache, wps[2], 6, &path ) );
+    GetPathCacheStats( &cache, &stats );
+    ck_assert_int_eq(1, stats.evictions);
+    ck_assert_int_eq(2, stats.entries);
+    ck_assert_int_le(stats.bytes, oneEntry * 5 / 2);
+    ReleaseCachedPath( &cache, AcquireCachedPath( &cache, wps[0], 6, &path ) );
+    GetPathCacheStats( &cache, &stats );
+    ck_assert_int_eq(2, stats.hits);
+    ck_assert_int_eq(3, stats.misses);
+
+    // Paths in use are kept over budget until they are released.
+    for ( i = 0; i < 3; i++ ) {
+        entry[i] = AcquireCachedPath( &cache, wps[i], 6, &path );
+    }
+    GetPathCacheStats( &cache, &stats );
+    ck_assert_int_eq(3, stats.entries);
+    for ( i = 0; i < 3; i++ ) {
+        ReleaseCachedPath( &cache, entry[i] );
+    }
+    GetPathCacheStats( &cache, &stats );
+    ck_assert_int_eq(2, stats.entries);
+    DestroyPathCache( &cache );
+
+} END_TEST
+
+
+START_TEST(test_PathCacheDiskTier) {
+    waypoint_t waypoints[12];
+    waypoint_t *wps[12];
+    pathSegmentsList_t path, built;
+    pathCacheEntry_t *entry;
+    pathCacheStats_t stats;
+    pathCache_t cache;
+    char directory[] = "/tmp/pathcacheXXXXXX", fileName[512];
+    struct dirent *dirEntry;
+    DIR *dir;
+    int run, files = 0;
+
+    MakeCacheTestWaypoints( waypoints, wps, 12, 60.0 );
+    ck_assert_ptr_nonnull(mkdtemp( directory ));
+    built = BuildPathFromWaypoints( wps, 12 );
+
+    // The first run builds and stores the path, the next run (a fresh cache) loads it.
+    for ( run = 0; run < 2; run++ ) {
+        ck_assert_int_eq(0, InitPathCache( &cache, 1 << 20, directory ));
+        entry = AcquireCachedPath( &cache, wps, 12, &path );
+        ck_assert_ptr_nonnull(entry);
+        AssertPathsEqual( &built, &path );
+        ReleaseCachedPath( &cache, entry );
+        GetPathCacheStats( &cache, &stats );
+        ck_assert_int_eq(1, stats.misses);
+        ck_assert_int_eq(run, stats.diskHits);
+        DestroyPathCache( &cache );
+    }
+
+    // Other waypoints never match the stored file.
+    waypoints[5].radius = 20.0;
+    ck_assert_int_eq(0, InitPathCache( &cache, 1 << 20, directory ));
+    ReleaseCachedPath( &cache, AcquireCachedPath( &cache, wps, 12, &path ) );
+    GetPathCacheStats( &cache, &stats );
+    ck_assert_int_eq(0, stats.diskHits);
+    DestroyPathCache( &cache );
+
+    dir = opendir( directory );
+    while ( ( dirEntry = readdir( dir ) ) ) {
+        if ( dirEntry->d_name[0] != '.' ) {
+            snprintf( fileName, sizeof( fileName ), "%s/%s", directory, dirEntry->d_name );
+            ck_assert_int_eq(0, unlink( fileName ));
+            files += 1;
+        }
+    }
+    closedir( dir );
+    ck_assert_int_eq(2, files);
+    ck_assert_int_eq(0, rmdir( directory ));
+    ClearPath( &built );
+
+} END_TEST
+
+
+Suite *pathCache_suite(void) {
+    Suite *s;
+    TCase *tc;
+
+    s = suite_create("PathCache");
+    tc = tcase_create("Core");
+
+    tcase_add_test(tc, test_PathCacheHitsAndMisses);
+    tcase_add_test(tc, test_PathCacheManyEntries);
+    tcase_add_test(tc, test_PathCacheSharedFollowing);
+    tcase_add_test(tc, test_PathCacheEviction);
+    tcase_add_test(tc, test_PathCacheDiskTier);
+    suite_add_tcase(s, tc);
+    return s;
+}
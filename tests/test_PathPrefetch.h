@@ -0,0 +1,150 @@
+#include <check.h>
+#include <sched.h>
+#include <stdlib.h>
+#include "../path/Path.h"
+#include "test_Helpers.h"
+
+
+void MakePrefetchTestWaypoints (waypoint_t *waypoints, waypoint_t **wps, int numWaypoints, double x, double y) {
+    int k;
+
+    for ( k = 0; k < numWaypoints; k++ ) {
+        waypoints[k].position.x_in = x + 120.0 * k;
+        waypoints[k].position.y_in = y + ( k % 2 ) * 96.0;
+        waypoints[k].radius = ( k == 0 || k == numWaypoints - 1 ) ? 0.0 : 24.0;
+        waypoints[k].speed_ips = 60.0;
+        wps[k] = &waypoints[k];
+    }
+}
+
+
+int WaitPrefetchedPath (pathPrefetch_t *prefetch, pathSegmentsList_t *path) {
+    int polls;
+
+    for ( polls = 0; polls < 1000000; polls++ ) {
+        if ( TakePrefetchedPath( prefetch, path ) ) {
+            return 1;
+        }
+        sched_yield();
+    }
+    return 0;
+}
+
+
+START_TEST(test_PrefetchPathMatchesBuild) {
+    waypoint_t waypoints[12], lineWaypoints[2] = {{{0.0, 0.0}, 0.0, 60.0}, {{100.0, 0.0}, 0.0, 60.0}};
+    waypoint_t *wps[12];
+    pathSegmentsList_t current = {NULL, NULL, 0}, prefetched, built;
+    pathPrefetch_t prefetch;
+    motionState_t rest = {0.0, 0.0, 0.0, 0.0}, endState;
+    line_t line;
+
+    // A path that ends still moving, as the front of a route being streamed in does.
+    line = CreateLine( &lineWaypoints[0], &lineWaypoints[1] );
+    AddPathSegment( &current, CreateLineSegment( &line, &rest, 40.0 ) );
+    endState = GetLastMotionState( &current );
+    ck_assert_double_eq_tol(40.0, endState.vel, 1E-9);
+
+    MakePrefetchTestWaypoints( waypoints, wps, 12, 100.0, 0.0 );
+    ck_assert_int_eq(0, InitPathPrefetch( &prefetch ));
+    ck_assert_int_eq(0, TakePrefetchedPath( &prefetch, &prefetched ));
+    ck_assert_int_eq(0, PrefetchPath( &prefetch, wps, 12, &current ));
+    ck_assert_int_eq(-1, PrefetchPath( &prefetch, wps, 12, &current ));
+
+    // The request is copied, so the caller's waypoints may change at once.
+    waypoints[3].radius = 4.0;
+    ck_assert_int_eq(1, WaitPrefetchedPath( &prefetch, &prefetched ));
+    waypoints[3].radius = 24.0;
+    built = BuildPathFromState( wps, 12, &endState );
+    AssertPathsEqual( &built, &prefetched );
+    ck_assert_double_eq(40.0, prefetched.head->segment.startState.vel);
+    ClearPath( &built );
+    ClearPath( &prefetched );
+
+    // Once taken the next one may be asked for; from no current path it starts at rest.
+    ck_assert_int_eq(0, PrefetchPath( &prefetch, wps, 5, NULL ));
+    ck_assert_int_eq(1, WaitPrefetchedPath( &prefetch, &prefetched ));
+    built = BuildPathFromWaypoints( wps, 5 );
+    AssertPathsEqual( &built, &prefetched );
+    ClearPath( &built );
+    ClearPath( &prefetched );
+
+    // A path never taken is freed with the prefetch.
+    ck_assert_int_eq(0, PrefetchPath( &prefetch, wps, 12, NULL ));
+    DestroyPathPrefetch( &prefetch );
+    ClearPath( &current );
+
+} END_TEST
+
+
+START_TEST(test_PrefetchPathSequence) {
+    pathFollowerParams_t params = GetTestFollowerParams();
+    waypoint_t waypoints[3][6];
+    waypoint_t *wps[3][6];
+    pathSegmentsList_t paths[3];
+    pathFollower_t follower;
+    pathPrefetch_t prefetch;
+    transform2d_t pose;
+    twist2d_t command = {0.0, 0.0, 0.0};
+    double displacement = 0.0, dt = 0.01;
+    int tick, route = 0, waits = 0;
+
+    // Three routes end to end, each starting where the one before stops.
+    MakePrefetchTestWaypoints( waypoints[0], wps[0], 6, 0.0, 0.0 );
+    MakePrefetchTestWaypoints( waypoints[1], wps[1], 6, 600.0, 96.0 );
+    MakePrefetchTestWaypoints( waypoints[2], wps[2], 6, 1200.0, 192.0 );
+    ck_assert_int_eq(0, InitPathPrefetch( &prefetch ));
+    paths[0] = BuildPathFromWaypoints( wps[0], 6 );
+    pose = GetTestPathStartPose( &paths[0] );
+    InitPathFollower( &follower, &paths[0], 0, &params );
+    ck_assert_int_eq(0, PrefetchPath( &prefetch, wps[1], 6, &paths[0] ));
+
+    // The control loop only ever polls: when a route is done it moves on to the next if that has been built, and otherwise
+    // keeps ticking.
+    for ( tick = 0; tick < 6000; tick++ ) {
+        if ( PathFollowerIsFinished( &follower ) ) {
+            if ( route == 2 ) {
+                break;
+            }
+            if ( !TakePrefetchedPath( &prefetch, &paths[route + 1] ) ) {
+                waits += 1;
+                sched_yield();
+            } else {
+                route += 1;
+                SetPathFollowerPath( &follower, &paths[route] );
+                if ( route < 2 ) {
+                    ck_assert_int_eq(0, PrefetchPath( &prefetch, wps[route + 1], 6, &paths[route] ));
+                }
+            }
+        }
+        command = GetPathFollowerUpdate( &follower, tick * dt, displacement, command.dx_in, &pose );
+        StepTestRobot( &command, &pose, &displacement, dt );
+    }
+
+    ck_assert_int_eq(2, route);
+    ck_assert_int_eq(1, PathFollowerIsFinished( &follower ));
+    ck_assert_double_eq_tol(1800.0, pose.translation.x_in, 1.0);
+    ck_assert_double_eq_tol(288.0, pose.translation.y_in, 1.0);
+    ck_assert_int_lt(waits, 100);
+
+    DestroyPathPrefetch( &prefetch );
+    for ( route = 0; route < 3; route++ ) {
+        ClearPath( &paths[route] );
+    }
+    ClearPathFollower( &follower );
+
+} END_TEST
+
+
+Suite *pathPrefetch_suite(void) {
+    Suite *s;
+    TCase *tc;
+
+    s = suite_create("PathPrefetch");
+    tc = tcase_create("Core");
+
+    tcase_add_test(tc, test_PrefetchPathMatchesBuild);
+    tcase_add_test(tc, test_PrefetchPathSequence);
+    suite_add_tcase(s, tc);
+    return s;
+}
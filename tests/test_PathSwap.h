@@ -0,0 +1,126 @@
+#include <check.h>
+#include <math.h>
+#include <pthread.h>
+#include "../path/Path.h"
+#include "test_Helpers.h"
+
+#define PATH_SWAP_STRESS_PATHS 200
+
+
+pathSegmentsList_t BuildSwapTestPath (double x, double y, double dx, double dy) {
+    waypoint_t waypoints[3] = {{{x, y}, 0.0, 60.0}, {{x + dx, y}, 20.0, 60.0}, {{x + dx, y + dy}, 0.0, 60.0}};
+    waypoint_t *wps[3] = {&waypoints[0], &waypoints[1], &waypoints[2]};
+
+    return BuildPathFromWaypoints( wps, 3 );
+}
+
+
+START_TEST(test_AdoptPublishedPath) {
+    pathFollowerParams_t params = GetTestFollowerParams();
+    pathFollower_t follower;
+    pathSegmentsList_t path;
+    pathSwap_t swap;
+    transform2d_t pose = {{0.0, 0.0}, {0.0, 1.0}};
+    twist2d_t command = {0.0, 0.0, 0.0};
+    double displacement = 0.0, speedBefore, swapY;
+    int tick;
+
+    InitPathSwap(&swap);
+    path = BuildSwapTestPath( 0.0, 0.0, 200.0, 200.0 );
+    InitPathFollower( &follower, &path, 0, &params );
+    ck_assert_int_eq(0, AdoptPublishedPath( &swap, &follower ));
+
+    ck_assert_int_eq(0, PublishPath( &swap, &path ));
+    ck_assert_ptr_null(path.head);
+    ck_assert_int_eq(1, AdoptPublishedPath( &swap, &follower ));
+    ck_assert_int_eq(0, AdoptPublishedPath( &swap, &follower ));
+
+    tick = DriveTestRobot( &follower, &command, &pose, &displacement, 0, 150, 0.01 );
+    speedBefore = command.dx_in;
+    swapY = pose.translation.y_in;
+    ck_assert_double_gt(speedBefore, 30.0);
+
+    // Re-route straight ahead of where the robot is now, without stopping.
+    path = BuildSwapTestPath( pose.translation.x_in, pose.translation.y_in, 150.0, -100.0 );
+    ck_assert_int_eq(0, PublishPath( &swap, &path ));
+    ck_assert_int_eq(0, ReclaimRetiredPaths( &swap ));
+    ck_assert_int_eq(1, AdoptPublishedPath( &swap, &follower ));
+    command = GetPathFollowerUpdate( &follower, tick * 0.01, displacement, command.dx_in, &pose );
+    ck_assert_double_gt(command.dx_in, 0.9 * speedBefore);
+    ck_assert_int_eq(1, ReclaimRetiredPaths( &swap ));
+
+    for ( ; tick < 2000 && !PathFollowerIsFinished( &follower ); tick++ ) {
+        StepTestRobot( &command, &pose, &displacement, 0.01 );
+        command = GetPathFollowerUpdate( &follower, tick * 0.01, displacement, command.dx_in, &pose );
+    }
+    ck_assert_int_eq(1, PathFollowerIsFinished( &follower ));
+    ck_assert_double_lt(fabs( pose.translation.y_in - ( swapY - 100.0 ) ), 6.0);
+    ck_assert_int_eq(2, swap.swaps);
+
+    DestroyPathSwap(&swap);
+    ClearPathFollower( &follower );
+
+} END_TEST
+
+
+void * PathSwapPlanner (void *arg) {
+    pathSwap_t *swap = arg;
+    pathSegmentsList_t path;
+    int i;
+
+    for ( i = 0; i < PATH_SWAP_STRESS_PATHS; i++ ) {
+        path = BuildSwapTestPath( 0.0, 0.0, 100.0 + i, 50.0 );
+        PublishPath( swap, &path );
+    }
+    return NULL;
+}
+
+
+START_TEST(test_PathSwapStress) {
+    pathFollowerParams_t params = GetTestFollowerParams();
+    pathFollower_t follower;
+    pathSegmentsList_t path;
+    pathSwap_t swap;
+    pthread_t planner;
+    transform2d_t pose = {{0.0, 0.0}, {0.0, 1.0}};
+    twist2d_t command = {0.0, 0.0, 0.0};
+    double displacement = 0.0;
+    int tick;
+
+    // The controller keeps following (and consuming) whatever path is newest while the planner publishes over it.
+    InitPathSwap(&swap);
+    path = BuildSwapTestPath( 0.0, 0.0, 100.0, 50.0 );
+    PublishPath( &swap, &path );
+    InitPathFollower( &follower, NULL, 0, &params );
+    ck_assert_int_eq(1, AdoptPublishedPath( &swap, &follower ));
+
+    pthread_create(&planner, NULL, PathSwapPlanner, &swap);
+    for ( tick = 0; tick < 3000; tick++ ) {
+        AdoptPublishedPath( &swap, &follower );
+        command = GetPathFollowerUpdate( &follower, tick * 0.01, displacement, command.dx_in, &pose );
+        StepTestRobot( &command, &pose, &displacement, 0.01 );
+    }
+    pthread_join(planner, NULL);
+    AdoptPublishedPath( &swap, &follower );
+    ck_assert_int_ge(swap.swaps, 2);
+    ck_assert_double_eq(100.0 + PATH_SWAP_STRESS_PATHS - 1, swap.current->segments.tail->segment.end.x_in);
+
+    DestroyPathSwap(&swap);
+    ClearPathFollower( &follower );
+
+} END_TEST
+
+
+Suite *pathSwap_suite(void) {
+    Suite *s;
+    TCase *tc;
+
+    s = suite_create("PathSwap");
+    tc = tcase_create("Core");
+
+    tcase_add_test(tc, test_AdoptPublishedPath);
+    tcase_add_test(tc, test_PathSwapStress);
+    tcase_set_timeout(tc, 30);
+    suite_add_tcase(s, tc);
+    return s;
+}
@@ -0,0 +1,94 @@
+#include <check.h>
+#include <math.h>
+#include <pthread.h>
+#include "../robot/PoseChannel.h"
+
+#define POSE_CHANNEL_STRESS_COUNT 2000000
+
+
+START_TEST(test_ReadLatestPose) {
+    poseChannel_t channel;
+    timestampedPose_t sample;
+    transform2d_t pose = {{1.0, 2.0}, {0.0, 1.0}};
+
+    InitPoseChannel(&channel);
+    ck_assert_int_eq(0, ReadLatestPose(&channel, &sample));
+    ck_assert_int_eq(0, sample.sequence);
+
+    PublishPose(&channel, &pose, 0.5);
+    pose.translation.x_in = 3.0;
+    PublishPose(&channel, &pose, 0.75);
+    ck_assert_int_eq(1, ReadLatestPose(&channel, &sample));
+    ck_assert_int_eq(2, sample.sequence);
+    ck_assert_double_eq(3.0, sample.pose.translation.x_in);
+    ck_assert_double_eq(0.75, sample.t);
+
+    // Nothing new, the same pose is returned again.
+    ck_assert_int_eq(0, ReadLatestPose(&channel, &sample));
+    ck_assert_int_eq(2, sample.sequence);
+
+} END_TEST
+
+
+void * PoseChannelWriter (void *arg) {
+    poseChannel_t *channel = arg;
+    transform2d_t pose;
+    uint32_t i;
+
+    for ( i = 1; i <= POSE_CHANNEL_STRESS_COUNT; i++ ) {
+        pose.translation.x_in = i;
+        pose.translation.y_in = -2.0 * i;
+        pose.rotation.sinTheta_rad = i + 0.5;
+        pose.rotation.cosTheta_rad = i + 0.25;
+        PublishPose( channel, &pose, i * 0.001 );
+    }
+    return NULL;
+}
+
+
+START_TEST(test_PoseChannelStress) {
+    poseChannel_t channel;
+    timestampedPose_t sample;
+    pthread_t writer;
+    uint32_t lastSequence = 0;
+    long reads = 0, fresh = 0;
+    double i;
+
+    // Every field of a published pose is derived from its sequence number, so a torn read shows up as a mismatch.
+    InitPoseChannel(&channel);
+    pthread_create(&writer, NULL, PoseChannelWriter, &channel);
+    while ( lastSequence < POSE_CHANNEL_STRESS_COUNT ) {
+        fresh += ReadLatestPose(&channel, &sample);
+        reads++;
+        if ( sample.sequence == 0 ) {
+            continue;
+        }
+        i = sample.sequence;
+        ck_assert_uint_ge(sample.sequence, lastSequence);
+        ck_assert_double_eq(i, sample.pose.translation.x_in);
+        ck_assert_double_eq(-2.0 * i, sample.pose.translation.y_in);
+        ck_assert_double_eq(i + 0.5, sample.pose.rotation.sinTheta_rad);
+        ck_assert_double_eq(i + 0.25, sample.pose.rotation.cosTheta_rad);
+        ck_assert_double_eq(i * 0.001, sample.t);
+        lastSequence = sample.sequence;
+    }
+    pthread_join(writer, NULL);
+    ck_assert_int_gt(fresh, 0);
+    ck_assert_int_ge(reads, fresh);
+
+} END_TEST
+
+
+Suite *poseChannel_suite(void) {
+    Suite *s;
+    TCase *tc;
+
+    s = suite_create("PoseChannel");
+    tc = tcase_create("Core");
+
+    tcase_set_timeout(tc, 30);
+    tcase_add_test(tc, test_ReadLatestPose);
+    tcase_add_test(tc, test_PoseChannelStress);
+    suite_add_tcase(s, tc);
+    return s;
+}
@@ -46,6 +46,19 @@ START_TEST(test_SetProfileFollowerGoalAndConstraints) {
 } END_TEST
 
 
+START_TEST(test_SetProfileFollowerReplanTolerance) {
+    profileFollower_t *profileFollower;
+
+    // Off by default, so every goal change regenerates the profile.
+    profileFollower = CreateProfileFollower();
+    ck_assert_double_eq(0.0, profileFollower->setpointGenerator->goalReplanTolerance);
+
+    SetProfileFollowerReplanTolerance(profileFollower, 1.5);
+    ck_assert_double_eq(1.5, profileFollower->setpointGenerator->goalReplanTolerance);
+
+} END_TEST
+
+
 START_TEST(test_ClearProfileFollower) {
     profileFollower_t *profileFollower;
 
@@ -122,6 +135,7 @@ Suite *profileFollower_suite(void) {
 
     tcase_add_test(tc, test_SetProfileFollowerGains);
     tcase_add_test(tc, test_SetProfileFollowerGoalAndConstraints);
+    tcase_add_test(tc, test_SetProfileFollowerReplanTolerance);
     tcase_add_test(tc, test_ClearProfileFollower);
     tcase_add_test(tc, test_ProfileFollowerUpdate);
     tcase_add_test(tc, test_IsProfileFinished);
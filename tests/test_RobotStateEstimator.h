@@ -0,0 +1,343 @@
+#include <check.h>
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include "../robot/RobotStateEstimator.h"
+#include "../sim/Sim.h"
+#include "../utils/AllocTrack.h"
+
+#define POSE_HISTORY_STRESS_COUNT 200000
+
+// The robot driving a 60 in radius circle at 30 ips, where it is at time t.
+transform2d_t CirclePoseAtTime (double t) {
+    twist2d_t twist = {30.0 * t, 0.0, 0.5 * t};
+
+    return Exp( &twist );
+}
+
+
+// How far a pose's heading is off the true one, in radians.
+double GetHeadingError (transform2d_t *pose, transform2d_t *truth) {
+    rotation2d_t inverse, offset;
+
+    inverse = RotationInverse( &truth->rotation );
+    offset = RotateAbyB( &pose->rotation, &inverse );
+    return fabs( atan2( offset.sinTheta_rad, offset.cosTheta_rad ) );
+}
+
+
+START_TEST(test_GetPoseAtTime) {
+    poseHistory_t *history;
+    transform2d_t pose, expected;
+    allocStats_t stats;
+    double t;
+    int k;
+
+    history = malloc( sizeof( poseHistory_t ) );
+    InitPoseHistory( history );
+    ck_assert_int_eq(-1, GetPoseAtTime( history, 0.0, &pose ));
+
+    // Ten times round the history at 100 Hz.
+    for ( k = 0; k < 10 * POSE_HISTORY_SIZE; k++ ) {
+        pose = CirclePoseAtTime( k * 0.01 );
+        RecordPose( history, &pose, k * 0.01 );
+    }
+
+    // Between two poses the robot was on the arc joining them, so on a circle the interpolation is exact.
+    StartAllocTracking();
+    for ( k = 0; k < 1000; k++ ) {
+        t = ( 9 * POSE_HISTORY_SIZE + 1 ) * 0.01 + ( POSE_HISTORY_SIZE - 2 ) * 0.01 * k / 1000.0;
+        expected = CirclePoseAtTime( t );
+        ck_assert_int_eq(0, GetPoseAtTime( history, t, &pose ));
+        ck_assert_double_eq_tol(expected.translation.x_in, pose.translation.x_in, 1E-9);
+        ck_assert_double_eq_tol(expected.translation.y_in, pose.translation.y_in, 1E-9);
+        ck_assert_double_eq_tol(expected.rotation.sinTheta_rad, pose.rotation.sinTheta_rad, 1E-9);
+        ck_assert_double_eq_tol(expected.rotation.cosTheta_rad, pose.rotation.cosTheta_rad, 1E-9);
+    }
+    StopAllocTracking();
+    GetAllocStats( &stats );
+    ck_assert_int_eq(0, stats.allocations);
+
+    // After the newest pose it is the newest, before the oldest kept the oldest.
+    expected = CirclePoseAtTime( ( 10 * POSE_HISTORY_SIZE - 1 ) * 0.01 );
+    ck_assert_int_eq(0, GetPoseAtTime( history, 1E6, &pose ));
+    ck_assert_double_eq(expected.translation.x_in, pose.translation.x_in);
+    expected = CirclePoseAtTime( ( 9 * POSE_HISTORY_SIZE + 1 ) * 0.01 );
+    ck_assert_int_eq(-1, GetPoseAtTime( history, 0.0, &pose ));
+    ck_assert_double_eq(expected.translation.x_in, pose.translation.x_in);
+    ck_assert_int_eq(0, GetPoseAtTime( history, ( 9 * POSE_HISTORY_SIZE + 1 ) * 0.01, &pose ));
+    ck_assert_double_eq(expected.translation.x_in, pose.translation.x_in);
+    free( history );
+
+} END_TEST
+
+
+START_TEST(test_UpdateRobotStateEstimator) {
+    robotStateEstimator_t *estimator;
+    poseChannel_t channel;
+    timestampedPose_t sample;
+    transform2d_t start = {{10.0, 20.0}, {1.0, 0.0}}, pose;
+    double left = 100.0, right = -50.0;
+    int k;
+
+    estimator = malloc( sizeof( robotStateEstimator_t ) );
+    InitPoseChannel( &channel );
+    InitRobotStateEstimator( estimator, 24.0, &channel );
+    ResetRobotStateEstimator( estimator, &start, 1.0, left, right );
+
+    // Straight ahead, facing +y.
+    for ( k = 1; k <= 10; k++ ) {
+        left += 6.0;
+        right += 6.0;
+        pose = UpdateRobotStateEstimator( estimator, 1.0 + 0.01 * k, left, right );
+    }
+    ck_assert_double_eq_tol(10.0, pose.translation.x_in, 1E-9);
+    ck_assert_double_eq_tol(80.0, pose.translation.y_in, 1E-9);
+
+    // Left wheels 12 in behind the right ones is half a radian to the left, on a 24 in radius circle for a 24 in track:
+    // after 2 pi radians the robot is back where it started the turn.
+    for ( k = 1; k <= 100; k++ ) {
+        left += 2.0 * M_PI * 12.0 / 100.0;
+        right += 2.0 * M_PI * 36.0 / 100.0;
+        pose = UpdateRobotStateEstimator( estimator, 1.1 + 0.01 * k, left, right );
+    }
+    ck_assert_double_eq_tol(10.0, pose.translation.x_in, 1E-9);
+    ck_assert_double_eq_tol(80.0, pose.translation.y_in, 1E-9);
+    ck_assert_double_eq_tol(1.0, pose.rotation.sinTheta_rad, 1E-9);
+
+    // Half way round the turn it was on the far side of the circle, 48 in to the left, facing back.
+    ck_assert_int_eq(0, GetPoseAtTime( &estimator->history, 1.6, &pose ));
+    ck_assert_double_eq_tol(-38.0, pose.translation.x_in, 1E-9);
+    ck_assert_double_eq_tol(80.0, pose.translation.y_in, 1E-9);
+    ck_assert_double_eq_tol(-1.0, pose.rotation.sinTheta_rad, 1E-9);
+    ck_assert_int_eq(-1, GetPoseAtTime( &estimator->history, 0.5, &pose ));
+
+    // Every pose was published.
+    ck_assert_int_eq(1, ReadLatestPose( &channel, &sample ));
+    ck_assert_int_eq(111, sample.sequence);
+    ck_assert_double_eq(2.1, sample.t);
+    free( estimator );
+
+} END_TEST
+
+START_TEST(test_UpdatePoseFilter) {
+    robotStateEstimator_t *estimator;
+    poseFilter_t filter;
+    transform2d_t start = {{10.0, 20.0}, {1.0, 0.0}}, pose, expected;
+    double left = 100.0, right = -50.0, t, variance;
+    int k;
+
+    // Exact wheels and an exact gyro: the filter drives the same arcs as the odometry, and stays certain of its pose.
+    estimator = malloc( sizeof( robotStateEstimator_t ) );
+    InitRobotStateEstimator( estimator, 24.0, NULL );
+    ResetRobotStateEstimator( estimator, &start, 1.0, left, right );
+    InitPoseFilter( &filter, 24.0, 0.0, 0.0 );
+    ResetPoseFilter( &filter, &start, 1.0, left, right );
+    for ( k = 1; k <= 300; k++ ) {
+        t = 1.0 + 0.01 * k;
+        left += 6.0 - 3.0 * sin( 0.05 * k );
+        right += 6.0 + 3.0 * sin( 0.05 * k );
+        expected = UpdateRobotStateEstimator( estimator, t, left, right );
+        pose = UpdatePoseFilter( &filter, t, left, right, 6.0 * sin( 0.05 * k ) / 24.0 / 0.01 );
+        ck_assert_double_eq_tol(expected.translation.x_in, pose.translation.x_in, 1E-9);
+        ck_assert_double_eq_tol(expected.translation.y_in, pose.translation.y_in, 1E-9);
+        ck_assert_double_eq_tol(expected.rotation.sinTheta_rad, pose.rotation.sinTheta_rad, 1E-9);
+        ck_assert_double_eq_tol(expected.rotation.cosTheta_rad, pose.rotation.cosTheta_rad, 1E-9);
+    }
+    ck_assert_double_eq(0.0, filter.covariance[0][0]);
+    ck_assert_double_eq(0.0, filter.covariance[2][2]);
+
+    // With uncertain wheels the covariance grows along the way, fastest across the direction of travel once the heading
+    // is uncertain.  A turn measurement pulls the turn, and the position it swung, towards it; a heading measurement
+    // shrinks the covariance further.
+    InitPoseFilter( &filter, 24.0, 0.01, 0.0 );
+    PredictPoseFilter( &filter, 1.0, 100.0, 100.0 );
+    ck_assert_double_eq(filter.covariance[0][2], filter.covariance[2][0]);
+    ck_assert_double_eq(filter.covariance[0][1], filter.covariance[1][0]);
+    ck_assert_double_gt(filter.covariance[1][1], filter.covariance[0][0]);
+    ck_assert_double_gt(filter.covariance[1][2], 0.0);
+    variance = filter.covariance[2][2];
+    CorrectPoseFilterTurn( &filter, 0.01, variance );
+    ck_assert_double_eq_tol(0.005, filter.theta_rad, 1E-12);
+    ck_assert_double_gt(filter.y_in, 0.0);
+    ck_assert_double_eq_tol(0.5 * variance, filter.covariance[2][2], 1E-12);
+    CorrectPoseFilterHeading( &filter, 0.1, 1E-4 );
+    ck_assert_double_gt(filter.theta_rad, 0.0);
+    ck_assert_double_lt(filter.theta_rad, 0.1);
+    ck_assert_double_lt(filter.covariance[2][2], 1E-4);
+    free( estimator );
+
+} END_TEST
+
+
+START_TEST(test_PoseFilterAccuracy) {
+    robotStateEstimator_t *estimator;
+    poseFilter_t filter;
+    simRandom_t random;
+    allocStats_t stats;
+    transform2d_t truth, odometry, fused, gyro, motion;
+    translation2d_t error;
+    twist2d_t delta;
+    double left, right, travelLeft, travelRight, groundLeft, groundRight, gyroRate_rps, turn_rps, t, dt = 0.01;
+    double odometryError[2] = {0.0, 0.0}, gyroError[2] = {0.0, 0.0}, fusedError[2] = {0.0, 0.0};
+    int run, k, ticks = 6000;
+
+    // Sixteen runs of a minute weaving about at 48 ips.  Each wheel's travel on the ground is off the encoder's by 3% (scrub
+    // and bumps); the gyro reads the robot's true turn rate with 0.085 rad/s of noise and a slow drift.  On their own the
+    // two turns are about as good as each other, and they are compared with the filter fusing them.  Driving on the gyro
+    // alone is dead reckoning with the encoders' distance and the gyro's turn.
+    estimator = malloc( sizeof( robotStateEstimator_t ) );
+    StartAllocTracking();
+    for ( run = 0; run < 16; run++ ) {
+        InitRobotStateEstimator( estimator, 24.0, NULL );
+        InitPoseFilter( &filter, 24.0, 4.3E-4, 7.2E-5 );
+        SeedSimRandom( &random, run + 1 );
+        truth = (transform2d_t) {{0.0, 0.0}, {0.0, 1.0}};
+        gyro = truth;
+        left = 0.0;
+        right = 0.0;
+        for ( k = 1; k <= ticks; k++ ) {
+            t = k * dt;
+            turn_rps = 0.8 * sin( 0.5 * t );
+            travelLeft = ( 48.0 - 12.0 * turn_rps ) * dt;
+            travelRight = ( 48.0 + 12.0 * turn_rps ) * dt;
+            groundLeft = travelLeft * ( 1.0 + 0.03 * SimRandomGaussian( &random ) );
+            groundRight = travelRight * ( 1.0 + 0.03 * SimRandomGaussian( &random ) );
+            delta.dx_in = 0.5 * ( groundLeft + groundRight );
+            delta.dy_in = 0.0;
+            delta.dtheta_rad = ( groundRight - groundLeft ) / 24.0;
+            motion = Exp( &delta );
+            truth = TranformAByB( &truth, &motion );
+            gyroRate_rps = delta.dtheta_rad / dt + 0.085 * SimRandomGaussian( &random ) + 0.0005;
+
+            left += travelLeft;
+            right += travelRight;
+            odometry = UpdateRobotStateEstimator( estimator, t, left, right );
+            fused = UpdatePoseFilter( &filter, t, left, right, gyroRate_rps );
+            delta.dx_in = 0.5 * ( travelLeft + travelRight );
+            delta.dtheta_rad = gyroRate_rps * dt;
+            motion = Exp( &delta );
+            gyro = TranformAByB( &gyro, &motion );
+
+            error = TranslationDelta( &truth.translation, &odometry.translation );
+            odometryError[0] += TranslationNormal( &error );
+            odometryError[1] += GetHeadingError( &odometry, &truth );
+            error = TranslationDelta( &truth.translation, &gyro.translation );
+            gyroError[0] += TranslationNormal( &error );
+            gyroError[1] += GetHeadingError( &gyro, &truth );
+            error = TranslationDelta( &truth.translation, &fused.translation );
+            fusedError[0] += TranslationNormal( &error );
+            fusedError[1] += GetHeadingError( &fused, &truth );
+        }
+    }
+    StopAllocTracking();
+    GetAllocStats( &stats );
+    ck_assert_int_eq(0, stats.allocations);
+
+    // Weighing the two turns by their variances, the fused heading and the position it steers are well ahead of either on
+    // its own.
+    ck_assert_double_lt(fusedError[1], 0.75 * odometryError[1]);
+    ck_assert_double_lt(fusedError[1], 0.75 * gyroError[1]);
+    ck_assert_double_lt(fusedError[0], 0.75 * odometryError[0]);
+    ck_assert_double_lt(fusedError[0], 0.85 * gyroError[0]);
+    free( estimator );
+
+} END_TEST
+
+
+START_TEST(test_PoseFilterTurnWeights) {
+    poseFilter_t filter;
+    double t, dt = 0.01;
+    int k;
+
+    // Straight ahead an inch a wheel a step, the wheels' and the gyro's turns each 1E-4 rad^2 uncertain a step, the gyro
+    // reading a constant 0.002 rad/s.  The filter meets them half way every step: it turns by half the gyro's turn and its
+    // heading variance grows by half of either's.
+    InitPoseFilter( &filter, 24.0, 0.0288, 1E-2 );
+    for ( k = 1; k <= 100; k++ ) {
+        t = k * dt;
+        UpdatePoseFilter( &filter, t, 100.0 * t, 100.0 * t, 0.002 );
+    }
+    ck_assert_double_eq_tol(0.5 * 0.002, filter.theta_rad, 1E-12);
+    ck_assert_double_eq_tol(100 * 0.5E-4, filter.covariance[2][2], 1E-12);
+
+} END_TEST
+
+
+typedef struct poseHistoryWriter {
+    poseHistory_t history;
+    _Atomic int done;
+} poseHistoryWriter_t;
+
+
+void * PoseHistoryWriter (void *arg) {
+    poseHistoryWriter_t *writer = arg;
+    transform2d_t pose;
+    int k;
+
+    // Every pose is on the line y = -2x, facing along it, x the time, so a torn or overwritten read shows up off the line.
+    pose.rotation.sinTheta_rad = -2.0 / sqrt( 5.0 );
+    pose.rotation.cosTheta_rad = 1.0 / sqrt( 5.0 );
+    for ( k = 0; k < POSE_HISTORY_STRESS_COUNT; k++ ) {
+        pose.translation.x_in = k;
+        pose.translation.y_in = -2.0 * k;
+        RecordPose( &writer->history, &pose, k );
+        if ( k % 64 == 0 ) {
+            sched_yield();
+        }
+    }
+    atomic_store( &writer->done, 1 );
+    return NULL;
+}
+
+
+START_TEST(test_PoseHistoryStress) {
+    poseHistoryWriter_t *writer;
+    transform2d_t pose;
+    pthread_t thread;
+    uint32_t count;
+    double t;
+    long reads = 0;
+
+    writer = malloc( sizeof( poseHistoryWriter_t ) );
+    InitPoseHistory( &writer->history );
+    atomic_init( &writer->done, 0 );
+    pthread_create( &thread, NULL, PoseHistoryWriter, writer );
+
+    // Ask for times just inside the oldest end of the history, where the writer keeps writing over entries.
+    while ( !atomic_load( &writer->done ) ) {
+        count = atomic_load( &writer->history.count );
+        if ( count < 2 ) {
+            continue;
+        }
+        t = ( count > POSE_HISTORY_SIZE ) ? count - POSE_HISTORY_SIZE + 1.5 : 0.5;
+        if ( GetPoseAtTime( &writer->history, t, &pose ) ) {
+            t = pose.translation.x_in;
+        }
+        ck_assert_double_eq_tol(-2.0 * pose.translation.x_in, pose.translation.y_in, 1E-6);
+        ck_assert_double_eq_tol(t, pose.translation.x_in, 1E-6);
+        reads += 1;
+    }
+    pthread_join( thread, NULL );
+    ck_assert_int_gt(reads, 0);
+    free( writer );
+
+} END_TEST
+
+
+Suite *robotStateEstimator_suite(void) {
+    Suite *s;
+    TCase *tc;
+
+    s = suite_create("RobotStateEstimator");
+    tc = tcase_create("Core");
+
+    tcase_add_test(tc, test_GetPoseAtTime);
+    tcase_add_test(tc, test_UpdateRobotStateEstimator);
+    tcase_add_test(tc, test_UpdatePoseFilter);
+    tcase_add_test(tc, test_PoseFilterTurnWeights);
+    tcase_add_test(tc, test_PoseFilterAccuracy);
+    tcase_add_test(tc, test_PoseHistoryStress);
+    suite_add_tcase(s, tc);
+    return s;
+}
@@ -0,0 +1,164 @@
+#include <check.h>
+#include <math.h>
+#include <stdlib.h>
+#include "../path/Path.h"
+#include "../utils/AllocTrack.h"
+#include "test_Helpers.h"
+
+// Three routes end to end: the first runs on into the second in the same direction, the second stops where the third
+// turns away.
+static const waypoint_t kSequencerTestRoutes[3][3] = {
+    {{{0.0, 0.0}, 0.0, 60.0}, {{150.0, 0.0}, 24.0, 60.0}, {{300.0, 90.0}, 0.0, 60.0}},
+    {{{300.0, 90.0}, 0.0, 60.0}, {{450.0, 180.0}, 24.0, 60.0}, {{600.0, 180.0}, 0.0, 60.0}},
+    {{{600.0, 180.0}, 0.0, 60.0}, {{750.0, 180.0}, 24.0, 60.0}, {{900.0, 90.0}, 0.0, 60.0}},
+};
+
+
+pathSegmentsList_t BuildSequencerTestRoute (int route, waypoint_t *waypoints) {
+    waypoint_t *wps[3];
+    int k;
+
+    for ( k = 0; k < 3; k++ ) {
+        waypoints[k] = kSequencerTestRoutes[route][k];
+        wps[k] = &waypoints[k];
+    }
+    return BuildPathFromWaypoints( wps, 3 );
+}
+
+
+// Drives the three routes with the first handing off at the given speed.  Returns the ticks taken, and the slowest the
+// robot went within 20 in of each join.
+int DriveSequencerTestRoutes (double handoffSpeed, double minJoinSpeed[2], allocStats_t *stats) {
+    pathFollowerParams_t params = GetTestFollowerParams();
+    translation2d_t joins[2] = {{300.0, 90.0}, {600.0, 180.0}};
+    waypoint_t waypoints[3][3];
+    pathSegmentsList_t paths[3];
+    routeSequencer_t sequencer;
+    pathFollower_t follower;
+    transform2d_t pose;
+    translation2d_t offset;
+    twist2d_t command = {0.0, 0.0, 0.0};
+    double displacement = 0.0, dt = 0.01;
+    int tick, i;
+
+    for ( i = 0; i < 3; i++ ) {
+        paths[i] = BuildSequencerTestRoute( i, waypoints[i] );
+    }
+    InitPathFollower( &follower, NULL, 0, &params );
+    InitRouteSequencer( &sequencer, &follower );
+    ck_assert_int_eq(0, AddSequencerRoute( &sequencer, &paths[0], handoffSpeed ));
+    ck_assert_int_eq(0, AddSequencerRoute( &sequencer, &paths[1], 0.0 ));
+    ck_assert_int_eq(0, AddSequencerRoute( &sequencer, &paths[2], 0.0 ));
+    pose = GetTestPathStartPose( &paths[0] );
+    minJoinSpeed[0] = minJoinSpeed[1] = 1E9;
+
+    for ( tick = 0; tick < 6000 && !RouteSequencerIsFinished( &sequencer ); tick++ ) {
+        if ( tick == 10 ) {
+            StartAllocTracking();
+        }
+        command = GetRouteSequencerUpdate( &sequencer, tick * dt, displacement, command.dx_in, &pose );
+        StepTestRobot( &command, &pose, &displacement, dt );
+        for ( i = 0; i < 2; i++ ) {
+            offset = TranslationDelta( &pose.translation, &joins[i] );
+            if ( TranslationNormal( &offset ) < 20.0 ) {
+                minJoinSpeed[i] = fmin( minJoinSpeed[i], command.dx_in );
+            }
+        }
+    }
+    StopAllocTracking();
+    GetAllocStats( stats );
+
+    ck_assert_int_eq(1, RouteSequencerIsFinished( &sequencer ));
+    ck_assert_int_eq(2, sequencer.current);
+    ck_assert_double_eq_tol(900.0, pose.translation.x_in, 1.0);
+    ck_assert_double_eq_tol(90.0, pose.translation.y_in, 1.0);
+
+    for ( i = 0; i < 3; i++ ) {
+        ClearPath( &paths[i] );
+    }
+    ClearPathFollower( &follower );
+
+    return tick;
+}
+
+
+START_TEST(test_AddSequencerRoute) {
+    pathFollowerParams_t params = GetTestFollowerParams();
+    waypoint_t waypoints[2][3];
+    waypoint_t *wps[3];
+    pathSegmentsList_t first, second, built, empty = {NULL, NULL, 0};
+    routeSequencer_t sequencer;
+    pathFollower_t follower;
+    motionState_t endState;
+    int k;
+
+    first = BuildSequencerTestRoute( 0, waypoints[0] );
+    second = BuildSequencerTestRoute( 1, waypoints[1] );
+    InitPathFollower( &follower, NULL, 0, &params );
+    InitRouteSequencer( &sequencer, &follower );
+    ck_assert_int_eq(1, RouteSequencerIsFinished( &sequencer ));
+    ck_assert_int_eq(-1, AddSequencerRoute( &sequencer, &empty, 0.0 ));
+    ck_assert_int_eq(0, AddSequencerRoute( &sequencer, &first, 40.0 ));
+    ck_assert_ptr_eq(&first, follower.steeringController.path);
+    ck_assert_int_eq(0, AddSequencerRoute( &sequencer, &second, 0.0 ));
+
+    // The first route now ends at the handoff speed and the second is planned from there, as if built from that state.
+    endState = GetLastMotionState( &first );
+    ck_assert_double_eq_tol(40.0, endState.vel, 1E-9);
+    for ( k = 0; k < 3; k++ ) {
+        wps[k] = &waypoints[1][k];
+    }
+    built = BuildPathFromState( wps, 3, &endState );
+    AssertPathsEqual( &built, &second );
+    ClearPath( &built );
+
+    for ( k = 2; k < ROUTE_SEQUENCER_MAX_ROUTES; k++ ) {
+        ck_assert_int_eq(0, AddSequencerRoute( &sequencer, &second, 0.0 ));
+    }
+    ck_assert_int_eq(-1, AddSequencerRoute( &sequencer, &second, 0.0 ));
+    ck_assert_ptr_eq(&first, follower.steeringController.path);
+
+    ClearPath( &first );
+    ClearPath( &second );
+    ClearPathFollower( &follower );
+
+} END_TEST
+
+
+START_TEST(test_RouteSequencerHandoff) {
+    allocStats_t stats;
+    double carried[2], stopped[2];
+    int carriedTicks, stoppedTicks;
+
+    // Carrying speed through the first join the robot never slows much there, and it still stops at the second (down to the
+    // follower's goal speed tolerance, after which it moves on).
+    carriedTicks = DriveSequencerTestRoutes( 40.0, carried, &stats );
+    if ( stats.allocations || stats.frees ) {
+        PrintAllocSites();
+    }
+    ck_assert_int_eq(0, stats.allocations);
+    ck_assert_int_eq(0, stats.frees);
+    ck_assert_double_gt(carried[0], 30.0);
+    ck_assert_double_lt(carried[1], 12.0);
+
+    // Stopping at both joins takes longer.
+    stoppedTicks = DriveSequencerTestRoutes( 0.0, stopped, &stats );
+    ck_assert_double_lt(stopped[0], 12.0);
+    ck_assert_double_lt(stopped[1], 12.0);
+    ck_assert_int_lt(carriedTicks, stoppedTicks);
+
+} END_TEST
+
+
+Suite *routeSequencer_suite(void) {
+    Suite *s;
+    TCase *tc;
+
+    s = suite_create("RouteSequencer");
+    tc = tcase_create("Core");
+
+    tcase_add_test(tc, test_AddSequencerRoute);
+    tcase_add_test(tc, test_RouteSequencerHandoff);
+    suite_add_tcase(s, tc);
+    return s;
+}
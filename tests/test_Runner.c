@@ -6,6 +6,22 @@
 #include "test_MotionProfileGenerator.h"
 #include "test_SetpointGenerator.h"
 #include "test_ProfileFollower.h"
+#include "test_FleetEngine.h"
+#include "test_PoseChannel.h"
+#include "test_PathSwap.h"
+#include "test_Instrument.h"
+#include "test_FlightRecorder.h"
+#include "test_Simulator.h"
+#include "test_Sweep.h"
+#include "test_AllocTrack.h"
+#include "test_Trajectory.h"
+#include "test_PathCache.h"
+#include "test_PathBuilder.h"
+#include "test_Path.h"
+#include "test_PathPrefetch.h"
+#include "test_RouteSequencer.h"
+#include "test_RobotStateEstimator.h"
+#include "test_ControlLoop.h"
 
 
 int main(void) {
@@ -19,6 +35,22 @@ int main(void) {
     srunner_add_suite(runner, motionProfileGenerator_suite());
     srunner_add_suite(runner, setpointGenerator_suite());
     srunner_add_suite(runner, profileFollower_suite());
+    srunner_add_suite(runner, fleetEngine_suite());
+    srunner_add_suite(runner, poseChannel_suite());
+    srunner_add_suite(runner, pathSwap_suite());
+    srunner_add_suite(runner, instrument_suite());
+    srunner_add_suite(runner, flightRecorder_suite());
+    srunner_add_suite(runner, simulator_suite());
+    srunner_add_suite(runner, sweep_suite());
+    srunner_add_suite(runner, allocTrack_suite());
+    srunner_add_suite(runner, trajectory_suite());
+    srunner_add_suite(runner, pathCache_suite());
+    srunner_add_suite(runner, pathBuilder_suite());
+    srunner_add_suite(runner, path_suite());
+    srunner_add_suite(runner, pathPrefetch_suite());
+    srunner_add_suite(runner, routeSequencer_suite());
+    srunner_add_suite(runner, robotStateEstimator_suite());
+    srunner_add_suite(runner, controlLoop_suite());
     srunner_set_fork_status(runner, CK_NOFORK);
     srunner_run_all(runner, CK_NORMAL);  
     no_failed = srunner_ntests_failed(runner); 
@@ -111,6 +111,95 @@ START_TEST(test_GetSetpoint) {
  } END_TEST
 
 
+START_TEST(test_GetSetpointIncremental) {
+    setpointGenerator_t setpointGenerator = kInvalidSetpointGenerator;
+    motionProfileConstraints_t constraints;
+    motionProfileGoal_t goalState;
+    motionProfileList_t expected;
+    motionState_t prevState;
+    setpoint_t setpoint;
+
+    constraints.maxAbsAcc = 10.0;
+    constraints.maxAbsVel = 5.0;
+    goalState.completionBehavior = VIOLATE_MAX_ACCEL;
+    goalState.maxAbsVel = 0.0;
+    goalState.pos = 20.0;
+    goalState.posTolerance = 0.05;
+    goalState.velTolerance = 0.1;
+    prevState.t = 0.0;
+    prevState.pos = 0.0;
+    prevState.vel = 0.0;
+    prevState.acc = 0.0;
+    SetGoalReplanTolerance(&setpointGenerator, 0.5);
+
+    // First call generates the whole profile.
+    setpoint = GetSetpoint(&setpointGenerator, &constraints, &goalState, &prevState, 1.0);
+    ck_assert_int_eq(1, setpointGenerator.fullRegenerations);
+    ck_assert_int_eq(0, setpointGenerator.incrementalRegenerations);
+    ck_assert_double_eq(5.0, setpoint.motionState.vel);
+
+    // Goal moves forward slightly while cruising.
+    prevState = setpoint.motionState;
+    goalState.pos = 20.3;
+    setpoint = GetSetpoint(&setpointGenerator, &constraints, &goalState, &prevState, 1.5);
+    ck_assert_int_eq(1, setpointGenerator.fullRegenerations);
+    ck_assert_int_eq(1, setpointGenerator.incrementalRegenerations);
+    expected = GenerateProfile(&constraints, &goalState, &prevState);
+    ck_assert_double_eq_tol(SegmentEnd( &expected.tail->segment ).t, SegmentEnd( &setpointGenerator.profile->tail->segment ).t, 1e-9);
+    ck_assert_double_eq_tol(20.3, SegmentEnd( &setpointGenerator.profile->tail->segment ).pos, 1e-9);
+    ck_assert_int_eq(1, IsProfileValid(setpointGenerator.profile));
+    ClearProfile(&expected);
+
+    // And back again, with a slower goal velocity.
+    prevState = setpoint.motionState;
+    goalState.pos = 20.0;
+    goalState.maxAbsVel = 1.0;
+    setpoint = GetSetpoint(&setpointGenerator, &constraints, &goalState, &prevState, 2.0);
+    ck_assert_int_eq(1, setpointGenerator.fullRegenerations);
+    ck_assert_int_eq(2, setpointGenerator.incrementalRegenerations);
+    expected = GenerateProfile(&constraints, &goalState, &prevState);
+    ck_assert_double_eq_tol(SegmentEnd( &expected.tail->segment ).t, SegmentEnd( &setpointGenerator.profile->tail->segment ).t, 1e-9);
+    ck_assert_double_eq_tol(1.0, SegmentEnd( &setpointGenerator.profile->tail->segment ).vel, 1e-9);
+    ClearProfile(&expected);
+
+    // The velocity limit drops while cruising, then rises again: the cruise drops to, or speeds up to, the new limit from
+    // where the robot is, as a new profile from there would.
+    prevState = setpoint.motionState;
+    constraints.maxAbsVel = 3.0;
+    setpoint = GetSetpoint(&setpointGenerator, &constraints, &goalState, &prevState, 2.5);
+    ck_assert_int_eq(1, setpointGenerator.fullRegenerations);
+    ck_assert_int_eq(3, setpointGenerator.incrementalRegenerations);
+    expected = GenerateProfile(&constraints, &goalState, &prevState);
+    ck_assert_double_eq_tol(SegmentEnd( &expected.tail->segment ).t, SegmentEnd( &setpointGenerator.profile->tail->segment ).t, 1e-9);
+    ck_assert_double_eq_tol(20.0, SegmentEnd( &setpointGenerator.profile->tail->segment ).pos, 1e-9);
+    ck_assert_double_eq_tol(3.0, setpoint.motionState.vel, 1e-9);
+    ck_assert_int_eq(1, IsProfileValid(setpointGenerator.profile));
+    ClearProfile(&expected);
+
+    prevState = setpoint.motionState;
+    setpoint = GetSetpoint(&setpointGenerator, &constraints, &goalState, &prevState, 3.0);
+    prevState = setpoint.motionState;
+    constraints.maxAbsVel = 4.0;
+    setpoint = GetSetpoint(&setpointGenerator, &constraints, &goalState, &prevState, 3.1);
+    ck_assert_int_eq(1, setpointGenerator.fullRegenerations);
+    ck_assert_int_eq(4, setpointGenerator.incrementalRegenerations);
+    expected = GenerateProfile(&constraints, &goalState, &prevState);
+    ck_assert_double_eq_tol(SegmentEnd( &expected.tail->segment ).t, SegmentEnd( &setpointGenerator.profile->tail->segment ).t, 1e-9);
+    ck_assert_double_eq_tol(4.0, setpoint.motionState.vel, 1e-9);
+    ClearProfile(&expected);
+
+    // A change larger than the tolerance regenerates.
+    prevState = setpoint.motionState;
+    goalState.pos = 25.0;
+    setpoint = GetSetpoint(&setpointGenerator, &constraints, &goalState, &prevState, 3.5);
+    ck_assert_int_eq(2, setpointGenerator.fullRegenerations);
+    ck_assert_int_eq(4, setpointGenerator.incrementalRegenerations);
+
+    ClearSetpointGenerator(&setpointGenerator);
+
+ } END_TEST
+
+
 Suite *setpointGenerator_suite(void) {
     Suite *s;
     TCase *tc;
@@ -121,6 +210,7 @@ Suite *setpointGenerator_suite(void) {
     tcase_add_test(tc, test_ClearSetpointGenerator);
     tcase_add_test(tc, test_SetSetpointGenerator);
     tcase_add_test(tc, test_GetSetpoint);
+    tcase_add_test(tc, test_GetSetpointIncremental);
     suite_add_tcase(s, tc);
     return s;
 }
@@ -0,0 +1,94 @@
+#include <check.h>
+#include <stdlib.h>
+#include "../sim/Sim.h"
+
+
+START_TEST(test_RunSweepGrid) {
+    sweepConfig_t config;
+    sweepResult_t *serial, *parallel;
+    int numSerial, numParallel, i;
+
+    InitSweepConfig( &config );
+    config.ranges[SWEEP_LOOKAHEAD_MIN_DISTANCE] = (sweepRange_t) {6.0, 12.0, 2};
+    config.ranges[SWEEP_LOOKAHEAD_MAX_DISTANCE] = (sweepRange_t) {8.0, 36.0, 3};
+    ck_assert_int_eq(6, GetSweepSize( &config ));
+
+    config.numThreads = 1;
+    serial = RunSweep( &config, &numSerial );
+    config.numThreads = 4;
+    parallel = RunSweep( &config, &numParallel );
+    ck_assert_int_eq(6, numSerial);
+    ck_assert_int_eq(6, numParallel);
+
+    // Same ranking whatever the thread count, best first.
+    for ( i = 0; i < numSerial; i++ ) {
+        ck_assert_int_eq(serial[i].index, parallel[i].index);
+        ck_assert_double_eq(serial[i].cost, parallel[i].cost);
+        ck_assert_double_eq(serial[i].maxCrossTrackError, parallel[i].maxCrossTrackError);
+        if ( i > 0 ) {
+            ck_assert_int_ge(serial[i - 1].routesFinished, serial[i].routesFinished);
+            if ( serial[i - 1].routesFinished == serial[i].routesFinished ) {
+                ck_assert_double_le(serial[i - 1].cost, serial[i].cost);
+            }
+        }
+    }
+    ck_assert_int_eq(GetNumSimRoutes(), serial[0].routesFinished);
+
+    // Set 2 is min distance 6 (first digit 0) with max distance 22 (second digit 1).
+    for ( i = 0; i < numSerial && serial[i].index != 2; i++ );
+    ck_assert_double_eq(6.0, serial[i].params.lookahead.minDistance_in);
+    ck_assert_double_eq(22.0, serial[i].params.lookahead.maxDistance_in);
+
+    // Max distance 8 with min distance 12 is not a valid lookahead and ranks last.
+    ck_assert_int_eq(1, serial[numSerial - 1].index);
+    ck_assert_int_eq(0, serial[numSerial - 1].routesFinished);
+
+    free( serial );
+    free( parallel );
+
+} END_TEST
+
+
+START_TEST(test_RunSweepRandom) {
+    sweepConfig_t config;
+    sweepResult_t *first, *second;
+    int numFirst, numSecond, i;
+
+    InitSweepConfig( &config );
+    config.ranges[SWEEP_INERTIA_GAIN] = (sweepRange_t) {0.0, 0.004, 1};
+    config.ranges[SWEEP_PROFILE_KP] = (sweepRange_t) {0.0, 0.5, 1};
+    config.randomSamples = 5;
+    config.seed = 1234;
+    config.sim.wheelSpeedNoise_ips = 1.0;
+    config.numThreads = 2;
+
+    first = RunSweep( &config, &numFirst );
+    second = RunSweep( &config, &numSecond );
+    ck_assert_int_eq(5, numFirst);
+    for ( i = 0; i < numFirst; i++ ) {
+        ck_assert_int_eq(first[i].index, second[i].index);
+        ck_assert_double_eq(first[i].params.inertiaGain, second[i].params.inertiaGain);
+        ck_assert_double_eq(first[i].cost, second[i].cost);
+        ck_assert_double_ge(first[i].params.profile_kp, 0.0);
+        ck_assert_double_le(first[i].params.profile_kp, 0.5);
+        ck_assert_double_eq(first[i].params.lookahead.minDistance_in, 12.0);
+    }
+    free( first );
+    free( second );
+
+} END_TEST
+
+
+Suite *sweep_suite(void) {
+    Suite *s;
+    TCase *tc;
+
+    s = suite_create("Sweep");
+    tc = tcase_create("Core");
+
+    tcase_add_test(tc, test_RunSweepGrid);
+    tcase_add_test(tc, test_RunSweepRandom);
+    tcase_set_timeout(tc, 60);
+    suite_add_tcase(s, tc);
+    return s;
+}
@@ -0,0 +1,145 @@
+#include <check.h>
+#include <math.h>
+#include <stdlib.h>
+#include "../path/Path.h"
+#include "test_Helpers.h"
+
+
+pathSegmentsList_t BuildTrajectoryTestPath (void) {
+    waypoint_t waypoints[4] = {
+        {{0.0, 0.0}, 0.0, 60.0},
+        {{120.0, 0.0}, 24.0, 60.0},
+        {{120.0, 120.0}, 24.0, 60.0},
+        {{0.0, 120.0}, 0.0, 60.0}
+    };
+    waypoint_t *wps[4] = {&waypoints[0], &waypoints[1], &waypoints[2], &waypoints[3]};
+
+    return BuildPathFromWaypoints( wps, 4 );
+}
+
+
+START_TEST(test_CompileTrajectory) {
+    pathSegmentsList_t path, empty = {NULL, NULL, 0};
+    pathSegmentNode_t *node;
+    trajectory_t trajectory;
+    const trajectoryPoint_t *first, *last, *point;
+    double duration = 0.0, length = 0.0, left, right;
+    int k, arcPoints = 0;
+
+    ck_assert_int_eq(-1, CompileTrajectory( &empty, 0.01, &trajectory ));
+    ck_assert_int_eq(0, trajectory.numPoints);
+
+    path = BuildTrajectoryTestPath();
+    for ( node = path.head; node; node = node->next ) {
+        duration += SegmentEndTime( &node->segment.speedController.tail->segment ) - node->segment.speedController.head->segment.t;
+        length += GetLength( &node->segment );
+    }
+    ck_assert_int_eq(0, CompileTrajectory( &path, 0.01, &trajectory ));
+    ck_assert_double_eq_tol(duration, trajectory.duration, 1E-9);
+    ck_assert_double_eq_tol(length, trajectory.length, 1E-9);
+    ck_assert_int_eq((int) ceil( duration / 0.01 ) + 1, trajectory.numPoints);
+
+    first = &trajectory.points[0];
+    last = &trajectory.points[trajectory.numPoints - 1];
+    ck_assert_double_eq_tol(0.0, first->pose.translation.x_in, 1E-9);
+    ck_assert_double_eq_tol(0.0, first->pose.translation.y_in, 1E-9);
+    ck_assert_double_eq_tol(0.0, first->velocity, 1E-6);
+    ck_assert_double_eq_tol(0.0, last->pose.translation.x_in, 1E-6);
+    ck_assert_double_eq_tol(120.0, last->pose.translation.y_in, 1E-6);
+    ck_assert_double_eq_tol(0.0, last->velocity, 1E-6);
+    ck_assert_double_eq_tol(length, last->distance, 1E-6);
+    ck_assert_double_eq_tol(duration, last->t, 1E-9);
+
+    for ( k = 1; k < trajectory.numPoints; k++ ) {
+        point = &trajectory.points[k];
+        ck_assert_double_le(trajectory.points[k - 1].distance, point->distance + 1E-9);
+        ck_assert_double_le(point->velocity, 60.0 + 1E-6);
+        if ( k < trajectory.numPoints - 1 ) {
+            ck_assert_double_eq_tol(k * 0.01, point->t, 1E-9);
+        }
+        // Both corners turn left on a 24 in radius, the heading follows the direction of travel.
+        if ( point->curvature != 0.0 ) {
+            ck_assert_double_eq_tol(1.0 / 24.0, point->curvature, 1E-9);
+            arcPoints += 1;
+        }
+        if ( point->pose.translation.x_in > 10.0 && point->pose.translation.x_in < 90.0 && point->pose.translation.y_in < 1E-6 ) {
+            ck_assert_double_eq_tol(0.0, point->pose.rotation.sinTheta_rad, 1E-9);
+        }
+    }
+    ck_assert_int_gt(arcPoints, 0);
+
+    // Lookup is by the nearest sample, clamped at both ends.
+    ck_assert_ptr_eq(first, GetTrajectoryPoint( &trajectory, -1.0 ));
+    ck_assert_ptr_eq(&trajectory.points[10], GetTrajectoryPoint( &trajectory, 0.1004 ));
+    ck_assert_ptr_eq(&trajectory.points[11], GetTrajectoryPoint( &trajectory, 0.1051 ));
+    ck_assert_ptr_eq(last, GetTrajectoryPoint( &trajectory, duration + 5.0 ));
+
+    for ( k = 0; k < trajectory.numPoints && trajectory.points[k].curvature == 0.0; k++ );
+    GetTrajectoryWheelSpeeds( &trajectory.points[k], 24.0, &left, &right );
+    ck_assert_double_eq_tol(trajectory.points[k].velocity * 0.5, left, 1E-9);
+    ck_assert_double_eq_tol(trajectory.points[k].velocity * 1.5, right, 1E-9);
+
+    ClearTrajectory( &trajectory );
+    ck_assert_ptr_null(trajectory.points);
+    ClearPath( &path );
+
+} END_TEST
+
+
+START_TEST(test_TrajectoryFollower) {
+    pathFollowerParams_t params = GetTestFollowerParams();
+    pathFollower_t follower;
+    pathSegmentsList_t path;
+    trajectory_t trajectory;
+    transform2d_t pose;
+    twist2d_t command = {0.0, 0.0, 0.0};
+    double displacement = 0.0, dt = 0.01, maxCrossTrack = 0.0;
+    int tick;
+
+    path = BuildTrajectoryTestPath();
+    ck_assert_int_eq(0, CompileTrajectory( &path, dt, &trajectory ));
+    InitPathFollower( &follower, &path, 0, &params );
+    SetPathFollowerTrajectory( &follower, &trajectory, 0.5 );
+
+    // Start 3 in to the right of the path, the correction has to bring the robot back onto it.
+    pose.translation.x_in = 0.0;
+    pose.translation.y_in = -3.0;
+    pose.rotation = TranslationDirection( &path.head->segment.deltaStart );
+    for ( tick = 50; tick < 3000 && !PathFollowerIsFinished( &follower ); tick++ ) {
+        command = GetPathFollowerUpdate( &follower, tick * dt, displacement, command.dx_in, &pose );
+        ck_assert_int_eq(tick < 50 + trajectory.numPoints ? tick - 50 : trajectory.numPoints - 1, follower.trajectoryIndex);
+        StepTestRobot( &command, &pose, &displacement, dt );
+        if ( tick > 50 + trajectory.numPoints / 2 ) {
+            maxCrossTrack = fmax( maxCrossTrack, follower.crossTrackError );
+        }
+    }
+
+    ck_assert_int_eq(1, PathFollowerIsFinished( &follower ));
+    ck_assert_double_lt(maxCrossTrack, 0.5);
+    ck_assert_double_eq_tol(0.0, pose.translation.x_in, 1.0);
+    ck_assert_double_eq_tol(120.0, pose.translation.y_in, 1.0);
+    ck_assert_double_eq_tol(0.0, command.dx_in, 1E-9);
+
+    // Without the trajectory the follower is back to pure pursuit.
+    SetPathFollowerTrajectory( &follower, NULL, 0.0 );
+    ck_assert_ptr_null(follower.trajectory);
+
+    ClearTrajectory( &trajectory );
+    ClearPath( &path );
+    ClearPathFollower( &follower );
+
+} END_TEST
+
+
+Suite *trajectory_suite(void) {
+    Suite *s;
+    TCase *tc;
+
+    s = suite_create("Trajectory");
+    tc = tcase_create("Core");
+
+    tcase_add_test(tc, test_CompileTrajectory);
+    tcase_add_test(tc, test_TrajectoryFollower);
+    suite_add_tcase(s, tc);
+    return s;
+}
@@ -0,0 +1,239 @@
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <malloc.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include "AllocTrack.h"
+
+typedef struct allocTrackSite {
+    _Atomic( void * ) caller;
+    _Atomic long allocations;
+    _Atomic long bytes;
+} allocTrackSite_t;
+
+void *__real_malloc (size_t size);
+void *__real_calloc (size_t count, size_t size);
+void *__real_realloc (void *ptr, size_t size);
+void __real_free (void *ptr);
+
+static _Atomic int gAllocTracking = 0;
+static _Atomic long gAllocations;
+static _Atomic long gFrees;
+static _Atomic long gBytes;
+static _Atomic long gLiveBytes;
+static _Atomic long gPeakBytes;
+static allocTrackSite_t gSites[ALLOC_TRACK_MAX_SITES];
+
+
+/********************************************************************************************************************************
+**  AddLiveBytes
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+static void AddLiveBytes (long delta) {
+    long live, peak;
+
+    live = atomic_fetch_add_explicit( &gLiveBytes, delta, memory_order_relaxed ) + delta;
+    peak = atomic_load_explicit( &gPeakBytes, memory_order_relaxed );
+    while ( live > peak && !atomic_compare_exchange_weak_explicit( &gPeakBytes, &peak, live, memory_order_relaxed, memory_order_relaxed ) );
+}
+
+
+/********************************************************************************************************************************
+**  RecordAllocation
+**
+**      Counts one allocation against its call site.  Once every site slot is taken further sites only add to the totals.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+static void RecordAllocation (void *caller, size_t size, long liveDelta) {
+    void *expected;
+    int i;
+
+    atomic_fetch_add_explicit( &gAllocations, 1, memory_order_relaxed );
+    atomic_fetch_add_explicit( &gBytes, (long) size, memory_order_relaxed );
+    AddLiveBytes( liveDelta );
+    for ( i = 0; i < ALLOC_TRACK_MAX_SITES; i++ ) {
+        expected = atomic_load_explicit( &gSites[i].caller, memory_order_acquire );
+        if ( !expected && atomic_compare_exchange_strong_explicit( &gSites[i].caller, &expected, caller, memory_order_acq_rel, memory_order_acquire ) ) {
+            expected = caller;
+        }
+        if ( expected == caller ) {
+            atomic_fetch_add_explicit( &gSites[i].allocations, 1, memory_order_relaxed );
+            atomic_fetch_add_explicit( &gSites[i].bytes, (long) size, memory_order_relaxed );
+            return;
+        }
+    }
+}
+
+
+/********************************************************************************************************************************
+**  __wrap_malloc, __wrap_calloc, __wrap_realloc, __wrap_free
+**
+**      What the linker substitutes for the allocator under --wrap.  They call through to the real allocator and, while
+**      tracking, count the call against the function that made it.
+**
+********************************************************************************************************************************/
+void * __wrap_malloc (size_t size) {
+    void *ptr;
+
+    ptr = __real_malloc( size );
+    if ( ptr && atomic_load_explicit( &gAllocTracking, memory_order_relaxed ) ) {
+        RecordAllocation( __builtin_return_address( 0 ), size, (long) malloc_usable_size( ptr ) );
+    }
+    return ptr;
+}
+
+void * __wrap_calloc (size_t count, size_t size) {
+    void *ptr;
+
+    ptr = __real_calloc( count, size );
+    if ( ptr && atomic_load_explicit( &gAllocTracking, memory_order_relaxed ) ) {
+        RecordAllocation( __builtin_return_address( 0 ), count * size, (long) malloc_usable_size( ptr ) );
+    }
+    return ptr;
+}
+
+void * __wrap_realloc (void *ptr, size_t size) {
+    void *newPtr;
+    long oldSize;
+
+    oldSize = ptr ? (long) malloc_usable_size( ptr ) : 0;
+    newPtr = __real_realloc( ptr, size );
+    if ( newPtr && atomic_load_explicit( &gAllocTracking, memory_order_relaxed ) ) {
+        RecordAllocation( __builtin_return_address( 0 ), size, (long) malloc_usable_size( newPtr ) - oldSize );
+    }
+    return newPtr;
+}
+
+void __wrap_free (void *ptr) {
+    if ( ptr && atomic_load_explicit( &gAllocTracking, memory_order_relaxed ) ) {
+        atomic_fetch_add_explicit( &gFrees, 1, memory_order_relaxed );
+        AddLiveBytes( -(long) malloc_usable_size( ptr ) );
+    }
+    __real_free( ptr );
+}
+
+
+/********************************************************************************************************************************
+**  StartAllocTracking
+**
+**      Clears all counters and starts counting allocator calls, from every thread.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void StartAllocTracking (void) {
+    int i;
+
+    atomic_store( &gAllocTracking, 0 );
+    atomic_store( &gAllocations, 0 );
+    atomic_store( &gFrees, 0 );
+    atomic_store( &gBytes, 0 );
+    atomic_store( &gLiveBytes, 0 );
+    atomic_store( &gPeakBytes, 0 );
+    for ( i = 0; i < ALLOC_TRACK_MAX_SITES; i++ ) {
+        atomic_store( &gSites[i].caller, NULL );
+        atomic_store( &gSites[i].allocations, 0 );
+        atomic_store( &gSites[i].bytes, 0 );
+    }
+    atomic_store( &gAllocTracking, 1 );
+}
+
+
+/********************************************************************************************************************************
+**  StopAllocTracking
+**
+**      Stops counting; the counters keep their values until the next StartAllocTracking.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void StopAllocTracking (void) {
+    atomic_store( &gAllocTracking, 0 );
+}
+
+
+/********************************************************************************************************************************
+**  GetAllocStats
+**
+**      Input:
+**
+**      Output:
+**          allocStats_t stats          Totals since StartAllocTracking
+**
+********************************************************************************************************************************/
+void GetAllocStats (allocStats_t *stats) {
+    stats->allocations = atomic_load( &gAllocations );
+    stats->frees = atomic_load( &gFrees );
+    stats->bytes = atomic_load( &gBytes );
+    stats->liveBytes = atomic_load( &gLiveBytes );
+    stats->peakBytes = atomic_load( &gPeakBytes );
+}
+
+
+/********************************************************************************************************************************
+**  GetAllocSites
+**
+**      Input:
+**          int maxSites                Room in sites
+**
+**      Output:
+**          allocSite_t sites           The call sites that allocated since StartAllocTracking, in the order first seen
+**          int                         Number of sites written
+**
+********************************************************************************************************************************/
+int GetAllocSites (allocSite_t *sites, int maxSites) {
+    int i, count = 0;
+
+    for ( i = 0; i < ALLOC_TRACK_MAX_SITES && count < maxSites; i++ ) {
+        sites[count].caller = atomic_load( &gSites[i].caller );
+        if ( !sites[count].caller ) {
+            break;
+        }
+        sites[count].allocations = atomic_load( &gSites[i].allocations );
+        sites[count].bytes = atomic_load( &gSites[i].bytes );
+        count += 1;
+    }
+    return count;
+}
+
+
+/********************************************************************************************************************************
+**  PrintAllocSites
+**
+**      Prints one line per call site, e.g.
+**          alloc_site=SetSetpointGenerator+0x1c allocations=3 bytes=96
+**      Functions are only named when the program is linked with -rdynamic, otherwise the raw address is printed.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void PrintAllocSites (void) {
+    allocSite_t sites[ALLOC_TRACK_MAX_SITES];
+    Dl_info info;
+    int i, count;
+
+    count = GetAllocSites( sites, ALLOC_TRACK_MAX_SITES );
+    for ( i = 0; i < count; i++ ) {
+        if ( dladdr( sites[i].caller, &info ) && info.dli_sname ) {
+            printf( "alloc_site=%s+%#lx", info.dli_sname, (unsigned long) ( (char *) sites[i].caller - (char *) info.dli_saddr ) );
+        } else {
+            printf( "alloc_site=%p", sites[i].caller );
+        }
+        printf( " allocations=%ld bytes=%ld\n", sites[i].allocations, sites[i].bytes );
+    }
+    fflush( stdout );
+}
@@ -0,0 +1,35 @@
+#ifndef ALLOC_TRACK_H
+#define ALLOC_TRACK_H
+
+#include <stddef.h>
+
+// Heap allocation tracking for tests and benchmarks.  A program that links AllocTrack.o must also be linked with
+//     -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc,--wrap=free
+// which routes every allocator call of the linked objects through the counters here.  Nothing is counted outside of
+// StartAllocTracking / StopAllocTracking, allocations are counted per call site and bytes are the sizes requested.
+
+#define ALLOC_TRACK_MAX_SITES 64
+
+typedef struct allocSite {
+    void *caller;               // Return address of the allocating call
+    long allocations;
+    long bytes;
+} allocSite_t;
+
+typedef struct allocStats {
+    long allocations;           // malloc, calloc and realloc calls
+    long frees;                 // free calls with a non-NULL pointer
+    long bytes;                 // Bytes requested
+    long liveBytes;             // Heap held now compared to the start of tracking (allocator usable sizes, may be negative)
+    long peakBytes;             // Largest liveBytes since the start of tracking
+} allocStats_t;
+
+
+// AllocTrack.c
+void StartAllocTracking (void);
+void StopAllocTracking (void);
+void GetAllocStats (allocStats_t *stats);
+int GetAllocSites (allocSite_t *sites, int maxSites);
+void PrintAllocSites (void);
+
+#endif
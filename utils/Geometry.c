@@ -54,7 +54,7 @@ translation2d_t TranslationRotate (translation2d_t *trans, rotation2d_t *rot) {
     translation2d_t rv;
 
     rv.x_in = trans->x_in * rot->cosTheta_rad - trans->y_in * rot->sinTheta_rad; 
-    rv.y_in = trans->x_in * rot->sinTheta_rad + rot->cosTheta_rad;
+    rv.y_in = trans->x_in * rot->sinTheta_rad + trans->y_in * rot->cosTheta_rad;
     return rv;
   }
 
@@ -83,8 +83,8 @@ translation2d_t TranslationInterpolate (translation2d_t *start, translation2d_t
     if ( scale >= 1.0 ) {
         rv = *end;    
     } else if ( scale >= 0 ) {
-        rv.x_in = scale * (end->x_in - start->x_in);
-        rv.y_in = scale * (end->y_in - start->y_in);
+        rv.x_in = scale * (end->x_in - start->x_in) + start->x_in;
+        rv.y_in = scale * (end->y_in - start->y_in) + start->y_in;
     }
     return rv;
 }
@@ -305,7 +305,7 @@ int IsColinear (transform2d_t *tfrmA, transform2d_t *tfrmB) {
     invertedTfrm = TransformInverse( tfrmA );
     invertedTfrm = TranformAByB( &invertedTfrm, tfrmB);
     twist = Log( &invertedTfrm );    
-    rv = ( EpsilonEquals(twist.dx_in, 0.0, 1e-9 ) && EpsilonEquals( twist.dtheta_rad, 0.0, 1e-9 ) );
+    rv = ( EpsilonEquals(twist.dy_in, 0.0, 1e-9 ) && EpsilonEquals( twist.dtheta_rad, 0.0, 1e-9 ) );
     return rv;
   }
 
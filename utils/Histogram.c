@@ -0,0 +1,179 @@
+#include <stdio.h>
+#include "Histogram.h"
+
+
+/********************************************************************************************************************************
+**  HistogramBin
+**
+**      Input:
+**
+**      Output: The bucket a value falls into.
+**
+********************************************************************************************************************************/
+static int HistogramBin (uint64_t value) {
+    int msb, bin;
+
+    if ( value < 16 ) {
+        return (int) value;
+    }
+    msb = 63 - __builtin_clzll( value );
+    bin = 16 + ( msb - 4 ) * 8 + (int) ( ( value >> ( msb - 3 ) ) & 7 );
+    return ( bin < HISTOGRAM_BINS ) ? bin : HISTOGRAM_BINS - 1;
+}
+
+
+/********************************************************************************************************************************
+**  HistogramBinUpper
+**
+**      Input:
+**
+**      Output: The largest value that falls into a bucket.
+**
+********************************************************************************************************************************/
+static uint64_t HistogramBinUpper (int bin) {
+    int msb, sub;
+
+    if ( bin < 16 ) {
+        return (uint64_t) bin;
+    }
+    msb = ( bin - 16 ) / 8 + 4;
+    sub = ( bin - 16 ) % 8;
+    return ( ( (uint64_t) ( 8 + sub + 1 ) ) << ( msb - 3 ) ) - 1;
+}
+
+
+/********************************************************************************************************************************
+**  ClearHistogram
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void ClearHistogram (histogram_t *histogram) {
+    int i;
+
+    for ( i = 0; i < HISTOGRAM_BINS; i++ ) {
+        histogram->bins[i] = 0;
+    }
+    histogram->count = 0;
+    histogram->min = UINT64_MAX;
+    histogram->max = 0;
+    histogram->sum = 0;
+}
+
+
+/********************************************************************************************************************************
+**  HistogramAdd
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void HistogramAdd (histogram_t *histogram, uint64_t value) {
+    histogram->bins[HistogramBin( value )] += 1;
+    histogram->count += 1;
+    histogram->sum += value;
+    if ( value < histogram->min ) {
+        histogram->min = value;
+    }
+    if ( value > histogram->max ) {
+        histogram->max = value;
+    }
+}
+
+
+/********************************************************************************************************************************
+**  HistogramMean
+**
+**      Input:
+**
+**      Output: The exact mean of the recorded values, 0.0 if there are none.
+**
+********************************************************************************************************************************/
+double HistogramMean (histogram_t *histogram) {
+    return histogram->count ? (double) histogram->sum / histogram->count : 0.0;
+}
+
+
+/********************************************************************************************************************************
+**  HistogramPercentile
+**
+**      Input:
+**          double percentile       Percentile in [0, 100]
+**
+**      Output: The upper bound of the bucket holding the percentile, clamped to the recorded maximum.
+**
+********************************************************************************************************************************/
+uint64_t HistogramPercentile (histogram_t *histogram, double percentile) {
+    uint64_t seen, target, rv;
+    int i;
+
+    if ( !histogram->count ) {
+        return 0;
+    }
+    target = (uint64_t) ( percentile / 100.0 * histogram->count + 0.5 );
+    if ( target < 1 ) {
+        target = 1;
+    }
+    seen = 0;
+    for ( i = 0; i < HISTOGRAM_BINS; i++ ) {
+        seen += histogram->bins[i];
+        if ( seen >= target ) {
+            break;
+        }
+    }
+    rv = HistogramBinUpper( i < HISTOGRAM_BINS ? i : HISTOGRAM_BINS - 1 );
+    return ( rv > histogram->max ) ? histogram->max : rv;
+}
+
+
+/********************************************************************************************************************************
+**  HistogramMerge
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void HistogramMerge (histogram_t *into, histogram_t *from) {
+    int i;
+
+    for ( i = 0; i < HISTOGRAM_BINS; i++ ) {
+        into->bins[i] += from->bins[i];
+    }
+    into->count += from->count;
+    into->sum += from->sum;
+    if ( from->min < into->min ) {
+        into->min = from->min;
+    }
+    if ( from->max > into->max ) {
+        into->max = from->max;
+    }
+}
+
+
+/********************************************************************************************************************************
+**  PrintHistogram
+**
+**      Prints a one line summary followed by the non-empty buckets.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void PrintHistogram (histogram_t *histogram, const char *name, const char *units) {
+    int i;
+
+    printf( "%-20s count=%lu min=%llu mean=%.1f p50=%llu p99=%llu max=%llu (%s)\n", name, (unsigned long) histogram->count,
+            (unsigned long long) ( histogram->count ? histogram->min : 0 ), HistogramMean( histogram ),
+            (unsigned long long) HistogramPercentile( histogram, 50.0 ), (unsigned long long) HistogramPercentile( histogram, 99.0 ),
+            (unsigned long long) histogram->max, units );
+    for ( i = 0; i < HISTOGRAM_BINS; i++ ) {
+        if ( histogram->bins[i] ) {
+            printf( "    <= %10llu %10lu\n", (unsigned long long) HistogramBinUpper( i ), (unsigned long) histogram->bins[i] );
+        }
+    }
+}
@@ -0,0 +1,26 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <stdint.h>
+
+// Log-linear buckets: values below 16 get a bucket each, above that every power of two is split into 8 buckets, so a
+// bucket is never wider than 1/8 of its value.  256 buckets reach 2^33 (about 8.6 s when counting nanoseconds).
+#define HISTOGRAM_BINS 256
+
+typedef struct histogram {
+    uint32_t bins[HISTOGRAM_BINS];
+    uint32_t count;
+    uint64_t min;
+    uint64_t max;
+    uint64_t sum;
+} histogram_t;
+
+// Histogram.c
+void ClearHistogram (histogram_t *histogram);
+void HistogramAdd (histogram_t *histogram, uint64_t value);
+double HistogramMean (histogram_t *histogram);
+uint64_t HistogramPercentile (histogram_t *histogram, double percentile);
+void HistogramMerge (histogram_t *into, histogram_t *from);
+void PrintHistogram (histogram_t *histogram, const char *name, const char *units);
+
+#endif
@@ -0,0 +1,307 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Instrument.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#endif
+
+// Each thread records into its own table so stepping followers on several cores never contends; queries merge them all.
+typedef struct instrumentTable {
+    histogram_t stages[INSTRUMENT_NUM_STAGES];
+    int inUse;
+} instrumentTable_t;
+
+static const char *kInstrumentStageNames[INSTRUMENT_NUM_STAGES] = {
+    "GetTargetPoint",
+    "GetCenter",
+    "GetSteeringArcLength",
+    "SetpointRegeneration",
+    "ProfileFollowerUpdate",
+};
+
+static double gInstrumentNsPerTick = 1.0;
+
+#ifdef __linux__
+// The tables are fixed, so recording never allocates.  A thread takes a free one on its first call and hands it back when it
+// exits, its statistics folded into the retired table, so thread pools coming and going do not use up the tables.
+static pthread_mutex_t gInstrumentLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t gInstrumentKeyOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t gInstrumentKey;
+static instrumentTable_t gInstrumentTables[INSTRUMENT_MAX_THREADS];
+static instrumentTable_t gRetiredTable;
+static _Thread_local instrumentTable_t *tInstrumentTable = NULL;
+#else
+static instrumentTable_t gInstrumentTable;
+#endif
+
+
+/********************************************************************************************************************************
+**  ReleaseThreadTable
+**
+**      Thread exit handler: folds the thread's statistics into the retired table and frees its table for another thread.
+**
+**      Input:
+**          void arg                    The thread's table
+**
+**      Output:
+**
+********************************************************************************************************************************/
+#ifdef __linux__
+static void ReleaseThreadTable (void *arg) {
+    instrumentTable_t *table = arg;
+    int i;
+
+    pthread_mutex_lock( &gInstrumentLock );
+    for ( i = 0; i < INSTRUMENT_NUM_STAGES; i++ ) {
+        HistogramMerge( &gRetiredTable.stages[i], &table->stages[i] );
+        ClearHistogram( &table->stages[i] );
+    }
+    table->inUse = 0;
+    pthread_mutex_unlock( &gInstrumentLock );
+}
+
+
+static void CreateInstrumentKey (void) {
+    pthread_key_create( &gInstrumentKey, ReleaseThreadTable );
+}
+#endif
+
+
+/********************************************************************************************************************************
+**  GetThreadTable
+**
+**      Input:
+**
+**      Output: The calling thread's table, taken on its first use (NULL if INSTRUMENT_MAX_THREADS threads hold one; that
+**              thread's calls are not recorded).
+**
+********************************************************************************************************************************/
+static instrumentTable_t * GetThreadTable (void) {
+#ifdef __linux__
+    instrumentTable_t *table = NULL;
+    int i;
+
+    if ( tInstrumentTable ) {
+        return tInstrumentTable;
+    }
+    pthread_once( &gInstrumentKeyOnce, CreateInstrumentKey );
+    pthread_mutex_lock( &gInstrumentLock );
+    for ( i = 0; i < INSTRUMENT_MAX_THREADS; i++ ) {
+        if ( !gInstrumentTables[i].inUse ) {
+            table = &gInstrumentTables[i];
+            table->inUse = 1;
+            break;
+        }
+    }
+    pthread_mutex_unlock( &gInstrumentLock );
+    if ( table ) {
+        pthread_setspecific( gInstrumentKey, table );
+        tInstrumentTable = table;
+    }
+    return table;
+#else
+    return &gInstrumentTable;
+#endif
+}
+
+
+/********************************************************************************************************************************
+**  InitInstrument
+**
+**      Starts the cycle counter (microcontroller) or calibrates the time stamp counter against the monotonic clock (Linux with
+**      INSTRUMENT_TSC), then clears all statistics.  Call once before the control loop starts.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void InitInstrument (void) {
+#if defined(__linux__) && defined(INSTRUMENT_TSC) && ( defined(__x86_64__) || defined(__i386__) )
+    struct timespec start, now, pause = {0, 20000000};
+    uint64_t startTicks, ticks;
+    double ns;
+
+    clock_gettime( CLOCK_MONOTONIC, &start );
+    startTicks = __rdtsc();
+    nanosleep( &pause, NULL );
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    ticks = __rdtsc() - startTicks;
+    ns = ( now.tv_sec - start.tv_sec ) * 1e9 + ( now.tv_nsec - start.tv_nsec );
+    gInstrumentNsPerTick = ticks ? ns / ticks : 1.0;
+#elif !defined(__linux__) && defined(__arm__)
+    // DEMCR.TRCENA then DWT_CTRL.CYCCNTENA.
+    *(volatile uint32_t *) 0xE000EDFC |= 1UL << 24;
+    INSTRUMENT_DWT_CYCCNT = 0;
+    *(volatile uint32_t *) 0xE0001000 |= 1UL;
+#endif
+    ResetInstrument();
+}
+
+
+/********************************************************************************************************************************
+**  InstrumentRecord
+**
+**      Adds one call of a stage that ran between two InstrumentNow readings.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void InstrumentRecord (instrumentStage_t stage, uint64_t start, uint64_t end) {
+    instrumentTable_t *table;
+    uint64_t elapsed;
+
+    table = GetThreadTable();
+    if ( !table ) {
+        return;
+    }
+#if defined(__arm__) && !defined(__linux__)
+    // The cycle counter is 32 bits wide and wraps every few seconds.
+    elapsed = (uint32_t) ( end - start );
+#else
+    elapsed = end - start;
+#endif
+    if ( gInstrumentNsPerTick != 1.0 ) {
+        elapsed = (uint64_t) ( elapsed * gInstrumentNsPerTick );
+    }
+    HistogramAdd( &table->stages[stage], elapsed );
+}
+
+
+/********************************************************************************************************************************
+**  EndInstrumentScope
+**
+**      Cleanup handler of INSTRUMENT_SCOPE.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void EndInstrumentScope (instrumentScope_t *scope) {
+    InstrumentRecord( scope->stage, scope->start, InstrumentNow() );
+}
+
+
+/********************************************************************************************************************************
+**  ResetInstrument
+**
+**      Clears the statistics of every thread, the ones that have exited too.  Must not run while any thread is inside an
+**      instrumented stage.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void ResetInstrument (void) {
+    instrumentTable_t *table;
+    int i;
+#ifdef __linux__
+    int k;
+#endif
+
+#ifdef __linux__
+    pthread_mutex_lock( &gInstrumentLock );
+    for ( k = 0; k <= INSTRUMENT_MAX_THREADS; k++ ) {
+        table = ( k < INSTRUMENT_MAX_THREADS ) ? &gInstrumentTables[k] : &gRetiredTable;
+        for ( i = 0; i < INSTRUMENT_NUM_STAGES; i++ ) {
+            ClearHistogram( &table->stages[i] );
+        }
+    }
+    pthread_mutex_unlock( &gInstrumentLock );
+#else
+    table = &gInstrumentTable;
+    for ( i = 0; i < INSTRUMENT_NUM_STAGES; i++ ) {
+        ClearHistogram( &table->stages[i] );
+    }
+#endif
+}
+
+
+/********************************************************************************************************************************
+**  GetInstrumentStats
+**
+**      Input:
+**          instrumentStage_t stage     The stage to summarize over all threads
+**
+**      Output:
+**          instrumentStats_t stats     Call count and min/mean/p99/max duration (zero when never called)
+**          int                         Returns the call count
+**
+**      Other threads' tables are read without stopping them, so query between ticks rather than during one.
+**
+********************************************************************************************************************************/
+int GetInstrumentStats (instrumentStage_t stage, instrumentStats_t *stats) {
+    histogram_t merged;
+#ifdef __linux__
+    int k;
+#endif
+
+    ClearHistogram( &merged );
+#ifdef __linux__
+    pthread_mutex_lock( &gInstrumentLock );
+    for ( k = 0; k < INSTRUMENT_MAX_THREADS; k++ ) {
+        if ( gInstrumentTables[k].inUse ) {
+            HistogramMerge( &merged, &gInstrumentTables[k].stages[stage] );
+        }
+    }
+    HistogramMerge( &merged, &gRetiredTable.stages[stage] );
+    pthread_mutex_unlock( &gInstrumentLock );
+#else
+    HistogramMerge( &merged, &gInstrumentTable.stages[stage] );
+#endif
+
+    memset( stats, 0, sizeof( instrumentStats_t ) );
+    stats->count = merged.count;
+    if ( merged.count ) {
+        stats->min = merged.min;
+        stats->mean = HistogramMean( &merged );
+        stats->p99 = HistogramPercentile( &merged, 99.0 );
+        stats->max = merged.max;
+    }
+
+    return (int) stats->count;
+}
+
+
+/********************************************************************************************************************************
+**  GetInstrumentStageName
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+const char * GetInstrumentStageName (instrumentStage_t stage) {
+    return ( stage >= 0 && stage < INSTRUMENT_NUM_STAGES ) ? kInstrumentStageNames[stage] : "Unknown";
+}
+
+
+/********************************************************************************************************************************
+**  PrintInstrumentStats
+**
+**      Prints one line per stage that has been called, e.g.
+**          stage=GetTargetPoint calls=2000 min=180 mean=231.5 p99=415 max=2311 units=ns
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void PrintInstrumentStats (void) {
+    instrumentStats_t stats;
+    int i;
+
+    for ( i = 0; i < INSTRUMENT_NUM_STAGES; i++ ) {
+        if ( GetInstrumentStats( (instrumentStage_t) i, &stats ) ) {
+            printf( "stage=%s calls=%u min=%llu mean=%.1f p99=%llu max=%llu units=%s\n", GetInstrumentStageName( (instrumentStage_t) i ),
+                    stats.count, (unsigned long long) stats.min, stats.mean, (unsigned long long) stats.p99,
+                    (unsigned long long) stats.max, INSTRUMENT_UNITS );
+        }
+    }
+}
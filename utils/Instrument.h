@@ -0,0 +1,92 @@
+#ifndef INSTRUMENT_H
+#define INSTRUMENT_H
+
+#include <stdint.h>
+#include "Histogram.h"
+
+// Hot-path stage timing.  Build with -DINSTRUMENT to record; without it INSTRUMENT_SCOPE expands to nothing and the control
+// code carries no timing overhead at all.  Durations are nanoseconds on Linux and CPU cycles on the microcontroller.
+// On x86 Linux -DINSTRUMENT_TSC reads the time stamp counter instead of clock_gettime (calibrated in InitInstrument).
+
+// Threads that can record at once (see GetThreadTable); a thread's table is freed for another when it exits.
+#define INSTRUMENT_MAX_THREADS 32
+
+typedef enum instrumentStage {
+    INSTRUMENT_GET_TARGET_POINT,
+    INSTRUMENT_GET_CENTER,
+    INSTRUMENT_GET_STEERING_ARC_LENGTH,
+    INSTRUMENT_SETPOINT_REGENERATION,
+    INSTRUMENT_PROFILE_FOLLOWER_UPDATE,
+    INSTRUMENT_NUM_STAGES
+} instrumentStage_t;
+
+typedef struct instrumentStats {
+    uint32_t count;
+    uint64_t min;
+    double mean;
+    uint64_t p99;
+    uint64_t max;
+} instrumentStats_t;
+
+typedef struct instrumentScope {
+    instrumentStage_t stage;
+    uint64_t start;
+} instrumentScope_t;
+
+#if defined(__linux__) && defined(INSTRUMENT_TSC) && ( defined(__x86_64__) || defined(__i386__) )
+#include <x86intrin.h>
+#define INSTRUMENT_UNITS "ns"
+#elif defined(__linux__)
+#include <time.h>
+#define INSTRUMENT_UNITS "ns"
+#elif defined(__arm__)
+// Cortex-M DWT cycle counter, enabled by InitInstrument.
+#define INSTRUMENT_DWT_CYCCNT (*(volatile uint32_t *) 0xE0001004)
+#define INSTRUMENT_UNITS "cycles"
+#else
+#define INSTRUMENT_UNITS "ticks"
+#endif
+
+
+/********************************************************************************************************************************
+**  InstrumentNow
+**
+**      Input:
+**
+**      Output: The raw value of the timing counter (see InstrumentRecord for the units).
+**
+********************************************************************************************************************************/
+static inline uint64_t InstrumentNow (void) {
+#if defined(__linux__) && defined(INSTRUMENT_TSC) && ( defined(__x86_64__) || defined(__i386__) )
+    return __rdtsc();
+#elif defined(__linux__)
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#elif defined(__arm__)
+    return INSTRUMENT_DWT_CYCCNT;
+#else
+    return 0;
+#endif
+}
+
+
+// Instrument.c
+void InitInstrument (void);
+void InstrumentRecord (instrumentStage_t stage, uint64_t start, uint64_t end);
+void EndInstrumentScope (instrumentScope_t *scope);
+void ResetInstrument (void);
+int GetInstrumentStats (instrumentStage_t stage, instrumentStats_t *stats);
+const char * GetInstrumentStageName (instrumentStage_t stage);
+void PrintInstrumentStats (void);
+
+// Times the rest of the enclosing block as the given stage, however the block is left.
+#ifdef INSTRUMENT
+#define INSTRUMENT_SCOPE(stage) \
+    instrumentScope_t instrumentScope __attribute__((cleanup(EndInstrumentScope))) = { (stage), InstrumentNow() }
+#else
+#define INSTRUMENT_SCOPE(stage) do { } while ( 0 )
+#endif
+
+#endif
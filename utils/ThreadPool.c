@@ -0,0 +1,292 @@
+#include <stdlib.h>
+#include <unistd.h>
+#include "ThreadPool.h"
+
+
+typedef struct threadPoolWorker {
+    threadPool_t *pool;
+    int id;
+} threadPoolWorker_t;
+
+
+/********************************************************************************************************************************
+**  PackRange
+**
+**      Input:
+**
+**      Output: The [head, tail) index range packed into a single queue word.
+**
+********************************************************************************************************************************/
+static uint64_t PackRange (uint32_t head, uint32_t tail) {
+    return ( (uint64_t) tail << 32 ) | head;
+}
+
+
+/********************************************************************************************************************************
+**  PopIndex
+**
+**      Takes the next index from the head of a thread's own range.
+**
+**      Input:
+**
+**      Output: The claimed index, or -1 if the range is empty.
+**
+********************************************************************************************************************************/
+static int PopIndex (threadPoolQueue_t *queue) {
+    uint64_t range;
+    uint32_t head, tail;
+
+    range = atomic_load_explicit( &queue->range, memory_order_acquire );
+    do {
+        head = (uint32_t) range;
+        tail = (uint32_t) ( range >> 32 );
+        if ( head >= tail ) {
+            return -1;
+        }
+    } while ( !atomic_compare_exchange_weak_explicit( &queue->range, &range, PackRange( head + 1, tail ), memory_order_acq_rel, memory_order_acquire ) );
+
+    return (int) head;
+}
+
+
+/********************************************************************************************************************************
+**  StealRange
+**
+**      Takes the back half of another thread's remaining range and makes it the thief's own range.  Victims are tried in
+**      order starting after the thief, so thieves spread out over the pool.
+**
+**      Input:
+**
+**      Output: Returns 1 if work was stolen, 0 if every other range is empty.
+**
+********************************************************************************************************************************/
+static int StealRange (threadPool_t *pool, int thief) {
+    uint64_t range;
+    uint32_t head, tail, take;
+    int i, victim;
+
+    for ( i = 1; i < pool->numThreads; i++ ) {
+        victim = ( thief + i ) % pool->numThreads;
+        range = atomic_load_explicit( &pool->queues[victim].range, memory_order_acquire );
+        do {
+            head = (uint32_t) range;
+            tail = (uint32_t) ( range >> 32 );
+            if ( head >= tail ) {
+                break;
+            }
+            take = ( tail - head + 1 ) / 2;
+        } while ( !atomic_compare_exchange_weak_explicit( &pool->queues[victim].range, &range, PackRange( head, tail - take ), memory_order_acq_rel, memory_order_acquire ) );
+
+        if ( head < tail ) {
+            atomic_store_explicit( &pool->queues[thief].range, PackRange( tail - take, tail ), memory_order_release );
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+
+/********************************************************************************************************************************
+**  DrainQueues
+**
+**      Runs the task on the thread's own indices, then steals from the others until there is nothing left.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+static void DrainQueues (threadPool_t *pool, int id) {
+    int index;
+
+    do {
+        while ( ( index = PopIndex( &pool->queues[id] ) ) >= 0 ) {
+            pool->task( pool->context, index );
+        }
+    } while ( StealRange( pool, id ) );
+}
+
+
+/********************************************************************************************************************************
+**  WorkerMain
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+static void * WorkerMain (void *arg) {
+    threadPoolWorker_t *worker = arg;
+    threadPool_t *pool = worker->pool;
+    unsigned long seenGeneration = 0;
+
+    while ( 1 ) {
+        pthread_mutex_lock( &pool->lock );
+        while ( !pool->shutdown && pool->generation == seenGeneration ) {
+            pthread_cond_wait( &pool->startCond, &pool->lock );
+        }
+        if ( pool->shutdown ) {
+            pthread_mutex_unlock( &pool->lock );
+            break;
+        }
+        seenGeneration = pool->generation;
+        pthread_mutex_unlock( &pool->lock );
+
+        DrainQueues( pool, worker->id );
+
+        pthread_mutex_lock( &pool->lock );
+        pool->workersDone += 1;
+        if ( pool->workersDone == pool->numThreads - 1 ) {
+            pthread_cond_signal( &pool->doneCond );
+        }
+        pthread_mutex_unlock( &pool->lock );
+    }
+
+    free( worker );
+    return NULL;
+}
+
+
+/********************************************************************************************************************************
+**  CreateThreadPool
+**
+**      Creates a pool of numThreads threads.  The thread calling RunThreadPool counts as one of them, so numThreads - 1 worker
+**      threads are started.
+**
+**      Input:
+**          int numThreads          Number of threads working on a run, clamped to [1, THREADPOOL_MAX_THREADS]
+**
+**      Output: The new pool, or NULL if it could not be created.
+**
+********************************************************************************************************************************/
+threadPool_t * CreateThreadPool (int numThreads) {
+    threadPool_t *pool;
+    threadPoolWorker_t *worker;
+    int i;
+
+    if ( numThreads < 1 ) {
+        numThreads = 1;
+    } else if ( numThreads > THREADPOOL_MAX_THREADS ) {
+        numThreads = THREADPOOL_MAX_THREADS;
+    }
+
+    pool = aligned_alloc( 64, ( sizeof( threadPool_t ) + 63 ) / 64 * 64 );
+    if ( !pool ) {
+        return NULL;
+    }
+    pool->numThreads = numThreads;
+    pool->generation = 0;
+    pool->workersDone = 0;
+    pool->shutdown = 0;
+    pool->task = NULL;
+    pool->context = NULL;
+    pthread_mutex_init( &pool->lock, NULL );
+    pthread_cond_init( &pool->startCond, NULL );
+    pthread_cond_init( &pool->doneCond, NULL );
+    for ( i = 0; i < THREADPOOL_MAX_THREADS; i++ ) {
+        atomic_init( &pool->queues[i].range, 0 );
+    }
+
+    for ( i = 1; i < numThreads; i++ ) {
+        worker = malloc( sizeof( threadPoolWorker_t ) );
+        worker->pool = pool;
+        worker->id = i;
+        if ( pthread_create( &pool->threads[i], NULL, WorkerMain, worker ) ) {
+            free( worker );
+            pool->numThreads = i;
+            break;
+        }
+    }
+
+    return pool;
+}
+
+
+/********************************************************************************************************************************
+**  DestroyThreadPool
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void DestroyThreadPool (threadPool_t *pool) {
+    int i;
+
+    pthread_mutex_lock( &pool->lock );
+    pool->shutdown = 1;
+    pthread_cond_broadcast( &pool->startCond );
+    pthread_mutex_unlock( &pool->lock );
+    for ( i = 1; i < pool->numThreads; i++ ) {
+        pthread_join( pool->threads[i], NULL );
+    }
+    pthread_mutex_destroy( &pool->lock );
+    pthread_cond_destroy( &pool->startCond );
+    pthread_cond_destroy( &pool->doneCond );
+    free( pool );
+}
+
+
+/********************************************************************************************************************************
+**  RunThreadPool
+**
+**      Calls task(context, i) for every i in [0, count) across the pool and returns once all of them have completed.  Each
+**      thread starts on its own contiguous share of the indices (so neighbouring data stays on one core) and steals from the
+**      others when it runs out.  Not reentrant: only one thread may run a given pool at a time.
+**
+**      Input:
+**
+**      Output:
+**
+********************************************************************************************************************************/
+void RunThreadPool (threadPool_t *pool, threadPoolTask_t task, void *context, int count) {
+    uint32_t start, end;
+    int i;
+
+    if ( count <= 0 ) {
+        return;
+    }
+    for ( i = 0; i < pool->numThreads; i++ ) {
+        start = (uint32_t) ( (int64_t) count * i / pool->numThreads );
+        end = (uint32_t) ( (int64_t) count * ( i + 1 ) / pool->numThreads );
+        atomic_store_explicit( &pool->queues[i].range, PackRange( start, end ), memory_order_relaxed );
+    }
+    pool->task = task;
+    pool->context = context;
+
+    if ( pool->numThreads == 1 ) {
+        DrainQueues( pool, 0 );
+        return;
+    }
+
+    pthread_mutex_lock( &pool->lock );
+    pool->workersDone = 0;
+    pool->generation += 1;
+    pthread_cond_broadcast( &pool->startCond );
+    pthread_mutex_unlock( &pool->lock );
+
+    DrainQueues( pool, 0 );
+
+    pthread_mutex_lock( &pool->lock );
+    while ( pool->workersDone < pool->numThreads - 1 ) {
+        pthread_cond_wait( &pool->doneCond, &pool->lock );
+    }
+    pthread_mutex_unlock( &pool->lock );
+}
+
+
+/********************************************************************************************************************************
+**  GetNumCores
+**
+**      Input:
+**
+**      Output: The number of online processors.
+**
+********************************************************************************************************************************/
+int GetNumCores (void) {
+    long rv;
+
+    rv = sysconf( _SC_NPROCESSORS_ONLN );
+    return ( rv < 1 ) ? 1 : (int) rv;
+}
@@ -0,0 +1,38 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+
+#define THREADPOOL_MAX_THREADS 64
+
+// Called once for every index in [0, count) handed to RunThreadPool.
+typedef void (*threadPoolTask_t)(void *context, int index);
+
+// The indices of a run are split into one contiguous range per thread.  A range is packed as (tail << 32 | head) so that the
+// owner taking from the head and thieves taking from the tail can both claim work with a single compare-and-swap.
+typedef struct threadPoolQueue {
+    _Alignas(64) _Atomic uint64_t range;
+} threadPoolQueue_t;
+
+typedef struct threadPool {
+    int numThreads;
+    pthread_t threads[THREADPOOL_MAX_THREADS];
+    threadPoolQueue_t queues[THREADPOOL_MAX_THREADS];
+    pthread_mutex_t lock;
+    pthread_cond_t startCond;
+    pthread_cond_t doneCond;
+    unsigned long generation;
+    int workersDone;
+    int shutdown;
+    threadPoolTask_t task;
+    void *context;
+} threadPool_t;
+
+threadPool_t * CreateThreadPool (int numThreads);
+void DestroyThreadPool (threadPool_t *pool);
+void RunThreadPool (threadPool_t *pool, threadPoolTask_t task, void *context, int count);
+int GetNumCores (void);
+
+#endif